@@ -54,6 +54,9 @@ void tausch_setSendCommunicationStrategy(CTausch *tC, const size_t haloId, int s
     else if(strategy == Tausch::Communication::CUDAAwareMPI) str = Tausch::Communication::CUDAAwareMPI;
     else if(strategy == Tausch::Communication::MPIPersistent) str = Tausch::Communication::MPIPersistent;
     else if(strategy == Tausch::Communication::GPUMultiCopy) str = Tausch::Communication::GPUMultiCopy;
+    else if(strategy == Tausch::Communication::DerivedMpiDatatypeSingleMessage) str = Tausch::Communication::DerivedMpiDatatypeSingleMessage;
+    else if(strategy == Tausch::Communication::MPIPartitioned) str = Tausch::Communication::MPIPartitioned;
+    else if(strategy == Tausch::Communication::UCX) str = Tausch::Communication::UCX;
 
     t->setSendCommunicationStrategy(haloId, str);
 }
@@ -70,6 +73,9 @@ void tausch_setRecvCommunicationStrategy(CTausch *tC, const size_t haloId, int s
     else if(strategy == Tausch::Communication::CUDAAwareMPI) str = Tausch::Communication::CUDAAwareMPI;
     else if(strategy == Tausch::Communication::MPIPersistent) str = Tausch::Communication::MPIPersistent;
     else if(strategy == Tausch::Communication::GPUMultiCopy) str = Tausch::Communication::GPUMultiCopy;
+    else if(strategy == Tausch::Communication::DerivedMpiDatatypeSingleMessage) str = Tausch::Communication::DerivedMpiDatatypeSingleMessage;
+    else if(strategy == Tausch::Communication::MPIPartitioned) str = Tausch::Communication::MPIPartitioned;
+    else if(strategy == Tausch::Communication::UCX) str = Tausch::Communication::UCX;
 
     t->setRecvCommunicationStrategy(haloId, str);
 }
@@ -45,7 +45,10 @@ enum Communication {
     TauschCommunicationDerivedMpiDatatype = 4,
     TauschCommunicationCUDAAwareMPI = 8,
     TauschCommunicationMPIPersistent = 16,
-    TauschCommunicationGPUMultiCopy = 32
+    TauschCommunicationGPUMultiCopy = 32,
+    TauschCommunicationDerivedMpiDatatypeSingleMessage = 64,
+    TauschCommunicationMPIPartitioned = 128,
+    TauschCommunicationUCX = 256
 };
 
 /**
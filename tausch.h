@@ -50,11 +50,39 @@
 #include <iostream>
 #include <map>
 #include <cstring>
+#include <cstdint>
 #include <algorithm>
 #include <future>
+#include <mutex>
 #include <cmath>
 #include <numeric>
 #include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <functional>
+#include <thread>
+#include <limits>
+#include <deque>
+#include <cstdlib>
+#if defined(TAUSCH_AVX2_GATHER) && defined(__AVX2__)
+#   include <immintrin.h>
+#endif
+#ifdef __SSE2__
+#   include <emmintrin.h>
+#endif
+#ifdef __linux__
+#   include <sched.h>
+#   include <unistd.h>
+#endif
+#ifdef TAUSCH_NUMA
+#   include <numa.h>
+#   include <numaif.h>
+#endif
+
+#ifdef TAUSCH_UCX
+#   include <ucp/api/ucp.h>
+#endif
 
 #ifdef TAUSCH_CUDA
 #   include <cuda_runtime.h>
@@ -224,6 +252,61 @@ public:
         isHIP = false;
         mpiop = req;
     }
+    /**
+     * @brief
+     * Constructor of a new Status object for MPI requests owned by Tausch.
+     *
+     * This constructs a new Status object referring to an MPI request that is stored (and possibly
+     * replaced at a later time) by Tausch. Waiting on this Status object updates the stored request.
+     * The Status object holds a pointer to the stored request, it is only valid as long as the
+     * request is stored, e.g., until the Tausch object is destroyed or the halo is deleted.
+     * Multiple consecutive requests (e.g., the chunks of a striped message) can be connected at once.
+     *
+     * @param req
+     * Pointer to the MPI request connected to the underlying operation.
+     * @param count
+     * The number of consecutive MPI requests starting at req.
+     */
+    Status(MPI_Request *req, int count = 1) {
+        running = false;
+        finished = false;
+        isCPU = false;
+        isCUDA = false;
+        isOCL = false;
+        isMPI = true;
+        isHIP = false;
+        mpiop = MPI_REQUEST_NULL;
+        mpiopPtr = req;
+        mpiopCount = count;
+    }
+
+#ifdef TAUSCH_UCX
+    /**
+     * @brief
+     * Constructor of a new Status object for UCX requests owned by Tausch.
+     *
+     * This constructs a new Status object referring to a UCX request that is stored by Tausch.
+     * Checking and waiting progresses the UCX worker, once completed the request is freed and the
+     * stored request is set to nullptr.
+     *
+     * @param worker
+     * The UCX worker progressing the request.
+     * @param req
+     * Pointer to the UCX request connected to the underlying operation (nullptr if completed).
+     */
+    Status(ucp_worker_h worker, void **req) {
+        running = false;
+        finished = false;
+        isCPU = false;
+        isCUDA = false;
+        isOCL = false;
+        isMPI = false;
+        isHIP = false;
+        isUCX = true;
+        ucxworker = worker;
+        ucxopPtr = req;
+    }
+#endif
 
     /**
      * @brief
@@ -274,7 +357,7 @@ public:
     operator MPI_Request() {
         if(!isMPI)
             std::cout << "Status warning: No MPI_Request active!" << std::endl;
-        return mpiop;
+        return (mpiopPtr == nullptr ? mpiop : *mpiopPtr);
     }
 #ifdef TAUSCH_CUDA
     /**
@@ -328,6 +411,58 @@ public:
     }
 #endif
 
+    /**
+     * @brief
+     * The modeled completion of an operation under network emulation.
+     *
+     * For sends the completion time is known right away. For receives it is sent along by the
+     * sender and only known once the request has completed.
+     */
+    struct EmulatedCompletion {
+        MPI_Request request = MPI_REQUEST_NULL;
+        int64_t completion = 0;     // nanoseconds since the epoch of std::chrono::steady_clock
+    };
+
+    /**
+     * @brief
+     * Hold back completion until the modeled completion time.
+     *
+     * Used by Tausch when network emulation is enabled, see Tausch::setNetworkEmulation(). The
+     * operation is only reported as completed once it has actually completed and the modeled
+     * completion time has passed.
+     *
+     * @param emulated
+     * The modeled completion of the operation.
+     */
+    void setEmulatedCompletion(std::shared_ptr<EmulatedCompletion> emulated) {
+        emulatedCompletion = emulated;
+    }
+
+    /**
+     * @brief
+     * The time from posting an operation until its completion was first observed.
+     *
+     * Shared between all copies of a Status object, whichever copy sees the operation completed
+     * first (when waiting or checking on it) records the time.
+     */
+    struct CompletionTiming {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        double elapsed = -1;        // in ms, -1 until completion has been observed
+    };
+
+    /**
+     * @brief
+     * Record when the operation is observed to have completed.
+     *
+     * Used by Tausch to time operations in adaptive mode, see Tausch::setSendAdaptiveStrategy().
+     *
+     * @param timing
+     * The timing to record the completion in.
+     */
+    void setCompletionTiming(std::shared_ptr<CompletionTiming> timing) {
+        completionTiming = timing;
+    }
+
     /**
      * @brief
      * Wait for operation to complete.
@@ -339,7 +474,10 @@ public:
             if(cpuop.valid())
                 cpuop.wait();
         } else if(isMPI) {
-            MPI_Wait(&mpiop, MPI_STATUS_IGNORE);
+            if(mpiopPtr == nullptr)
+                MPI_Wait(&mpiop, MPI_STATUS_IGNORE);
+            else
+                MPI_Waitall(mpiopCount, mpiopPtr, MPI_STATUSES_IGNORE);
 #ifdef TAUSCH_CUDA
         } else if(isCUDA) {
             cudaEvent_t ev;
@@ -357,9 +495,23 @@ public:
 #ifdef TAUSCH_OPENCL
         } else if(isOCL) {
             oclop.wait();
+#endif
+#ifdef TAUSCH_UCX
+        } else if(isUCX) {
+            while(*ucxopPtr != nullptr)
+                check();
 #endif
         }
 
+        if(emulatedCompletion != nullptr) {
+            MPI_Wait(&emulatedCompletion->request, MPI_STATUS_IGNORE);
+            // spin, sleeping is too coarse for modeled latencies of a few microseconds
+            while(!emulatedCompletionReached())
+                std::this_thread::yield();
+        }
+
+        recordCompletion();
+
     }
 
     /**
@@ -378,6 +530,7 @@ public:
         isOCL = false;
         isCUDA = false;
         isHIP = false;
+        isUCX = false;
     }
 
     /**
@@ -391,11 +544,14 @@ public:
      **/
     void set(MPI_Request &req) {
         mpiop = req;
+        mpiopPtr = nullptr;
+        mpiopCount = 1;
         isCPU = false;
         isMPI = true;
         isOCL = false;
         isCUDA = false;
         isHIP = false;
+        isUCX = false;
     }
 
 #if defined(TAUSCH_CUDA) || defined(TAUSCH_HIP)
@@ -421,6 +577,7 @@ public:
         isCUDA = false;
         isHIP = true;
 #endif
+        isUCX = false;
     }
 #endif
 
@@ -441,6 +598,7 @@ public:
         isOCL = true;
         isCUDA = false;
         isHIP = false;
+        isUCX = false;
     }
 #endif
 
@@ -455,13 +613,19 @@ private:
                 running = false;
                 finished = true;
             }
+        } else if(isMPI && mpiopCount > 1) {
+            int flag;
+            MPI_Testall(mpiopCount, mpiopPtr, &flag, MPI_STATUSES_IGNORE);
+            running = (!flag);
+            finished = flag;
         } else if(isMPI) {
-            if(mpiop == MPI_REQUEST_NULL) {
+            MPI_Request &req = (mpiopPtr == nullptr ? mpiop : *mpiopPtr);
+            if(req == MPI_REQUEST_NULL) {
                 running = false;
                 finished = true;
             } else {
                 int flag;
-                MPI_Test(&mpiop, &flag, MPI_STATUS_IGNORE);
+                MPI_Test(&req, &flag, MPI_STATUS_IGNORE);
                 running = (!flag);
                 finished = flag;
             }
@@ -484,12 +648,45 @@ private:
             running = (status==CL_QUEUED || status==CL_SUBMITTED || status==CL_RUNNING);
             finished = (status == CL_COMPLETE);
 #endif
+#ifdef TAUSCH_UCX
+        } else if(isUCX) {
+            if(*ucxopPtr != nullptr) {
+                ucp_worker_progress(ucxworker);
+                if(ucp_request_check_status(*ucxopPtr) != UCS_INPROGRESS) {
+                    ucp_request_free(*ucxopPtr);
+                    *ucxopPtr = nullptr;
+                }
+            }
+            running = (*ucxopPtr != nullptr);
+            finished = (*ucxopPtr == nullptr);
+#endif
+        }
+        if(finished && emulatedCompletion != nullptr && !emulatedCompletionReached()) {
+            running = true;
+            finished = false;
+        }
+        if(finished)
+            recordCompletion();
+    }
+    void recordCompletion() {
+        if(completionTiming != nullptr && completionTiming->elapsed < 0)
+            completionTiming->elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now()-completionTiming->start).count();
+    }
+    bool emulatedCompletionReached() {
+        if(emulatedCompletion->request != MPI_REQUEST_NULL) {
+            int flag;
+            MPI_Test(&emulatedCompletion->request, &flag, MPI_STATUS_IGNORE);
+            if(!flag)
+                return false;
         }
+        return (std::chrono::steady_clock::now().time_since_epoch() >= std::chrono::nanoseconds(emulatedCompletion->completion));
     }
     bool running;
     bool finished;
     std::shared_future<void> cpuop;
     MPI_Request mpiop;
+    MPI_Request *mpiopPtr = nullptr;
+    int mpiopCount = 1;
 #ifdef TAUSCH_CUDA
     cudaStream_t cudaop;
 #endif
@@ -498,12 +695,305 @@ private:
 #endif
 #ifdef TAUSCH_OPENCL
     cl::UserEvent oclop;
+#endif
+#ifdef TAUSCH_UCX
+    ucp_worker_h ucxworker;
+    void **ucxopPtr = nullptr;
 #endif
     bool isCPU;
     bool isCUDA;
     bool isOCL;
     bool isHIP;
     bool isMPI;
+    bool isUCX = false;
+    std::shared_ptr<EmulatedCompletion> emulatedCompletion;
+    std::shared_ptr<CompletionTiming> completionTiming;
+};
+
+/**
+ * @brief
+ * The interface of a transport used for sending and receiving packed halos.
+ *
+ * By default Tausch talks to MPI directly. A Transport can be passed to Tausch to send and receive
+ * the packed staging buffers through something else, e.g., the ThreadTransport connecting several
+ * Tausch objects living in the same process. Completion of an operation is reported through the
+ * Status object returned when posting it.
+ */
+class Transport {
+public:
+    virtual ~Transport() {}
+
+    /**
+     * @brief
+     * Post sending a buffer.
+     *
+     * The buffer must not be modified until the returned Status has completed.
+     *
+     * @param buf
+     * The data to be sent.
+     * @param size
+     * The size of the data in bytes.
+     * @param remoteRank
+     * The receiving rank.
+     * @param msgtag
+     * The message tag.
+     *
+     * @return
+     * Status object referring to the operation.
+     */
+    virtual Status postSend(const unsigned char *buf, const size_t size, const int remoteRank, const int msgtag) = 0;
+
+    /**
+     * @brief
+     * Post receiving into a buffer.
+     *
+     * Messages from the same rank with the same tag are received in the order they were sent.
+     *
+     * @param buf
+     * The buffer to receive into.
+     * @param size
+     * The size of the data in bytes.
+     * @param remoteRank
+     * The sending rank.
+     * @param msgtag
+     * The message tag.
+     *
+     * @return
+     * Status object referring to the operation.
+     */
+    virtual Status postRecv(unsigned char *buf, const size_t size, const int remoteRank, const int msgtag) = 0;
+
+    /**
+     * @brief
+     * Test whether a posted operation has completed.
+     *
+     * @param status
+     * The Status returned when posting the operation.
+     *
+     * @return
+     * Whether the operation has completed.
+     */
+    virtual bool test(Status &status) { return status.isCompleted(); }
+
+    /**
+     * @brief
+     * Wait for a posted operation to complete.
+     *
+     * @param status
+     * The Status returned when posting the operation.
+     */
+    virtual void wait(Status &status) { status.wait(); }
+
+    /**
+     * @brief
+     * The rank of this endpoint of the transport.
+     */
+    virtual int getRank() = 0;
+
+    /**
+     * @brief
+     * The number of endpoints connected by the transport.
+     */
+    virtual int getSize() = 0;
+
+    /**
+     * @brief
+     * A future that is already ready, for operations completing right away.
+     */
+    static std::shared_future<void> completed() {
+        std::promise<void> done;
+        done.set_value();
+        return done.get_future().share();
+    }
+};
+
+/**
+ * @brief
+ * Transport sending messages using non-blocking MPI point-to-point communication.
+ *
+ * Each message is sent as a single MPI message, messages larger than INT_MAX bytes are rejected
+ * (the program aborts).
+ */
+class MpiTransport : public Transport {
+public:
+    /**
+     * @brief
+     * Constructor of a new MPI transport.
+     *
+     * @param comm
+     * The communicator to use, it is not duplicated.
+     */
+    MpiTransport(const MPI_Comm comm = MPI_COMM_WORLD) : comm(comm) {}
+
+    Status postSend(const unsigned char *buf, const size_t size, const int remoteRank, const int msgtag) override {
+        checkCount(size, remoteRank, msgtag);
+        MPI_Request req;
+        MPI_Isend(buf, static_cast<int>(size), MPI_CHAR, remoteRank, msgtag, comm, &req);
+        return Status(req);
+    }
+
+    Status postRecv(unsigned char *buf, const size_t size, const int remoteRank, const int msgtag) override {
+        checkCount(size, remoteRank, msgtag);
+        MPI_Request req;
+        MPI_Irecv(buf, static_cast<int>(size), MPI_CHAR, remoteRank, msgtag, comm, &req);
+        return Status(req);
+    }
+
+    int getRank() override {
+        int rank;
+        MPI_Comm_rank(comm, &rank);
+        return rank;
+    }
+
+    int getSize() override {
+        int size;
+        MPI_Comm_size(comm, &size);
+        return size;
+    }
+
+private:
+    // MPI counts are ints, a larger message would be silently truncated
+    void checkCount(const size_t size, const int remoteRank, const int msgtag) {
+        if(size <= static_cast<size_t>(std::numeric_limits<int>::max()))
+            return;
+        std::cout << "MpiTransport: Message of " << size << " bytes to/from rank " << remoteRank << " with tag " << msgtag
+                  << " exceeds the maximum MPI count..." << std::endl;
+        MPI_Abort(comm, 1);
+    }
+
+    MPI_Comm comm;
+};
+
+/**
+ * @brief
+ * Transport connecting several Tausch objects living in the same process.
+ *
+ * This allows to run several subdomains as threads of a single process without using MPI at
+ * all, e.g., for ensemble runs on a single node or for unit tests. All endpoints share a mailbox,
+ * a message sent before the matching receive has been posted is copied into the mailbox (and the
+ * send completes right away), otherwise it is copied directly into the posted receive buffer.
+ * The transport is thread-safe but not lock-free: the mailbox is protected by mutexes and posting
+ * a message or receive briefly takes a lock. The mailbox is split up by receiving rank and tag,
+ * each part having its own lock, so threads exchanging different halos do not contend (they may
+ * still briefly contend for the lock guarding the list of parts). Like with MPI a message may be
+ * shorter than the receive buffer, a message longer than the receive buffer is reported as
+ * truncated and aborts. The endpoints are created using create().
+ */
+class ThreadTransport : public Transport {
+public:
+    /**
+     * @brief
+     * Create the connected endpoints of a new in-process transport.
+     *
+     * @param numRanks
+     * The number of endpoints, endpoint i has rank i.
+     *
+     * @return
+     * One endpoint per rank, each to be passed to one Tausch object.
+     */
+    static std::vector<std::shared_ptr<Transport> > create(const int numRanks) {
+        auto mailbox = std::make_shared<Mailbox>(numRanks);
+        std::vector<std::shared_ptr<Transport> > endpoints;
+        for(int rank = 0; rank < numRanks; ++rank)
+            endpoints.push_back(std::shared_ptr<Transport>(new ThreadTransport(mailbox, rank, numRanks)));
+        return endpoints;
+    }
+
+    Status postSend(const unsigned char *buf, const size_t size, const int remoteRank, const int msgtag) override {
+
+        Shard &shard = getShard(remoteRank, msgtag);
+        std::unique_lock<std::mutex> lock(shard.mutex);
+
+        Channel &channel = shard.channels[rank];
+        if(channel.recvs.size() > 0) {
+            PostedRecv recv = std::move(channel.recvs.front());
+            channel.recvs.pop_front();
+            lock.unlock();
+            checkTruncation(size, recv.size, rank, remoteRank, msgtag);
+            std::memcpy(recv.buf, buf, size);
+            recv.done.set_value();
+        } else
+            channel.messages.emplace_back(buf, buf+size);
+
+        return Status(completed());
+
+    }
+
+    Status postRecv(unsigned char *buf, const size_t size, const int remoteRank, const int msgtag) override {
+
+        Shard &shard = getShard(rank, msgtag);
+        std::unique_lock<std::mutex> lock(shard.mutex);
+
+        Channel &channel = shard.channels[remoteRank];
+        if(channel.messages.size() > 0) {
+            std::vector<unsigned char> message = std::move(channel.messages.front());
+            channel.messages.pop_front();
+            lock.unlock();
+            checkTruncation(message.size(), size, remoteRank, rank, msgtag);
+            std::memcpy(buf, message.data(), message.size());
+            return Status(completed());
+        }
+
+        PostedRecv recv;
+        recv.buf = buf;
+        recv.size = size;
+        std::shared_future<void> future = recv.done.get_future().share();
+        channel.recvs.push_back(std::move(recv));
+        return Status(future);
+
+    }
+
+    int getRank() override { return rank; }
+
+    int getSize() override { return numRanks; }
+
+private:
+    // a receive waiting for its message
+    struct PostedRecv {
+        unsigned char *buf;
+        size_t size;
+        std::promise<void> done;
+    };
+    // messages and receives are matched in order per (sender, receiver, tag)
+    struct Channel {
+        std::deque<std::vector<unsigned char> > messages;
+        std::deque<PostedRecv> recvs;
+    };
+    // all channels of one receiver and tag, indexed by the sender
+    struct Shard {
+        std::mutex mutex;
+        std::map<int, Channel> channels;
+    };
+    // the shards of one receiver, indexed by the tag, the lock only guards adding shards
+    struct Inbox {
+        std::mutex mutex;
+        std::map<int, Shard> shards;
+    };
+    struct Mailbox {
+        Mailbox(const int numRanks) : inboxes(numRanks) {}
+        std::vector<Inbox> inboxes;
+    };
+
+    ThreadTransport(std::shared_ptr<Mailbox> mailbox, const int rank, const int numRanks) : mailbox(mailbox), rank(rank), numRanks(numRanks) {}
+
+    // shards are never removed, the reference stays valid after releasing the lock
+    Shard &getShard(const int receiver, const int msgtag) {
+        Inbox &inbox = mailbox->inboxes[receiver];
+        std::unique_lock<std::mutex> lock(inbox.mutex);
+        return inbox.shards[msgtag];
+    }
+
+    static void checkTruncation(const size_t messageSize, const size_t bufferSize, const int sender, const int receiver, const int msgtag) {
+        if(messageSize <= bufferSize)
+            return;
+        std::cout << "ThreadTransport: Message truncated, " << messageSize << " bytes sent from rank " << sender
+                  << " to rank " << receiver << " with tag " << msgtag << " into a buffer of " << bufferSize << " bytes..." << std::endl;
+        std::abort();
+    }
+
+    std::shared_ptr<Mailbox> mailbox;
+    int rank;
+    int numRanks;
 };
 
 /**
@@ -526,9 +1016,43 @@ public:
         DerivedMpiDatatype = 4,
         CUDAAwareMPI = 8,
         MPIPersistent = 16,
-        GPUMultiCopy = 32
+        GPUMultiCopy = 32,
+        DerivedMpiDatatypeSingleMessage = 64,
+        MPIPartitioned = 128,
+        UCX = 256
     };
 
+    /**
+     * @brief
+     * Get the name of a communication strategy.
+     *
+     * @param strategy
+     * The strategy, a combination of strategies is listed separated by '|'.
+     *
+     * @return
+     * The name(s) as used in the Communication enum.
+     */
+    static std::string getCommunicationStrategyName(const Communication strategy) {
+
+        const std::vector<std::pair<Communication, std::string> > names = {{Default, "Default"},
+                                                                           {TryDirectCopy, "TryDirectCopy"},
+                                                                           {DerivedMpiDatatype, "DerivedMpiDatatype"},
+                                                                           {CUDAAwareMPI, "CUDAAwareMPI"},
+                                                                           {MPIPersistent, "MPIPersistent"},
+                                                                           {GPUMultiCopy, "GPUMultiCopy"},
+                                                                           {DerivedMpiDatatypeSingleMessage, "DerivedMpiDatatypeSingleMessage"},
+                                                                           {MPIPartitioned, "MPIPartitioned"},
+                                                                           {UCX, "UCX"}};
+
+        std::string ret;
+        for(auto const & name : names)
+            if((strategy&name.first) == name.first)
+                ret += (ret.size() > 0 ? "|" : "") + name.second;
+
+        return (ret.size() > 0 ? ret : std::to_string(static_cast<int>(strategy)));
+
+    }
+
     /**
      * @brief
      * This enum can be used to tell Tausch to warn of/prevent race conditions.
@@ -568,12 +1092,39 @@ public:
 
     }
 
+    /**
+     * @brief
+     * Constructor of a new Tausch object using a custom transport.
+     *
+     * This constructs a new Tausch object sending and receiving all packed halos through the given
+     * transport (see setTransport()). Used with a ThreadTransport no MPI call is made as long as
+     * only strategies using the staging buffers are used, and MPI does not need to be initialized.
+     *
+     * @param transport
+     * The transport to use.
+     * @param handling
+     * How to handle race conditions, see Tausch().
+     */
+    Tausch(std::shared_ptr<Transport> transport, OutOfSync handling = OutOfSync::WarnMe) {
+
+        TAUSCH_COMM = MPI_COMM_NULL;
+        this->transport = transport;
+
+        handleOutOfSync = handling;
+
+    }
+
     /**
      * @brief
      * Destructor.
      */
     ~Tausch() {
 
+#ifdef TAUSCH_UCX
+        // the registered staging buffers need to be unmapped before they are deleted
+        releaseUcx();
+#endif
+
         for(int i = 0; i < static_cast<int>(sendBuffer.size()); ++i) {
             std::vector<int>::iterator it = std::find(sendBufferHaloIdDeleted.begin(), sendBufferHaloIdDeleted.end(), i);
             if(it == sendBufferHaloIdDeleted.end())
@@ -581,6 +1132,28 @@ public:
 
         }
 
+        int mpiFinalized;
+        MPI_Finalized(&mpiFinalized);
+
+        // a restarted receive might still write into its staging buffer
+        if(!mpiFinalized)
+            for(auto &rearm : recvHaloRearm)
+                cancelRearmed(rearm.first);
+
+        for(auto &ring : sendHaloRing) {
+            if(!mpiFinalized) {
+                for(size_t slot = 0; slot < ring.second.requests.size(); ++slot) {
+                    MPI_Wait(&ring.second.requests[slot], MPI_STATUS_IGNORE);
+                    if(ring.second.setup[slot])
+                        MPI_Request_free(&ring.second.requests[slot]);
+                }
+            }
+            // the current buffer of the ring is deleted as sendBuffer
+            for(size_t slot = 0; slot < ring.second.buffers.size(); ++slot)
+                if(slot != ring.second.current)
+                    delete[] ring.second.buffers[slot];
+        }
+
         for(int i = 0; i < static_cast<int>(recvBuffer.size()); ++i) {
             std::vector<int>::iterator it = std::find(recvBufferHaloIdDeleted.begin(), recvBufferHaloIdDeleted.end(), i);
             if(it == recvBufferHaloIdDeleted.end())
@@ -603,6 +1176,53 @@ public:
 
 #endif
 
+        if(!mpiFinalized) {
+
+            for(auto &combined : sendHaloCombinedDatatype)
+                if(combined.second != MPI_DATATYPE_NULL)
+                    MPI_Type_free(&combined.second);
+            for(auto &combined : recvHaloCombinedDatatype)
+                if(combined.second != MPI_DATATYPE_NULL)
+                    MPI_Type_free(&combined.second);
+            for(auto &cached : derivedDatatypeCache)
+                MPI_Type_free(&cached.second.first);
+
+            for(auto &msg : aggregatedSendMessages)
+                MPI_Wait(&msg.second.request, MPI_STATUS_IGNORE);
+
+            for(auto &striping : sendHaloStriping)
+                MPI_Waitall(striping.second.requests.size(), striping.second.requests.data(), MPI_STATUSES_IGNORE);
+            for(auto &comm : communicatorPool)
+                MPI_Comm_free(&comm);
+            for(auto &comm : channelPool)
+                MPI_Comm_free(&comm);
+
+            for(auto &partitioned : sendHaloPartitioned)
+                if(sendHaloMpiSetup[partitioned.first][0]) {
+                    MPI_Wait(&sendHaloMpiRequests[partitioned.first][0], MPI_STATUS_IGNORE);
+                    MPI_Request_free(&sendHaloMpiRequests[partitioned.first][0]);
+                }
+            for(auto &partitioned : recvHaloPartitioned)
+                if(recvHaloMpiSetup[partitioned.first][0]) {
+                    MPI_Wait(&recvHaloMpiRequests[partitioned.first][0], MPI_STATUS_IGNORE);
+                    MPI_Request_free(&recvHaloMpiRequests[partitioned.first][0]);
+                }
+
+            for(auto &emulated : networkEmulation.sent)
+                MPI_Wait(&emulated->request, MPI_STATUS_IGNORE);
+            for(auto &emulated : networkEmulation.received) {
+                if(emulated->request != MPI_REQUEST_NULL)
+                    MPI_Cancel(&emulated->request);
+                MPI_Wait(&emulated->request, MPI_STATUS_IGNORE);
+            }
+            if(networkEmulation.comm != MPI_COMM_NULL)
+                MPI_Comm_free(&networkEmulation.comm);
+
+            if(TAUSCH_NODE_COMM != MPI_COMM_NULL)
+                MPI_Comm_free(&TAUSCH_NODE_COMM);
+
+        }
+
     }
 
     /***********************************************************************/
@@ -769,30 +1389,46 @@ public:
             haloSizePerBuffer.push_back(bufHaloSize);
         }
 
-        sendHaloIndices.push_back(indices);
         sendHaloIndicesSizePerBuffer.push_back(haloSizePerBuffer);
         sendHaloIndicesSizeTotal.push_back(totalHaloSize);
         sendHaloNumBuffers.push_back(indices.size());
         sendHaloCommunicationStrategy.push_back(Communication::Default);
         sendHaloRemoteRank.push_back(remoteMpiRank);
+        sendHaloTypeSizePerBuffer.push_back(typeSizePerBuffer);
+
+        sendHaloUniformLayout.push_back(hasUniformLayout(indices, typeSizePerBuffer));
+
+        // fragmented buffers only keep their element offsets, the regions are rebuilt when needed (see haloRegions())
+        std::vector<std::vector<uint32_t> > elementOffsets;
+        for(size_t bufferId = 0; bufferId < indices.size(); ++bufferId) {
+            elementOffsets.push_back(buildElementOffsets(indices[bufferId], typeSizePerBuffer[bufferId]));
+            if(elementOffsets.back().size() > 0)
+                std::vector<std::array<int, 4> >().swap(indices[bufferId]);
+        }
+        sendHaloElementOffsets.push_back(elementOffsets);
+        sendHaloIndices.push_back(indices);
 
         packFutures.push_back(Status(std::shared_future<void>()));
 
-        sendBuffer.push_back(new unsigned char[totalHaloSize]{});
+        // not initialised, the pages are placed by the thread touching them first (see setHaloNumaNode())
+        sendBuffer.push_back(new unsigned char[totalHaloSize]);
 
 #ifdef TAUSCH_CUDA
         cudaSendBuffer.push_back(nullptr);
 #endif
 
         std::vector<MPI_Request> perBufRequests;
-        std::vector<bool> perBufSetup;
+        std::vector<int> perBufSetup;
         for(size_t iBuf = 0; iBuf < haloSizePerBuffer.size(); ++iBuf) {
-            perBufRequests.push_back(MPI_Request());
+            perBufRequests.push_back(MPI_REQUEST_NULL);
             perBufSetup.push_back(false);
         }
         sendHaloMpiRequests.push_back(perBufRequests);
         sendHaloMpiSetup.push_back(perBufSetup);
 
+        if(strategyCacheLoaded)
+            applyCachedCommunicationStrategy(true, sendBuffer.size()-1);
+
         return sendBuffer.size()-1;
 
     }
@@ -975,14 +1611,27 @@ public:
             haloSizePerBuffer.push_back(bufHaloSize);
         }
 
-        recvHaloIndices.push_back(indices);
         recvHaloIndicesSizePerBuffer.push_back(haloSizePerBuffer);
         recvHaloIndicesSizeTotal.push_back(totalHaloSize);
         recvHaloNumBuffers.push_back(indices.size());
         recvHaloCommunicationStrategy.push_back(Communication::Default);
         recvHaloRemoteRank.push_back(remoteMpiRank);
+        recvHaloTypeSizePerBuffer.push_back(typeSizePerBuffer);
+
+        recvHaloUniformLayout.push_back(hasUniformLayout(indices, typeSizePerBuffer));
+
+        // fragmented buffers only keep their element offsets, the regions are rebuilt when needed (see haloRegions())
+        std::vector<std::vector<uint32_t> > elementOffsets;
+        for(size_t bufferId = 0; bufferId < indices.size(); ++bufferId) {
+            elementOffsets.push_back(buildElementOffsets(indices[bufferId], typeSizePerBuffer[bufferId]));
+            if(elementOffsets.back().size() > 0)
+                std::vector<std::array<int, 4> >().swap(indices[bufferId]);
+        }
+        recvHaloElementOffsets.push_back(elementOffsets);
+        recvHaloIndices.push_back(indices);
 
-        recvBuffer.push_back(new unsigned char[totalHaloSize]{});
+        // not initialised, the pages are placed by the thread touching them first (see setHaloNumaNode())
+        recvBuffer.push_back(new unsigned char[totalHaloSize]);
 
         unpackFutures.push_back(Status(std::shared_future<void>()));
 
@@ -991,14 +1640,17 @@ public:
 #endif
 
         std::vector<MPI_Request> perBufRequests;
-        std::vector<bool> perBufSetup;
+        std::vector<int> perBufSetup;
         for(size_t iBuf = 0; iBuf < haloSizePerBuffer.size(); ++iBuf) {
-            perBufRequests.push_back(MPI_Request());
+            perBufRequests.push_back(MPI_REQUEST_NULL);
             perBufSetup.push_back(false);
         }
         recvHaloMpiRequests.push_back(perBufRequests);
         recvHaloMpiSetup.push_back(perBufSetup);
 
+        if(strategyCacheLoaded)
+            applyCachedCommunicationStrategy(false, recvBuffer.size()-1);
+
         return recvBuffer.size()-1;
 
     }
@@ -1028,6 +1680,10 @@ public:
      * Set a communication strategy for sending a halo. The strategy can be any one of the
      * Communication enum.
      *
+     * DerivedMpiDatatype sends one message per buffer, DerivedMpiDatatypeSingleMessage combines all
+     * buffers into a single message. Both require the halo buffers to be set using setSendHaloBuffer().
+     * UCX sends the staging buffer using UCX tagged messages and requires setupUcx() to be called first.
+     *
      * @param haloId
      * The halo id returned by the addSendHaloInfo() member function.
      * @param strategy
@@ -1035,51 +1691,52 @@ public:
      */
     inline void setSendCommunicationStrategy(size_t haloId, Communication strategy) {
 
+        auto validating = sendHaloAdaptive.find(haloId);
+        if(validating != sendHaloAdaptive.end() && validating->second.validationRounds > 0 && !validating->second.switching)
+            sendHaloAdaptive.erase(validating);
+
         sendHaloCommunicationStrategy[haloId] = strategy;
 
-        if((strategy&Communication::DerivedMpiDatatype) == Communication::DerivedMpiDatatype) {
+        const bool derived = ((strategy&Communication::DerivedMpiDatatype) == Communication::DerivedMpiDatatype ||
+                              (strategy&Communication::DerivedMpiDatatypeSingleMessage) == Communication::DerivedMpiDatatypeSingleMessage);
 
-            std::vector<MPI_Datatype> sendHaloTypePerBuffer;
+        // release the datatypes of a previous setup of this halo, they might be shared with other halos
+        const bool wasDerived = (sendHaloDerivedDatatype[haloId].size() > 0);
+        for(auto &type : sendHaloDerivedDatatype[haloId])
+            releaseDerivedDatatype(type);
+        sendHaloDerivedDatatype[haloId].clear();
 
-            for(auto const & perbuf : sendHaloIndices[haloId]) {
+        // the staging buffer is only a placeholder while using derived datatypes
+        if(wasDerived && !derived) {
+            delete[] sendBuffer[haloId];
+            sendBuffer[haloId] = new unsigned char[sendHaloIndicesSizeTotal[haloId]];
+        }
 
-                std::vector<MPI_Datatype> vectorDataTypes;
-                std::vector<MPI_Aint> displacement;
-                std::vector<int> blocklength;
+        if(derived) {
 
-                vectorDataTypes.reserve(perbuf.size());
-                displacement.reserve(perbuf.size());
-                blocklength.reserve(perbuf.size());
+            for(size_t iBuf = 0; iBuf < sendHaloIndices[haloId].size(); ++iBuf)
+                sendHaloDerivedDatatype[haloId].push_back(getDerivedDatatype(haloRegions(true, haloId, iBuf)));
 
-                for(auto const & item : perbuf) {
+            // the datatype combining all buffers is built once the buffers are known
+            if((strategy&Communication::DerivedMpiDatatypeSingleMessage) == Communication::DerivedMpiDatatypeSingleMessage)
+                freeCombinedDatatype(true, haloId);
 
-                    MPI_Datatype vec;
-                    MPI_Type_vector(item[2], item[1], item[3], MPI_CHAR, &vec);
-                    MPI_Type_commit(&vec);
+            sendBuffer[haloId] = new unsigned char[1];
 
-                    vectorDataTypes.push_back(vec);
-                    displacement.push_back(item[0]);
-                    blocklength.push_back(1);
-
-                }
-
-                MPI_Datatype newtype;
-                MPI_Type_create_struct(perbuf.size(), blocklength.data(), displacement.data(), vectorDataTypes.data(), &newtype);
-                MPI_Type_commit(&newtype);
-                sendHaloDerivedDatatype[haloId].push_back(newtype);
-
-            }
-
-            sendBuffer[haloId] = new unsigned char[1];
-
-#ifdef TAUSCH_CUDA
-        } else if((strategy&Communication::CUDAAwareMPI) == Communication::CUDAAwareMPI) {
+#ifdef TAUSCH_CUDA
+        } else if((strategy&Communication::CUDAAwareMPI) == Communication::CUDAAwareMPI) {
 
             cudaMalloc(&cudaSendBuffer[haloId], sendHaloIndicesSizeTotal[haloId]*sizeof(unsigned char));
 #endif
 
         }
 
+        if((strategy&Communication::MPIPartitioned) == Communication::MPIPartitioned)
+            setupPartitions(true, haloId, 0);
+
+        if((strategy&Communication::UCX) == Communication::UCX)
+            setupUcxHalo(true, haloId);
+
     }
 
     /**
@@ -1088,6 +1745,10 @@ public:
      *
      * Set a communication strategy for receiving a halo. The strategy can be any one of the Communication enum.
      *
+     * DerivedMpiDatatype receives one message per buffer, DerivedMpiDatatypeSingleMessage receives
+     * all buffers as a single message. Both require the halo buffers to be set using setRecvHaloBuffer().
+     * UCX receives the staging buffer using UCX tagged messages and requires setupUcx() to be called first.
+     *
      * @param haloId
      * The halo id returned by the addRecvHaloInfo() member function.
      * @param strategy
@@ -1095,40 +1756,35 @@ public:
      */
     inline void setRecvCommunicationStrategy(size_t haloId, Communication strategy) {
 
-        recvHaloCommunicationStrategy[haloId] = strategy;
-
-        if((strategy&Communication::DerivedMpiDatatype) == Communication::DerivedMpiDatatype) {
-
-            std::vector<MPI_Datatype> recvHaloTypePerBuffer;
-
-            for(auto const & perbuf : recvHaloIndices[haloId]) {
+        auto validating = recvHaloAdaptive.find(haloId);
+        if(validating != recvHaloAdaptive.end() && validating->second.validationRounds > 0 && !validating->second.switching)
+            recvHaloAdaptive.erase(validating);
 
-                std::vector<MPI_Datatype> vectorDataTypes;
-                std::vector<MPI_Aint> displacement;
-                std::vector<int> blocklength;
-
-                vectorDataTypes.reserve(perbuf.size());
-                displacement.reserve(perbuf.size());
-                blocklength.reserve(perbuf.size());
+        recvHaloCommunicationStrategy[haloId] = strategy;
 
-                for(auto const & item : perbuf) {
+        const bool derived = ((strategy&Communication::DerivedMpiDatatype) == Communication::DerivedMpiDatatype ||
+                              (strategy&Communication::DerivedMpiDatatypeSingleMessage) == Communication::DerivedMpiDatatypeSingleMessage);
 
-                    MPI_Datatype vec;
-                    MPI_Type_vector(item[2], item[1], item[3], MPI_CHAR, &vec);
-                    MPI_Type_commit(&vec);
+        // release the datatypes of a previous setup of this halo, they might be shared with other halos
+        const bool wasDerived = (recvHaloDerivedDatatype[haloId].size() > 0);
+        for(auto &type : recvHaloDerivedDatatype[haloId])
+            releaseDerivedDatatype(type);
+        recvHaloDerivedDatatype[haloId].clear();
 
-                    vectorDataTypes.push_back(vec);
-                    displacement.push_back(item[0]);
-                    blocklength.push_back(1);
+        // the staging buffer is only a placeholder while using derived datatypes
+        if(wasDerived && !derived) {
+            delete[] recvBuffer[haloId];
+            recvBuffer[haloId] = new unsigned char[recvHaloIndicesSizeTotal[haloId]];
+        }
 
-                }
+        if(derived) {
 
-                MPI_Datatype newtype;
-                MPI_Type_create_struct(perbuf.size(), blocklength.data(), displacement.data(), vectorDataTypes.data(), &newtype);
-                MPI_Type_commit(&newtype);
-                recvHaloDerivedDatatype[haloId].push_back(newtype);
+            for(size_t iBuf = 0; iBuf < recvHaloIndices[haloId].size(); ++iBuf)
+                recvHaloDerivedDatatype[haloId].push_back(getDerivedDatatype(haloRegions(false, haloId, iBuf)));
 
-            }
+            // the datatype combining all buffers is built once the buffers are known
+            if((strategy&Communication::DerivedMpiDatatypeSingleMessage) == Communication::DerivedMpiDatatypeSingleMessage)
+                freeCombinedDatatype(false, haloId);
 
             recvBuffer[haloId] = new unsigned char[1];
 
@@ -1140,1851 +1796,8061 @@ public:
 
         }
 
-    }
-
+        if((strategy&Communication::MPIPartitioned) == Communication::MPIPartitioned)
+            setupPartitions(false, haloId, 0);
 
-    /***********************************************************************/
-    /*                     HANDLING OF RACE CONDITIONS                     */
-    /***********************************************************************/
+        if((strategy&Communication::UCX) == Communication::UCX)
+            setupUcxHalo(false, haloId);
 
-    /**
-     * @brief
-     * Tells Tausch if/how to handle potential race conditions.
-     *
-     * Tells Tausch if/how to handle potential race conditions. The handling can be any one of the OutOfSync enum.
-     *
-     * @param handling
-     * Value from OutOfSync enum, whether to warn, wait or do nothing.
-     */
-    void setOutOfSyncHandling(OutOfSync handling) {
-        handleOutOfSync = handling;
     }
 
     /**
      * @brief
-     * Return Status object for packing of halo with given haloId.
+     * Get the derived datatype used for sending a buffer of a halo.
      *
-     * Return Status object for packing of halo with given haloId. This can be called at any time as long as the haloId is valid.
+     * Halos with identical regions share the same datatype, it stays valid as long as any halo uses
+     * it and must not be freed by the user.
      *
      * @param haloId
      * The halo id returned by the addSendHaloInfo() member function.
+     * @param bufferId
+     * The id of the buffer.
      *
      * @return
-     * The Status object associated with the packing of the given haloId.
-     *
+     * The committed datatype, MPI_DATATYPE_NULL if the halo is not sent using DerivedMpiDatatype or
+     * DerivedMpiDatatypeSingleMessage.
      */
-    Status getPackStatus(int haloId) {
-        return packFutures[haloId];
+    inline MPI_Datatype getSendHaloDerivedDatatype(size_t haloId, size_t bufferId) {
+        auto it = sendHaloDerivedDatatype.find(haloId);
+        return ((it == sendHaloDerivedDatatype.end() || bufferId >= it->second.size()) ? MPI_DATATYPE_NULL : it->second[bufferId]);
     }
 
     /**
      * @brief
-     * Return Status object for unpacking of halo with given haloId.
+     * Get the derived datatype used for receiving a buffer of a halo.
      *
-     * Return Status object for unpacking of halo with given haloId. This can be called at any time as long as the haloId is valid.
+     * See getSendHaloDerivedDatatype().
      *
      * @param haloId
      * The halo id returned by the addRecvHaloInfo() member function.
+     * @param bufferId
+     * The id of the buffer.
      *
      * @return
-     * The Status object associated with the unpacking of the given haloId.
-     *
+     * The committed datatype, MPI_DATATYPE_NULL if the halo is not received using DerivedMpiDatatype
+     * or DerivedMpiDatatypeSingleMessage.
      */
-    Status getUnpackStatus(int haloId) {
-        return unpackFutures[haloId];
+    inline MPI_Datatype getRecvHaloDerivedDatatype(size_t haloId, size_t bufferId) {
+        auto it = recvHaloDerivedDatatype.find(haloId);
+        return ((it == recvHaloDerivedDatatype.end() || bufferId >= it->second.size()) ? MPI_DATATYPE_NULL : it->second[bufferId]);
     }
 
 
     /***********************************************************************/
-    /*                          SEND HALO BUFFER                           */
+    /*                      CACHE OF BEST STRATEGIES                       */
     /***********************************************************************/
 
     /**
-     * \overload
+     * @brief
+     * Find out which MPI ranks share a node.
      *
-     * Internally the data buffer will be recast to unsigned char.
+     * Splits the communicator into shared-memory node communicators and records for each rank
+     * of the communicator which node it lives on. This is a collective call over the communicator
+     * passed to the constructor, calling it more than once has no effect.
      */
-    inline void setSendHaloBuffer(int haloId, int bufferId, int* buf) {
-        setSendHaloBuffer(haloId, bufferId, reinterpret_cast<unsigned char*>(buf));
+    inline void setupNodeInformation() {
+
+        if(TAUSCH_NODE_COMM != MPI_COMM_NULL)
+            return;
+
+        int myRank;
+        MPI_Comm_rank(TAUSCH_COMM, &myRank);
+
+        MPI_Comm_split_type(TAUSCH_COMM, MPI_COMM_TYPE_SHARED, myRank, MPI_INFO_NULL, &TAUSCH_NODE_COMM);
+
+        setupNodeMapping();
+
     }
 
     /**
-     * \overload
-     *
-     * Internally the data buffer will be recast to unsigned char.
+     * @brief
+     * Load the cache of best communication strategies.
+     *
+     * Loads the per-machine cache of best communication strategies. From this point on every newly
+     * added halo whose signature is found in the cache starts out with the cached strategy, as long
+     * as it works with the remote side using Default, i.e., it is one of the strategies allowed by
+     * setSendAdaptiveStrategy(). TryDirectCopy is dropped from a cached strategy, it needs both sides
+     * to agree. Any cached strategy can be queried using getCachedSendCommunicationStrategy()
+     * and getCachedRecvCommunicationStrategy(). This is a collective call.
+     *
+     * The cache is filled by testForBestCommunication() and testForBestCommunicationFast() (when
+     * passed this object) and by the adaptive strategy selection (see setSendAdaptiveStrategy()).
+     *
+     * Unless disabled, a cached strategy other than Default is validated during the first sends/recvs
+     * of a halo: the cached strategy and Default are used in turns and timed. Afterwards the faster
+     * of the two is kept and stored in the cache. If the cached strategy lost, or was slower than
+     * allowed by the tolerance, the cache is marked as stale (see isStrategyCacheStale()). Setting a
+     * strategy explicitly ends the validation of a halo.
+     *
+     * @param filename
+     * The cache file to use. If left empty, a file called tausch_strategies_<hostname>.cache in the
+     * current working directory is used.
+     * @param tolerance
+     * A newly stored timing that is more than this factor slower than the cached timing of the same
+     * strategy marks the cache as stale.
+     * @param validationRounds
+     * How many times each of the cached strategy and Default are timed when validating a cached
+     * strategy, 0 disables the validation.
      */
-    inline void setSendHaloBuffer(int haloId, int bufferId, double* buf) {
-        setSendHaloBuffer(haloId, bufferId, reinterpret_cast<unsigned char*>(buf));
+    inline void setStrategyCache(std::string filename = "", double tolerance = 2.0, int validationRounds = 5) {
+
+        setupNodeInformation();
+
+        if(filename == "") {
+            char hostname[MPI_MAX_PROCESSOR_NAME];
+            int hostnameLength;
+            MPI_Get_processor_name(hostname, &hostnameLength);
+            filename = "tausch_strategies_" + std::string(hostname, hostnameLength) + ".cache";
+        }
+
+        strategyCacheFilename = filename;
+        strategyCacheTolerance = tolerance;
+        strategyCacheValidationRounds = std::max(0, validationRounds);
+        strategyCacheLoaded = true;
+        strategyCacheStale = false;
+        strategyCache.clear();
+
+        std::ifstream in(filename);
+        std::string line;
+        while(std::getline(in, line)) {
+            if(line.size() == 0 || line[0] == '#')
+                continue;
+            std::stringstream entry(line);
+            std::string sig;
+            int strategy;
+            double t;
+            if(entry >> sig >> strategy >> t)
+                strategyCache[sig] = {strategy, t};
+        }
+
+        for(size_t haloId = 0; haloId < sendBuffer.size(); ++haloId)
+            applyCachedCommunicationStrategy(true, haloId);
+        for(size_t haloId = 0; haloId < recvBuffer.size(); ++haloId)
+            applyCachedCommunicationStrategy(false, haloId);
+
     }
 
     /**
      * @brief
-     * Set a pointer to the sending halo data buffer.
-     *
-     * This sets a pointer to the sending halo data buffer of type unsigned char. This is a
-     * necessary step for certain communication strategies, e.g., using MPI derived data types.
+     * Get the cached strategy for sending a halo.
      *
      * @param haloId
      * The halo id returned by the addSendHaloInfo() member function.
-     * @param bufferId
-     * The id of the current buffer (numbered starting at 0).
-     * @param buf
-     * Pointer to the data buffer of type unsigned char.
+     *
+     * @return
+     * The cached strategy, or Communication::Default if nothing is cached for this halo.
      */
-    inline void setSendHaloBuffer(int haloId, int bufferId, unsigned char* buf) {
-        sendHaloBuffer[haloId][bufferId] = buf;
+    inline Communication getCachedSendCommunicationStrategy(size_t haloId) {
+        auto it = strategyCache.find(getHaloSignature(true, haloId));
+        return (it == strategyCache.end() ? Communication::Default : static_cast<Communication>(it->second.first));
     }
 
-
-
-    /***********************************************************************/
-    /*                          RECV HALO BUFFER                           */
-    /***********************************************************************/
-
     /**
-     * \overload
+     * @brief
+     * Get the cached strategy for receiving a halo.
      *
-     * Internally the data buffer will be recast to unsigned char.
+     * @param haloId
+     * The halo id returned by the addRecvHaloInfo() member function.
+     *
+     * @return
+     * The cached strategy, or Communication::Default if nothing is cached for this halo.
      */
-    inline void setRecvHaloBuffer(int haloId, int bufferId, int* buf) {
-        setRecvHaloBuffer(haloId, bufferId, reinterpret_cast<unsigned char*>(buf));
+    inline Communication getCachedRecvCommunicationStrategy(size_t haloId) {
+        auto it = strategyCache.find(getHaloSignature(false, haloId));
+        return (it == strategyCache.end() ? Communication::Default : static_cast<Communication>(it->second.first));
     }
 
     /**
-     * \overload
+     * @brief
+     * Store a measured strategy for sending a halo in the cache.
      *
-     * Internally the data buffer will be recast to unsigned char.
+     * Store a measured strategy for sending a halo in the cache. The entry is only replaced if the
+     * new timing is faster, or if it is a re-measurement of the cached strategy. A re-measurement
+     * that is slower than the cached timing by more than the tolerance marks the cache as stale.
+     *
+     * @param haloId
+     * The halo id returned by the addSendHaloInfo() member function.
+     * @param strategy
+     * The strategy that was measured.
+     * @param t
+     * The time it took (in ms).
      */
-    inline void setRecvHaloBuffer(int haloId, int bufferId, double* buf) {
-        setRecvHaloBuffer(haloId, bufferId, reinterpret_cast<unsigned char*>(buf));
+    inline void storeSendCommunicationStrategy(size_t haloId, Communication strategy, double t) {
+        storeCommunicationStrategy(getHaloSignature(true, haloId), strategy, t);
     }
 
     /**
      * @brief
-     * Set a pointer to the receiving halo data buffer.
+     * Store a measured strategy for receiving a halo in the cache.
      *
-     * This sets a pointer to the receiving halo data buffer of type int. This is a necessary step
-     * for certain communication strategies, e.g., using MPI derived data types.
+     * Store a measured strategy for receiving a halo in the cache. See storeSendCommunicationStrategy().
      *
      * @param haloId
      * The halo id returned by the addRecvHaloInfo() member function.
-     * @param bufferId
-     * The id of the current buffer (numbered starting at 0).
-     * @param buf
-     * Pointer to the data buffer of type unsigned char.
+     * @param strategy
+     * The strategy that was measured.
+     * @param t
+     * The time it took (in ms).
      */
-    inline void setRecvHaloBuffer(int haloId, int bufferId, unsigned char* buf) {
-        recvHaloBuffer[haloId][bufferId] = buf;
+    inline void storeRecvCommunicationStrategy(size_t haloId, Communication strategy, double t) {
+        storeCommunicationStrategy(getHaloSignature(false, haloId), strategy, t);
+    }
+
+    /**
+     * @brief
+     * Check whether the strategy cache has gone stale.
+     *
+     * @return
+     * True if a re-measured cached strategy turned out slower than allowed by the tolerance.
+     */
+    inline bool isStrategyCacheStale() {
+        return strategyCacheStale;
     }
 
+    /**
+     * @brief
+     * Write the strategy cache to file.
+     *
+     * Write the strategy cache to file. The entries of all ranks on a node are merged (keeping the
+     * fastest timing for each signature) and written by the first rank of the node. This is a
+     * collective call.
+     */
+    inline void saveStrategyCache() {
+
+        if(!strategyCacheLoaded)
+            return;
+
+        std::stringstream out;
+        for(auto const & entry : strategyCache)
+            out << entry.first << " " << entry.second.first << " " << entry.second.second << "\n";
+        std::string local = out.str();
+
+        int nodeRank, nodeSize;
+        MPI_Comm_rank(TAUSCH_NODE_COMM, &nodeRank);
+        MPI_Comm_size(TAUSCH_NODE_COMM, &nodeSize);
+
+        int localSize = local.size();
+        std::vector<int> allSizes(nodeSize);
+        MPI_Gather(&localSize, 1, MPI_INT, allSizes.data(), 1, MPI_INT, 0, TAUSCH_NODE_COMM);
+
+        std::vector<int> displs(nodeSize, 0);
+        for(int i = 1; i < nodeSize; ++i)
+            displs[i] = displs[i-1] + allSizes[i-1];
+        std::vector<char> all((nodeSize > 0 ? displs[nodeSize-1]+allSizes[nodeSize-1] : 0) + 1);
+
+        MPI_Gatherv(local.data(), localSize, MPI_CHAR, all.data(), allSizes.data(), displs.data(), MPI_CHAR, 0, TAUSCH_NODE_COMM);
+
+        if(nodeRank != 0)
+            return;
+
+        std::stringstream merged(std::string(all.data(), all.size()-1));
+        std::string sig;
+        int strategy;
+        double t;
+        while(merged >> sig >> strategy >> t) {
+            auto it = strategyCache.find(sig);
+            if(it == strategyCache.end() || it->second.second > t)
+                strategyCache[sig] = {strategy, t};
+        }
+
+        std::ofstream file(strategyCacheFilename);
+        file << "# Tausch communication strategy cache: <signature> <strategy> <time in ms>" << std::endl;
+        for(auto const & entry : strategyCache)
+            file << entry.first << " " << entry.second.first << " " << entry.second.second << std::endl;
+
+    }
 
 
     /***********************************************************************/
-    /*                             PACK BUFFER                             */
+    /*                    ADAPTIVE STRATEGY SELECTION                      */
     /***********************************************************************/
 
     /**
-     * \overload
+     * @brief
+     * Get the communication strategy currently used for sending a halo.
      *
-     * Internally the data buffer will be recast to unsigned char.
+     * @param haloId
+     * The halo id returned by the addSendHaloInfo() member function.
+     *
+     * @return
+     * The strategy currently in use.
      */
-    inline Status packSendBuffer(const size_t haloId, const size_t bufferId, const double *buf, const bool blocking = true) {
-        return packSendBuffer(haloId, bufferId, reinterpret_cast<const unsigned char*>(buf), blocking);
+    inline Communication getSendCommunicationStrategy(size_t haloId) {
+        return sendHaloCommunicationStrategy[haloId];
     }
 
     /**
-     * \overload
+     * @brief
+     * Get the communication strategy currently used for receiving a halo.
      *
-     * Internally the data buffer will be recast to unsigned char.
+     * @param haloId
+     * The halo id returned by the addRecvHaloInfo() member function.
+     *
+     * @return
+     * The strategy currently in use.
      */
-    inline Status packSendBuffer(const size_t haloId, const size_t bufferId, const int *buf, const bool blocking = true) {
-        return packSendBuffer(haloId, bufferId, reinterpret_cast<const unsigned char*>(buf), blocking);
+    inline Communication getRecvCommunicationStrategy(size_t haloId) {
+        return recvHaloCommunicationStrategy[haloId];
     }
 
     /**
      * @brief
-     * Packs a data buffer for the given halo and buffer id.
-     *
-     * Packs a data buffer for the given halo and buffer id. Once the packing has completed the
-     * data buffer is free to be used and changed as desired.
+     * Let Tausch pick the strategy for sending a halo while running.
+     *
+     * In adaptive mode every send of this halo is timed from posting it until its completion is
+     * first observed, either through the returned Status object or, at the latest, at the beginning
+     * of the next send of this halo (which then waits for it). This covers all messages making up
+     * the send, e.g., all chunks of a striped halo. The strategy with the lowest moving average is
+     * used, every so often one of the other candidates is re-timed (explore/exploit). Switching only
+     * happens at the beginning of a send once the previous message has completed, persistent requests
+     * are released when switching away from MPIPersistent.
+     *
+     * The candidates must be wire-compatible with whatever strategy the receiving side uses, which is
+     * the case for Default and MPIPersistent. DerivedMpiDatatype, DerivedMpiDatatypeSingleMessage,
+     * MPIPartitioned and UCX are thus not allowed here, neither is TryDirectCopy (which requires both
+     * sides to use it). CUDAAwareMPI and GPUMultiCopy are only considered if Tausch was built with
+     * support for the respective GPU backend. Any other candidate is ignored.
      *
      * @param haloId
      * The halo id returned by the addSendHaloInfo() member function.
-     * @param bufferId
-     * The id of the current buffer (numbered starting at 0).
-     * @param buf
-     * Pointer to the data buffer.
-     * @param blocking
-     * Whether to do the packing in a separate thread or not.
-     *
-     * @return
-     * A Status object containing information about the packing operation is returned.
+     * @param candidates
+     * The strategies to choose from.
+     * @param exploreInterval
+     * Every how many sends one of the currently not preferred strategies is re-timed.
      */
-    inline Status packSendBuffer(const size_t haloId, const size_t bufferId, const unsigned char *buf, const bool blocking = true) {
-
-        if(blocking) {
-
-            size_t bufferOffset = 0;
-            for(size_t i = 0; i < bufferId; ++i)
-                bufferOffset += sendHaloIndicesSizePerBuffer[haloId][i];
-
-            size_t mpiSendBufferIndex = 0;
-            for(auto const & region : sendHaloIndices[haloId][bufferId]) {
-
-                const size_t &region_start = region[0];
-                const size_t &region_howmanycols = region[1];
-                const size_t &region_howmanyrows = region[2];
-                const size_t &region_stridecol = region[3];
-
-                for(size_t rows = 0; rows < region_howmanyrows; ++rows) {
-
-                    std::memcpy(&sendBuffer[haloId][bufferOffset + mpiSendBufferIndex], &buf[region_start + rows*region_stridecol], region_howmanycols);
-                    mpiSendBufferIndex += region_howmanycols;
+    inline void setSendAdaptiveStrategy(size_t haloId,
+                                        std::vector<Communication> candidates = {Communication::Default, Communication::MPIPersistent},
+                                        int exploreInterval = 50) {
+        setAdaptiveStrategy(true, haloId, candidates, exploreInterval);
+    }
 
-                }
+    /**
+     * @brief
+     * Let Tausch pick the strategy for receiving a halo while running.
+     *
+     * This is the receiving counterpart of setSendAdaptiveStrategy(). Every receive is timed from
+     * posting it until its completion is first observed.
+     *
+     * @param haloId
+     * The halo id returned by the addRecvHaloInfo() member function.
+     * @param candidates
+     * The strategies to choose from.
+     * @param exploreInterval
+     * Every how many receives one of the currently not preferred strategies is re-timed.
+     */
+    inline void setRecvAdaptiveStrategy(size_t haloId,
+                                        std::vector<Communication> candidates = {Communication::Default, Communication::MPIPersistent},
+                                        int exploreInterval = 50) {
+        setAdaptiveStrategy(false, haloId, candidates, exploreInterval);
+    }
 
-            }
+    /**
+     * @brief
+     * Switch off adaptive strategy selection for sending a halo.
+     *
+     * The strategy that is currently in use is kept.
+     *
+     * @param haloId
+     * The halo id returned by the addSendHaloInfo() member function.
+     */
+    inline void unsetSendAdaptiveStrategy(size_t haloId) {
+        sendHaloAdaptive.erase(haloId);
+    }
 
-            return Status(std::shared_future<void>());
+    /**
+     * @brief
+     * Switch off adaptive strategy selection for receiving a halo.
+     *
+     * The strategy that is currently in use is kept.
+     *
+     * @param haloId
+     * The halo id returned by the addRecvHaloInfo() member function.
+     */
+    inline void unsetRecvAdaptiveStrategy(size_t haloId) {
+        recvHaloAdaptive.erase(haloId);
+    }
 
-        } else {
 
-            auto future = std::shared_future<void>(std::async(std::launch::async, [=]() {
 
-                size_t bufferOffset = 0;
-                for(size_t i = 0; i < bufferId; ++i)
-                    bufferOffset += sendHaloIndicesSizePerBuffer[haloId][i];
+    /***********************************************************************/
+    /*                             COST MODEL                              */
+    /***********************************************************************/
 
-                size_t mpiSendBufferIndex = 0;
-                for(auto const & region : sendHaloIndices[haloId][bufferId]) {
+    /**
+     * @brief
+     * Calibrate the cost model used to predict exchange times.
+     *
+     * This measures the latency (with normal and persistent requests) and bandwidth of the network
+     * using a short ping-pong between pairs of ranks, and the throughput of packing data both
+     * with memcpy (as done by Tausch) and with MPI derived datatypes (as done by MPI internally). The
+     * results are averaged over all ranks. This is a collective call.
+     *
+     * @param iterations
+     * How many ping-pong iterations to time for small messages (a fifth of it for large messages).
+     */
+    inline void calibrateCostModel(int iterations = 20) {
 
-                    const size_t &region_start = region[0];
-                    const size_t &region_howmanycols = region[1];
-                    const size_t &region_howmanyrows = region[2];
-                    const size_t &region_stridecol = region[3];
+        MPI_Comm calibcomm;
+        MPI_Comm_dup(TAUSCH_COMM, &calibcomm);
 
-                    for(size_t rows = 0; rows < region_howmanyrows; ++rows) {
+        int myRank, mpiSize;
+        MPI_Comm_rank(calibcomm, &myRank);
+        MPI_Comm_size(calibcomm, &mpiSize);
 
-                        std::memcpy(&sendBuffer[haloId][bufferOffset + mpiSendBufferIndex], &buf[region_start + rows*region_stridecol], region_howmanycols);
-                        mpiSendBufferIndex += region_howmanycols;
+        int partner = myRank^1;
+        if(partner >= mpiSize)
+            partner = myRank;
 
-                    }
+        const int largeSize = 1<<20;
+        const int largeIterations = std::max(1, iterations/5);
+        std::vector<unsigned char> sendbuf(largeSize), recvbuf(largeSize);
 
+        auto pingpong = [&](int bytes, int iter, bool persistent) {
+            MPI_Request req[2];
+            if(persistent) {
+                MPI_Send_init(sendbuf.data(), bytes, MPI_CHAR, partner, 0, calibcomm, &req[0]);
+                MPI_Recv_init(recvbuf.data(), bytes, MPI_CHAR, partner, 0, calibcomm, &req[1]);
+            }
+            MPI_Barrier(calibcomm);
+            auto t1 = std::chrono::steady_clock::now();
+            for(int i = 0; i < iter; ++i) {
+                if(persistent) {
+                    MPI_Startall(2, req);
+                } else {
+                    MPI_Irecv(recvbuf.data(), bytes, MPI_CHAR, partner, 0, calibcomm, &req[1]);
+                    MPI_Isend(sendbuf.data(), bytes, MPI_CHAR, partner, 0, calibcomm, &req[0]);
                 }
-            }));
-            packFutures[haloId].set(future);
-
-            return packFutures[haloId];
-
+                MPI_Waitall(2, req, MPI_STATUSES_IGNORE);
+            }
+            auto t2 = std::chrono::steady_clock::now();
+            if(persistent) {
+                MPI_Request_free(&req[0]);
+                MPI_Request_free(&req[1]);
+            }
+            return std::chrono::duration<double, std::milli>(t2-t1).count()/iter;
+        };
+
+        pingpong(1, 2, false);
+        costAlpha = pingpong(1, iterations, false);
+        costAlphaPersistent = pingpong(1, iterations, true);
+        costBeta = largeSize/std::max(1e-9, pingpong(largeSize, largeIterations, false)-costAlpha);
+
+        MPI_Comm_free(&calibcomm);
+
+        // packing: rows of 8 bytes with a stride of 16 bytes vs one contiguous chunk
+        const int rowSize = 8;
+        const int numRows = largeSize/(2*rowSize);
+
+        auto t1 = std::chrono::steady_clock::now();
+        for(int i = 0; i < largeIterations; ++i)
+            std::memcpy(recvbuf.data(), sendbuf.data(), largeSize);
+        auto t2 = std::chrono::steady_clock::now();
+        for(int i = 0; i < largeIterations; ++i)
+            for(int row = 0; row < numRows; ++row)
+                std::memcpy(&recvbuf[row*rowSize], &sendbuf[2*row*rowSize], rowSize);
+        auto t3 = std::chrono::steady_clock::now();
+
+        const double tContiguous = std::chrono::duration<double, std::milli>(t2-t1).count()/largeIterations;
+        const double tRows = std::chrono::duration<double, std::milli>(t3-t2).count()/largeIterations;
+        costPackBandwidth = largeSize/std::max(1e-9, tContiguous);
+        costPackRow = std::max(0.0, tRows/numRows - rowSize/costPackBandwidth);
+
+        MPI_Datatype vec;
+        MPI_Type_vector(numRows, rowSize, 2*rowSize, MPI_CHAR, &vec);
+        MPI_Type_commit(&vec);
+        int position;
+        t1 = std::chrono::steady_clock::now();
+        for(int i = 0; i < largeIterations; ++i) {
+            position = 0;
+            MPI_Pack(sendbuf.data(), largeSize, MPI_CHAR, recvbuf.data(), largeSize, &position, MPI_COMM_SELF);
         }
+        t2 = std::chrono::steady_clock::now();
+        for(int i = 0; i < largeIterations; ++i) {
+            position = 0;
+            MPI_Pack(sendbuf.data(), 1, vec, recvbuf.data(), largeSize, &position, MPI_COMM_SELF);
+        }
+        t3 = std::chrono::steady_clock::now();
+        MPI_Type_free(&vec);
+
+        const double tDerivedContiguous = std::chrono::duration<double, std::milli>(t2-t1).count()/largeIterations;
+        const double tDerivedRows = std::chrono::duration<double, std::milli>(t3-t2).count()/largeIterations;
+        costDerivedBandwidth = largeSize/std::max(1e-9, tDerivedContiguous);
+        costDerivedRow = std::max(0.0, tDerivedRows/numRows - rowSize/costDerivedBandwidth);
+
+        // average over all ranks
+        double values[8] = {costAlpha, costAlphaPersistent, costBeta, costPackBandwidth, costPackRow, costDerivedBandwidth, costDerivedRow, 0};
+        MPI_Allreduce(MPI_IN_PLACE, values, 8, MPI_DOUBLE, MPI_SUM, TAUSCH_COMM);
+        costAlpha = values[0]/mpiSize;
+        costAlphaPersistent = values[1]/mpiSize;
+        costBeta = values[2]/mpiSize;
+        costPackBandwidth = values[3]/mpiSize;
+        costPackRow = values[4]/mpiSize;
+        costDerivedBandwidth = values[5]/mpiSize;
+        costDerivedRow = values[6]/mpiSize;
+
+        costModelCalibrated = true;
 
     }
 
-    /***********************************************************************/
-    /*                            SEND MESSAGE                             */
-    /***********************************************************************/
-
     /**
      * @brief
-     * Send a given halo data off.
+     * Predict the time needed for sending a halo.
      *
-     * Send a given halo data off.
+     * This includes packing the data and sending it.
      *
      * @param haloId
      * The halo id returned by the addSendHaloInfo() member function.
-     * @param msgtag
-     * The message tag to be used by this communication. For CPU-CPU communication this is the same
-     * as an MPI tag.
-     * @param remoteMpiRank
-     * The receiving MPI rank.
-     * @param bufferId
-     * The id of the current buffer (numbered starting at 0).
-     * @param blocking
-     * If set to true Tausch will block until the send routine has been fully received. If set to
-     * false this routine will return immediately and the data will be sent in the background.
-     * @param communicator
-     * If a communicator is specified here then Tausch will ignore the global communicator set
-     * during construction.
      *
      * @return
-     * Returns the Status object containing a handle for this operation.
+     * The predicted time in ms using the current strategy, or -1 if the cost model has not been calibrated.
      */
-    inline Status send(size_t haloId, const int msgtag, const int remoteMpiRank = -1, const int bufferId = -1, const bool blocking = false, MPI_Comm communicator = MPI_COMM_NULL) {
-
-        if(sendHaloIndicesSizeTotal[haloId] == 0) {
-            sendHaloMpiRequests[haloId][0] = MPI_REQUEST_NULL;
-            return Status(MPI_REQUEST_NULL);
-        }
-
-        if((handleOutOfSync&OutOfSync::DontCheck) != OutOfSync::DontCheck) {
-
-            if((handleOutOfSync&OutOfSync::WarnMe) == OutOfSync::WarnMe) {
-                if(packFutures[haloId].isRunning())
-                    std::cout << "Warning: Halo " << haloId << " has not finished packing..." << std::endl;
-            }
-
-            if((handleOutOfSync&OutOfSync::Wait) == OutOfSync::Wait) {
-                if(packFutures[haloId].isRunning())
-                    packFutures[haloId].wait();
-            }
-
-        }
-
-        if(communicator == MPI_COMM_NULL)
-            communicator = TAUSCH_COMM;
-
-        int useRemoteMpiRank = sendHaloRemoteRank.at(haloId);
-        if(remoteMpiRank != -1)
-            useRemoteMpiRank = remoteMpiRank;
-
-        // if we stay on the same rank, we don't need to use MPI
-        int myRank;
-        MPI_Comm_rank(communicator, &myRank);
-        if(useRemoteMpiRank == myRank && (sendHaloCommunicationStrategy[haloId]&Communication::TryDirectCopy) == Communication::TryDirectCopy) {
-            msgtagToHaloId[myRank*1000000 + msgtag] = haloId;
-            return Status(MPI_REQUEST_NULL);
-        }
-
-        int useBufferId = 0;
-        if((sendHaloCommunicationStrategy[haloId]&Communication::DerivedMpiDatatype) == Communication::DerivedMpiDatatype)
-            useBufferId = bufferId;
-
-        // Take this path if we are to use MPI persistent communication
-        // Depending on the implementation this can be a good or bad idea.
-        // Using persistent communication could pin the communication protocol to eager (tends to bad performance for larger messages)
-        if((sendHaloCommunicationStrategy[haloId]&Communication::MPIPersistent) == Communication::MPIPersistent) {
-
-            if(!sendHaloMpiSetup[haloId][useBufferId]) {
-
-                sendHaloMpiSetup[haloId][useBufferId] = true;
-
-#ifdef TAUSCH_CUDA
-                if((sendHaloCommunicationStrategy[haloId]&Communication::CUDAAwareMPI) == Communication::CUDAAwareMPI) {
-
-                    MPI_Send_init(cudaSendBuffer[haloId], sendHaloIndicesSizeTotal[haloId], MPI_CHAR,
-                                  useRemoteMpiRank, msgtag, communicator,
-                                  &sendHaloMpiRequests[haloId][0]);
-
-                } else
-#endif
-                if((sendHaloCommunicationStrategy[haloId]&Communication::DerivedMpiDatatype) == Communication::DerivedMpiDatatype)
-                    MPI_Send_init(sendHaloBuffer[haloId][useBufferId], 1, sendHaloDerivedDatatype[haloId][useBufferId],
-                                  useRemoteMpiRank, msgtag, communicator,
-                                  &sendHaloMpiRequests[haloId][useBufferId]);
-                else
-                    MPI_Send_init(sendBuffer[haloId], sendHaloIndicesSizeTotal[haloId], MPI_CHAR,
-                                  useRemoteMpiRank, msgtag, communicator,
-                                  &sendHaloMpiRequests[haloId][0]);
-
-            } else
-
-                MPI_Wait(&sendHaloMpiRequests[haloId][useBufferId], MPI_STATUS_IGNORE);
-
-            MPI_Start(&sendHaloMpiRequests[haloId][useBufferId]);
-
-        // Take this path to use normal Isend/Irecv communication
-        // This is the default.
-        } else {
-
-#ifdef TAUSCH_CUDA
-            if((sendHaloCommunicationStrategy[haloId]&Communication::CUDAAwareMPI) == Communication::CUDAAwareMPI) {
-
-                MPI_Isend(cudaSendBuffer[haloId], sendHaloIndicesSizeTotal[haloId], MPI_CHAR,
-                          useRemoteMpiRank, msgtag, communicator,
-                          &sendHaloMpiRequests[haloId][0]);
+    inline double predictSendTime(const size_t haloId) {
+        if(!costModelCalibrated)
+            return -1;
+        return predictPackTime(true, haloId, sendHaloCommunicationStrategy[haloId]) + predictWireTime(true, haloId, sendHaloCommunicationStrategy[haloId]);
+    }
 
-            } else
-#endif
+    /**
+     * @brief
+     * Predict the time needed for receiving a halo.
+     *
+     * This includes receiving the data and unpacking it.
+     *
+     * @param haloId
+     * The halo id returned by the addRecvHaloInfo() member function.
+     *
+     * @return
+     * The predicted time in ms using the current strategy, or -1 if the cost model has not been calibrated.
+     */
+    inline double predictRecvTime(const size_t haloId) {
+        if(!costModelCalibrated)
+            return -1;
+        return predictPackTime(false, haloId, recvHaloCommunicationStrategy[haloId]) + predictWireTime(false, haloId, recvHaloCommunicationStrategy[haloId]);
+    }
 
-                if((sendHaloCommunicationStrategy[haloId]&Communication::DerivedMpiDatatype) == Communication::DerivedMpiDatatype)
-                    MPI_Isend(sendHaloBuffer[haloId][useBufferId], 1, sendHaloDerivedDatatype[haloId][useBufferId],
-                              useRemoteMpiRank, msgtag, communicator,
-                              &sendHaloMpiRequests[haloId][useBufferId]);
-                else
-                    MPI_Isend(sendBuffer[haloId], sendHaloIndicesSizeTotal[haloId], MPI_CHAR,
-                              useRemoteMpiRank, msgtag, communicator,
-                              &sendHaloMpiRequests[haloId][0]);
+    /**
+     * @brief
+     * Predict the time needed for one full exchange of all halos.
+     *
+     * All messages are assumed to share the bandwidth, the latencies and packing/unpacking of all
+     * halos add up.
+     *
+     * @return
+     * The predicted time in ms, or -1 if the cost model has not been calibrated.
+     */
+    inline double predictExchangeTime() {
 
-        }
+        if(!costModelCalibrated)
+            return -1;
 
-        if(blocking)
-            MPI_Wait(&sendHaloMpiRequests[haloId][useBufferId], MPI_STATUS_IGNORE);
+        double t = 0;
+        for(size_t haloId = 0; haloId < sendBuffer.size(); ++haloId)
+            t += predictSendTime(haloId);
+        for(size_t haloId = 0; haloId < recvBuffer.size(); ++haloId)
+            t += predictRecvTime(haloId);
 
-        return Status(sendHaloMpiRequests[haloId][0]);
+        return t;
 
     }
 
-    /***********************************************************************/
-    /*                         RECEIVE MESSAGE                             */
-    /***********************************************************************/
+    /**
+     * @brief
+     * Choose a strategy for sending a halo based on the cost model.
+     *
+     * Compares packing by Tausch against packing by MPI (derived datatypes) and normal against
+     * persistent requests. Note that DerivedMpiDatatype and DerivedMpiDatatypeSingleMessage require
+     * the halo buffers to be set using setSendHaloBuffer(), thus the returned strategy is not applied automatically.
+     *
+     * @param haloId
+     * The halo id returned by the addSendHaloInfo() member function.
+     *
+     * @return
+     * The predicted fastest strategy (Default if the cost model has not been calibrated).
+     */
+    inline Communication chooseSendCommunicationStrategy(const size_t haloId) {
+        return chooseCommunicationStrategy(true, haloId);
+    }
 
     /**
      * @brief
-     * Receives a given halo.
+     * Choose a strategy for receiving a halo based on the cost model.
      *
-     * Receives a given halo.
+     * See chooseSendCommunicationStrategy().
      *
      * @param haloId
      * The halo id returned by the addRecvHaloInfo() member function.
-     * @param msgtag
-     * The message tag to be used by this communication. For CPU-CPU communication this is the same
-     * as an MPI tag.
-     * @param remoteMpiRank
-     * The sending MPI rank.
-     * @param bufferId
-     * The id of the current buffer (numbered starting at 0).
-     * @param blocking
-     * If set to true Tausch will block until the receive routine has been fully completed. If set
-     * to false this routine will return immediately and the data will be received in the
-     * background (the MPI_Request can be tested to check for completion).
-     * @param communicator
-     * If a communicator is specified here then Tausch will ignore the global communicator set
-     * during construction.
      *
      * @return
-     * Returns the Status object containing a handle for this operation.
+     * The predicted fastest strategy (Default if the cost model has not been calibrated).
      */
-    inline Status recv(size_t haloId, const int msgtag, const int remoteMpiRank = -1, const int bufferId = -1, const bool blocking = true, MPI_Comm communicator = MPI_COMM_NULL) {
-
-        if(recvHaloIndicesSizeTotal[haloId] == 0) {
-            recvHaloMpiRequests[haloId][0] = MPI_REQUEST_NULL;
-            return Status(MPI_REQUEST_NULL);
-        }
-
-        if(communicator == MPI_COMM_NULL)
-            communicator = TAUSCH_COMM;
+    inline Communication chooseRecvCommunicationStrategy(const size_t haloId) {
+        return chooseCommunicationStrategy(false, haloId);
+    }
 
-        int useRemoteMpiRank = recvHaloRemoteRank.at(haloId);
-        if(remoteMpiRank != -1)
-            useRemoteMpiRank = remoteMpiRank;
+    /**
+     * @brief
+     * Print a report of the predicted exchange times.
+     *
+     * Lists the predicted packing and wire time of each halo together with the suggested strategy,
+     * halos where packing takes longer than sending the data are flagged.
+     *
+     * @param out
+     * Where to write the report to.
+     */
+    inline void printCostModelReport(std::ostream &out = std::cout) {
 
-        // if we stay on the same rank, we don't need to use MPI
-        int myRank;
-        MPI_Comm_rank(communicator, &myRank);
-        if(useRemoteMpiRank == myRank && (recvHaloCommunicationStrategy[haloId]&Communication::TryDirectCopy) == Communication::TryDirectCopy) {
-            const int remoteHaloId = msgtagToHaloId[myRank*1000000 + msgtag];
-            std::memcpy(recvBuffer[haloId], sendBuffer[remoteHaloId], recvHaloIndicesSizeTotal[haloId]);
-            return Status(MPI_REQUEST_NULL);
+        if(!costModelCalibrated) {
+            out << "Tausch::printCostModelReport(): Cost model has not been calibrated, call calibrateCostModel() first" << std::endl;
+            return;
         }
 
-        int useBufferId = 0;
-        if((recvHaloCommunicationStrategy[haloId]&Communication::DerivedMpiDatatype) == Communication::DerivedMpiDatatype)
-            useBufferId = bufferId;
+        int myRank;
+        MPI_Comm_rank(TAUSCH_COMM, &myRank);
 
-        // Take this path if we are to use MPI persistent communication
-        // Depending on the implementation this can be a good or bad idea.
-        // Using persistent communication could pin the communication protocol to eager (tends to bad performance for larger messages)
-        if((recvHaloCommunicationStrategy[haloId]&Communication::MPIPersistent) == Communication::MPIPersistent) {
+        out << " ** Cost model of rank " << myRank << " (latency: " << costAlpha << " ms, persistent latency: " << costAlphaPersistent
+            << " ms, bandwidth: " << costBeta*1e-6 << " GB/s)" << std::endl;
 
-            if(!recvHaloMpiSetup[haloId][useBufferId]) {
+        for(int isSend = 1; isSend >= 0; --isSend) {
 
-                recvHaloMpiSetup[haloId][useBufferId] = true;
+            const size_t numHalos = (isSend ? sendBuffer.size() : recvBuffer.size());
 
-#ifdef TAUSCH_CUDA
-                if((recvHaloCommunicationStrategy[haloId]&Communication::CUDAAwareMPI) == Communication::CUDAAwareMPI) {
+            for(size_t haloId = 0; haloId < numHalos; ++haloId) {
 
-                    MPI_Recv_init(cudaRecvBuffer[haloId], recvHaloIndicesSizeTotal[haloId], MPI_CHAR,
-                                  useRemoteMpiRank, msgtag, communicator,
-                                  &recvHaloMpiRequests[haloId][0]);
+                const Communication strategy = (isSend ? sendHaloCommunicationStrategy[haloId] : recvHaloCommunicationStrategy[haloId]);
+                const double tPack = predictPackTime(isSend, haloId, strategy);
+                const double tWire = predictWireTime(isSend, haloId, strategy);
 
-                } else
-#endif
-                if((recvHaloCommunicationStrategy[haloId]&Communication::DerivedMpiDatatype) == Communication::DerivedMpiDatatype)
-                    MPI_Recv_init(recvHaloBuffer[haloId][useBufferId], 1, recvHaloDerivedDatatype[haloId][useBufferId],
-                                  useRemoteMpiRank, msgtag, communicator,
-                                  &recvHaloMpiRequests[haloId][useBufferId]);
-                else
-                    MPI_Recv_init(recvBuffer[haloId], recvHaloIndicesSizeTotal[haloId], MPI_CHAR,
-                                  useRemoteMpiRank, msgtag, communicator,
-                                  &recvHaloMpiRequests[haloId][0]);
+                out << "   > " << (isSend ? "send" : "recv") << " halo " << haloId << ": "
+                    << (isSend ? sendHaloIndicesSizeTotal[haloId] : recvHaloIndicesSizeTotal[haloId]) << " bytes, "
+                    << (isSend ? "pack " : "unpack ") << tPack << " ms, wire " << tWire << " ms, suggested strategy "
+                    << getCommunicationStrategyName(chooseCommunicationStrategy(isSend, haloId))
+                    << (tPack > tWire ? "  <-- packing outweighs wire time" : "") << std::endl;
 
-            } else
-                MPI_Wait(&recvHaloMpiRequests[haloId][useBufferId], MPI_STATUS_IGNORE);
+            }
 
-            MPI_Start(&recvHaloMpiRequests[haloId][useBufferId]);
+        }
 
-        // Take this path to use normal Isend/Irecv communication
-        // This is the default.
-        } else {
+    }
 
-#ifdef TAUSCH_CUDA
-            if((recvHaloCommunicationStrategy[haloId]&Communication::CUDAAwareMPI) == Communication::CUDAAwareMPI) {
 
-                MPI_Irecv(cudaRecvBuffer[haloId], recvHaloIndicesSizeTotal[haloId], MPI_CHAR,
-                          useRemoteMpiRank, msgtag, communicator,
-                          &recvHaloMpiRequests[haloId][0]);
+    /***********************************************************************/
+    /*                            THREAD SAFETY                            */
+    /***********************************************************************/
 
-            } else
-#endif
-            if((recvHaloCommunicationStrategy[haloId]&Communication::DerivedMpiDatatype) == Communication::DerivedMpiDatatype)
-                MPI_Irecv(recvHaloBuffer[haloId][useBufferId], 1, recvHaloDerivedDatatype[haloId][useBufferId],
-                          useRemoteMpiRank, msgtag, communicator,
-                          &recvHaloMpiRequests[haloId][useBufferId]);
-            else
-                MPI_Irecv(recvBuffer[haloId], recvHaloIndicesSizeTotal[haloId], MPI_CHAR,
-                          useRemoteMpiRank, msgtag, communicator,
-                          &recvHaloMpiRequests[haloId][0]);
+    /**
+     * @brief
+     * Tells Tausch whether it is used concurrently from multiple threads.
+     *
+     * In thread-safe mode packing, sending, receiving and unpacking of <b>different</b> halos can be
+     * called concurrently from different threads (e.g., OpenMP threads each taking care of some of
+     * the halos). Most state touched by these operations is kept per halo, the state shared between
+     * halos is guarded by one mutex each: the lookup table for TryDirectCopy, the buffers of aggregated
+     * messages, the link and arrival times of the network emulation, the outstanding receives through
+     * a custom transport, the lazily created UCX endpoints (the UCX worker is created in multi-threaded
+     * mode), the strategy cache, and the state of partitioned communication.
+     *
+     * Adding/deleting halos, setting strategies, halo buffers, channels, striping, rings, partitions,
+     * transports and network emulation, loading/saving the strategy cache, prewarming, and the
+     * hierarchical exchange and reordering of ranks are setup or collective operations and must not
+     * run concurrently with any other call. MPI needs to be initialized with MPI_THREAD_MULTIPLE for
+     * this to work, a warning is printed otherwise.
+     *
+     * @param enable
+     * Whether to enable (true) or disable (false) thread-safe mode.
+     */
+    inline void setThreadSafety(bool enable) {
 
+        if(enable) {
+            int provided;
+            MPI_Query_thread(&provided);
+            if(provided != MPI_THREAD_MULTIPLE)
+                std::cout << "Tausch::setThreadSafety(): Warning, MPI has not been initialized with MPI_THREAD_MULTIPLE" << std::endl;
         }
 
-        if(blocking)
-            MPI_Wait(&recvHaloMpiRequests[haloId][useBufferId], MPI_STATUS_IGNORE);
-
-        return Status(recvHaloMpiRequests[haloId][0]);
+        threadSafe = enable;
 
     }
 
     /***********************************************************************/
-    /*                           UNPACK BUFFER                             */
+    /*                     HANDLING OF RACE CONDITIONS                     */
     /***********************************************************************/
 
     /**
-     * \overload
+     * @brief
+     * Tells Tausch if/how to handle potential race conditions.
      *
-     * Internally the data buffer will be recast to unsigned char.
+     * Tells Tausch if/how to handle potential race conditions. The handling can be any one of the OutOfSync enum.
+     *
+     * @param handling
+     * Value from OutOfSync enum, whether to warn, wait or do nothing.
      */
-    inline Status unpackRecvBuffer(const size_t haloId, const size_t bufferId, double *buf, const bool blocking = true) {
-        return unpackRecvBuffer(haloId, bufferId, reinterpret_cast<unsigned char*>(buf), blocking);
+    void setOutOfSyncHandling(OutOfSync handling) {
+        handleOutOfSync = handling;
     }
 
     /**
-     * \overload
+     * @brief
+     * Return Status object for packing of halo with given haloId.
+     *
+     * Return Status object for packing of halo with given haloId. This can be called at any time as long as the haloId is valid.
+     *
+     * @param haloId
+     * The halo id returned by the addSendHaloInfo() member function.
+     *
+     * @return
+     * The Status object associated with the packing of the given haloId.
      *
-     * Internally the data buffer will be recast to unsigned char.
      */
-    inline Status unpackRecvBuffer(const size_t haloId, const size_t bufferId, int *buf, const bool blocking = true) {
-        return unpackRecvBuffer(haloId, bufferId, reinterpret_cast<unsigned char*>(buf), blocking);
+    Status getPackStatus(int haloId) {
+        return packFutures[haloId];
     }
 
     /**
      * @brief
-     * Unpacks a data buffer for the given halo and buffer id.
+     * Return Status object for unpacking of halo with given haloId.
      *
-     * Unpacks a data buffer for the given halo and buffer id. If this function has been called in a blocking way, then
-     * the received data can be used immediately. Otherwise, make sure to check whether the operation has completed or not.
+     * Return Status object for unpacking of halo with given haloId. This can be called at any time as long as the haloId is valid.
      *
      * @param haloId
      * The halo id returned by the addRecvHaloInfo() member function.
-     * @param bufferId
-     * The id of the current buffer (numbered starting at 0).
-     * @param buf
-     * Pointer to the data buffer.
-     * @param blocking
-     * Whether to do the unpacking in a separate thread or not.
      *
      * @return
-     * A Status object containing information about the unpacking operation is returned.
+     * The Status object associated with the unpacking of the given haloId.
+     *
      */
-    inline Status unpackRecvBuffer(const size_t haloId, const size_t bufferId, unsigned char *buf, const bool blocking = true) {
-
-        if((handleOutOfSync&OutOfSync::DontCheck) != OutOfSync::DontCheck && recvHaloMpiRequests[haloId][0] != MPI_REQUEST_NULL) {
+    Status getUnpackStatus(int haloId) {
+        return unpackFutures[haloId];
+    }
 
-            if((handleOutOfSync&OutOfSync::WarnMe) == OutOfSync::WarnMe) {
 
-                int useBufferId = 0;
-                if((recvHaloCommunicationStrategy[haloId]&Communication::DerivedMpiDatatype) == Communication::DerivedMpiDatatype)
-                    useBufferId = bufferId;
+    /***********************************************************************/
+    /*                          SEND HALO BUFFER                           */
+    /***********************************************************************/
 
-                int flag;
-                MPI_Test(&recvHaloMpiRequests[haloId][useBufferId], &flag, MPI_STATUS_IGNORE);
-                if(!flag)
-                    std::cout << "Warning: Halo " << haloId << " has not finished receiving..." << std::endl;
-
-            }
-
-            if((handleOutOfSync&OutOfSync::Wait) == OutOfSync::Wait) {
-
-                int useBufferId = 0;
-                if((recvHaloCommunicationStrategy[haloId]&Communication::DerivedMpiDatatype) == Communication::DerivedMpiDatatype)
-                    useBufferId = bufferId;
-
-                MPI_Wait(&recvHaloMpiRequests[haloId][useBufferId], MPI_STATUS_IGNORE);
-
-            }
-
-        }
-
-        if(blocking) {
-
-            size_t bufferOffset = 0;
-            for(size_t i = 0; i < bufferId; ++i)
-                bufferOffset += recvHaloIndicesSizePerBuffer[haloId][i];
-
-            size_t mpiRecvBufferIndex = 0;
-
-            for(auto const & region : recvHaloIndices[haloId][bufferId]) {
-
-                const size_t &region_start = region[0];
-                const size_t &region_howmanycols = region[1];
-                const size_t &region_howmanyrows = region[2];
-                const size_t &region_stridecol = region[3];
-
-                for(size_t rows = 0; rows < region_howmanyrows; ++rows) {
-
-                    std::memcpy(&buf[region_start + rows*region_stridecol], &recvBuffer[haloId][bufferOffset + mpiRecvBufferIndex], region_howmanycols);
-                    mpiRecvBufferIndex += region_howmanycols;
-
-                }
-
-            }
-
-            return Status(std::shared_future<void>());
-
-        } else {
-
-            auto future = std::shared_future<void>(std::async(std::launch::async, [=]() {
-
-                size_t bufferOffset = 0;
-                for(size_t i = 0; i < bufferId; ++i)
-                    bufferOffset += recvHaloIndicesSizePerBuffer[haloId][i];
-
-                size_t mpiRecvBufferIndex = 0;
-
-                for(auto const & region : recvHaloIndices[haloId][bufferId]) {
-
-                    const size_t &region_start = region[0];
-                    const size_t &region_howmanycols = region[1];
-                    const size_t &region_howmanyrows = region[2];
-                    const size_t &region_stridecol = region[3];
-
-                    for(size_t rows = 0; rows < region_howmanyrows; ++rows) {
-
-                        std::memcpy(&buf[region_start + rows*region_stridecol], &recvBuffer[haloId][bufferOffset + mpiRecvBufferIndex], region_howmanycols);
-                        mpiRecvBufferIndex += region_howmanycols;
-
-                    }
-
-                }
+    /**
+     * \overload
+     *
+     * Internally the data buffer will be recast to unsigned char.
+     */
+    inline void setSendHaloBuffer(int haloId, int bufferId, int* buf) {
+        setSendHaloBuffer(haloId, bufferId, reinterpret_cast<unsigned char*>(buf));
+    }
 
-            }));
-            unpackFutures[haloId].set(future);
+    /**
+     * \overload
+     *
+     * Internally the data buffer will be recast to unsigned char.
+     */
+    inline void setSendHaloBuffer(int haloId, int bufferId, double* buf) {
+        setSendHaloBuffer(haloId, bufferId, reinterpret_cast<unsigned char*>(buf));
+    }
 
-            return unpackFutures[haloId];
+    /**
+     * @brief
+     * Set a pointer to the sending halo data buffer.
+     *
+     * This sets a pointer to the sending halo data buffer of type unsigned char. This is a
+     * necessary step for certain communication strategies, e.g., using MPI derived data types.
+     *
+     * @param haloId
+     * The halo id returned by the addSendHaloInfo() member function.
+     * @param bufferId
+     * The id of the current buffer (numbered starting at 0).
+     * @param buf
+     * Pointer to the data buffer of type unsigned char.
+     */
+    inline void setSendHaloBuffer(int haloId, int bufferId, unsigned char* buf) {
+        sendHaloBuffer[haloId][bufferId] = buf;
+        // a datatype combining all buffers depends on their addresses
+        if(sendHaloCombinedDatatype.find(haloId) != sendHaloCombinedDatatype.end())
+            freeCombinedDatatype(true, haloId);
+    }
 
-        }
 
-    }
 
     /***********************************************************************/
+    /*                          RECV HALO BUFFER                           */
     /***********************************************************************/
 
-#ifdef TAUSCH_OPENCL
-
-    /** @name OpenCL
-     * The OpenCL routines. In order to use these the macro TAUSCH_OPENCL needs to be defined before including the tausch header.
+    /**
+     * \overload
+     *
+     * Internally the data buffer will be recast to unsigned char.
      */
-    /**@{*/
+    inline void setRecvHaloBuffer(int haloId, int bufferId, int* buf) {
+        setRecvHaloBuffer(haloId, bufferId, reinterpret_cast<unsigned char*>(buf));
+    }
 
-    /***********************************************************************/
-    /*                          SET OPENCL SETUP                           */
-    /***********************************************************************/
+    /**
+     * \overload
+     *
+     * Internally the data buffer will be recast to unsigned char.
+     */
+    inline void setRecvHaloBuffer(int haloId, int bufferId, double* buf) {
+        setRecvHaloBuffer(haloId, bufferId, reinterpret_cast<unsigned char*>(buf));
+    }
 
     /**
      * @brief
-     * Tells Tausch about an existing OpenCL environment.
+     * Set a pointer to the receiving halo data buffer.
      *
-     * Tells Tausch about an existing OpenCL environment. The environment needs to be set up by the user before calling this function.
+     * This sets a pointer to the receiving halo data buffer of type int. This is a necessary step
+     * for certain communication strategies, e.g., using MPI derived data types.
      *
-     * @param ocl_device
-     * The OpenCL device.
-     * @param ocl_context
-     * The OpenCL context.
-     * @param ocl_queue
-     * The OpenCL CommandQueue.
+     * @param haloId
+     * The halo id returned by the addRecvHaloInfo() member function.
+     * @param bufferId
+     * The id of the current buffer (numbered starting at 0).
+     * @param buf
+     * Pointer to the data buffer of type unsigned char.
      */
-    inline void setOpenCL(cl::Device ocl_device, cl::Context ocl_context, cl::CommandQueue ocl_queue) {
-        this->ocl_device = ocl_device;
-        this->ocl_context = ocl_context;
-        this->ocl_queue = ocl_queue;
+    inline void setRecvHaloBuffer(int haloId, int bufferId, unsigned char* buf) {
+        recvHaloBuffer[haloId][bufferId] = buf;
+        // a datatype combining all buffers depends on their addresses
+        if(recvHaloCombinedDatatype.find(haloId) != recvHaloCombinedDatatype.end())
+            freeCombinedDatatype(false, haloId);
     }
 
+
+
+    /***********************************************************************/
+    /*                            NUMA PLACEMENT                           */
+    /***********************************************************************/
+
     /**
      * @brief
-     * Tells Tausch to set up an OpenCL environment.
-     *
-     * Tells Tausch to set up an OpenCL environment. Tausch will use this environment for all subsequent OpenCL operations.
+     * Static member function returning the number of NUMA nodes.
      *
-     * @param deviceNumber
-     * Choose a device number.
+     * Uses libnuma if TAUSCH_NUMA is defined, otherwise /sys on Linux.
      *
      * @return
-     * String containing the name of the chosen OpenCL device.
+     * The number of NUMA nodes, 1 if it cannot be determined.
      */
-    inline std::string enableOpenCL(size_t deviceNumber = 0) {
-        try {
+    static inline int getNumNumaNodes() {
 
-            std::vector<cl::Platform> all_platforms;
-            cl::Platform::get(&all_platforms);
-            cl::Platform ocl_platform = all_platforms[0];
+#ifdef TAUSCH_NUMA
+        if(numa_available() >= 0)
+            return numa_max_node()+1;
+#endif
 
-            std::vector<cl::Device> all_devices;
-            ocl_platform.getDevices(CL_DEVICE_TYPE_ALL, &all_devices);
-            if(deviceNumber >= all_devices.size())
-                deviceNumber = 0;
-            this->ocl_device = all_devices[deviceNumber];
+        int num = 0;
+        while(std::ifstream("/sys/devices/system/node/node" + std::to_string(num) + "/cpulist").good())
+            ++num;
 
-            std::string deviceName = ocl_device.getInfo<CL_DEVICE_NAME>();
+        return std::max(1, num);
 
-            // Create context and queue
-            this->ocl_context = cl::Context({ocl_device});
-            this->ocl_queue = cl::CommandQueue(ocl_context,ocl_device);
+    }
 
-            return deviceName;
+    /**
+     * @brief
+     * Static member function returning the CPUs belonging to a NUMA node.
+     *
+     * Uses libnuma if TAUSCH_NUMA is defined, otherwise /sys on Linux.
+     *
+     * @param node
+     * The NUMA node.
+     *
+     * @return
+     * The ids of the CPUs of the node, empty if it cannot be determined.
+     */
+    static inline std::vector<int> getNumaNodeCpus(const int node) {
+
+        std::vector<int> cpus;
+
+#ifdef TAUSCH_NUMA
+        if(numa_available() >= 0) {
+            struct bitmask *mask = numa_allocate_cpumask();
+            if(numa_node_to_cpus(node, mask) == 0)
+                for(int cpu = 0; cpu < numa_num_possible_cpus(); ++cpu)
+                    if(numa_bitmask_isbitset(mask, cpu))
+                        cpus.push_back(cpu);
+            numa_free_cpumask(mask);
+            return cpus;
+        }
+#endif
 
-        } catch(cl::Error &error) {
-            std::cout << "[enableOpenCL] OpenCL exception caught: " << error.what() << " (" << error.err() << ")" << std::endl;
-            exit(1);
+        // cpulist is a comma separated list of ranges, e.g., 0-15,32-47
+        std::ifstream in("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        std::string range;
+        while(std::getline(in, range, ',')) {
+            const size_t dash = range.find('-');
+            try {
+                const int first = std::stoi(range.substr(0, dash));
+                const int last = (dash == std::string::npos ? first : std::stoi(range.substr(dash+1)));
+                for(int cpu = first; cpu <= last; ++cpu)
+                    cpus.push_back(cpu);
+            } catch(...) {}
         }
 
-        return "";
+        return cpus;
 
     }
 
     /**
      * @brief
-     * Get OpenCL device.
+     * Static member function returning the NUMA node a memory address lives on.
      *
-     * Get OpenCL device.
+     * This can be used to place a staging buffer on the node of the data it packs, see
+     * setSendHaloNumaNode(). Requires TAUSCH_NUMA to be defined.
+     *
+     * @param ptr
+     * The address, e.g., the data buffer of a field.
      *
      * @return
-     * OpenCL device in use by Tausch.
+     * The NUMA node, -1 if it cannot be determined.
      */
-    inline cl::Device getOclDevice() {
-        return ocl_device;
+    static inline int getNumaNodeOfAddress(const void *ptr) {
+
+#ifdef TAUSCH_NUMA
+        int node = -1;
+        if(numa_available() >= 0 && get_mempolicy(&node, nullptr, 0, const_cast<void*>(ptr), MPOL_F_NODE|MPOL_F_ADDR) == 0)
+            return node;
+#else
+        (void)ptr;
+#endif
+
+        return -1;
+
     }
 
     /**
      * @brief
-     * Get OpenCL context.
+     * Static member function pinning the calling thread to the CPUs of a NUMA node.
      *
-     * Get OpenCL context.
+     * Only supported on Linux.
+     *
+     * @param node
+     * The NUMA node.
      *
      * @return
-     * OpenCL context in use by Tausch.
+     * Whether the thread has been pinned.
      */
-    inline cl::Context getOclContext() {
-        return ocl_context;
+    static inline bool pinThreadToNumaNode(const int node) {
+
+#ifdef __linux__
+        const std::vector<int> cpus = getNumaNodeCpus(node);
+        if(cpus.size() == 0)
+            return false;
+
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for(int cpu : cpus)
+            if(cpu < CPU_SETSIZE)
+                CPU_SET(cpu, &set);
+
+        return (sched_setaffinity(0, sizeof(set), &set) == 0);
+#else
+        (void)node;
+        return false;
+#endif
+
     }
 
     /**
-     * @brief
-     * Get OpenCL command queue.
+     * \overload
      *
-     * Get OpenCL command queue.
+     * Places the staging buffer of a send halo, see setHaloNumaNode().
+     */
+    inline void setSendHaloNumaNode(const size_t haloId, const int node, const bool pinThreads = true) {
+        setHaloNumaNode(true, haloId, node, pinThreads);
+    }
+
+    /**
+     * \overload
      *
-     * @return
-     * OpenCL command queue in use by Tausch.
+     * Places the staging buffer of a recv halo, see setHaloNumaNode().
      */
-    inline cl::CommandQueue getOclQueue() {
-        return ocl_queue;
+    inline void setRecvHaloNumaNode(const size_t haloId, const int node, const bool pinThreads = true) {
+        setHaloNumaNode(false, haloId, node, pinThreads);
+    }
+
+    /***********************************************************************/
+    /*                             PACK BUFFER                             */
+    /***********************************************************************/
+
+    /**
+     * \overload
+     *
+     * Internally the data buffer will be recast to unsigned char.
+     */
+    inline Status packSendBuffer(const size_t haloId, const size_t bufferId, const double *buf, const bool blocking = true) {
+        return packSendBuffer(haloId, bufferId, reinterpret_cast<const unsigned char*>(buf), blocking);
+    }
+
+    /**
+     * \overload
+     *
+     * Internally the data buffer will be recast to unsigned char.
+     */
+    inline Status packSendBuffer(const size_t haloId, const size_t bufferId, const int *buf, const bool blocking = true) {
+        return packSendBuffer(haloId, bufferId, reinterpret_cast<const unsigned char*>(buf), blocking);
     }
 
     /**
      * @brief
-     * Packs an OpenCL buffer for the given halo and buffer id.
+     * Packs a data buffer for the given halo and buffer id.
      *
-     * Packs an OpenCL buffer for the given halo and buffer id. If this function has been called in a blocking way,
-     * then the OpenCL buffer is immediately free to be used and changed as desired. Otherwise, please make sure the oepration has
-     * completed before using the buffer.
+     * Packs a data buffer for the given halo and buffer id. Once the packing has completed the
+     * data buffer is free to be used and changed as desired.
      *
      * @param haloId
      * The halo id returned by the addSendHaloInfo() member function.
      * @param bufferId
      * The id of the current buffer (numbered starting at 0).
      * @param buf
-     * Handler of the OpenCL buffer.
+     * Pointer to the data buffer.
      * @param blocking
-     * Whether to pack the data blocking or not.
+     * Whether to do the packing in a separate thread or not.
      *
      * @return
-     * The Status object associated with the packing process.
+     * A Status object containing information about the packing operation is returned.
      */
+    inline Status packSendBuffer(const size_t haloId, const size_t bufferId, const unsigned char *buf, const bool blocking = true) {
 
-    inline Status packSendBufferOCL(const size_t haloId, const size_t bufferId, cl::Buffer buf, const bool blocking = true) {
-
-        cl::UserEvent ev(ocl_context);
-
-        if(sendHaloIndicesSizePerBuffer[haloId][bufferId] == 0)
-            return Status(ev);
-
-        size_t bufferOffset = 0;
-        for(size_t i = 0; i < bufferId; ++i)
-            bufferOffset += sendHaloIndicesSizePerBuffer[haloId][i];
-
-        size_t mpiSendBufferIndex = 0;
-
-        if((sendHaloCommunicationStrategy[haloId]&Communication::GPUMultiCopy) == Communication::GPUMultiCopy) {
-
-            for(auto const & region : sendHaloIndices[haloId][bufferId]) {
-
-                const size_t &region_start = region[0];
-                const size_t &region_howmanycols = region[1];
-                const size_t &region_howmanyrows = region[2];
-                const size_t &region_striderow = region[3];
-
-                cl::size_t<3> buffer_offset;
-                buffer_offset[0] = region_start; // dest starting index in bytes
-                buffer_offset[1] = 0; buffer_offset[2] = 0;
-                cl::size_t<3> host_offset;
-                host_offset[0] = bufferOffset+mpiSendBufferIndex; // host starting index in bytes
-                host_offset[1] = 0; host_offset[2] = 0;
-
-                cl::size_t<3> reg;
-                reg[0] = region_howmanycols; // how many bytes in one row
-                reg[1] = region_howmanyrows; // how many rows
-                reg[2] = 1; // leave at 1
-
-                ocl_queue.enqueueReadBufferRect(buf, blocking, buffer_offset, host_offset, reg,
-                                                region_striderow, // dest stride
-                                                0,
-                                                region_howmanycols,  // host stride
-                                                0,
-                                                sendBuffer[haloId],
-                                                NULL, &ev);
-
+        if(blocking) {
 
-                mpiSendBufferIndex += region_howmanyrows*region_howmanycols;
+            packBuffer(haloId, bufferId, buf);
 
-            }
+            return Status(std::shared_future<void>());
 
         } else {
 
-            cl::Buffer tmpSendBuffer(ocl_context, CL_MEM_READ_WRITE, sendHaloIndicesSizePerBuffer[haloId][bufferId]*sizeof(unsigned char));
+            auto future = std::shared_future<void>(std::async(std::launch::async, [=]() {
 
-            for(auto const & region : sendHaloIndices[haloId][bufferId]) {
+                pinWorkerThread(true, haloId);
 
-                const size_t &region_start = region[0];
-                const size_t &region_howmanycols = region[1];
-                const size_t &region_howmanyrows = region[2];
-                const size_t &region_striderow = region[3];
+                packBuffer(haloId, bufferId, buf);
 
-                cl::size_t<3> src_origin;
-                src_origin[0] = region_start*sizeof(unsigned char);
-                src_origin[1] = 0;
-                src_origin[2] = 0;
-                cl::size_t<3> dst_origin;
-                dst_origin[0] = (mpiSendBufferIndex)*sizeof(unsigned char);
-                dst_origin[1] = 0;
-                dst_origin[2] = 0;
-                cl::size_t<3> reg;
-                reg[0] = region_howmanycols*sizeof(unsigned char);
-                reg[1] = region_howmanyrows;
-                reg[2] = 1;
+            }));
+            packFutures[haloId].set(future);
 
-                ocl_queue.enqueueCopyBufferRect(buf, tmpSendBuffer,
-                                                src_origin, dst_origin, reg,
-                                                region_striderow, // dest stride
-                                                0,
-                                                region_howmanycols,  // host stride
-                                                0);
+            return packFutures[haloId];
 
-                mpiSendBufferIndex += region_howmanyrows*region_howmanycols;
+        }
 
-            }
+    }
 
-            ocl_queue.enqueueReadBuffer(tmpSendBuffer, blocking,
-                                        0, sendHaloIndicesSizePerBuffer[haloId][bufferId]*sizeof(unsigned char),
-                                        &sendBuffer[haloId][bufferOffset],
-                                        NULL, &ev);
-        }
+    /***********************************************************************/
+    /*                         PACK MULTIPLE BUFFERS                       */
+    /***********************************************************************/
 
-        return Status(ev);
+    /**
+     * \overload
+     *
+     * Internally the data buffers will be recast to unsigned char.
+     */
+    inline Status packSendBuffers(const size_t haloId, const std::vector<const double*> &bufs, const bool blocking = true) {
+        std::vector<const unsigned char*> ucbufs;
+        for(auto b : bufs)
+            ucbufs.push_back(reinterpret_cast<const unsigned char*>(b));
+        return packSendBuffers(haloId, ucbufs, blocking);
+    }
 
+    /**
+     * \overload
+     *
+     * Internally the data buffers will be recast to unsigned char.
+     */
+    inline Status packSendBuffers(const size_t haloId, const std::vector<const int*> &bufs, const bool blocking = true) {
+        std::vector<const unsigned char*> ucbufs;
+        for(auto b : bufs)
+            ucbufs.push_back(reinterpret_cast<const unsigned char*>(b));
+        return packSendBuffers(haloId, ucbufs, blocking);
     }
 
     /**
      * @brief
-     * Unpacks an OpenCL buffer for the given halo and buffer id.
-     *
-     * Unpacks an OpenCL buffer for the given halo and buffer id. If this function has been called in a blocking way,
-     * then the received data can be used immediately. Otherwise, please make sure the oepration has completed before
-     * using the buffer.
+     * Packs all data buffers of the given halo at once.
      *
+     * This is equivalent to calling packSendBuffer() for each buffer id, buf with buffer i being
+     * bufs[i]. If all buffers share the same halo indices and type size, the region list is only
+     * traversed once for all buffers. If the halo is large enough (see
+     * setMultiFieldParallelThreshold()), the buffers are split into groups packed concurrently.
+     * The layout of the send buffer is unchanged.
      *
      * @param haloId
-     * The halo id returned by the addRecvHaloInfo() member function.
-     * @param bufferId
-     * The id of the current buffer (numbered starting at 0).
-     * @param buf
-     * Handler of the OpenCL buffer.
+     * The halo id returned by the addSendHaloInfo() member function.
+     * @param bufs
+     * Pointers to the data buffers, one per buffer id.
      * @param blocking
-     * Whether to unpack the data blocking or not.
+     * Whether to do the packing in a separate thread or not.
      *
      * @return
-     * The Status object associated with the unpacking process.
+     * A Status object containing information about the packing operation is returned.
      */
-    inline Status unpackRecvBufferOCL(const size_t haloId, const size_t bufferId, cl::Buffer buf, const bool blocking = true) {
-
-        cl::UserEvent ev(ocl_context);
-
-        if(recvHaloIndicesSizePerBuffer[haloId][bufferId] == 0)
-            return Status(ev);
-
-        size_t bufferOffset = 0;
-        for(size_t i = 0; i < bufferId; ++i)
-            bufferOffset += recvHaloIndicesSizePerBuffer[haloId][i];
-
-        size_t mpiRecvBufferIndex = 0;
-
-        if((recvHaloCommunicationStrategy[haloId]&Communication::GPUMultiCopy) == Communication::GPUMultiCopy) {
-
-            for(auto const & region : recvHaloIndices[haloId][bufferId]) {
-
-                const size_t &region_start = region[0];
-                const size_t &region_howmanycols = region[1];
-                const size_t &region_howmanyrows = region[2];
-                const size_t &region_striderow = region[3];
-
-                cl::size_t<3> buffer_offset;
-                buffer_offset[0] = region_start; // dest starting index in bytes
-                buffer_offset[1] = 0; buffer_offset[2] = 0;
-                cl::size_t<3> host_offset;
-                host_offset[0] = bufferOffset+mpiRecvBufferIndex; // host starting index in bytes
-                host_offset[1] = 0; host_offset[2] = 0;
-
-                cl::size_t<3> reg;
-                reg[0] = region_howmanycols; // how many bytes in one row
-                reg[1] = region_howmanyrows; // how many rows
-                reg[2] = 1; // leave at 1
+    inline Status packSendBuffers(const size_t haloId, const std::vector<const unsigned char*> &bufs, const bool blocking = true) {
 
-                ocl_queue.enqueueWriteBufferRect(buf, blocking, buffer_offset, host_offset, reg,
-                                                 region_striderow, // dest stride
-                                                 0,
-                                                 region_howmanycols,  // host stride
-                                                 0,
-                                                 recvBuffer[haloId],
-                                                 NULL, &ev);
+        auto pack = [=]() {
+            forEachFieldGroup(bufs.size(), sendHaloIndicesSizeTotal[haloId], getThreadNumaNode(true, haloId), [=](const size_t first, const size_t last) {
+                packSendBufferFields(haloId, bufs, first, last);
+            });
+        };
 
+        if(blocking) {
 
-                mpiRecvBufferIndex += region_howmanyrows*region_howmanycols;
+            pack();
 
-            }
+            return Status(std::shared_future<void>());
 
         } else {
 
-            cl::Buffer tmpRecvBuffer(ocl_context, CL_MEM_READ_WRITE, recvHaloIndicesSizePerBuffer[haloId][bufferId]*sizeof(unsigned char));
-            // this has to stay blocking in order to be able to distribute it below
-            cl::copy(ocl_queue, &recvBuffer[haloId][bufferOffset], &recvBuffer[haloId][bufferOffset + recvHaloIndicesSizePerBuffer[haloId][bufferId]], tmpRecvBuffer);
-
-            for(auto const & region : recvHaloIndices[haloId][bufferId]) {
-
-                const size_t &region_start = region[0];
-                const size_t &region_howmanycols = region[1];
-                const size_t &region_howmanyrows = region[2];
-                const size_t &region_striderow = region[3];
-
-                cl::size_t<3> src_origin;
-                src_origin[0] = (mpiRecvBufferIndex)*sizeof(unsigned char);
-                src_origin[1] = 0;
-                src_origin[2] = 0;
-                cl::size_t<3> dst_origin;
-                dst_origin[0] = region_start*sizeof(unsigned char);
-                dst_origin[1] = 0;
-                dst_origin[2] = 0;
-                cl::size_t<3> reg;
-                reg[0] = region_howmanycols*sizeof(unsigned char);
-                reg[1] = region_howmanyrows;
-                reg[2] = 1;
-
-                ocl_queue.enqueueCopyBufferRect(tmpRecvBuffer, buf,
-                                                src_origin, dst_origin, reg,
-                                                region_howmanycols, // dest stride
-                                                0,
-                                                region_striderow,  // host stride
-                                                0);
-
-                mpiRecvBufferIndex += region_howmanyrows*region_howmanycols;
+            auto future = std::shared_future<void>(std::async(std::launch::async, [=]() {
+                pinWorkerThread(true, haloId);
+                pack();
+            }));
+            packFutures[haloId].set(future);
 
-            }
+            return packFutures[haloId];
 
         }
 
-        return Status(ev);
-
     }
 
-    /**@}*/
-
-#endif
-
-    /***********************************************************************/
-    /***********************************************************************/
-
-#ifdef TAUSCH_CUDA
-
-    /** @name CUDA
-     * The CUDA routines. In order to use these the macro TAUSCH_CUDA needs to be defined before including the tausch header.
-     */
-    /**@{*/
-
-    /***********************************************************************/
-    /*                         PACK BUFFER (CUDA)                          */
-    /***********************************************************************/
-
     /**
-     * \overload
+     * @brief
+     * Sets the size above which multiple buffers are packed/unpacked concurrently.
      *
-     * Internally the CUDA buffer will be recast to unsigned char.
+     * Used by packSendBuffers() and unpackRecvBuffers(). Spawning threads only pays off for
+     * large halos, below this total halo size (in bytes) all buffers are handled by the calling
+     * thread.
+     *
+     * @param bytes
+     * The minimum total halo size in bytes. Default is 2 MiB.
+     * @param maxThreads
+     * The maximum number of threads used, 0 uses the available hardware concurrency.
      */
-    inline Status packSendBufferCUDA(const size_t haloId, const size_t bufferId, const double *buf, const bool blocking = true, cudaStream_t stream = 0) {
-        return packSendBufferCUDA(haloId, bufferId, reinterpret_cast<const unsigned char*>(buf), blocking, stream);
+    inline void setMultiFieldParallelThreshold(const size_t bytes, const int maxThreads = 0) {
+        multiFieldParallelThreshold = bytes;
+        multiFieldMaxThreads = maxThreads;
     }
 
     /**
-     * \overload
-     *
-     * Internally the CUDA buffer will be recast to unsigned char.
+     * @brief
+     * Sets the size thresholds of the cache-aware packing and unpacking.
+     *
+     * Halos of at least nonTemporalPackSize bytes are packed using non-temporal stores (with
+     * SSE2). These only pay off once the staging buffer does not fit into the last-level cache
+     * anyway, for smaller halos they slow down packing and evict the data MPI reads next. Recv
+     * halos of at least prefetchUnpackSize bytes are unpacked while prefetching the rows
+     * prefetchDistance rows ahead. This only affects halo regions copied row by row, not fragmented
+     * halos using element offsets.
+     *
+     * @param nonTemporalPackSize
+     * The minimum send halo size in bytes for non-temporal stores. Default is twice the size of the
+     * last-level cache (see defaultNonTemporalPackThreshold()).
+     * @param prefetchUnpackSize
+     * The minimum recv halo size in bytes for software prefetching. Default is 256 KiB.
+     * @param prefetchDistance
+     * How many rows ahead to prefetch. Default is 4.
      */
-    inline Status packSendBufferCUDA(const size_t haloId, const size_t bufferId, const int *buf, const bool blocking = true, cudaStream_t stream = 0) {
-        return packSendBufferCUDA(haloId, bufferId, reinterpret_cast<const unsigned char*>(buf), blocking, stream);
+    inline void setCacheAwareThresholds(const size_t nonTemporalPackSize, const size_t prefetchUnpackSize, const size_t prefetchDistance = 4) {
+        nonTemporalPackThreshold = nonTemporalPackSize;
+        unpackPrefetchThreshold = prefetchUnpackSize;
+        this->prefetchDistance = prefetchDistance;
     }
 
+    /***********************************************************************/
+    /*                            SEND MESSAGE                             */
+    /***********************************************************************/
+
     /**
      * @brief
-     * Packs a CUDA buffer for the given halo and buffer id.
+     * Send a given halo data off.
      *
-     * Packs a CUDA buffer for the given halo and buffer id. Once this function has been called the
-     * CUDA buffer is free to be used and changed as desired.
+     * Send a given halo data off.
      *
      * @param haloId
      * The halo id returned by the addSendHaloInfo() member function.
+     * @param msgtag
+     * The message tag to be used by this communication. For CPU-CPU communication this is the same
+     * as an MPI tag.
+     * @param remoteMpiRank
+     * The receiving MPI rank.
      * @param bufferId
      * The id of the current buffer (numbered starting at 0).
-     * @param buf
-     * Pointer to the CUDA buffer.
      * @param blocking
-     * Whether to wait for the completion of the memory copies before returning.
-     * @param stream
-     * The cudaStream to be used for queueing up the memory copies.
+     * If set to true Tausch will block until the send routine has been fully received. If set to
+     * false this routine will return immediately and the data will be sent in the background.
+     * @param communicator
+     * If a communicator is specified here then Tausch will ignore the global communicator set
+     * during construction.
      *
      * @return
-     * The Status object associated with the packing process.
+     * Returns the Status object containing a handle for this operation. For MPI messages the Status
+     * refers to the request stored by Tausch, i.e., it must not be used after this Tausch object has
+     * been destroyed or the halo has been deleted, and waiting on it after the next send() of the
+     * same halo waits for that message instead.
      */
-    inline Status packSendBufferCUDA(const size_t haloId, const size_t bufferId, const unsigned char *buf, const bool blocking = true, cudaStream_t stream = 0) {
+    inline Status send(size_t haloId, const int msgtag, const int remoteMpiRank = -1, const int bufferId = -1, const bool blocking = false, MPI_Comm communicator = MPI_COMM_NULL) {
 
-        size_t bufferOffset = 0;
-        for(size_t i = 0; i < bufferId; ++i)
-            bufferOffset += sendHaloIndicesSizePerBuffer[haloId][i];
+        if(!networkEmulation.enabled || communicator != MPI_COMM_NULL)
+            return sendMessage(haloId, msgtag, remoteMpiRank, bufferId, blocking, communicator);
 
-        if((sendHaloCommunicationStrategy[haloId]&Communication::CUDAAwareMPI) == Communication::CUDAAwareMPI) {
+        Status status = sendMessage(haloId, msgtag, remoteMpiRank, bufferId, false, communicator);
+        emulateNetwork(true, haloId, msgtag, remoteMpiRank, bufferId, status);
+        if(blocking)
+            status.wait();
+        return status;
 
-            size_t mpiSendBufferIndex = 0;
-            for(auto const & region : sendHaloIndices[haloId][bufferId]) {
+    }
 
-                const size_t &region_start = region[0];
-                const size_t &region_howmanycols = region[1];
-                const size_t &region_howmanyrows = region[2];
-                const size_t &region_striderow = region[3];
+    /***********************************************************************/
+    /*                         RECEIVE MESSAGE                             */
+    /***********************************************************************/
 
-                cudaError_t err = cudaMemcpy2DAsync(&cudaSendBuffer[haloId][bufferOffset + mpiSendBufferIndex], region_howmanycols*sizeof(unsigned char),
-                                                    &buf[region_start], region_striderow*sizeof(unsigned char),
-                                                    region_howmanycols*sizeof(unsigned char), region_howmanyrows,
-                                                    cudaMemcpyDeviceToDevice, stream);
+    /**
+     * @brief
+     * Receives a given halo.
+     *
+     * Receives a given halo.
+     *
+     * @param haloId
+     * The halo id returned by the addRecvHaloInfo() member function.
+     * @param msgtag
+     * The message tag to be used by this communication. For CPU-CPU communication this is the same
+     * as an MPI tag.
+     * @param remoteMpiRank
+     * The sending MPI rank.
+     * @param bufferId
+     * The id of the current buffer (numbered starting at 0).
+     * @param blocking
+     * If set to true Tausch will block until the receive routine has been fully completed. If set
+     * to false this routine will return immediately and the data will be received in the
+     * background (the MPI_Request can be tested to check for completion).
+     * @param communicator
+     * If a communicator is specified here then Tausch will ignore the global communicator set
+     * during construction.
+     *
+     * @return
+     * Returns the Status object containing a handle for this operation. For MPI messages the Status
+     * refers to the request stored by Tausch, i.e., it must not be used after this Tausch object has
+     * been destroyed or the halo has been deleted, and waiting on it after the next recv() of the
+     * same halo waits for that message instead.
+     */
+    inline Status recv(size_t haloId, const int msgtag, const int remoteMpiRank = -1, const int bufferId = -1, const bool blocking = true, MPI_Comm communicator = MPI_COMM_NULL) {
 
-                mpiSendBufferIndex += region_howmanyrows*region_howmanycols;
+        if(!networkEmulation.enabled || communicator != MPI_COMM_NULL)
+            return recvMessage(haloId, msgtag, remoteMpiRank, bufferId, blocking, communicator);
 
-                if(err != cudaSuccess)
-                    std::cout << "Tausch::packSendBufferCUDA(): CUDA error detected: " << cudaGetErrorString(err) << " (" << err << ")" << std::endl;
+        Status status = recvMessage(haloId, msgtag, remoteMpiRank, bufferId, false, communicator);
+        emulateNetwork(false, haloId, msgtag, remoteMpiRank, bufferId, status);
+        if(blocking)
+            status.wait();
+        return status;
+
+    }
+
+    /***********************************************************************/
+    /*                         AGGREGATED MESSAGES                         */
+    /***********************************************************************/
+
+    /**
+     * @brief
+     * Send several halos to the same remote rank(s) as one message per rank.
+     *
+     * All given halos with the same remote rank are copied into one contiguous message that starts
+     * with an offset table (the number of halos followed by the size of each halo in bytes) and are
+     * sent off using a single MPI message. This reduces the per-message latency when there are many
+     * small halos per neighbour. The halos need to be packed beforehand using packSendBuffer() and
+     * need to use a strategy with a packed buffer in host memory, i.e., not DerivedMpiDatatype,
+     * DerivedMpiDatatypeSingleMessage, or CUDAAwareMPI. Other halos are skipped.
+     *
+     * The receiving side has to call recvAggregated() with its corresponding halos listed in the
+     * same order.
+     *
+     * @param haloIds
+     * The halo ids returned by the addSendHaloInfo() member function.
+     * @param msgtag
+     * The message tag to be used by this communication.
+     * @param remoteMpiRank
+     * The receiving MPI rank for all halos. If set to -1 the remote ranks the halos were registered
+     * with are used.
+     * @param blocking
+     * If set to true Tausch will block until the messages have been fully received. If set to
+     * false this routine will return immediately and the data will be sent in the background.
+     * @param communicator
+     * If a communicator is specified here then Tausch will ignore the global communicator set
+     * during construction.
+     *
+     * @return
+     * Returns one Status object per remote rank (in ascending order of the remote ranks).
+     */
+    inline std::vector<Status> sendAggregated(std::vector<size_t> haloIds, const int msgtag, const int remoteMpiRank = -1, const bool blocking = false, MPI_Comm communicator = MPI_COMM_NULL) {
+
+        if(communicator == MPI_COMM_NULL)
+            communicator = TAUSCH_COMM;
 
+        std::map<int, std::vector<size_t> > haloIdsPerRank;
+        for(auto haloId : haloIds) {
+            if(!isAggregatable(sendHaloCommunicationStrategy[haloId])) {
+                std::cout << "Tausch::sendAggregated(): Halo " << haloId << " does not use a packed host buffer, skipping it..." << std::endl;
+                continue;
             }
+            haloIdsPerRank[(remoteMpiRank != -1 ? remoteMpiRank : sendHaloRemoteRank.at(haloId))].push_back(haloId);
+        }
 
-        } else if((sendHaloCommunicationStrategy[haloId]&Communication::GPUMultiCopy) == Communication::GPUMultiCopy) {
+        std::vector<Status> status;
 
-            size_t mpiSendBufferIndex = 0;
-            for(auto const & region : sendHaloIndices[haloId][bufferId]) {
+        for(auto const & group : haloIdsPerRank) {
 
-                const size_t &region_start = region[0];
-                const size_t &region_howmanycols = region[1];
-                const size_t &region_howmanyrows = region[2];
-                const size_t &region_striderow = region[3];
+            std::unique_lock<std::mutex> lock(aggregatedMutex, std::defer_lock);
+            if(threadSafe)
+                lock.lock();
+            AggregatedMessage &msg = aggregatedSendMessages[{group.first, msgtag}];
+            if(threadSafe)
+                lock.unlock();
 
-                cudaError_t err = cudaMemcpy2DAsync(&sendBuffer[haloId][bufferOffset + mpiSendBufferIndex], region_howmanycols*sizeof(unsigned char),
-                                                    &buf[region_start], region_striderow*sizeof(unsigned char),
-                                                    region_howmanycols*sizeof(unsigned char), region_howmanyrows,
-                                                    cudaMemcpyDeviceToHost, stream);
+            // the previous message with this rank/tag needs to be out before its buffer is reused
+            MPI_Wait(&msg.request, MPI_STATUS_IGNORE);
 
-                mpiSendBufferIndex += region_howmanyrows*region_howmanycols;
+            const size_t headerSize = (group.second.size()+1)*sizeof(uint64_t);
+            size_t totalSize = headerSize;
+            for(auto haloId : group.second)
+                totalSize += sendHaloIndicesSizeTotal[haloId];
+            msg.buffer.resize(totalSize);
 
-                if(err != cudaSuccess)
-                    std::cout << "Tausch::packSendBufferCUDA(): CUDA error detected: " << cudaGetErrorString(err) << " (" << err << ")" << std::endl;
+            uint64_t *header = reinterpret_cast<uint64_t*>(msg.buffer.data());
+            header[0] = group.second.size();
 
+            size_t offset = headerSize;
+            for(size_t i = 0; i < group.second.size(); ++i) {
+                const size_t haloId = group.second[i];
+                if(packFutures[haloId].isRunning())
+                    packFutures[haloId].wait();
+                header[i+1] = sendHaloIndicesSizeTotal[haloId];
+                std::memcpy(&msg.buffer[offset], sendBuffer[haloId], sendHaloIndicesSizeTotal[haloId]);
+                offset += sendHaloIndicesSizeTotal[haloId];
             }
 
-        } else {
+            MPI_Isend(msg.buffer.data(), totalSize, MPI_CHAR, group.first, msgtag, communicator, &msg.request);
 
-            unsigned char *tmpSendBuffer;
-            cudaMalloc(&tmpSendBuffer, sendHaloIndicesSizePerBuffer[haloId][bufferId]*sizeof(unsigned char));
+            if(blocking)
+                MPI_Wait(&msg.request, MPI_STATUS_IGNORE);
 
-            size_t mpiSendBufferIndex = 0;
-            for(auto const & region : sendHaloIndices[haloId][bufferId]) {
+            status.push_back(Status(&msg.request));
 
-                const size_t &region_start = region[0];
-                const size_t &region_howmanycols = region[1];
-                const size_t &region_howmanyrows = region[2];
-                const size_t &region_striderow = region[3];
+        }
 
-                cudaError_t err = cudaMemcpy2DAsync(&tmpSendBuffer[mpiSendBufferIndex], region_howmanycols*sizeof(unsigned char),
-                                                    &buf[region_start], region_striderow*sizeof(unsigned char),
-                                                    region_howmanycols*sizeof(unsigned char), region_howmanyrows,
-                                                    cudaMemcpyDeviceToDevice, stream);
+        return status;
 
-                mpiSendBufferIndex += region_howmanyrows*region_howmanycols;
+    }
 
-                if(err != cudaSuccess)
-                    std::cout << "Tausch::packSendBufferCUDA(): CUDA error detected: " << cudaGetErrorString(err) << " (" << err << ")" << std::endl;
+    /**
+     * @brief
+     * Receive several halos sent using sendAggregated().
+     *
+     * One message per remote rank is received and split into the receive buffers of the given
+     * halos as soon as it arrives. This call returns once all messages have been received and
+     * split, the halos can then be unpacked as usual using unpackRecvBuffer(). The halos need to be
+     * listed in the same order as on the sending side and need to use a strategy with a packed
+     * buffer in host memory (see sendAggregated()). If the number or the sizes of the halos in a
+     * received message do not match the halos listed here, Tausch aborts.
+     *
+     * @param haloIds
+     * The halo ids returned by the addRecvHaloInfo() member function.
+     * @param msgtag
+     * The message tag to be used by this communication.
+     * @param remoteMpiRank
+     * The sending MPI rank for all halos. If set to -1 the remote ranks the halos were registered
+     * with are used.
+     * @param communicator
+     * If a communicator is specified here then Tausch will ignore the global communicator set
+     * during construction.
+     */
+    inline void recvAggregated(std::vector<size_t> haloIds, const int msgtag, const int remoteMpiRank = -1, MPI_Comm communicator = MPI_COMM_NULL) {
+
+        if(communicator == MPI_COMM_NULL)
+            communicator = TAUSCH_COMM;
 
+        std::map<int, std::vector<size_t> > haloIdsPerRank;
+        for(auto haloId : haloIds) {
+            if(!isAggregatable(recvHaloCommunicationStrategy[haloId])) {
+                std::cout << "Tausch::recvAggregated(): Halo " << haloId << " does not use a packed host buffer, skipping it..." << std::endl;
+                continue;
             }
+            haloIdsPerRank[(remoteMpiRank != -1 ? remoteMpiRank : recvHaloRemoteRank.at(haloId))].push_back(haloId);
+        }
 
-            cudaMemcpyAsync(&sendBuffer[haloId][bufferOffset], tmpSendBuffer, sendHaloIndicesSizePerBuffer[haloId][bufferId]*sizeof(unsigned char), cudaMemcpyDeviceToHost, stream);
+        std::vector<const std::vector<size_t>*> groups;
+        std::vector<AggregatedMessage*> messages;
+        std::vector<MPI_Request> requests;
 
-        }
+        for(auto const & group : haloIdsPerRank) {
 
-        if(blocking) {
+            std::unique_lock<std::mutex> lock(aggregatedMutex, std::defer_lock);
+            if(threadSafe)
+                lock.lock();
+            AggregatedMessage &msg = aggregatedRecvMessages[{group.first, msgtag}];
+            if(threadSafe)
+                lock.unlock();
 
-            cudaEvent_t ev;
-            cudaEventCreate(&ev);
-            cudaEventRecord(ev, stream);
-            cudaEventSynchronize(ev);
+            size_t totalSize = (group.second.size()+1)*sizeof(uint64_t);
+            for(auto haloId : group.second)
+                totalSize += recvHaloIndicesSizeTotal[haloId];
+            msg.buffer.resize(totalSize);
+
+            requests.push_back(MPI_REQUEST_NULL);
+            MPI_Irecv(msg.buffer.data(), totalSize, MPI_CHAR, group.first, msgtag, communicator, &requests.back());
+
+            groups.push_back(&group.second);
+            messages.push_back(&msg);
 
         }
 
-        return Status(stream);
+        // split up the messages in the order in which they arrive
+        for(size_t iMsg = 0; iMsg < requests.size(); ++iMsg) {
+
+            int index;
+            MPI_Waitany(requests.size(), requests.data(), &index, MPI_STATUS_IGNORE);
+
+            const std::vector<size_t> &group = *groups[index];
+            const unsigned char *buf = messages[index]->buffer.data();
+            const uint64_t *header = reinterpret_cast<const uint64_t*>(buf);
+
+            // the halos listed on both sides do not match, there is no way of telling which data belongs where
+            if(header[0] != group.size()) {
+                std::cout << "Tausch::recvAggregated(): Expected " << group.size() << " halos but received " << header[0] << ", aborting..." << std::endl;
+                MPI_Abort(TAUSCH_COMM, 1);
+            }
+            for(size_t i = 0; i < group.size(); ++i) {
+                if(header[i+1] != static_cast<uint64_t>(recvHaloIndicesSizeTotal[group[i]])) {
+                    std::cout << "Tausch::recvAggregated(): Size mismatch for halo " << group[i] << ", expected " << recvHaloIndicesSizeTotal[group[i]]
+                              << " bytes but received " << header[i+1] << ", aborting..." << std::endl;
+                    MPI_Abort(TAUSCH_COMM, 1);
+                }
+            }
+
+            size_t offset = (group.size()+1)*sizeof(uint64_t);
+            for(size_t i = 0; i < group.size(); ++i) {
+                const size_t haloId = group[i];
+                std::memcpy(recvBuffer[haloId], &buf[offset], recvHaloIndicesSizeTotal[haloId]);
+                offset += recvHaloIndicesSizeTotal[haloId];
+                // nothing is pending for this halo anymore
+                if(!recvHaloMpiSetup[haloId][0])
+                    recvHaloMpiRequests[haloId][0] = MPI_REQUEST_NULL;
+            }
+
+        }
 
     }
 
     /***********************************************************************/
-    /*                        UNPACK BUFFER (CUDA)                         */
+    /*                       HIERARCHICAL EXCHANGE                         */
     /***********************************************************************/
 
     /**
-     * \overload
+     * @brief
+     * Use a custom node communicator.
      *
-     * Internally the data buffer will be recast to unsigned char.
-     */
-    inline Status unpackRecvBufferCUDA(const size_t haloId, const size_t bufferId, double *buf, const bool blocking = true, cudaStream_t stream = 0) {
-        return unpackRecvBufferCUDA(haloId, bufferId, reinterpret_cast<unsigned char*>(buf), blocking, stream);
-    }
-
-    /**
-     * \overload
+     * By default the ranks sharing a node are found using MPI_COMM_TYPE_SHARED (see
+     * setupNodeInformation()). This allows to use any other grouping instead, e.g., splitting the
+     * ranks into several fake nodes for testing exchangeHierarchical() on a single machine. The
+     * communicator is duplicated. This is a collective call over the communicator passed to the
+     * constructor.
      *
-     * Internally the data buffer will be recast to unsigned char.
+     * @param nodeComm
+     * The communicator containing all ranks of the same node as this rank.
      */
-    inline Status unpackRecvBufferCUDA(const size_t haloId, const size_t bufferId, int *buf, const bool blocking = true, cudaStream_t stream = 0) {
-        return unpackRecvBufferCUDA(haloId, bufferId, reinterpret_cast<unsigned char*>(buf), blocking, stream);
+    inline void setNodeCommunicator(MPI_Comm nodeComm) {
+
+        if(TAUSCH_NODE_COMM != MPI_COMM_NULL)
+            MPI_Comm_free(&TAUSCH_NODE_COMM);
+
+        MPI_Comm_dup(nodeComm, &TAUSCH_NODE_COMM);
+        setupNodeMapping();
+
     }
 
     /**
      * @brief
-     * Unpacks a CUDA buffer for the given halo and buffer id.
-     *
-     * Unpacks a CUDA buffer for the given halo and buffer id. Once this function has been called
-     * the received data can be immediately used.
-     *
-     * @param haloId
-     * The halo id returned by the addRecvHaloInfo() member function.
-     * @param bufferId
-     * The id of the current buffer (numbered starting at 0).
-     * @param buf
-     * Pointer to the CUDA buffer.
-     * @param blocking
-     * Whether to wait for the completion of the memory copies before returning.
-     * @param stream
-     * The cudaStream to be used for queueing up the memory copies.
-     *
-     * @return
-     * The Status object associated with the unpacking process.
+     * Exchange halos going off-node through one leader rank per node.
+     *
+     * Many small halos sent to ranks on other nodes lead to many tiny inter-node messages. With
+     * this exchange each rank hands all its off-node halos to the leader of its node (the lowest
+     * rank of the node communicator), the leader sends one message per remote node to the leader
+     * of that node, and the remote leader distributes the halos to the ranks of its node. Halos
+     * between ranks of the same node are sent directly.
+     *
+     * This is a collective call over the node communicator (see setupNodeInformation() and
+     * setNodeCommunicator()), every rank of a node needs to call it, possibly with empty lists.
+     * The halos need to use a packed buffer in host memory (see isAggregatable()) and be
+     * registered with their remote rank. Halos sent from one rank to another need to be listed in
+     * the same order on both sides. Once this call returns the received halos can be unpacked as
+     * usual using unpackRecvBuffer().
+     *
+     * @param sendHaloIds
+     * The halo ids returned by the addSendHaloInfo() member function.
+     * @param recvHaloIds
+     * The halo ids returned by the addRecvHaloInfo() member function.
+     * @param msgtag
+     * The message tag to be used by this communication.
      */
-    inline Status unpackRecvBufferCUDA(const size_t haloId, const size_t bufferId, unsigned char *buf, const bool blocking = true, cudaStream_t stream = 0) {
-
-        size_t bufferOffset = 0;
-        for(size_t i = 0; i < bufferId; ++i)
-            bufferOffset += recvHaloIndicesSizePerBuffer[haloId][i];
-
-        if((recvHaloCommunicationStrategy[haloId]&Communication::CUDAAwareMPI) == Communication::CUDAAwareMPI) {
-
-            size_t mpiRecvBufferIndex = 0;
-            for(auto const & region : recvHaloIndices[haloId][bufferId]) {
+    inline void exchangeHierarchical(const std::vector<size_t> &sendHaloIds, const std::vector<size_t> &recvHaloIds, const int msgtag) {
 
-                const size_t &region_start = region[0];
-                const size_t &region_howmanycols = region[1];
-                const size_t &region_howmanyrows = region[2];
-                const size_t &region_striderow = region[3];
+        setupNodeInformation();
 
-                cudaError_t err = cudaMemcpy2DAsync(&buf[region_start], region_striderow*sizeof(unsigned char),
-                                                    &cudaRecvBuffer[haloId][bufferOffset + mpiRecvBufferIndex], region_howmanycols*sizeof(unsigned char),
-                                                    region_howmanycols*sizeof(unsigned char), region_howmanyrows,
-                                                    cudaMemcpyDeviceToDevice, stream);
+        int myRank, nodeRank, nodeSize;
+        MPI_Comm_rank(TAUSCH_COMM, &myRank);
+        MPI_Comm_rank(TAUSCH_NODE_COMM, &nodeRank);
+        MPI_Comm_size(TAUSCH_NODE_COMM, &nodeSize);
+        const int myNode = rankToNode[myRank];
 
-                if(err != cudaSuccess)
-                    std::cout << "Tausch::unpackRecvBufferCUDA(): CUDA error detected: " << cudaGetErrorString(err) << " (" << err << ")" << std::endl;
+        std::vector<MPI_Request> localRequests;
 
-                mpiRecvBufferIndex += region_howmanyrows*region_howmanycols;
+        // off-node halos are handed to the leader: header of (src, dst, size) triples followed by the data
+        std::vector<uint64_t> outMeta, inMeta;
+        std::vector<unsigned char> outData;
 
+        for(auto haloId : sendHaloIds) {
+            if(!isAggregatable(sendHaloCommunicationStrategy[haloId])) {
+                std::cout << "Tausch::exchangeHierarchical(): Halo " << haloId << " does not use a packed host buffer, skipping it..." << std::endl;
+                continue;
             }
+            if(packFutures[haloId].isRunning())
+                packFutures[haloId].wait();
+            const int remoteRank = sendHaloRemoteRank.at(haloId);
+            const size_t size = sendHaloIndicesSizeTotal[haloId];
+            if(rankToNode[remoteRank] == myNode) {
+                localRequests.push_back(MPI_REQUEST_NULL);
+                MPI_Isend(sendBuffer[haloId], size, MPI_CHAR, remoteRank, msgtag, TAUSCH_COMM, &localRequests.back());
+            } else {
+                outMeta.insert(outMeta.end(), {static_cast<uint64_t>(myRank), static_cast<uint64_t>(remoteRank), size});
+                outData.insert(outData.end(), sendBuffer[haloId], sendBuffer[haloId]+size);
+            }
+        }
 
-        } else if((recvHaloCommunicationStrategy[haloId]&Communication::GPUMultiCopy) == Communication::GPUMultiCopy) {
-
-            size_t mpiRecvBufferIndex = 0;
-            for(auto const & region : recvHaloIndices[haloId][bufferId]) {
+        std::vector<size_t> offNodeRecvHalos;
+        for(auto haloId : recvHaloIds) {
+            if(!isAggregatable(recvHaloCommunicationStrategy[haloId])) {
+                std::cout << "Tausch::exchangeHierarchical(): Halo " << haloId << " does not use a packed host buffer, skipping it..." << std::endl;
+                continue;
+            }
+            const int remoteRank = recvHaloRemoteRank.at(haloId);
+            const size_t size = recvHaloIndicesSizeTotal[haloId];
+            if(rankToNode[remoteRank] == myNode) {
+                localRequests.push_back(MPI_REQUEST_NULL);
+                MPI_Irecv(recvBuffer[haloId], size, MPI_CHAR, remoteRank, msgtag, TAUSCH_COMM, &localRequests.back());
+            } else {
+                inMeta.insert(inMeta.end(), {static_cast<uint64_t>(remoteRank), static_cast<uint64_t>(myRank), size});
+                offNodeRecvHalos.push_back(haloId);
+            }
+        }
 
-                const size_t &region_start = region[0];
-                const size_t &region_howmanycols = region[1];
-                const size_t &region_howmanyrows = region[2];
-                const size_t &region_striderow = region[3];
+        // gather everything on the leader of this node
+        std::vector<unsigned char> toLeader = serializeHierarchicalItems(outMeta, inMeta, outData);
+        std::vector<unsigned char> fromRanks;
+        std::vector<int> blobSizes, blobDispls;
+        gatherOnNodeLeader(toLeader, fromRanks, blobSizes, blobDispls);
+
+        std::vector<unsigned char> fromLeader;
+
+        if(nodeRank == 0) {
+
+            std::vector<int> nodeRanks(nodeSize);
+            MPI_Gather(&myRank, 1, MPI_INT, nodeRanks.data(), 1, MPI_INT, 0, TAUSCH_NODE_COMM);
+            std::map<int, int> rankToNodeRank;
+            for(int i = 0; i < nodeSize; ++i)
+                rankToNodeRank[nodeRanks[i]] = i;
+
+            // one message per remote node leader
+            std::map<int, std::vector<uint64_t> > sendMeta;
+            std::map<int, std::vector<unsigned char> > sendData;
+            std::map<int, size_t> expectedCount, expectedSize;
+
+            for(int i = 0; i < nodeSize; ++i) {
+                std::vector<uint64_t> rankOut, rankIn;
+                std::vector<unsigned char> rankData;
+                deserializeHierarchicalItems(&fromRanks[blobDispls[i]], rankOut, rankIn, rankData);
+                size_t offset = 0;
+                for(size_t j = 0; j < rankOut.size(); j += 3) {
+                    const int leader = rankToNode[rankOut[j+1]];
+                    sendMeta[leader].insert(sendMeta[leader].end(), rankOut.begin()+j, rankOut.begin()+j+3);
+                    sendData[leader].insert(sendData[leader].end(), rankData.begin()+offset, rankData.begin()+offset+rankOut[j+2]);
+                    offset += rankOut[j+2];
+                }
+                for(size_t j = 0; j < rankIn.size(); j += 3) {
+                    const int leader = rankToNode[rankIn[j]];
+                    ++expectedCount[leader];
+                    expectedSize[leader] += rankIn[j+2];
+                }
+            }
 
-                cudaError_t err = cudaMemcpy2DAsync(&buf[region_start], region_striderow*sizeof(unsigned char),
-                                                    &recvBuffer[haloId][bufferOffset + mpiRecvBufferIndex], region_howmanycols*sizeof(unsigned char),
-                                                    region_howmanycols*sizeof(unsigned char), region_howmanyrows,
-                                                    cudaMemcpyHostToDevice, stream);
+            std::vector<std::vector<unsigned char> > outgoing;
+            std::vector<MPI_Request> leaderRequests;
+            for(auto &meta : sendMeta) {
+                std::vector<uint64_t> none;
+                outgoing.push_back(serializeHierarchicalItems(meta.second, none, sendData[meta.first]));
+            }
+            size_t iOut = 0;
+            for(auto &meta : sendMeta) {
+                leaderRequests.push_back(MPI_REQUEST_NULL);
+                MPI_Isend(outgoing[iOut].data(), outgoing[iOut].size(), MPI_CHAR, meta.first, msgtag, TAUSCH_COMM, &leaderRequests.back());
+                ++iOut;
+            }
 
-                if(err != cudaSuccess)
-                    std::cout << "Tausch::unpackRecvBufferCUDA(): CUDA error detected: " << cudaGetErrorString(err) << " (" << err << ")" << std::endl;
+            std::vector<std::vector<unsigned char> > incoming;
+            for(auto &count : expectedCount) {
+                incoming.push_back(std::vector<unsigned char>(2*sizeof(uint64_t) + 3*count.second*sizeof(uint64_t) + expectedSize[count.first]));
+                leaderRequests.push_back(MPI_REQUEST_NULL);
+                MPI_Irecv(incoming.back().data(), incoming.back().size(), MPI_CHAR, count.first, msgtag, TAUSCH_COMM, &leaderRequests.back());
+            }
 
-                mpiRecvBufferIndex += region_howmanyrows*region_howmanycols;
+            MPI_Waitall(leaderRequests.size(), leaderRequests.data(), MPI_STATUSES_IGNORE);
+
+            // sort the received halos by the rank of this node they go to
+            std::vector<std::vector<uint64_t> > perRankMeta(nodeSize);
+            std::vector<std::vector<unsigned char> > perRankData(nodeSize);
+            for(auto &msg : incoming) {
+                std::vector<uint64_t> meta, none;
+                std::vector<unsigned char> data;
+                deserializeHierarchicalItems(msg.data(), meta, none, data);
+                size_t offset = 0;
+                for(size_t j = 0; j < meta.size(); j += 3) {
+                    const int dst = rankToNodeRank.at(meta[j+1]);
+                    perRankMeta[dst].insert(perRankMeta[dst].end(), meta.begin()+j, meta.begin()+j+3);
+                    perRankData[dst].insert(perRankData[dst].end(), data.begin()+offset, data.begin()+offset+meta[j+2]);
+                    offset += meta[j+2];
+                }
+            }
 
+            std::vector<unsigned char> allRanks;
+            blobSizes.assign(nodeSize, 0);
+            blobDispls.assign(nodeSize, 0);
+            for(int i = 0; i < nodeSize; ++i) {
+                std::vector<uint64_t> none;
+                std::vector<unsigned char> blob = serializeHierarchicalItems(perRankMeta[i], none, perRankData[i]);
+                blobDispls[i] = allRanks.size();
+                blobSizes[i] = blob.size();
+                allRanks.insert(allRanks.end(), blob.begin(), blob.end());
             }
+            scatterFromNodeLeader(allRanks, blobSizes, blobDispls, fromLeader);
 
         } else {
 
-            unsigned char *tmpRecvBuffer;
-            cudaMalloc(&tmpRecvBuffer, recvHaloIndicesSizePerBuffer[haloId][bufferId]*sizeof(unsigned char));
-            cudaMemcpyAsync(tmpRecvBuffer, &recvBuffer[haloId][bufferOffset], recvHaloIndicesSizePerBuffer[haloId][bufferId]*sizeof(unsigned char), cudaMemcpyHostToDevice, stream);
+            MPI_Gather(&myRank, 1, MPI_INT, nullptr, 1, MPI_INT, 0, TAUSCH_NODE_COMM);
+            scatterFromNodeLeader(std::vector<unsigned char>(), blobSizes, blobDispls, fromLeader);
 
-            size_t mpiRecvBufferIndex = 0;
-            for(auto const & region : recvHaloIndices[haloId][bufferId]) {
+        }
 
-                const size_t &region_start = region[0];
-                const size_t &region_howmanycols = region[1];
-                const size_t &region_howmanyrows = region[2];
-                const size_t &region_striderow = region[3];
+        // hand out the received halos in the order they were sent by each remote rank
+        std::vector<uint64_t> meta, none;
+        std::vector<unsigned char> data;
+        deserializeHierarchicalItems(fromLeader.data(), meta, none, data);
 
-                cudaError_t err = cudaMemcpy2DAsync(&buf[region_start], region_striderow*sizeof(unsigned char),
-                                                    &tmpRecvBuffer[mpiRecvBufferIndex], region_howmanycols*sizeof(unsigned char),
-                                                    region_howmanycols*sizeof(unsigned char), region_howmanyrows,
-                                                    cudaMemcpyDeviceToDevice, stream);
+        std::map<int, std::vector<std::pair<size_t, size_t> > > itemsPerRank;  // offset and size of each halo
+        size_t offset = 0;
+        for(size_t j = 0; j < meta.size(); j += 3) {
+            itemsPerRank[meta[j]].push_back({offset, meta[j+2]});
+            offset += meta[j+2];
+        }
 
-                if(err != cudaSuccess)
-                    std::cout << "Tausch::unpackRecvBufferCUDA(): CUDA error detected: " << cudaGetErrorString(err) << " (" << err << ")" << std::endl;
+        std::map<int, size_t> nextItem;
+        for(auto haloId : offNodeRecvHalos) {
+            const int remoteRank = recvHaloRemoteRank.at(haloId);
+            const size_t iItem = nextItem[remoteRank]++;
+            auto &items = itemsPerRank[remoteRank];
+            if(iItem >= items.size() || items[iItem].second != static_cast<size_t>(recvHaloIndicesSizeTotal[haloId])) {
+                std::cout << "Tausch::exchangeHierarchical(): Size mismatch for halo " << haloId << ", ignoring it..." << std::endl;
+                continue;
+            }
+            std::memcpy(recvBuffer[haloId], &data[items[iItem].first], items[iItem].second);
+        }
 
-                mpiRecvBufferIndex += region_howmanyrows*region_howmanycols;
+        MPI_Waitall(localRequests.size(), localRequests.data(), MPI_STATUSES_IGNORE);
 
-            }
+        // nothing is pending for these halos anymore
+        for(auto haloId : recvHaloIds)
+            if(!recvHaloMpiSetup[haloId][0])
+                recvHaloMpiRequests[haloId][0] = MPI_REQUEST_NULL;
 
-        }
+    }
 
-        if(blocking) {
+    /***********************************************************************/
+    /*                     TOPOLOGY-AWARE REORDERING                       */
+    /***********************************************************************/
 
-            cudaEvent_t ev;
-            cudaEventCreate(&ev);
-            cudaEventRecord(ev, stream);
-            cudaEventSynchronize(ev);
+    /**
+     * @brief
+     * Returns how many bytes this rank sends to every other rank.
+     *
+     * Sums up the sizes of all registered send halos per remote rank. Halos without a remote rank
+     * and deleted halos are ignored.
+     *
+     * @return
+     * The number of bytes per remote rank.
+     */
+    inline std::map<int, size_t> getSendBytesPerRank() {
 
+        std::map<int, size_t> bytes;
+        for(size_t haloId = 0; haloId < sendBuffer.size(); ++haloId) {
+            if(sendHaloRemoteRank[haloId] < 0 || std::find(sendBufferHaloIdDeleted.begin(), sendBufferHaloIdDeleted.end(), haloId) != sendBufferHaloIdDeleted.end())
+                continue;
+            bytes[sendHaloRemoteRank[haloId]] += sendHaloIndicesSizeTotal[haloId];
         }
 
-        return Status(stream);
+        return bytes;
 
     }
 
-    /**@}*/
-
-#endif
-
-#ifdef TAUSCH_HIP
-
-    /** @name HIP
-     * The HIP routines. In order to use these the macro TAUSCH_HIP needs to be defined before including the tausch header.
-     */
-    /**@{*/
-
-    /***********************************************************************/
-    /*                         PACK BUFFER (HIP)                           */
-    /***********************************************************************/
-
     /**
-     * \overload
+     * @brief
+     * Gathers the byte-weighted communication matrix on rank 0.
      *
-     * Internally the HIP buffer will be recast to unsigned char.
+     * Entry [i][j] is the number of bytes rank i sends to rank j per exchange. The matrix is dense
+     * and thus only meant for diagnostics at moderate scale. This is a collective call.
+     *
+     * @return
+     * The matrix on rank 0, an empty matrix on all other ranks.
      */
-    inline Status packSendBufferHIP(const size_t haloId, const size_t bufferId, const double *buf, const bool blocking = true, hipStream_t stream = 0) {
-        return packSendBufferHIP(haloId, bufferId, reinterpret_cast<const unsigned char*>(buf), blocking, stream);
+    inline std::vector<std::vector<size_t> > getCommunicationMatrix() {
+
+        int myRank, mpiSize;
+        MPI_Comm_rank(TAUSCH_COMM, &myRank);
+        MPI_Comm_size(TAUSCH_COMM, &mpiSize);
+
+        std::vector<unsigned long long> row(mpiSize, 0);
+        for(auto const & entry : getSendBytesPerRank())
+            row[entry.first] = entry.second;
+
+        std::vector<unsigned long long> all;
+        if(myRank == 0)
+            all.resize(static_cast<size_t>(mpiSize)*mpiSize);
+        MPI_Gather(row.data(), mpiSize, MPI_UNSIGNED_LONG_LONG, all.data(), mpiSize, MPI_UNSIGNED_LONG_LONG, 0, TAUSCH_COMM);
+
+        std::vector<std::vector<size_t> > matrix;
+        if(myRank == 0)
+            for(int i = 0; i < mpiSize; ++i)
+                matrix.push_back(std::vector<size_t>(&all[static_cast<size_t>(i)*mpiSize], &all[static_cast<size_t>(i)*mpiSize]+mpiSize));
+
+        return matrix;
+
     }
 
     /**
-     * \overload
+     * @brief
+     * Computes a rank reordering placing heavily communicating ranks close together.
+     *
+     * Builds a distributed graph communicator (MPI_Dist_graph_create_adjacent with reorder
+     * enabled) from the registered halos, with the halo bytes as edge weights, and lets the MPI
+     * library map the graph to the machine. The application can then redistribute its subdomains
+     * according to the returned permutation, i.e., the process that was rank i takes over the
+     * subdomain of rank permutation[i]. Optionally the byte-weighted communication matrix
+     * (for up to 32 ranks) and the estimated intra- and inter-node traffic before and after the
+     * reordering are printed. Whether ranks are actually moved depends on the MPI library. This is
+     * a collective call.
+     *
+     * @param reorderedComm
+     * If not null, the graph communicator is returned here and has to be freed by the caller.
+     * @param report
+     * If not null, rank 0 prints a report to this stream.
      *
-     * Internally the HIP buffer will be recast to unsigned char.
+     * @return
+     * The permutation, entry i holds the new rank of rank i.
      */
-    inline Status packSendBufferHIP(const size_t haloId, const size_t bufferId, const int *buf, const bool blocking = true, hipStream_t stream = 0) {
-        return packSendBufferHIP(haloId, bufferId, reinterpret_cast<const unsigned char*>(buf), blocking, stream);
+    inline std::vector<int> reorderRanksByCommunication(MPI_Comm *reorderedComm = nullptr, std::ostream *report = nullptr) {
+
+        setupNodeInformation();
+
+        int myRank, mpiSize;
+        MPI_Comm_rank(TAUSCH_COMM, &myRank);
+        MPI_Comm_size(TAUSCH_COMM, &mpiSize);
+
+        const std::map<int, size_t> sendBytes = getSendBytesPerRank();
+        std::map<int, size_t> recvBytes;
+        for(size_t haloId = 0; haloId < recvBuffer.size(); ++haloId) {
+            if(recvHaloRemoteRank[haloId] < 0 || std::find(recvBufferHaloIdDeleted.begin(), recvBufferHaloIdDeleted.end(), haloId) != recvBufferHaloIdDeleted.end())
+                continue;
+            recvBytes[recvHaloRemoteRank[haloId]] += recvHaloIndicesSizeTotal[haloId];
+        }
+
+        // MPI only supports int weights
+        auto toWeight = [](const size_t bytes) {
+            return static_cast<int>(std::min(bytes, static_cast<size_t>(std::numeric_limits<int>::max())));
+        };
+
+        std::vector<int> sources, sourceWeights, destinations, destinationWeights;
+        for(auto const & entry : recvBytes) {
+            sources.push_back(entry.first);
+            sourceWeights.push_back(toWeight(entry.second));
+        }
+        for(auto const & entry : sendBytes) {
+            destinations.push_back(entry.first);
+            destinationWeights.push_back(toWeight(entry.second));
+        }
+
+        MPI_Comm graphComm;
+        MPI_Dist_graph_create_adjacent(TAUSCH_COMM,
+                                       sources.size(), sources.data(), sourceWeights.data(),
+                                       destinations.size(), destinations.data(), destinationWeights.data(),
+                                       MPI_INFO_NULL, 1, &graphComm);
+
+        int newRank;
+        MPI_Comm_rank(graphComm, &newRank);
+        std::vector<int> permutation(mpiSize);
+        MPI_Allgather(&newRank, 1, MPI_INT, permutation.data(), 1, MPI_INT, TAUSCH_COMM);
+
+        if(reorderedComm != nullptr)
+            *reorderedComm = graphComm;
+        else
+            MPI_Comm_free(&graphComm);
+
+        if(report != nullptr) {
+
+            const std::vector<std::vector<size_t> > matrix = getCommunicationMatrix();
+            const std::array<unsigned long long, 4> traffic = estimateNodeTraffic(permutation);
+
+            if(myRank == 0) {
+
+                std::ostream &out = *report;
+
+                if(mpiSize <= 32) {
+                    out << " ** Communication matrix (bytes sent from row to column rank):" << std::endl;
+                    for(int i = 0; i < mpiSize; ++i) {
+                        out << "   ";
+                        for(int j = 0; j < mpiSize; ++j)
+                            out << std::setw(10) << matrix[i][j];
+                        out << std::endl;
+                    }
+                }
+
+                const double total = std::max(1ull, traffic[0]+traffic[1]);
+                out << " ** Estimated traffic before reordering: " << traffic[0] << " bytes intra-node (" << 100.0*traffic[0]/total << "%), "
+                    << traffic[1] << " bytes inter-node (" << 100.0*traffic[1]/total << "%)" << std::endl;
+                out << " ** Estimated traffic after reordering:  " << traffic[2] << " bytes intra-node (" << 100.0*traffic[2]/total << "%), "
+                    << traffic[3] << " bytes inter-node (" << 100.0*traffic[3]/total << "%)" << std::endl;
+
+            }
+
+        }
+
+        return permutation;
+
     }
 
     /**
      * @brief
-     * Packs a HIP buffer for the given halo and buffer id.
+     * Estimates the intra- and inter-node traffic before and after redistributing the subdomains.
      *
-     * Packs a HIP buffer for the given halo and buffer id. Once this function has been called the
-     * HIP buffer is free to be used and changed as desired.
+     * After redistributing the subdomains according to a permutation (see
+     * reorderRanksByCommunication()) the subdomain of rank i is handled by the process that was
+     * rank j with permutation[j] = i. The traffic is estimated from the registered send halos and
+     * the nodes of the ranks (see setupNodeInformation() and setNodeCommunicator()). This is a
+     * collective call.
      *
-     * @param haloId
-     * The halo id returned by the addSendHaloInfo() member function.
-     * @param bufferId
-     * The id of the current buffer (numbered starting at 0).
-     * @param buf
-     * Pointer to the HIP buffer.
-     * @param blocking
-     * Whether to wait for the completion of the memory copies before returning.
-     * @param stream
-     * The hipStream to be used for queueing up the memory copies.
+     * @param permutation
+     * The permutation, entry i holds the new rank of rank i.
      *
      * @return
-     * The Status object associated with the packing process.
+     * The bytes sent intra-node and inter-node before, and intra-node and inter-node after
+     * redistributing. Summed over all ranks on rank 0, only the own share on all other ranks.
      */
-    inline Status packSendBufferHIP(const size_t haloId, const size_t bufferId, const unsigned char *buf, const bool blocking = true, hipStream_t stream = 0) {
+    inline std::array<unsigned long long, 4> estimateNodeTraffic(const std::vector<int> &permutation) {
 
-        size_t bufferOffset = 0;
-        for(size_t i = 0; i < bufferId; ++i)
-            bufferOffset += sendHaloIndicesSizePerBuffer[haloId][i];
+        setupNodeInformation();
 
-        if((sendHaloCommunicationStrategy[haloId]&Communication::GPUMultiCopy) == Communication::GPUMultiCopy) {
+        int myRank, mpiSize;
+        MPI_Comm_rank(TAUSCH_COMM, &myRank);
+        MPI_Comm_size(TAUSCH_COMM, &mpiSize);
 
-            size_t mpiSendBufferIndex = 0;
-            for(auto const & region : sendHaloIndices[haloId][bufferId]) {
+        std::vector<int> inverse(mpiSize);
+        for(int i = 0; i < mpiSize; ++i)
+            inverse[permutation[i]] = i;
 
-                const size_t &region_start = region[0];
-                const size_t &region_howmanycols = region[1];
-                const size_t &region_howmanyrows = region[2];
-                const size_t &region_striderow = region[3];
+        std::array<unsigned long long, 4> traffic = {0, 0, 0, 0};
+        for(auto const & entry : getSendBytesPerRank()) {
+            traffic[(rankToNode[myRank] == rankToNode[entry.first] ? 0 : 1)] += entry.second;
+            traffic[(rankToNode[inverse[myRank]] == rankToNode[inverse[entry.first]] ? 2 : 3)] += entry.second;
+        }
+        MPI_Reduce((myRank == 0 ? MPI_IN_PLACE : traffic.data()), traffic.data(), 4, MPI_UNSIGNED_LONG_LONG, MPI_SUM, 0, TAUSCH_COMM);
 
-                hipError_t err = hipMemcpy2DAsync(&sendBuffer[haloId][bufferOffset + mpiSendBufferIndex], region_howmanycols*sizeof(unsigned char),
-                                                  &buf[region_start], region_striderow*sizeof(unsigned char),
-                                                  region_howmanycols*sizeof(unsigned char), region_howmanyrows,
-                                                  hipMemcpyDeviceToHost, stream);
+        return traffic;
 
-                mpiSendBufferIndex += region_howmanyrows*region_howmanycols;
+    }
 
-                if(err != hipSuccess)
-                    std::cout << "Tausch::packSendBufferHIP(): HIP error detected: " << hipGetErrorString(err) << " (" << err << ")" << std::endl;
+    /***********************************************************************/
+    /*                              CHANNELS                               */
+    /***********************************************************************/
 
-            }
+    /**
+     * @brief
+     * Spread the messages of send() and recv() over several communicators (channels).
+     *
+     * With all traffic going through a single communicator many MPI implementations serialise
+     * on one lock or network endpoint. This sets up a pool of duplicated communicators (separate
+     * from the one used for striping, see setupCommunicatorPool()) and, unless a communicator is
+     * passed explicitly, sends and receives every message on the channel chosen by getChannel().
+     * All chunks of a striped halo then go through the channel of the halo. This is a collective
+     * call and needs to happen before any persistent requests are set up.
+     *
+     * @param numChannels
+     * The number of channels, 1 or less disables channels again.
+     */
+    inline void setupChannels(const int numChannels) {
 
-        } else {
+        for(auto &comm : channelPool)
+            MPI_Comm_free(&comm);
+        channelPool.clear();
 
-            unsigned char *tmpSendBuffer;
-            hipMalloc(&tmpSendBuffer, sendHaloIndicesSizePerBuffer[haloId][bufferId]*sizeof(unsigned char));
+        useChannels = (numChannels > 1);
+        if(!useChannels)
+            return;
 
-            size_t mpiSendBufferIndex = 0;
-            for(auto const & region : sendHaloIndices[haloId][bufferId]) {
+        for(int i = 0; i < numChannels; ++i) {
+            MPI_Comm comm;
+            MPI_Comm_dup(TAUSCH_COMM, &comm);
+            channelPool.push_back(comm);
+        }
 
-                const size_t &region_start = region[0];
-                const size_t &region_howmanycols = region[1];
-                const size_t &region_howmanyrows = region[2];
-                const size_t &region_striderow = region[3];
+    }
 
-                hipError_t err = hipMemcpy2DAsync(&tmpSendBuffer[mpiSendBufferIndex], region_howmanycols*sizeof(unsigned char),
-                                                  &buf[region_start], region_striderow*sizeof(unsigned char),
-                                                  region_howmanycols*sizeof(unsigned char), region_howmanyrows,
-                                                  hipMemcpyDeviceToDevice, stream);
+    /**
+     * \overload
+     *
+     * Assign a send halo to a channel, see setHaloChannel().
+     */
+    inline void setSendHaloChannel(const size_t haloId, const int channel) {
+        setHaloChannel(true, haloId, channel);
+    }
 
-                mpiSendBufferIndex += region_howmanyrows*region_howmanycols;
+    /**
+     * \overload
+     *
+     * Assign a recv halo to a channel, see setHaloChannel().
+     */
+    inline void setRecvHaloChannel(const size_t haloId, const int channel) {
+        setHaloChannel(false, haloId, channel);
+    }
 
-                if(err != hipSuccess)
-                    std::cout << "Tausch::packSendBufferHIP(): HIP error detected: " << hipGetErrorString(err) << " (" << err << ")" << std::endl;
+    /**
+     * @brief
+     * Exchange several halos, driving every channel from its own thread.
+     *
+     * The halos are grouped by channel (see setupChannels()) and each group is posted and
+     * completed by a separate thread, which allows the MPI library to progress the channels
+     * in parallel. This requires MPI_THREAD_MULTIPLE, otherwise the groups are handled one after
+     * the other by the calling thread. The halos need to use a packed buffer in host memory (see
+     * isAggregatable()). This call returns once all messages have completed, the received halos
+     * can then be unpacked as usual using unpackRecvBuffer().
+     *
+     * @param sendHaloIds
+     * The halo ids returned by the addSendHaloInfo() member function.
+     * @param recvHaloIds
+     * The halo ids returned by the addRecvHaloInfo() member function.
+     * @param msgtag
+     * The message tag to be used by this communication.
+     */
+    inline void exchangeOverChannels(const std::vector<size_t> &sendHaloIds, const std::vector<size_t> &recvHaloIds, const int msgtag) {
 
+        const int numChannels = std::max<int>(1, channelPool.size());
+
+        std::vector<std::vector<size_t> > sendPerChannel(numChannels), recvPerChannel(numChannels);
+        for(auto haloId : sendHaloIds) {
+            if(!isAggregatable(sendHaloCommunicationStrategy[haloId])) {
+                std::cout << "Tausch::exchangeOverChannels(): Halo " << haloId << " does not use a packed host buffer, skipping it..." << std::endl;
+                continue;
+            }
+            sendPerChannel[useChannels ? getChannel(true, haloId, msgtag, sendHaloRemoteRank.at(haloId)) : 0].push_back(haloId);
+        }
+        for(auto haloId : recvHaloIds) {
+            if(!isAggregatable(recvHaloCommunicationStrategy[haloId])) {
+                std::cout << "Tausch::exchangeOverChannels(): Halo " << haloId << " does not use a packed host buffer, skipping it..." << std::endl;
+                continue;
             }
+            recvPerChannel[useChannels ? getChannel(false, haloId, msgtag, recvHaloRemoteRank.at(haloId)) : 0].push_back(haloId);
+        }
 
-            hipMemcpyAsync(&sendBuffer[haloId][bufferOffset], tmpSendBuffer, sendHaloIndicesSizePerBuffer[haloId][bufferId]*sizeof(unsigned char), hipMemcpyDeviceToHost, stream);
+        auto driveChannel = [&](const int channel) {
 
-        }
+            MPI_Comm comm = (useChannels ? channelPool[channel] : TAUSCH_COMM);
 
-        if(blocking) {
+            std::vector<Status> status;
+            for(auto haloId : recvPerChannel[channel])
+                status.push_back(recv(haloId, msgtag, -1, -1, false, comm));
+            for(auto haloId : sendPerChannel[channel])
+                status.push_back(send(haloId, msgtag, -1, -1, false, comm));
+            for(auto &s : status)
+                s.wait();
 
-            hipEvent_t ev;
-            hipEventCreate(&ev);
-            hipEventRecord(ev, stream);
-            hipEventSynchronize(ev);
+            // the requests have been completed through the Status objects
+            for(auto haloId : recvPerChannel[channel])
+                if(!recvHaloMpiSetup[haloId][0])
+                    recvHaloMpiRequests[haloId][0] = MPI_REQUEST_NULL;
+            for(auto haloId : sendPerChannel[channel])
+                if(!sendHaloMpiSetup[haloId][0])
+                    sendHaloMpiRequests[haloId][0] = MPI_REQUEST_NULL;
+
+        };
 
+        int threadLevel;
+        MPI_Query_thread(&threadLevel);
+
+        if(threadLevel < MPI_THREAD_MULTIPLE || numChannels == 1) {
+            for(int channel = 0; channel < numChannels; ++channel)
+                driveChannel(channel);
+            return;
         }
 
-        return Status(stream);
+        std::vector<std::future<void> > threads;
+        for(int channel = 1; channel < numChannels; ++channel)
+            threads.push_back(std::async(std::launch::async, driveChannel, channel));
+        driveChannel(0);
+        for(auto &t : threads)
+            t.get();
 
     }
 
     /***********************************************************************/
-    /*                        UNPACK BUFFER (HIP)                         */
+    /*                              STRIPING                               */
     /***********************************************************************/
 
     /**
-     * \overload
+     * @brief
+     * Set up a pool of duplicated communicators.
      *
-     * Internally the data buffer will be recast to unsigned char.
+     * Creates the given number of duplicates of the communicator passed on during construction.
+     * Striped halos spread their chunks across these communicators (round robin), allowing the MPI
+     * library to drive them independently, e.g., across multiple rails. This is a collective call.
+     *
+     * @param numCommunicators
+     * The number of communicators in the pool.
      */
-    inline Status unpackRecvBufferHIP(const size_t haloId, const size_t bufferId, double *buf, const bool blocking = true, hipStream_t stream = 0) {
-        return unpackRecvBufferHIP(haloId, bufferId, reinterpret_cast<unsigned char*>(buf), blocking, stream);
+    inline void setupCommunicatorPool(const int numCommunicators) {
+
+        for(auto &comm : communicatorPool)
+            MPI_Comm_free(&comm);
+        communicatorPool.clear();
+
+        for(int i = 0; i < numCommunicators; ++i) {
+            MPI_Comm comm;
+            MPI_Comm_dup(TAUSCH_COMM, &comm);
+            communicatorPool.push_back(comm);
+        }
+
     }
 
     /**
-     * \overload
+     * @brief
+     * Enable striping of a large send halo.
      *
-     * Internally the data buffer will be recast to unsigned char.
+     * A packed halo of at least the given size is split into the given number of chunks that are
+     * sent as independent messages, spread across the communicator pool (see
+     * setupCommunicatorPool()) if one has been set up. This applies to halos with a packed buffer
+     * in host memory and takes precedence over MPIPersistent. The receiving side needs to use the
+     * same number of chunks and size threshold. Halos going through a custom transport (see
+     * setTransport()) are not striped.
+     *
+     * @param haloId
+     * The halo id returned by the addSendHaloInfo() member function.
+     * @param numChunks
+     * The number of chunks, a value of 1 or less disables striping.
+     * @param minSize
+     * Only halos of at least this size (in bytes) are striped.
      */
-    inline Status unpackRecvBufferHIP(const size_t haloId, const size_t bufferId, int *buf, const bool blocking = true, hipStream_t stream = 0) {
-        return unpackRecvBufferHIP(haloId, bufferId, reinterpret_cast<unsigned char*>(buf), blocking, stream);
+    inline void setSendStriping(const size_t haloId, const int numChunks, const size_t minSize = 1<<20) {
+        setStriping(true, haloId, numChunks, minSize);
     }
 
     /**
      * @brief
-     * Unpacks a HIP buffer for the given halo and buffer id.
+     * Enable striping of a large recv halo.
      *
-     * Unpacks a HIP buffer for the given halo and buffer id. Once this function has been called
-     * the received data can be immediately used.
+     * See setSendStriping(). The chunks can be unpacked as they arrive using
+     * unpackRecvBufferStriped().
      *
      * @param haloId
      * The halo id returned by the addRecvHaloInfo() member function.
-     * @param bufferId
-     * The id of the current buffer (numbered starting at 0).
-     * @param buf
-     * Pointer to the HIP buffer.
-     * @param blocking
-     * Whether to wait for the completion of the memory copies before returning.
-     * @param stream
-     * The hipStream to be used for queueing up the memory copies.
+     * @param numChunks
+     * The number of chunks, a value of 1 or less disables striping.
+     * @param minSize
+     * Only halos of at least this size (in bytes) are striped.
+     */
+    inline void setRecvStriping(const size_t haloId, const int numChunks, const size_t minSize = 1<<20) {
+        setStriping(false, haloId, numChunks, minSize);
+    }
+
+    /**
+     * @brief
+     * Whether a halo is sent/received in chunks.
+     *
+     * @param isSend
+     * Whether this is a send halo (true) or a recv halo (false).
+     * @param haloId
+     * The halo id returned by the addSendHaloInfo()/addRecvHaloInfo() member function.
      *
      * @return
-     * The Status object associated with the unpacking process.
+     * True if striping is enabled for this halo and applies to its size and strategy.
      */
-    inline Status unpackRecvBufferHIP(const size_t haloId, const size_t bufferId, unsigned char *buf, const bool blocking = true, hipStream_t stream = 0) {
-
-        size_t bufferOffset = 0;
-        for(size_t i = 0; i < bufferId; ++i)
-            bufferOffset += recvHaloIndicesSizePerBuffer[haloId][i];
-
-        if((recvHaloCommunicationStrategy[haloId]&Communication::GPUMultiCopy) == Communication::GPUMultiCopy) {
+    inline bool isStriped(const bool isSend, const size_t haloId) {
 
-            size_t mpiRecvBufferIndex = 0;
-            for(auto const & region : recvHaloIndices[haloId][bufferId]) {
+        auto &stripingPerHalo = (isSend ? sendHaloStriping : recvHaloStriping);
+        auto it = stripingPerHalo.find(haloId);
+        if(it == stripingPerHalo.end() || usesTransport(isSend, haloId, MPI_COMM_NULL))
+            return false;
 
-                const size_t &region_start = region[0];
-                const size_t &region_howmanycols = region[1];
-                const size_t &region_howmanyrows = region[2];
-                const size_t &region_striderow = region[3];
+        const size_t size = (isSend ? sendHaloIndicesSizeTotal[haloId] : recvHaloIndicesSizeTotal[haloId]);
+        return (size >= it->second.minSize &&
+                isAggregatable(isSend ? sendHaloCommunicationStrategy[haloId] : recvHaloCommunicationStrategy[haloId]));
 
-                hipError_t err = hipMemcpy2DAsync(&buf[region_start], region_striderow*sizeof(unsigned char),
-                                                  &recvBuffer[haloId][bufferOffset + mpiRecvBufferIndex], region_howmanycols*sizeof(unsigned char),
-                                                  region_howmanycols*sizeof(unsigned char), region_howmanyrows,
-                                                  hipMemcpyHostToDevice, stream);
+    }
 
-                if(err != hipSuccess)
-                    std::cout << "Tausch::unpackRecvBufferHIP(): HIP error detected: " << hipGetErrorString(err) << " (" << err << ")" << std::endl;
+    /**
+     * @brief
+     * Unpack a striped halo chunk by chunk as the chunks arrive.
+     *
+     * Blocks until all chunks have arrived. Each chunk is unpacked into all buffers it overlaps as
+     * soon as it has been received. For halos that are not striped this simply unpacks all buffers.
+     *
+     * @param haloId
+     * The halo id returned by the addRecvHaloInfo() member function.
+     * @param bufs
+     * Pointers to the data buffers, one per buffer id.
+     */
+    inline void unpackRecvBufferStriped(const size_t haloId, std::vector<unsigned char*> bufs) {
 
-                mpiRecvBufferIndex += region_howmanyrows*region_howmanycols;
+        if(!isStriped(false, haloId)) {
+            for(size_t iBuf = 0; iBuf < bufs.size(); ++iBuf)
+                unpackRecvBuffer(haloId, iBuf, bufs[iBuf]);
+            return;
+        }
 
-            }
+        Striping &striping = recvHaloStriping.at(haloId);
+        const int numChunks = striping.requests.size();
+        const size_t size = recvHaloIndicesSizeTotal[haloId];
 
-        } else {
+        for(int iChunk = 0; iChunk < numChunks; ++iChunk) {
 
-            unsigned char *tmpRecvBuffer;
-            hipMalloc(&tmpRecvBuffer, recvHaloIndicesSizePerBuffer[haloId][bufferId]*sizeof(unsigned char));
-            hipMemcpyAsync(tmpRecvBuffer, &recvBuffer[haloId][bufferOffset], recvHaloIndicesSizePerBuffer[haloId][bufferId]*sizeof(unsigned char), hipMemcpyHostToDevice, stream);
+            int c;
+            MPI_Waitany(numChunks, striping.requests.data(), &c, MPI_STATUS_IGNORE);
+            if(c == MPI_UNDEFINED)
+                c = iChunk;
 
-            size_t mpiRecvBufferIndex = 0;
-            for(auto const & region : recvHaloIndices[haloId][bufferId]) {
+            for(size_t iBuf = 0; iBuf < bufs.size(); ++iBuf)
+                unpackRecvBufferRange(haloId, iBuf, bufs[iBuf], size*c/numChunks, size*(c+1)/numChunks);
 
-                const size_t &region_start = region[0];
-                const size_t &region_howmanycols = region[1];
-                const size_t &region_howmanyrows = region[2];
-                const size_t &region_striderow = region[3];
+        }
 
-                hipError_t err = hipMemcpy2DAsync(&buf[region_start], region_striderow*sizeof(unsigned char),
-                                                  &tmpRecvBuffer[mpiRecvBufferIndex], region_howmanycols*sizeof(unsigned char),
-                                                  region_howmanycols*sizeof(unsigned char), region_howmanyrows,
-                                                  hipMemcpyDeviceToDevice, stream);
+    }
 
-                if(err != hipSuccess)
-                    std::cout << "Tausch::unpackRecvBufferHIP(): HIP error detected: " << hipGetErrorString(err) << " (" << err << ")" << std::endl;
+    /**
+     * @brief
+     * Unpack part of the receive buffer.
+     *
+     * Only the bytes in the range [rangeBegin, rangeEnd) of the packed receive buffer are unpacked
+     * into the given data buffer.
+     *
+     * @param haloId
+     * The halo id returned by the addRecvHaloInfo() member function.
+     * @param bufferId
+     * The id of the current buffer (numbered starting at 0).
+     * @param buf
+     * Pointer to the data buffer.
+     * @param rangeBegin
+     * The first byte of the packed receive buffer to be unpacked.
+     * @param rangeEnd
+     * One past the last byte of the packed receive buffer to be unpacked.
+     */
+    inline void unpackRecvBufferRange(const size_t haloId, const size_t bufferId, unsigned char *buf, const size_t rangeBegin, const size_t rangeEnd) {
 
-                mpiRecvBufferIndex += region_howmanyrows*region_howmanycols;
+        size_t mpiRecvBufferIndex = 0;
+        for(size_t i = 0; i < bufferId; ++i)
+            mpiRecvBufferIndex += recvHaloIndicesSizePerBuffer[haloId][i];
 
-            }
+        for(auto const & region : haloRegions(false, haloId, bufferId)) {
 
-        }
+            const size_t &region_start = region[0];
+            const size_t &region_howmanycols = region[1];
+            const size_t &region_howmanyrows = region[2];
+            const size_t &region_stridecol = region[3];
 
-        if(blocking) {
+            const size_t regionEnd = mpiRecvBufferIndex + region_howmanycols*region_howmanyrows;
 
-            hipEvent_t ev;
-            hipEventCreate(&ev);
-            hipEventRecord(ev, stream);
-            hipEventSynchronize(ev);
+            if(region_howmanycols == 0 || regionEnd <= rangeBegin) {
+                mpiRecvBufferIndex = regionEnd;
+                continue;
+            }
+            if(mpiRecvBufferIndex >= rangeEnd)
+                break;
 
-        }
+            size_t rows = (rangeBegin > mpiRecvBufferIndex ? (rangeBegin-mpiRecvBufferIndex)/region_howmanycols : 0);
+            for(; rows < region_howmanyrows; ++rows) {
 
-        return Status(stream);
+                const size_t rowBegin = mpiRecvBufferIndex + rows*region_howmanycols;
+                if(rowBegin >= rangeEnd)
+                    break;
 
-    }
+                const size_t copyBegin = std::max(rowBegin, rangeBegin);
+                const size_t copyEnd = std::min(rowBegin+region_howmanycols, rangeEnd);
+                std::memcpy(&buf[region_start + rows*region_stridecol + (copyBegin-rowBegin)], &recvBuffer[haloId][copyBegin], copyEnd-copyBegin);
 
-    /**@}*/
+            }
 
-#endif
+            mpiRecvBufferIndex = regionEnd;
 
+        }
 
+    }
 
     /***********************************************************************/
+    /*                             PREWARMING                              */
     /***********************************************************************/
 
     /**
      * @brief
-     * Converts a list of halo indices to rectangular subregions.
-     *
-     * Converts a list of halo indices to rectangular subregions. Each subregion is represented by
-     * four integers.
-     *
-     * @param indices
-     * A list of indices specifying the location of halo data.
-     *
-     * @return
-     * Returns the encoded halo information.
+     * Set up all resources needed for communication before the first exchange.
+     *
+     * The first exchange is usually much slower than all following ones: MPI establishes the
+     * connection to a rank the first time it is communicated with, persistent requests and
+     * datatypes combining several buffers are created the first time a halo is sent/received, and
+     * the pages of the staging buffers are only mapped when they are first written to. This does
+     * all of this upfront:
+     *
+     * - one tiny message is exchanged with every rank any halo is sent to or received from,
+     * - the persistent requests of all halos using MPIPersistent are initialized (this requires
+     *   the message tag, which is passed in per halo, halos without a tag are skipped),
+     * - the datatypes combining all buffers of halos using DerivedMpiDatatypeSingleMessage are
+     *   built (if the halo buffers have been set),
+     * - all staging buffers not yet placed on a NUMA node (see setSendHaloNumaNode()) are written
+     *   to once.
+     *
+     * With UCX the endpoints to all partners are created, too. This is a collective call over the
+     * communicator passed to the constructor. It must not be called while any message is in
+     * flight, as the staging buffers are overwritten.
+     *
+     * @param sendMsgtags
+     * The message tag to be used by send() for a halo id, needed for persistent requests.
+     * @param recvMsgtags
+     * The message tag to be used by recv() for a halo id, needed for persistent requests.
      */
-    inline std::vector<std::array<int, 4> > extractHaloIndicesWithStride(std::vector<int> indices) {
+    inline void prewarm(const std::map<size_t, int> &sendMsgtags = std::map<size_t, int>(), const std::map<size_t, int> &recvMsgtags = std::map<size_t, int>()) {
+
+        int myRank, mpiSize;
+        MPI_Comm_rank(TAUSCH_COMM, &myRank);
+        MPI_Comm_size(TAUSCH_COMM, &mpiSize);
+
+        // every rank learns how many ranks will contact it
+        std::vector<int> isPartner(mpiSize, 0);
+        for(auto const & remoteRanks : {&sendHaloRemoteRank, &recvHaloRemoteRank})
+            for(auto const & rank : *remoteRanks)
+                if(rank >= 0 && rank < mpiSize && rank != myRank)
+                    isPartner[rank] = 1;
+
+        MPI_Comm comm;
+        MPI_Comm_dup(TAUSCH_COMM, &comm);
+
+        int numIncoming;
+        MPI_Reduce_scatter_block(isPartner.data(), &numIncoming, 1, MPI_INT, MPI_SUM, comm);
+
+        std::vector<unsigned char> incoming(numIncoming);
+        unsigned char outgoing = 0;
+        std::vector<MPI_Request> requests;
+        for(int i = 0; i < numIncoming; ++i) {
+            requests.push_back(MPI_REQUEST_NULL);
+            MPI_Irecv(&incoming[i], 1, MPI_UNSIGNED_CHAR, MPI_ANY_SOURCE, 0, comm, &requests.back());
+        }
+        for(int rank = 0; rank < mpiSize; ++rank) {
+            if(!isPartner[rank])
+                continue;
+            requests.push_back(MPI_REQUEST_NULL);
+            MPI_Isend(&outgoing, 1, MPI_UNSIGNED_CHAR, rank, 0, comm, &requests.back());
+#ifdef TAUSCH_UCX
+            if(ucxWorker != nullptr)
+                getUcxEndpoint(rank);
+#endif
+        }
+        MPI_Waitall(requests.size(), requests.data(), MPI_STATUSES_IGNORE);
 
-        // nothing to do
-        if(indices.size() == 0)
-            return std::vector<std::array<int, 4> >();
+        MPI_Comm_free(&comm);
 
-        // first we build a collection of all consecutive rows
-        std::vector<std::array<int, 2> > rows;
+        for(int isSend = 1; isSend >= 0; --isSend) {
 
-        size_t curIndex = 1;
-        int start = indices[0];
-        int howmany = 1;
-        while(curIndex < indices.size()) {
+            const auto &msgtags = (isSend ? sendMsgtags : recvMsgtags);
+            const auto &deleted = (isSend ? sendBufferHaloIdDeleted : recvBufferHaloIdDeleted);
+            const size_t numHalos = (isSend ? sendBuffer.size() : recvBuffer.size());
 
-            if(indices[curIndex]-indices[curIndex-1] == 1)
-                ++howmany;
-            else {
+            for(size_t haloId = 0; haloId < numHalos; ++haloId) {
 
-                rows.push_back({start, howmany});
+                if(std::find(deleted.begin(), deleted.end(), static_cast<int>(haloId)) != deleted.end())
+                    continue;
 
-                start = indices[curIndex];
-                howmany = 1;
+                prewarmHalo(isSend, haloId, msgtags);
 
             }
 
-            ++curIndex;
-
         }
 
-        rows.push_back({start, howmany});
-
-        // second we look for simple patterns within these rows
-        std::vector<std::array<int, 4> > ret;
-
-        ret.push_back({rows[0][0], rows[0][1], 1, 0});
-
-        for(size_t currow = 1; currow < rows.size(); ++currow) {
-
-            if(rows[currow][1] == ret.back()[1] && (ret.back()[3] == 0 || rows[currow][0]-(ret.back()[0]+(ret.back()[2]-1)*ret.back()[3]) == ret.back()[3])) {
+    }
 
-                if(ret.back()[3] == 0) {
-                    ++ret.back()[2];
-                    ret.back()[3] = (rows[currow][0]-ret.back()[0]);
-                } else
-                    ++ret.back()[2];
+    /***********************************************************************/
+    /*                          NETWORK EMULATION                          */
+    /***********************************************************************/
 
-            } else {
+    /**
+     * @brief
+     * Emulate a network with a given latency and bandwidth.
+     *
+     * Messages between ranks on the same machine are almost free, which makes it impossible to
+     * judge whether a strategy hides communication latency. With network emulation enabled the
+     * Status objects returned by send() and recv() only report completion once the message would
+     * have completed on the modeled network:
+     *
+     * - a message of n bytes takes latency + n/bandwidth,
+     * - the messages sent by a rank are serialized on its link,
+     * - the ranks of a node share the bandwidth of the node, each additional rank reduces the
+     *   bandwidth available to a rank by the contention factor.
+     *
+     * Consecutive ranks are grouped into nodes of ranksPerNode ranks, messages within a node are
+     * not delayed. The modeled arrival time is computed by the sender and sent along with every
+     * message, this relies on std::chrono::steady_clock being the same for all ranks, i.e., all
+     * ranks running on the same machine. Messages sent using an explicitly passed communicator, or
+     * sent using a custom transport, are not emulated. This is a collective call over the
+     * communicator passed to the constructor.
+     *
+     * @param latency
+     * The latency of a message in seconds.
+     * @param bandwidth
+     * The bandwidth of the link of a node in bytes per second.
+     * @param ranksPerNode
+     * The number of consecutive ranks forming a modeled node.
+     * @param contention
+     * The fraction of the bandwidth taken away by every additional rank on a node (0 means no
+     * contention, 1 means the bandwidth is shared evenly between all ranks of a node).
+     */
+    inline void setNetworkEmulation(const double latency, const double bandwidth, const int ranksPerNode = 1, const double contention = 0) {
 
-                ret.push_back({rows[currow][0], rows[currow][1], 1, 0});
-            }
+        if(networkEmulation.comm == MPI_COMM_NULL)
+            MPI_Comm_dup(TAUSCH_COMM, &networkEmulation.comm);
 
-        }
+        networkEmulation.enabled = (bandwidth > 0);
+        networkEmulation.latency = std::max(0.0, latency);
+        networkEmulation.bandwidth = bandwidth;
+        networkEmulation.ranksPerNode = std::max(1, ranksPerNode);
+        networkEmulation.contention = std::max(0.0, contention);
+        networkEmulation.linkFreeAt = 0;
 
-        return ret;
+    }
 
+    /**
+     * @brief
+     * Disable network emulation enabled using setNetworkEmulation().
+     *
+     * This needs to be called on all ranks before the next message is sent.
+     */
+    inline void disableNetworkEmulation() {
+        networkEmulation.enabled = false;
     }
 
+    /***********************************************************************/
+    /*                              TRANSPORT                              */
+    /***********************************************************************/
+
     /**
      * @brief
-     * Converts indices based on a certain data type into indices for unsigned char.
+     * Send and receive the packed halos through a custom transport.
      *
-     * Converts indices based on a certain data type into indices for unsigned char.
+     * Once a transport is set all halos using their staging buffer (i.e., not using derived
+     * datatypes, CUDA-aware MPI, partitioned communication, or UCX) are sent and received using the
+     * transport instead of MPI, unless a communicator is passed to send()/recv() explicitly. The
+     * remote ranks are the ranks of the transport. Passing nullptr goes back to using MPI.
      *
-     * @param indices
-     * The halo indices based on given data type.
-     * @param typeSize
-     * The size of the data type.
+     * A halo going through the transport is always sent as one message from its staging buffer:
+     * TryDirectCopy, striping (setSendStriping()/setRecvStriping()) and a ring of send buffers
+     * (setSendBufferRing()) are not applied to it.
      *
-     * @return
-     * Returns a list of indices based on unsigned char.
+     * @param transport
+     * The transport to use, e.g., an MpiTransport or an endpoint of a ThreadTransport.
      */
-    inline std::vector<std::array<int, 4> > convertToUnsignedCharIndices(std::vector<std::array<int, 4> > indices, const size_t typeSize) {
-
-        if(typeSize == 1)
-            return indices;
+    inline void setTransport(std::shared_ptr<Transport> transport) {
 
-        std::vector<std::array<int, 4> > ret;
+        for(auto &status : recvHaloTransportStatus)
+            this->transport->wait(status.second);
+        recvHaloTransportStatus.clear();
 
-        for(auto region : indices)
-            ret.push_back({region[0]*static_cast<int>(typeSize),
-                           region[1]*static_cast<int>(typeSize),
-                           region[2],
-                           region[3]*static_cast<int>(typeSize)});
+        this->transport = transport;
 
-        return ret;
+    }
 
+    /**
+     * @brief
+     * Get the transport set using setTransport().
+     *
+     * @return
+     * The transport, nullptr if MPI is used directly.
+     */
+    inline std::shared_ptr<Transport> getTransport() {
+        return transport;
     }
 
+    /***********************************************************************/
+    /*                                 UCX                                 */
+    /***********************************************************************/
+
     /**
      * @brief
-     * Static member function doing halo exchanges with all possible and applicable
-     * configurations.
+     * Set up the UCX transport.
      *
-     * Static member function doing halo exchanges with all possible and applicable
-     * configurations to find the fastest communication path
+     * Halos using the UCX communication strategy are sent as UCX tagged messages instead of MPI
+     * messages, which avoids the MPI matching and progress layers on the critical path. This
+     * creates the UCX context and worker and exchanges the worker addresses of all ranks using MPI,
+     * the endpoints are created the first time a rank is communicated with. On a single machine UCX
+     * picks shared memory and loopback transports by itself. This is a collective call over the
+     * communicator passed to the constructor and needs to be called before setting the UCX
+     * strategy for any halo. Calling it more than once has no effect.
      *
-     * @param testcomm
-     * Which communicator to use
+     * Without TAUSCH_UCX being defined this only prints a warning.
      *
      * @return
-     * Returns a vector containing the best send and the best receiving
-     * communication strategy.
+     * Whether UCX has been set up successfully on all ranks.
      */
-    static std::vector<Communication> testForBestCommunication(MPI_Comm testcomm, bool printProgress = true) {
-
-        std::vector<Communication> strategies;
-        std::vector<std::string> strategyNames;
-
-        strategies.push_back(Communication::Default);
-        strategyNames.push_back("Default");
-
-        strategies.push_back(Communication::TryDirectCopy);
-        strategyNames.push_back("TryDirectCopy");
-
-        strategies.push_back(Communication::DerivedMpiDatatype);
-        strategyNames.push_back("DerivedMpiDatatype");
-
-        strategies.push_back(Communication::CUDAAwareMPI);
-        strategyNames.push_back("CUDAAwareMPI");
+    inline bool setupUcx() {
 
-        strategies.push_back(Communication::MPIPersistent);
-        strategyNames.push_back("MPIPersistent");
+#ifdef TAUSCH_UCX
 
-        strategies.push_back(Communication::GPUMultiCopy);
-        strategyNames.push_back("GPUMultiCopy");
+        if(ucxWorker != nullptr)
+            return true;
 
-        int bestSend = 0;
-        int bestRecv = 0;
+        int ok = 1;
 
-        double t_best = -1;
+        ucp_config_t *config;
+        if(ucp_config_read(nullptr, nullptr, &config) != UCS_OK)
+            ok = 0;
 
-        int mpiRank, mpiSize;
-        MPI_Comm_rank(MPI_COMM_WORLD, &mpiRank);
-        MPI_Comm_size(MPI_COMM_WORLD, &mpiSize);
+        if(ok) {
+            ucp_params_t params;
+            params.field_mask = UCP_PARAM_FIELD_FEATURES;
+            params.features = UCP_FEATURE_TAG;
+            if(ucp_init(&params, config, &ucxContext) != UCS_OK) {
+                ucxContext = nullptr;
+                ok = 0;
+            }
+            ucp_config_release(config);
+        }
 
-        if(mpiRank == 0 && printProgress)
-            std::cout << " ** Testing communication stratgies" << std::endl << std::endl;
+        if(ok) {
+            ucp_worker_params_t params;
+            params.field_mask = UCP_WORKER_PARAM_FIELD_THREAD_MODE;
+            params.thread_mode = (threadSafe ? UCS_THREAD_MODE_MULTI : UCS_THREAD_MODE_SINGLE);
+            if(ucp_worker_create(ucxContext, &params, &ucxWorker) != UCS_OK) {
+                ucxWorker = nullptr;
+                ok = 0;
+            }
+        }
 
-        for(size_t iSend = 0; iSend < strategies.size(); ++iSend) {
+        ucp_address_t *address = nullptr;
+        size_t addressLength = 0;
+        if(ok && ucp_worker_get_address(ucxWorker, &address, &addressLength) != UCS_OK) {
+            address = nullptr;
+            addressLength = 0;
+            ok = 0;
+        }
 
-            for(size_t iRecv = 0; iRecv < strategies.size(); ++iRecv) {
+        // every rank has to succeed, otherwise nobody uses UCX
+        MPI_Allreduce(MPI_IN_PLACE, &ok, 1, MPI_INT, MPI_MIN, TAUSCH_COMM);
 
-#ifndef TAUSCH_CUDA
-                // require CUDA
-                if(strategies[iSend] == Communication::CUDAAwareMPI || strategies[iRecv] == Communication::CUDAAwareMPI)
-                    continue;
-#endif
+        if(!ok) {
+            std::cout << "Tausch::setupUcx(): Unable to set up UCX on all ranks..." << std::endl;
+            if(address != nullptr)
+                ucp_worker_release_address(ucxWorker, address);
+            releaseUcx();
+            return false;
+        }
 
-#if !defined(TAUSCH_CUDA) && !defined(TAUSCH_HIP) && !defined(TAUSCH_OPENCL)
-                // requires GPGPU
-                if(strategies[iSend] == Communication::GPUMultiCopy || strategies[iRecv] == Communication::GPUMultiCopy)
-                    continue;
-#endif
+        int mpiSize;
+        MPI_Comm_size(TAUSCH_COMM, &mpiSize);
 
-#if defined(TAUSCH_CUDA) || defined(TAUSCH_HIP) || defined(TAUSCH_OPENCL)
-                // requires CPU
-                if(strategies[iSend] == Communication::TryDirectCopy || strategies[iRecv] == Communication::TryDirectCopy)
-                    continue;
-#endif
+        int myLength = static_cast<int>(addressLength);
+        std::vector<int> lengths(mpiSize);
+        MPI_Allgather(&myLength, 1, MPI_INT, lengths.data(), 1, MPI_INT, TAUSCH_COMM);
 
-                // required on both sides and for single MPI rank only
-                if((strategies[iRecv] == Communication::TryDirectCopy && (strategies[iSend] != Communication::TryDirectCopy || mpiSize > 1)) ||
-                   (strategies[iSend] == Communication::TryDirectCopy && (strategies[iRecv] != Communication::TryDirectCopy || mpiSize > 1)))
-                    continue;
+        std::vector<int> displs(mpiSize, 0);
+        for(int r = 1; r < mpiSize; ++r)
+            displs[r] = displs[r-1] + lengths[r-1];
 
-                if(mpiRank == 0 && printProgress)
-                    std::cout << "   > Testing " << strategyNames[iSend] << " (send) / " << strategyNames[iRecv] << " (recv) ... " << std::flush;
+        std::vector<char> allAddresses(displs[mpiSize-1] + lengths[mpiSize-1]);
+        MPI_Allgatherv(address, myLength, MPI_BYTE, allAddresses.data(), lengths.data(), displs.data(), MPI_BYTE, TAUSCH_COMM);
 
-                std::vector<double> allt;
+        ucp_worker_release_address(ucxWorker, address);
 
-                // we try multiple problem and halo sizes
-                for(int sizepower = 1; sizepower < 5; ++sizepower) {
+        ucxAddresses.resize(mpiSize);
+        for(int r = 0; r < mpiSize; ++r)
+            ucxAddresses[r].assign(allAddresses.begin()+displs[r], allAddresses.begin()+displs[r]+lengths[r]);
+        ucxEndpoints.assign(mpiSize, nullptr);
 
-                    const int size = std::pow(10,sizepower);
+        return true;
 
-                    for(int halowidth = 1; halowidth < 4; ++halowidth) {
+#else
 
-                        Tausch testtausch(testcomm, true);
+        std::cout << "Tausch::setupUcx(): Tausch has been compiled without TAUSCH_UCX..." << std::endl;
+        return false;
 
-                        std::vector<unsigned char> sendbuf(size*size);
-                        std::vector<unsigned char> recvbuf(size*size);
+#endif
 
-                        std::vector<std::array<int,4> > indices;
-                        std::array<int,4> bottom = {0, size, halowidth, size};
-                        std::array<int,4> top = {size*(size-halowidth), size, halowidth, size};
-                        std::array<int,4> left = {size*halowidth, halowidth, size-2*halowidth, size};
-                        std::array<int,4> right = {size*halowidth-2*halowidth, halowidth, size-2*halowidth, size};
-                        indices.push_back(bottom);
-                        indices.push_back(top);
-                        indices.push_back(left);
-                        indices.push_back(right);
+    }
 
-                        testtausch.addSendHaloInfo(indices, 1, -1);
-                        testtausch.addRecvHaloInfo(indices, 1, -1);
+    /***********************************************************************/
+    /*                           SEND BUFFER RING                          */
+    /***********************************************************************/
 
-                        testtausch.setSendCommunicationStrategy(0, strategies[iSend]);
-                        testtausch.setRecvCommunicationStrategy(0, strategies[iRecv]);
+    /**
+     * @brief
+     * Use a ring of several staging buffers for a send halo.
+     *
+     * With a single staging buffer a send has to complete before the halo can be packed again.
+     * With a ring of depth K each send() posts the message from the current buffer and then moves
+     * on to the next buffer in the ring, which is what the following packing writes into. Only the
+     * send posted K-1 sends earlier needs to have completed at that point, so packing the next step
+     * overlaps with sending the current one. Every buffer of the ring has its own request (a
+     * persistent one with MPIPersistent). The Status returned by send() refers to the message just
+     * posted.
+     *
+     * This applies to halos sent from the staging buffer, i.e., not with derived datatypes,
+     * CUDA-aware MPI, partitioned communication, striping, or a custom transport.
+     *
+     * @param haloId
+     * The halo id returned by the addSendHaloInfo() member function.
+     * @param depth
+     * The number of staging buffers, 1 uses the single staging buffer again.
+     */
+    inline void setSendBufferRing(const size_t haloId, const int depth) {
+
+        packFutures[haloId].wait();
+        releasePersistentRequests(true, haloId);
+
+        auto it = sendHaloRing.find(haloId);
+        if(it != sendHaloRing.end()) {
+            for(auto &req : it->second.requests)
+                MPI_Wait(&req, MPI_STATUS_IGNORE);
+            for(auto buf : it->second.buffers)
+                if(buf != sendBuffer[haloId])
+                    delete[] buf;
+            sendHaloRing.erase(it);
+        }
 
-                        int sendRank = (mpiRank+1)%mpiSize;
-                        int recvRank = (mpiRank+mpiSize-1)%mpiSize;
+        if(depth <= 1)
+            return;
 
-                        if(strategies[iRecv] == Communication::TryDirectCopy) {
-                            sendRank = mpiRank;
-                            recvRank = mpiRank;
-                        }
+        SendRing &ring = sendHaloRing[haloId];
+        ring.buffers.push_back(sendBuffer[haloId]);
+        for(int i = 1; i < depth; ++i)
+            ring.buffers.push_back(new unsigned char[sendHaloIndicesSizeTotal[haloId]]);
+        ring.requests.resize(depth, MPI_REQUEST_NULL);
+        ring.setup.resize(depth, false);
 
-                        if(strategies[iSend] == Communication::DerivedMpiDatatype)
-                            testtausch.setSendHaloBuffer(0, 0, &sendbuf[0]);
-                        if(strategies[iRecv] == Communication::DerivedMpiDatatype)
-                            testtausch.setRecvHaloBuffer(0, 0, &recvbuf[0]);
+    }
 
-                        auto t1 = std::chrono::steady_clock::now();
+    /***********************************************************************/
+    /*                      PARTITIONED COMMUNICATION                      */
+    /***********************************************************************/
 
-                        for(int iter = 0; iter < 10; ++iter) {
+    /**
+     * @brief
+     * Set the number of partitions of a send halo using MPIPartitioned.
+     *
+     * With MPIPartitioned (requires MPI 4) the packed halo is sent as a single partitioned message.
+     * A partition is marked ready (MPI_Pready) as soon as all buffers overlapping it have been
+     * packed and send() has been called, i.e., calling send() before packSendBuffer() overlaps the
+     * packing with the transfer. Packing in a separate thread requires MPI_THREAD_MULTIPLE. On the
+     * receiving side unpackRecvBuffer() only waits for the partitions overlapping the unpacked
+     * buffer (MPI_Parrived). Partitioned messages only match partitioned messages.
+     *
+     * By default a halo is split into partitions of about 16 kB, but into at least as many partitions
+     * as it has buffers (up to 64 partitions). packSendBuffer() marks each partition as soon as it has been
+     * filled, i.e., even a halo with a single buffer overlaps packing and sending. The number of
+     * partitions is reduced to the nearest divisor of the halo size in bytes (all partitions need
+     * to be of equal size). Both sides can use different numbers of partitions.
+     *
+     * @param haloId
+     * The halo id returned by the addSendHaloInfo() member function.
+     * @param numPartitions
+     * The requested number of partitions.
+     */
+    inline void setSendPartitions(const size_t haloId, const int numPartitions) {
+        setupPartitions(true, haloId, numPartitions);
+    }
 
-                            if(strategies[iSend] != Communication::DerivedMpiDatatype && strategies[iSend] != Communication::TryDirectCopy)
-                                testtausch.packSendBuffer(0, 0, &sendbuf[0]);
+    /**
+     * @brief
+     * Set the number of partitions of a recv halo using MPIPartitioned.
+     *
+     * See setSendPartitions().
+     *
+     * @param haloId
+     * The halo id returned by the addRecvHaloInfo() member function.
+     * @param numPartitions
+     * The requested number of partitions.
+     */
+    inline void setRecvPartitions(const size_t haloId, const int numPartitions) {
+        setupPartitions(false, haloId, numPartitions);
+    }
 
-                            Status sendstatus(MPI_REQUEST_NULL);
-                            Status recvstatus(MPI_REQUEST_NULL);
+    /***********************************************************************/
+    /*                      AUTO-REARMING RECEIVES                         */
+    /***********************************************************************/
 
-                            if(strategies[iSend] == Communication::DerivedMpiDatatype)
-                                sendstatus = testtausch.send(0, 0, sendRank, 0);
-                            else
-                                sendstatus = testtausch.send(0, 0, sendRank);
+    /**
+     * @brief
+     * Restart the persistent receive of a halo as soon as it has been unpacked.
+     *
+     * Normally a persistent receive is only restarted when recv() is called for the next
+     * iteration, which is often after the local computation. Messages arriving before that end up
+     * in the unexpected-message queue of MPI and need to be copied once more. With auto-rearming
+     * the receive is restarted by the blocking unpackRecvBuffer()/unpackRecvBuffers() once all
+     * buffers of the halo have been unpacked, and the following call to recv() does not restart
+     * it again. The receive is always posted and the messages can land directly in the staging
+     * buffer.
+     *
+     * This only applies to halos received into the staging buffer using MPIPersistent (no derived
+     * datatypes, CUDA-aware MPI, partitioned communication, or striping). The remote rank and
+     * message tag are the ones of the first recv() call. The last restarted receive stays posted
+     * until it is cancelled when the halo is set up again or this object is destroyed, until then
+     * it matches any message with the same source and tag on the communicator.
+     *
+     * @param haloId
+     * The halo id returned by the addRecvHaloInfo() member function.
+     * @param enable
+     * Whether to enable or disable auto-rearming.
+     */
+    inline void setRecvAutoRearm(const size_t haloId, const bool enable = true) {
 
-                            if(strategies[iRecv] == Communication::DerivedMpiDatatype)
-                                recvstatus = testtausch.recv(0, 0, recvRank, 0);
-                            else
-                                recvstatus = testtausch.recv(0, 0, recvRank);
+        RecvRearm &rearm = recvHaloRearm[haloId];
+        rearm.enabled = enable;
+        rearm.unpacked.assign(recvHaloNumBuffers[haloId], false);
 
-                            sendstatus.wait();
-                            recvstatus.wait();
+    }
 
-                            if(strategies[iRecv] != Communication::DerivedMpiDatatype && strategies[iRecv] != Communication::TryDirectCopy)
-                                testtausch.unpackRecvBuffer(0, 0, &recvbuf[0]);
+    /***********************************************************************/
+    /*                           UNPACK BUFFER                             */
+    /***********************************************************************/
 
-                        }
+    /**
+     * \overload
+     *
+     * Internally the data buffer will be recast to unsigned char.
+     */
+    inline Status unpackRecvBuffer(const size_t haloId, const size_t bufferId, double *buf, const bool blocking = true) {
+        return unpackRecvBuffer(haloId, bufferId, reinterpret_cast<unsigned char*>(buf), blocking);
+    }
 
-                        auto t2 = std::chrono::steady_clock::now();
+    /**
+     * \overload
+     *
+     * Internally the data buffer will be recast to unsigned char.
+     */
+    inline Status unpackRecvBuffer(const size_t haloId, const size_t bufferId, int *buf, const bool blocking = true) {
+        return unpackRecvBuffer(haloId, bufferId, reinterpret_cast<unsigned char*>(buf), blocking);
+    }
 
-                        double duration = std::chrono::duration<double, std::milli>(t2-t1).count();
+    /**
+     * @brief
+     * Unpacks a data buffer for the given halo and buffer id.
+     *
+     * Unpacks a data buffer for the given halo and buffer id. If this function has been called in a blocking way, then
+     * the received data can be used immediately. Otherwise, make sure to check whether the operation has completed or not.
+     *
+     * @param haloId
+     * The halo id returned by the addRecvHaloInfo() member function.
+     * @param bufferId
+     * The id of the current buffer (numbered starting at 0).
+     * @param buf
+     * Pointer to the data buffer.
+     * @param blocking
+     * Whether to do the unpacking in a separate thread or not.
+     *
+     * @return
+     * A Status object containing information about the unpacking operation is returned.
+     */
+    inline Status unpackRecvBuffer(const size_t haloId, const size_t bufferId, unsigned char *buf, const bool blocking = true) {
+
+        checkRecvBufferArrived(haloId, bufferId);
+
+        if(blocking) {
+
+            size_t bufferOffset = 0;
+            for(size_t i = 0; i < bufferId; ++i)
+                bufferOffset += recvHaloIndicesSizePerBuffer[haloId][i];
+
+            const auto &elementOffsets = recvHaloElementOffsets[haloId][bufferId];
+
+            size_t mpiRecvBufferIndex = 0;
+
+            if(elementOffsets.size() > 0) {
+
+                scatterElements(buf, &recvBuffer[haloId][bufferOffset], elementOffsets.data(), elementOffsets.size(), recvHaloTypeSizePerBuffer[haloId][bufferId]);
+
+            } else {
+
+                const bool prefetch = (size_t(recvHaloIndicesSizeTotal[haloId]) >= unpackPrefetchThreshold);
+
+                for(auto const & region : haloRegions(false, haloId, bufferId)) {
+
+                    const size_t &region_start = region[0];
+                    const size_t &region_howmanycols = region[1];
+                    const size_t &region_howmanyrows = region[2];
+                    const size_t &region_stridecol = region[3];
+
+                    for(size_t rows = 0; rows < region_howmanyrows; ++rows) {
+
+                        if(prefetch && rows+prefetchDistance < region_howmanyrows)
+                            prefetchRow(&buf[region_start + (rows+prefetchDistance)*region_stridecol], region_howmanycols);
+                        std::memcpy(&buf[region_start + rows*region_stridecol], &recvBuffer[haloId][bufferOffset + mpiRecvBufferIndex], region_howmanycols);
+                        mpiRecvBufferIndex += region_howmanycols;
+
+                    }
+
+                }
+
+            }
+
+            rearmAfterUnpack(haloId, bufferId);
+
+            return Status(std::shared_future<void>());
+
+        } else {
+
+            auto future = std::shared_future<void>(std::async(std::launch::async, [=]() {
+
+                pinWorkerThread(false, haloId);
+
+                size_t bufferOffset = 0;
+                for(size_t i = 0; i < bufferId; ++i)
+                    bufferOffset += recvHaloIndicesSizePerBuffer[haloId][i];
+
+                const auto &elementOffsets = recvHaloElementOffsets[haloId][bufferId];
+
+                size_t mpiRecvBufferIndex = 0;
+
+                if(elementOffsets.size() > 0) {
+
+                    scatterElements(buf, &recvBuffer[haloId][bufferOffset], elementOffsets.data(), elementOffsets.size(), recvHaloTypeSizePerBuffer[haloId][bufferId]);
+
+                } else {
+
+                    const bool prefetch = (size_t(recvHaloIndicesSizeTotal[haloId]) >= unpackPrefetchThreshold);
+
+                    for(auto const & region : haloRegions(false, haloId, bufferId)) {
+
+                        const size_t &region_start = region[0];
+                        const size_t &region_howmanycols = region[1];
+                        const size_t &region_howmanyrows = region[2];
+                        const size_t &region_stridecol = region[3];
+
+                        for(size_t rows = 0; rows < region_howmanyrows; ++rows) {
+
+                            if(prefetch && rows+prefetchDistance < region_howmanyrows)
+                                prefetchRow(&buf[region_start + (rows+prefetchDistance)*region_stridecol], region_howmanycols);
+                            std::memcpy(&buf[region_start + rows*region_stridecol], &recvBuffer[haloId][bufferOffset + mpiRecvBufferIndex], region_howmanycols);
+                            mpiRecvBufferIndex += region_howmanycols;
+
+                        }
+
+                    }
+
+                }
+
+            }));
+            unpackFutures[haloId].set(future);
+
+            return unpackFutures[haloId];
+
+        }
+
+    }
+
+    /***********************************************************************/
+    /*                        UNPACK MULTIPLE BUFFERS                      */
+    /***********************************************************************/
+
+    /**
+     * \overload
+     *
+     * Internally the data buffers will be recast to unsigned char.
+     */
+    inline Status unpackRecvBuffers(const size_t haloId, const std::vector<double*> &bufs, const bool blocking = true) {
+        std::vector<unsigned char*> ucbufs;
+        for(auto b : bufs)
+            ucbufs.push_back(reinterpret_cast<unsigned char*>(b));
+        return unpackRecvBuffers(haloId, ucbufs, blocking);
+    }
+
+    /**
+     * \overload
+     *
+     * Internally the data buffers will be recast to unsigned char.
+     */
+    inline Status unpackRecvBuffers(const size_t haloId, const std::vector<int*> &bufs, const bool blocking = true) {
+        std::vector<unsigned char*> ucbufs;
+        for(auto b : bufs)
+            ucbufs.push_back(reinterpret_cast<unsigned char*>(b));
+        return unpackRecvBuffers(haloId, ucbufs, blocking);
+    }
+
+    /**
+     * @brief
+     * Unpacks all data buffers of the given halo at once.
+     *
+     * This is equivalent to calling unpackRecvBuffer() for each buffer id, with buffer i being
+     * unpacked into bufs[i]. If all buffers share the same halo indices and type size, the region
+     * list is only traversed once for all buffers. If the halo is large enough (see
+     * setMultiFieldParallelThreshold()), the buffers are split into groups unpacked concurrently.
+     *
+     * @param haloId
+     * The halo id returned by the addRecvHaloInfo() member function.
+     * @param bufs
+     * Pointers to the data buffers, one per buffer id.
+     * @param blocking
+     * Whether to do the unpacking in a separate thread or not.
+     *
+     * @return
+     * A Status object containing information about the unpacking operation is returned.
+     */
+    inline Status unpackRecvBuffers(const size_t haloId, const std::vector<unsigned char*> &bufs, const bool blocking = true) {
+
+        for(size_t bufferId = 0; bufferId < bufs.size(); ++bufferId)
+            checkRecvBufferArrived(haloId, bufferId);
+
+        auto unpack = [=]() {
+            forEachFieldGroup(bufs.size(), recvHaloIndicesSizeTotal[haloId], getThreadNumaNode(false, haloId), [=](const size_t first, const size_t last) {
+                unpackRecvBufferFields(haloId, bufs, first, last);
+            });
+        };
+
+        if(blocking) {
+
+            unpack();
+
+            for(size_t bufferId = 0; bufferId < bufs.size(); ++bufferId)
+                rearmAfterUnpack(haloId, bufferId);
+
+            return Status(std::shared_future<void>());
+
+        } else {
+
+            auto future = std::shared_future<void>(std::async(std::launch::async, [=]() {
+                pinWorkerThread(false, haloId);
+                unpack();
+            }));
+            unpackFutures[haloId].set(future);
+
+            return unpackFutures[haloId];
+
+        }
+
+    }
+
+    /***********************************************************************/
+    /***********************************************************************/
+
+#ifdef TAUSCH_OPENCL
+
+    /** @name OpenCL
+     * The OpenCL routines. In order to use these the macro TAUSCH_OPENCL needs to be defined before including the tausch header.
+     */
+    /**@{*/
+
+    /***********************************************************************/
+    /*                          SET OPENCL SETUP                           */
+    /***********************************************************************/
+
+    /**
+     * @brief
+     * Tells Tausch about an existing OpenCL environment.
+     *
+     * Tells Tausch about an existing OpenCL environment. The environment needs to be set up by the user before calling this function.
+     *
+     * @param ocl_device
+     * The OpenCL device.
+     * @param ocl_context
+     * The OpenCL context.
+     * @param ocl_queue
+     * The OpenCL CommandQueue.
+     */
+    inline void setOpenCL(cl::Device ocl_device, cl::Context ocl_context, cl::CommandQueue ocl_queue) {
+        this->ocl_device = ocl_device;
+        this->ocl_context = ocl_context;
+        this->ocl_queue = ocl_queue;
+    }
+
+    /**
+     * @brief
+     * Tells Tausch to set up an OpenCL environment.
+     *
+     * Tells Tausch to set up an OpenCL environment. Tausch will use this environment for all subsequent OpenCL operations.
+     *
+     * @param deviceNumber
+     * Choose a device number.
+     *
+     * @return
+     * String containing the name of the chosen OpenCL device.
+     */
+    inline std::string enableOpenCL(size_t deviceNumber = 0) {
+        try {
+
+            std::vector<cl::Platform> all_platforms;
+            cl::Platform::get(&all_platforms);
+            cl::Platform ocl_platform = all_platforms[0];
+
+            std::vector<cl::Device> all_devices;
+            ocl_platform.getDevices(CL_DEVICE_TYPE_ALL, &all_devices);
+            if(deviceNumber >= all_devices.size())
+                deviceNumber = 0;
+            this->ocl_device = all_devices[deviceNumber];
+
+            std::string deviceName = ocl_device.getInfo<CL_DEVICE_NAME>();
+
+            // Create context and queue
+            this->ocl_context = cl::Context({ocl_device});
+            this->ocl_queue = cl::CommandQueue(ocl_context,ocl_device);
+
+            return deviceName;
+
+        } catch(cl::Error &error) {
+            std::cout << "[enableOpenCL] OpenCL exception caught: " << error.what() << " (" << error.err() << ")" << std::endl;
+            exit(1);
+        }
+
+        return "";
+
+    }
+
+    /**
+     * @brief
+     * Get OpenCL device.
+     *
+     * Get OpenCL device.
+     *
+     * @return
+     * OpenCL device in use by Tausch.
+     */
+    inline cl::Device getOclDevice() {
+        return ocl_device;
+    }
+
+    /**
+     * @brief
+     * Get OpenCL context.
+     *
+     * Get OpenCL context.
+     *
+     * @return
+     * OpenCL context in use by Tausch.
+     */
+    inline cl::Context getOclContext() {
+        return ocl_context;
+    }
+
+    /**
+     * @brief
+     * Get OpenCL command queue.
+     *
+     * Get OpenCL command queue.
+     *
+     * @return
+     * OpenCL command queue in use by Tausch.
+     */
+    inline cl::CommandQueue getOclQueue() {
+        return ocl_queue;
+    }
+
+    /**
+     * @brief
+     * Packs an OpenCL buffer for the given halo and buffer id.
+     *
+     * Packs an OpenCL buffer for the given halo and buffer id. If this function has been called in a blocking way,
+     * then the OpenCL buffer is immediately free to be used and changed as desired. Otherwise, please make sure the oepration has
+     * completed before using the buffer.
+     *
+     * @param haloId
+     * The halo id returned by the addSendHaloInfo() member function.
+     * @param bufferId
+     * The id of the current buffer (numbered starting at 0).
+     * @param buf
+     * Handler of the OpenCL buffer.
+     * @param blocking
+     * Whether to pack the data blocking or not.
+     *
+     * @return
+     * The Status object associated with the packing process.
+     */
+
+    inline Status packSendBufferOCL(const size_t haloId, const size_t bufferId, cl::Buffer buf, const bool blocking = true) {
+
+        cl::UserEvent ev(ocl_context);
+
+        if(sendHaloIndicesSizePerBuffer[haloId][bufferId] == 0)
+            return Status(ev);
+
+        size_t bufferOffset = 0;
+        for(size_t i = 0; i < bufferId; ++i)
+            bufferOffset += sendHaloIndicesSizePerBuffer[haloId][i];
+
+        size_t mpiSendBufferIndex = 0;
+
+        if((sendHaloCommunicationStrategy[haloId]&Communication::GPUMultiCopy) == Communication::GPUMultiCopy) {
+
+            for(auto const & region : haloRegions(true, haloId, bufferId)) {
+
+                const size_t &region_start = region[0];
+                const size_t &region_howmanycols = region[1];
+                const size_t &region_howmanyrows = region[2];
+                const size_t &region_striderow = region[3];
+
+                cl::size_t<3> buffer_offset;
+                buffer_offset[0] = region_start; // dest starting index in bytes
+                buffer_offset[1] = 0; buffer_offset[2] = 0;
+                cl::size_t<3> host_offset;
+                host_offset[0] = bufferOffset+mpiSendBufferIndex; // host starting index in bytes
+                host_offset[1] = 0; host_offset[2] = 0;
+
+                cl::size_t<3> reg;
+                reg[0] = region_howmanycols; // how many bytes in one row
+                reg[1] = region_howmanyrows; // how many rows
+                reg[2] = 1; // leave at 1
+
+                ocl_queue.enqueueReadBufferRect(buf, blocking, buffer_offset, host_offset, reg,
+                                                region_striderow, // dest stride
+                                                0,
+                                                region_howmanycols,  // host stride
+                                                0,
+                                                sendBuffer[haloId],
+                                                NULL, &ev);
+
+
+                mpiSendBufferIndex += region_howmanyrows*region_howmanycols;
+
+            }
+
+        } else {
+
+            cl::Buffer tmpSendBuffer(ocl_context, CL_MEM_READ_WRITE, sendHaloIndicesSizePerBuffer[haloId][bufferId]*sizeof(unsigned char));
+
+            for(auto const & region : haloRegions(true, haloId, bufferId)) {
+
+                const size_t &region_start = region[0];
+                const size_t &region_howmanycols = region[1];
+                const size_t &region_howmanyrows = region[2];
+                const size_t &region_striderow = region[3];
+
+                cl::size_t<3> src_origin;
+                src_origin[0] = region_start*sizeof(unsigned char);
+                src_origin[1] = 0;
+                src_origin[2] = 0;
+                cl::size_t<3> dst_origin;
+                dst_origin[0] = (mpiSendBufferIndex)*sizeof(unsigned char);
+                dst_origin[1] = 0;
+                dst_origin[2] = 0;
+                cl::size_t<3> reg;
+                reg[0] = region_howmanycols*sizeof(unsigned char);
+                reg[1] = region_howmanyrows;
+                reg[2] = 1;
+
+                ocl_queue.enqueueCopyBufferRect(buf, tmpSendBuffer,
+                                                src_origin, dst_origin, reg,
+                                                region_striderow, // dest stride
+                                                0,
+                                                region_howmanycols,  // host stride
+                                                0);
+
+                mpiSendBufferIndex += region_howmanyrows*region_howmanycols;
+
+            }
+
+            ocl_queue.enqueueReadBuffer(tmpSendBuffer, blocking,
+                                        0, sendHaloIndicesSizePerBuffer[haloId][bufferId]*sizeof(unsigned char),
+                                        &sendBuffer[haloId][bufferOffset],
+                                        NULL, &ev);
+        }
+
+        return Status(ev);
+
+    }
+
+    /**
+     * @brief
+     * Unpacks an OpenCL buffer for the given halo and buffer id.
+     *
+     * Unpacks an OpenCL buffer for the given halo and buffer id. If this function has been called in a blocking way,
+     * then the received data can be used immediately. Otherwise, please make sure the oepration has completed before
+     * using the buffer.
+     *
+     *
+     * @param haloId
+     * The halo id returned by the addRecvHaloInfo() member function.
+     * @param bufferId
+     * The id of the current buffer (numbered starting at 0).
+     * @param buf
+     * Handler of the OpenCL buffer.
+     * @param blocking
+     * Whether to unpack the data blocking or not.
+     *
+     * @return
+     * The Status object associated with the unpacking process.
+     */
+    inline Status unpackRecvBufferOCL(const size_t haloId, const size_t bufferId, cl::Buffer buf, const bool blocking = true) {
+
+        cl::UserEvent ev(ocl_context);
+
+        if(recvHaloIndicesSizePerBuffer[haloId][bufferId] == 0)
+            return Status(ev);
+
+        size_t bufferOffset = 0;
+        for(size_t i = 0; i < bufferId; ++i)
+            bufferOffset += recvHaloIndicesSizePerBuffer[haloId][i];
+
+        size_t mpiRecvBufferIndex = 0;
+
+        if((recvHaloCommunicationStrategy[haloId]&Communication::GPUMultiCopy) == Communication::GPUMultiCopy) {
+
+            for(auto const & region : haloRegions(false, haloId, bufferId)) {
+
+                const size_t &region_start = region[0];
+                const size_t &region_howmanycols = region[1];
+                const size_t &region_howmanyrows = region[2];
+                const size_t &region_striderow = region[3];
+
+                cl::size_t<3> buffer_offset;
+                buffer_offset[0] = region_start; // dest starting index in bytes
+                buffer_offset[1] = 0; buffer_offset[2] = 0;
+                cl::size_t<3> host_offset;
+                host_offset[0] = bufferOffset+mpiRecvBufferIndex; // host starting index in bytes
+                host_offset[1] = 0; host_offset[2] = 0;
+
+                cl::size_t<3> reg;
+                reg[0] = region_howmanycols; // how many bytes in one row
+                reg[1] = region_howmanyrows; // how many rows
+                reg[2] = 1; // leave at 1
+
+                ocl_queue.enqueueWriteBufferRect(buf, blocking, buffer_offset, host_offset, reg,
+                                                 region_striderow, // dest stride
+                                                 0,
+                                                 region_howmanycols,  // host stride
+                                                 0,
+                                                 recvBuffer[haloId],
+                                                 NULL, &ev);
+
+
+                mpiRecvBufferIndex += region_howmanyrows*region_howmanycols;
+
+            }
+
+        } else {
+
+            cl::Buffer tmpRecvBuffer(ocl_context, CL_MEM_READ_WRITE, recvHaloIndicesSizePerBuffer[haloId][bufferId]*sizeof(unsigned char));
+            // this has to stay blocking in order to be able to distribute it below
+            cl::copy(ocl_queue, &recvBuffer[haloId][bufferOffset], &recvBuffer[haloId][bufferOffset + recvHaloIndicesSizePerBuffer[haloId][bufferId]], tmpRecvBuffer);
+
+            for(auto const & region : haloRegions(false, haloId, bufferId)) {
+
+                const size_t &region_start = region[0];
+                const size_t &region_howmanycols = region[1];
+                const size_t &region_howmanyrows = region[2];
+                const size_t &region_striderow = region[3];
+
+                cl::size_t<3> src_origin;
+                src_origin[0] = (mpiRecvBufferIndex)*sizeof(unsigned char);
+                src_origin[1] = 0;
+                src_origin[2] = 0;
+                cl::size_t<3> dst_origin;
+                dst_origin[0] = region_start*sizeof(unsigned char);
+                dst_origin[1] = 0;
+                dst_origin[2] = 0;
+                cl::size_t<3> reg;
+                reg[0] = region_howmanycols*sizeof(unsigned char);
+                reg[1] = region_howmanyrows;
+                reg[2] = 1;
+
+                ocl_queue.enqueueCopyBufferRect(tmpRecvBuffer, buf,
+                                                src_origin, dst_origin, reg,
+                                                region_howmanycols, // dest stride
+                                                0,
+                                                region_striderow,  // host stride
+                                                0);
+
+                mpiRecvBufferIndex += region_howmanyrows*region_howmanycols;
+
+            }
+
+        }
+
+        return Status(ev);
+
+    }
+
+    /**@}*/
+
+#endif
+
+    /***********************************************************************/
+    /***********************************************************************/
+
+#ifdef TAUSCH_CUDA
+
+    /** @name CUDA
+     * The CUDA routines. In order to use these the macro TAUSCH_CUDA needs to be defined before including the tausch header.
+     */
+    /**@{*/
+
+    /***********************************************************************/
+    /*                         PACK BUFFER (CUDA)                          */
+    /***********************************************************************/
+
+    /**
+     * \overload
+     *
+     * Internally the CUDA buffer will be recast to unsigned char.
+     */
+    inline Status packSendBufferCUDA(const size_t haloId, const size_t bufferId, const double *buf, const bool blocking = true, cudaStream_t stream = 0) {
+        return packSendBufferCUDA(haloId, bufferId, reinterpret_cast<const unsigned char*>(buf), blocking, stream);
+    }
+
+    /**
+     * \overload
+     *
+     * Internally the CUDA buffer will be recast to unsigned char.
+     */
+    inline Status packSendBufferCUDA(const size_t haloId, const size_t bufferId, const int *buf, const bool blocking = true, cudaStream_t stream = 0) {
+        return packSendBufferCUDA(haloId, bufferId, reinterpret_cast<const unsigned char*>(buf), blocking, stream);
+    }
+
+    /**
+     * @brief
+     * Packs a CUDA buffer for the given halo and buffer id.
+     *
+     * Packs a CUDA buffer for the given halo and buffer id. Once this function has been called the
+     * CUDA buffer is free to be used and changed as desired.
+     *
+     * @param haloId
+     * The halo id returned by the addSendHaloInfo() member function.
+     * @param bufferId
+     * The id of the current buffer (numbered starting at 0).
+     * @param buf
+     * Pointer to the CUDA buffer.
+     * @param blocking
+     * Whether to wait for the completion of the memory copies before returning.
+     * @param stream
+     * The cudaStream to be used for queueing up the memory copies.
+     *
+     * @return
+     * The Status object associated with the packing process.
+     */
+    inline Status packSendBufferCUDA(const size_t haloId, const size_t bufferId, const unsigned char *buf, const bool blocking = true, cudaStream_t stream = 0) {
+
+        size_t bufferOffset = 0;
+        for(size_t i = 0; i < bufferId; ++i)
+            bufferOffset += sendHaloIndicesSizePerBuffer[haloId][i];
+
+        if((sendHaloCommunicationStrategy[haloId]&Communication::CUDAAwareMPI) == Communication::CUDAAwareMPI) {
+
+            size_t mpiSendBufferIndex = 0;
+            for(auto const & region : haloRegions(true, haloId, bufferId)) {
+
+                const size_t &region_start = region[0];
+                const size_t &region_howmanycols = region[1];
+                const size_t &region_howmanyrows = region[2];
+                const size_t &region_striderow = region[3];
+
+                cudaError_t err = cudaMemcpy2DAsync(&cudaSendBuffer[haloId][bufferOffset + mpiSendBufferIndex], region_howmanycols*sizeof(unsigned char),
+                                                    &buf[region_start], region_striderow*sizeof(unsigned char),
+                                                    region_howmanycols*sizeof(unsigned char), region_howmanyrows,
+                                                    cudaMemcpyDeviceToDevice, stream);
+
+                mpiSendBufferIndex += region_howmanyrows*region_howmanycols;
+
+                if(err != cudaSuccess)
+                    std::cout << "Tausch::packSendBufferCUDA(): CUDA error detected: " << cudaGetErrorString(err) << " (" << err << ")" << std::endl;
+
+            }
+
+        } else if((sendHaloCommunicationStrategy[haloId]&Communication::GPUMultiCopy) == Communication::GPUMultiCopy) {
+
+            size_t mpiSendBufferIndex = 0;
+            for(auto const & region : haloRegions(true, haloId, bufferId)) {
+
+                const size_t &region_start = region[0];
+                const size_t &region_howmanycols = region[1];
+                const size_t &region_howmanyrows = region[2];
+                const size_t &region_striderow = region[3];
+
+                cudaError_t err = cudaMemcpy2DAsync(&sendBuffer[haloId][bufferOffset + mpiSendBufferIndex], region_howmanycols*sizeof(unsigned char),
+                                                    &buf[region_start], region_striderow*sizeof(unsigned char),
+                                                    region_howmanycols*sizeof(unsigned char), region_howmanyrows,
+                                                    cudaMemcpyDeviceToHost, stream);
+
+                mpiSendBufferIndex += region_howmanyrows*region_howmanycols;
+
+                if(err != cudaSuccess)
+                    std::cout << "Tausch::packSendBufferCUDA(): CUDA error detected: " << cudaGetErrorString(err) << " (" << err << ")" << std::endl;
+
+            }
+
+        } else {
+
+            unsigned char *tmpSendBuffer;
+            cudaMalloc(&tmpSendBuffer, sendHaloIndicesSizePerBuffer[haloId][bufferId]*sizeof(unsigned char));
+
+            size_t mpiSendBufferIndex = 0;
+            for(auto const & region : haloRegions(true, haloId, bufferId)) {
+
+                const size_t &region_start = region[0];
+                const size_t &region_howmanycols = region[1];
+                const size_t &region_howmanyrows = region[2];
+                const size_t &region_striderow = region[3];
+
+                cudaError_t err = cudaMemcpy2DAsync(&tmpSendBuffer[mpiSendBufferIndex], region_howmanycols*sizeof(unsigned char),
+                                                    &buf[region_start], region_striderow*sizeof(unsigned char),
+                                                    region_howmanycols*sizeof(unsigned char), region_howmanyrows,
+                                                    cudaMemcpyDeviceToDevice, stream);
+
+                mpiSendBufferIndex += region_howmanyrows*region_howmanycols;
+
+                if(err != cudaSuccess)
+                    std::cout << "Tausch::packSendBufferCUDA(): CUDA error detected: " << cudaGetErrorString(err) << " (" << err << ")" << std::endl;
+
+            }
+
+            cudaMemcpyAsync(&sendBuffer[haloId][bufferOffset], tmpSendBuffer, sendHaloIndicesSizePerBuffer[haloId][bufferId]*sizeof(unsigned char), cudaMemcpyDeviceToHost, stream);
+
+        }
+
+        if(blocking) {
+
+            cudaEvent_t ev;
+            cudaEventCreate(&ev);
+            cudaEventRecord(ev, stream);
+            cudaEventSynchronize(ev);
+
+        }
+
+        return Status(stream);
+
+    }
+
+    /***********************************************************************/
+    /*                        UNPACK BUFFER (CUDA)                         */
+    /***********************************************************************/
+
+    /**
+     * \overload
+     *
+     * Internally the data buffer will be recast to unsigned char.
+     */
+    inline Status unpackRecvBufferCUDA(const size_t haloId, const size_t bufferId, double *buf, const bool blocking = true, cudaStream_t stream = 0) {
+        return unpackRecvBufferCUDA(haloId, bufferId, reinterpret_cast<unsigned char*>(buf), blocking, stream);
+    }
+
+    /**
+     * \overload
+     *
+     * Internally the data buffer will be recast to unsigned char.
+     */
+    inline Status unpackRecvBufferCUDA(const size_t haloId, const size_t bufferId, int *buf, const bool blocking = true, cudaStream_t stream = 0) {
+        return unpackRecvBufferCUDA(haloId, bufferId, reinterpret_cast<unsigned char*>(buf), blocking, stream);
+    }
+
+    /**
+     * @brief
+     * Unpacks a CUDA buffer for the given halo and buffer id.
+     *
+     * Unpacks a CUDA buffer for the given halo and buffer id. Once this function has been called
+     * the received data can be immediately used.
+     *
+     * @param haloId
+     * The halo id returned by the addRecvHaloInfo() member function.
+     * @param bufferId
+     * The id of the current buffer (numbered starting at 0).
+     * @param buf
+     * Pointer to the CUDA buffer.
+     * @param blocking
+     * Whether to wait for the completion of the memory copies before returning.
+     * @param stream
+     * The cudaStream to be used for queueing up the memory copies.
+     *
+     * @return
+     * The Status object associated with the unpacking process.
+     */
+    inline Status unpackRecvBufferCUDA(const size_t haloId, const size_t bufferId, unsigned char *buf, const bool blocking = true, cudaStream_t stream = 0) {
+
+        size_t bufferOffset = 0;
+        for(size_t i = 0; i < bufferId; ++i)
+            bufferOffset += recvHaloIndicesSizePerBuffer[haloId][i];
+
+        if((recvHaloCommunicationStrategy[haloId]&Communication::CUDAAwareMPI) == Communication::CUDAAwareMPI) {
+
+            size_t mpiRecvBufferIndex = 0;
+            for(auto const & region : haloRegions(false, haloId, bufferId)) {
+
+                const size_t &region_start = region[0];
+                const size_t &region_howmanycols = region[1];
+                const size_t &region_howmanyrows = region[2];
+                const size_t &region_striderow = region[3];
+
+                cudaError_t err = cudaMemcpy2DAsync(&buf[region_start], region_striderow*sizeof(unsigned char),
+                                                    &cudaRecvBuffer[haloId][bufferOffset + mpiRecvBufferIndex], region_howmanycols*sizeof(unsigned char),
+                                                    region_howmanycols*sizeof(unsigned char), region_howmanyrows,
+                                                    cudaMemcpyDeviceToDevice, stream);
+
+                if(err != cudaSuccess)
+                    std::cout << "Tausch::unpackRecvBufferCUDA(): CUDA error detected: " << cudaGetErrorString(err) << " (" << err << ")" << std::endl;
+
+                mpiRecvBufferIndex += region_howmanyrows*region_howmanycols;
+
+            }
+
+        } else if((recvHaloCommunicationStrategy[haloId]&Communication::GPUMultiCopy) == Communication::GPUMultiCopy) {
+
+            size_t mpiRecvBufferIndex = 0;
+            for(auto const & region : haloRegions(false, haloId, bufferId)) {
+
+                const size_t &region_start = region[0];
+                const size_t &region_howmanycols = region[1];
+                const size_t &region_howmanyrows = region[2];
+                const size_t &region_striderow = region[3];
+
+                cudaError_t err = cudaMemcpy2DAsync(&buf[region_start], region_striderow*sizeof(unsigned char),
+                                                    &recvBuffer[haloId][bufferOffset + mpiRecvBufferIndex], region_howmanycols*sizeof(unsigned char),
+                                                    region_howmanycols*sizeof(unsigned char), region_howmanyrows,
+                                                    cudaMemcpyHostToDevice, stream);
+
+                if(err != cudaSuccess)
+                    std::cout << "Tausch::unpackRecvBufferCUDA(): CUDA error detected: " << cudaGetErrorString(err) << " (" << err << ")" << std::endl;
+
+                mpiRecvBufferIndex += region_howmanyrows*region_howmanycols;
+
+            }
+
+        } else {
+
+            unsigned char *tmpRecvBuffer;
+            cudaMalloc(&tmpRecvBuffer, recvHaloIndicesSizePerBuffer[haloId][bufferId]*sizeof(unsigned char));
+            cudaMemcpyAsync(tmpRecvBuffer, &recvBuffer[haloId][bufferOffset], recvHaloIndicesSizePerBuffer[haloId][bufferId]*sizeof(unsigned char), cudaMemcpyHostToDevice, stream);
+
+            size_t mpiRecvBufferIndex = 0;
+            for(auto const & region : haloRegions(false, haloId, bufferId)) {
+
+                const size_t &region_start = region[0];
+                const size_t &region_howmanycols = region[1];
+                const size_t &region_howmanyrows = region[2];
+                const size_t &region_striderow = region[3];
+
+                cudaError_t err = cudaMemcpy2DAsync(&buf[region_start], region_striderow*sizeof(unsigned char),
+                                                    &tmpRecvBuffer[mpiRecvBufferIndex], region_howmanycols*sizeof(unsigned char),
+                                                    region_howmanycols*sizeof(unsigned char), region_howmanyrows,
+                                                    cudaMemcpyDeviceToDevice, stream);
+
+                if(err != cudaSuccess)
+                    std::cout << "Tausch::unpackRecvBufferCUDA(): CUDA error detected: " << cudaGetErrorString(err) << " (" << err << ")" << std::endl;
+
+                mpiRecvBufferIndex += region_howmanyrows*region_howmanycols;
+
+            }
+
+        }
+
+        if(blocking) {
+
+            cudaEvent_t ev;
+            cudaEventCreate(&ev);
+            cudaEventRecord(ev, stream);
+            cudaEventSynchronize(ev);
+
+        }
+
+        return Status(stream);
+
+    }
+
+    /**@}*/
+
+#endif
+
+#ifdef TAUSCH_HIP
+
+    /** @name HIP
+     * The HIP routines. In order to use these the macro TAUSCH_HIP needs to be defined before including the tausch header.
+     */
+    /**@{*/
+
+    /***********************************************************************/
+    /*                         PACK BUFFER (HIP)                           */
+    /***********************************************************************/
+
+    /**
+     * \overload
+     *
+     * Internally the HIP buffer will be recast to unsigned char.
+     */
+    inline Status packSendBufferHIP(const size_t haloId, const size_t bufferId, const double *buf, const bool blocking = true, hipStream_t stream = 0) {
+        return packSendBufferHIP(haloId, bufferId, reinterpret_cast<const unsigned char*>(buf), blocking, stream);
+    }
+
+    /**
+     * \overload
+     *
+     * Internally the HIP buffer will be recast to unsigned char.
+     */
+    inline Status packSendBufferHIP(const size_t haloId, const size_t bufferId, const int *buf, const bool blocking = true, hipStream_t stream = 0) {
+        return packSendBufferHIP(haloId, bufferId, reinterpret_cast<const unsigned char*>(buf), blocking, stream);
+    }
+
+    /**
+     * @brief
+     * Packs a HIP buffer for the given halo and buffer id.
+     *
+     * Packs a HIP buffer for the given halo and buffer id. Once this function has been called the
+     * HIP buffer is free to be used and changed as desired.
+     *
+     * @param haloId
+     * The halo id returned by the addSendHaloInfo() member function.
+     * @param bufferId
+     * The id of the current buffer (numbered starting at 0).
+     * @param buf
+     * Pointer to the HIP buffer.
+     * @param blocking
+     * Whether to wait for the completion of the memory copies before returning.
+     * @param stream
+     * The hipStream to be used for queueing up the memory copies.
+     *
+     * @return
+     * The Status object associated with the packing process.
+     */
+    inline Status packSendBufferHIP(const size_t haloId, const size_t bufferId, const unsigned char *buf, const bool blocking = true, hipStream_t stream = 0) {
+
+        size_t bufferOffset = 0;
+        for(size_t i = 0; i < bufferId; ++i)
+            bufferOffset += sendHaloIndicesSizePerBuffer[haloId][i];
+
+        if((sendHaloCommunicationStrategy[haloId]&Communication::GPUMultiCopy) == Communication::GPUMultiCopy) {
+
+            size_t mpiSendBufferIndex = 0;
+            for(auto const & region : haloRegions(true, haloId, bufferId)) {
+
+                const size_t &region_start = region[0];
+                const size_t &region_howmanycols = region[1];
+                const size_t &region_howmanyrows = region[2];
+                const size_t &region_striderow = region[3];
+
+                hipError_t err = hipMemcpy2DAsync(&sendBuffer[haloId][bufferOffset + mpiSendBufferIndex], region_howmanycols*sizeof(unsigned char),
+                                                  &buf[region_start], region_striderow*sizeof(unsigned char),
+                                                  region_howmanycols*sizeof(unsigned char), region_howmanyrows,
+                                                  hipMemcpyDeviceToHost, stream);
+
+                mpiSendBufferIndex += region_howmanyrows*region_howmanycols;
+
+                if(err != hipSuccess)
+                    std::cout << "Tausch::packSendBufferHIP(): HIP error detected: " << hipGetErrorString(err) << " (" << err << ")" << std::endl;
+
+            }
+
+        } else {
+
+            unsigned char *tmpSendBuffer;
+            hipMalloc(&tmpSendBuffer, sendHaloIndicesSizePerBuffer[haloId][bufferId]*sizeof(unsigned char));
+
+            size_t mpiSendBufferIndex = 0;
+            for(auto const & region : haloRegions(true, haloId, bufferId)) {
+
+                const size_t &region_start = region[0];
+                const size_t &region_howmanycols = region[1];
+                const size_t &region_howmanyrows = region[2];
+                const size_t &region_striderow = region[3];
+
+                hipError_t err = hipMemcpy2DAsync(&tmpSendBuffer[mpiSendBufferIndex], region_howmanycols*sizeof(unsigned char),
+                                                  &buf[region_start], region_striderow*sizeof(unsigned char),
+                                                  region_howmanycols*sizeof(unsigned char), region_howmanyrows,
+                                                  hipMemcpyDeviceToDevice, stream);
+
+                mpiSendBufferIndex += region_howmanyrows*region_howmanycols;
+
+                if(err != hipSuccess)
+                    std::cout << "Tausch::packSendBufferHIP(): HIP error detected: " << hipGetErrorString(err) << " (" << err << ")" << std::endl;
+
+            }
+
+            hipMemcpyAsync(&sendBuffer[haloId][bufferOffset], tmpSendBuffer, sendHaloIndicesSizePerBuffer[haloId][bufferId]*sizeof(unsigned char), hipMemcpyDeviceToHost, stream);
+
+        }
+
+        if(blocking) {
+
+            hipEvent_t ev;
+            hipEventCreate(&ev);
+            hipEventRecord(ev, stream);
+            hipEventSynchronize(ev);
+
+        }
+
+        return Status(stream);
+
+    }
+
+    /***********************************************************************/
+    /*                        UNPACK BUFFER (HIP)                         */
+    /***********************************************************************/
+
+    /**
+     * \overload
+     *
+     * Internally the data buffer will be recast to unsigned char.
+     */
+    inline Status unpackRecvBufferHIP(const size_t haloId, const size_t bufferId, double *buf, const bool blocking = true, hipStream_t stream = 0) {
+        return unpackRecvBufferHIP(haloId, bufferId, reinterpret_cast<unsigned char*>(buf), blocking, stream);
+    }
+
+    /**
+     * \overload
+     *
+     * Internally the data buffer will be recast to unsigned char.
+     */
+    inline Status unpackRecvBufferHIP(const size_t haloId, const size_t bufferId, int *buf, const bool blocking = true, hipStream_t stream = 0) {
+        return unpackRecvBufferHIP(haloId, bufferId, reinterpret_cast<unsigned char*>(buf), blocking, stream);
+    }
+
+    /**
+     * @brief
+     * Unpacks a HIP buffer for the given halo and buffer id.
+     *
+     * Unpacks a HIP buffer for the given halo and buffer id. Once this function has been called
+     * the received data can be immediately used.
+     *
+     * @param haloId
+     * The halo id returned by the addRecvHaloInfo() member function.
+     * @param bufferId
+     * The id of the current buffer (numbered starting at 0).
+     * @param buf
+     * Pointer to the HIP buffer.
+     * @param blocking
+     * Whether to wait for the completion of the memory copies before returning.
+     * @param stream
+     * The hipStream to be used for queueing up the memory copies.
+     *
+     * @return
+     * The Status object associated with the unpacking process.
+     */
+    inline Status unpackRecvBufferHIP(const size_t haloId, const size_t bufferId, unsigned char *buf, const bool blocking = true, hipStream_t stream = 0) {
+
+        size_t bufferOffset = 0;
+        for(size_t i = 0; i < bufferId; ++i)
+            bufferOffset += recvHaloIndicesSizePerBuffer[haloId][i];
+
+        if((recvHaloCommunicationStrategy[haloId]&Communication::GPUMultiCopy) == Communication::GPUMultiCopy) {
+
+            size_t mpiRecvBufferIndex = 0;
+            for(auto const & region : haloRegions(false, haloId, bufferId)) {
+
+                const size_t &region_start = region[0];
+                const size_t &region_howmanycols = region[1];
+                const size_t &region_howmanyrows = region[2];
+                const size_t &region_striderow = region[3];
+
+                hipError_t err = hipMemcpy2DAsync(&buf[region_start], region_striderow*sizeof(unsigned char),
+                                                  &recvBuffer[haloId][bufferOffset + mpiRecvBufferIndex], region_howmanycols*sizeof(unsigned char),
+                                                  region_howmanycols*sizeof(unsigned char), region_howmanyrows,
+                                                  hipMemcpyHostToDevice, stream);
+
+                if(err != hipSuccess)
+                    std::cout << "Tausch::unpackRecvBufferHIP(): HIP error detected: " << hipGetErrorString(err) << " (" << err << ")" << std::endl;
+
+                mpiRecvBufferIndex += region_howmanyrows*region_howmanycols;
+
+            }
+
+        } else {
+
+            unsigned char *tmpRecvBuffer;
+            hipMalloc(&tmpRecvBuffer, recvHaloIndicesSizePerBuffer[haloId][bufferId]*sizeof(unsigned char));
+            hipMemcpyAsync(tmpRecvBuffer, &recvBuffer[haloId][bufferOffset], recvHaloIndicesSizePerBuffer[haloId][bufferId]*sizeof(unsigned char), hipMemcpyHostToDevice, stream);
+
+            size_t mpiRecvBufferIndex = 0;
+            for(auto const & region : haloRegions(false, haloId, bufferId)) {
+
+                const size_t &region_start = region[0];
+                const size_t &region_howmanycols = region[1];
+                const size_t &region_howmanyrows = region[2];
+                const size_t &region_striderow = region[3];
+
+                hipError_t err = hipMemcpy2DAsync(&buf[region_start], region_striderow*sizeof(unsigned char),
+                                                  &tmpRecvBuffer[mpiRecvBufferIndex], region_howmanycols*sizeof(unsigned char),
+                                                  region_howmanycols*sizeof(unsigned char), region_howmanyrows,
+                                                  hipMemcpyDeviceToDevice, stream);
+
+                if(err != hipSuccess)
+                    std::cout << "Tausch::unpackRecvBufferHIP(): HIP error detected: " << hipGetErrorString(err) << " (" << err << ")" << std::endl;
+
+                mpiRecvBufferIndex += region_howmanyrows*region_howmanycols;
+
+            }
+
+        }
+
+        if(blocking) {
+
+            hipEvent_t ev;
+            hipEventCreate(&ev);
+            hipEventRecord(ev, stream);
+            hipEventSynchronize(ev);
+
+        }
+
+        return Status(stream);
+
+    }
+
+    /**@}*/
+
+#endif
+
+
+
+    /***********************************************************************/
+    /***********************************************************************/
+
+    /**
+     * @brief
+     * Converts a list of halo indices to rectangular subregions.
+     *
+     * Converts a list of halo indices to rectangular subregions. Each subregion is represented by
+     * four integers.
+     *
+     * @param indices
+     * A list of indices specifying the location of halo data.
+     *
+     * @return
+     * Returns the encoded halo information.
+     */
+    inline std::vector<std::array<int, 4> > extractHaloIndicesWithStride(std::vector<int> indices) {
+
+        // nothing to do
+        if(indices.size() == 0)
+            return std::vector<std::array<int, 4> >();
+
+        // first we build a collection of all consecutive rows
+        std::vector<std::array<int, 2> > rows;
+
+        size_t curIndex = 1;
+        int start = indices[0];
+        int howmany = 1;
+        while(curIndex < indices.size()) {
+
+            if(indices[curIndex]-indices[curIndex-1] == 1)
+                ++howmany;
+            else {
+
+                rows.push_back({start, howmany});
+
+                start = indices[curIndex];
+                howmany = 1;
+
+            }
+
+            ++curIndex;
+
+        }
+
+        rows.push_back({start, howmany});
+
+        // second we look for simple patterns within these rows
+        std::vector<std::array<int, 4> > ret;
+
+        ret.push_back({rows[0][0], rows[0][1], 1, 0});
+
+        for(size_t currow = 1; currow < rows.size(); ++currow) {
+
+            if(rows[currow][1] == ret.back()[1] && (ret.back()[3] == 0 || rows[currow][0]-(ret.back()[0]+(ret.back()[2]-1)*ret.back()[3]) == ret.back()[3])) {
+
+                if(ret.back()[3] == 0) {
+                    ++ret.back()[2];
+                    ret.back()[3] = (rows[currow][0]-ret.back()[0]);
+                } else
+                    ++ret.back()[2];
+
+            } else {
+
+                ret.push_back({rows[currow][0], rows[currow][1], 1, 0});
+            }
+
+        }
+
+        return ret;
+
+    }
+
+    /**
+     * @brief
+     * Computes a local renumbering that makes the halo of each neighbour contiguous.
+     *
+     * Unstructured meshes often have their boundary and ghost entries scattered across the local
+     * numbering, resulting in many small regions (see extractHaloIndicesWithStride()). This
+     * computes a permutation of the local numbering that places all entries not involved in any
+     * halo first (keeping their order), followed by the owned boundary entries grouped per
+     * neighbour, followed by the ghost entries grouped per neighbour. Within each group the order
+     * of the given index list is kept. An owned entry sent to several neighbours can only be
+     * placed with the first of them. After renumbering the data and the index lists (see
+     * applyRenumbering()), each halo consists of a single contiguous region that can be sent
+     * without packing, e.g., using DerivedMpiDatatype.
+     *
+     * @param numLocal
+     * The total number of local entries (owned and ghost).
+     * @param sendIndicesPerNeighbour
+     * For each neighbour the owned entries that are sent to it.
+     * @param recvIndicesPerNeighbour
+     * For each neighbour the ghost entries that are received from it.
+     *
+     * @return
+     * The permutation, entry i holds the new index of the old index i. Empty (and a message is
+     * printed) if numLocal is negative or any index lies outside of [0, numLocal).
+     */
+    static inline std::vector<int> computeLocalityRenumbering(const int numLocal,
+                                                              const std::vector<std::vector<int> > &sendIndicesPerNeighbour,
+                                                              const std::vector<std::vector<int> > &recvIndicesPerNeighbour) {
+
+        if(numLocal < 0) {
+            std::cout << "Tausch::computeLocalityRenumbering(): Invalid number of local entries " << numLocal << ", returning no permutation..." << std::endl;
+            return {};
+        }
+
+        for(auto const & perRank : {&sendIndicesPerNeighbour, &recvIndicesPerNeighbour}) {
+            for(size_t neighbour = 0; neighbour < perRank->size(); ++neighbour) {
+                for(auto ind : (*perRank)[neighbour]) {
+                    if(ind < 0 || ind >= numLocal) {
+                        std::cout << "Tausch::computeLocalityRenumbering(): Index " << ind << " of " << (perRank == &sendIndicesPerNeighbour ? "send" : "recv")
+                                  << " neighbour " << neighbour << " is outside of [0, " << numLocal << "), returning no permutation..." << std::endl;
+                        return {};
+                    }
+                }
+            }
+        }
+
+        // 0: interior, 1: owned boundary, 2: ghost
+        std::vector<char> kind(numLocal, 0);
+        for(auto const & perNeighbour : recvIndicesPerNeighbour)
+            for(auto ind : perNeighbour)
+                kind[ind] = 2;
+        for(auto const & perNeighbour : sendIndicesPerNeighbour)
+            for(auto ind : perNeighbour)
+                if(kind[ind] == 0)
+                    kind[ind] = 1;
+
+        std::vector<int> permutation(numLocal, -1);
+        int next = 0;
+
+        for(int i = 0; i < numLocal; ++i)
+            if(kind[i] == 0)
+                permutation[i] = next++;
+
+        for(auto const & perNeighbour : sendIndicesPerNeighbour)
+            for(auto ind : perNeighbour)
+                if(kind[ind] == 1 && permutation[ind] == -1)
+                    permutation[ind] = next++;
+
+        for(auto const & perNeighbour : recvIndicesPerNeighbour)
+            for(auto ind : perNeighbour)
+                if(permutation[ind] == -1)
+                    permutation[ind] = next++;
+
+        return permutation;
+
+    }
+
+    /**
+     * @brief
+     * Applies a renumbering to a list of indices.
+     *
+     * @param permutation
+     * The permutation as returned by computeLocalityRenumbering().
+     * @param indices
+     * The indices in the old numbering.
+     *
+     * @return
+     * The indices in the new numbering. Empty (and a message is printed) if any index is not covered
+     * by the permutation.
+     */
+    static inline std::vector<int> applyRenumbering(const std::vector<int> &permutation, const std::vector<int> &indices) {
+
+        std::vector<int> ret;
+        ret.reserve(indices.size());
+        for(auto ind : indices) {
+            if(ind < 0 || ind >= static_cast<int>(permutation.size())) {
+                std::cout << "Tausch::applyRenumbering(): Index " << ind << " is outside of the permutation of size " << permutation.size()
+                          << ", returning no indices..." << std::endl;
+                return {};
+            }
+            ret.push_back(permutation[ind]);
+        }
+
+        return ret;
+
+    }
+
+    /**
+     * @brief
+     * Converts indices based on a certain data type into indices for unsigned char.
+     *
+     * Converts indices based on a certain data type into indices for unsigned char.
+     *
+     * @param indices
+     * The halo indices based on given data type.
+     * @param typeSize
+     * The size of the data type.
+     *
+     * @return
+     * Returns a list of indices based on unsigned char.
+     */
+    inline std::vector<std::array<int, 4> > convertToUnsignedCharIndices(std::vector<std::array<int, 4> > indices, const size_t typeSize) {
+
+        if(typeSize == 1)
+            return indices;
+
+        std::vector<std::array<int, 4> > ret;
+
+        for(auto region : indices)
+            ret.push_back({region[0]*static_cast<int>(typeSize),
+                           region[1]*static_cast<int>(typeSize),
+                           region[2],
+                           region[3]*static_cast<int>(typeSize)});
+
+        return ret;
+
+    }
+
+    /**
+     * @brief
+     * Static member function checking whether a combination of strategies can be tested.
+     *
+     * Static member function checking whether a combination of a send and a recv strategy
+     * is applicable with the enabled backends and the given number of MPI ranks.
+     *
+     * @param sendStrategy
+     * The strategy used for sending.
+     * @param recvStrategy
+     * The strategy used for receiving.
+     * @param mpiSize
+     * The number of MPI ranks taking part.
+     *
+     * @return
+     * Whether the combination can be tested.
+     */
+    static bool isTestableStrategyCombination(Communication sendStrategy, Communication recvStrategy, int mpiSize) {
+
+#ifndef TAUSCH_CUDA
+        // require CUDA
+        if(sendStrategy == Communication::CUDAAwareMPI || recvStrategy == Communication::CUDAAwareMPI)
+            return false;
+#endif
+
+#if !defined(TAUSCH_CUDA) && !defined(TAUSCH_HIP) && !defined(TAUSCH_OPENCL)
+        // requires GPGPU
+        if(sendStrategy == Communication::GPUMultiCopy || recvStrategy == Communication::GPUMultiCopy)
+            return false;
+#endif
+
+#if defined(TAUSCH_CUDA) || defined(TAUSCH_HIP) || defined(TAUSCH_OPENCL)
+        // requires CPU
+        if(sendStrategy == Communication::TryDirectCopy || recvStrategy == Communication::TryDirectCopy)
+            return false;
+#endif
+
+        // partitioned messages only match partitioned messages
+        if((sendStrategy == Communication::MPIPartitioned) != (recvStrategy == Communication::MPIPartitioned))
+            return false;
+
+#ifndef TAUSCH_UCX
+        // requires UCX
+        if(sendStrategy == Communication::UCX || recvStrategy == Communication::UCX)
+            return false;
+#endif
+
+        // UCX tagged messages only match UCX tagged messages
+        if((sendStrategy == Communication::UCX) != (recvStrategy == Communication::UCX))
+            return false;
+
+        // required on both sides and for single MPI rank only
+        if((recvStrategy == Communication::TryDirectCopy && (sendStrategy != Communication::TryDirectCopy || mpiSize > 1)) ||
+           (sendStrategy == Communication::TryDirectCopy && (recvStrategy != Communication::TryDirectCopy || mpiSize > 1)))
+            return false;
+
+        return true;
+
+    }
+
+    /**
+     * @brief
+     * Static member function doing halo exchanges with all possible and applicable
+     * configurations.
+     *
+     * Static member function doing halo exchanges with all possible and applicable
+     * configurations to find the fastest communication path
+     *
+     * @param testcomm
+     * Which communicator to use
+     * @param printProgress
+     * Whether to print the results.
+     * @param cache
+     * If set, the fastest combination for each of the tested problem and halo sizes is stored in the
+     * strategy cache of this Tausch object (see setStrategyCache()), keyed by the signature of the
+     * test halo. This has to be set either on all or on none of the ranks.
+     *
+     * @return
+     * Returns a vector containing the best send and the best receiving
+     * communication strategy.
+     */
+    static std::vector<Communication> testForBestCommunication(MPI_Comm testcomm, bool printProgress = true, Tausch *cache = nullptr) {
+
+        std::vector<Communication> strategies;
+        std::vector<std::string> strategyNames;
+
+        strategies.push_back(Communication::Default);
+        strategyNames.push_back("Default");
+
+        strategies.push_back(Communication::TryDirectCopy);
+        strategyNames.push_back("TryDirectCopy");
+
+        strategies.push_back(Communication::DerivedMpiDatatype);
+        strategyNames.push_back("DerivedMpiDatatype");
+
+        strategies.push_back(Communication::DerivedMpiDatatypeSingleMessage);
+        strategyNames.push_back("DerivedMpiDatatypeSingleMessage");
+
+        strategies.push_back(Communication::CUDAAwareMPI);
+        strategyNames.push_back("CUDAAwareMPI");
+
+        strategies.push_back(Communication::MPIPersistent);
+        strategyNames.push_back("MPIPersistent");
+
+        strategies.push_back(Communication::GPUMultiCopy);
+        strategyNames.push_back("GPUMultiCopy");
+
+#if MPI_VERSION >= 4
+        strategies.push_back(Communication::MPIPartitioned);
+        strategyNames.push_back("MPIPartitioned");
+#endif
+
+        int bestSend = 0;
+        int bestRecv = 0;
+
+        double t_best = -1;
+
+        // the fastest combination (and its time per exchange) for each problem and halo size
+        const int numConfigs = 4*3;
+        std::vector<int> configBestSend(numConfigs, 0);
+        std::vector<int> configBestRecv(numConfigs, 0);
+        std::vector<double> configBestTime(numConfigs, -1);
+        std::vector<std::string> configSendSignature(numConfigs);
+        std::vector<std::string> configRecvSignature(numConfigs);
+
+        int mpiRank, mpiSize;
+        MPI_Comm_rank(MPI_COMM_WORLD, &mpiRank);
+        MPI_Comm_size(MPI_COMM_WORLD, &mpiSize);
+
+        if(mpiRank == 0 && printProgress)
+            std::cout << " ** Testing communication stratgies" << std::endl << std::endl;
+
+        for(size_t iSend = 0; iSend < strategies.size(); ++iSend) {
+
+            for(size_t iRecv = 0; iRecv < strategies.size(); ++iRecv) {
+
+                if(!isTestableStrategyCombination(strategies[iSend], strategies[iRecv], mpiSize))
+                    continue;
+
+                if(mpiRank == 0 && printProgress)
+                    std::cout << "   > Testing " << strategyNames[iSend] << " (send) / " << strategyNames[iRecv] << " (recv) ... " << std::flush;
+
+                std::vector<double> allt;
+
+                // we try multiple problem and halo sizes
+                for(int sizepower = 1; sizepower < 5; ++sizepower) {
+
+                    const int size = std::pow(10,sizepower);
+
+                    for(int halowidth = 1; halowidth < 4; ++halowidth) {
+
+                        Tausch testtausch(testcomm, true);
+
+                        std::vector<unsigned char> sendbuf(size*size);
+                        std::vector<unsigned char> recvbuf(size*size);
+
+                        std::vector<std::array<int,4> > indices;
+                        std::array<int,4> bottom = {0, size, halowidth, size};
+                        std::array<int,4> top = {size*(size-halowidth), size, halowidth, size};
+                        std::array<int,4> left = {size*halowidth, halowidth, size-2*halowidth, size};
+                        std::array<int,4> right = {size*halowidth-2*halowidth, halowidth, size-2*halowidth, size};
+                        indices.push_back(bottom);
+                        indices.push_back(top);
+                        indices.push_back(left);
+                        indices.push_back(right);
+
+                        int sendRank = (mpiRank+1)%mpiSize;
+                        int recvRank = (mpiRank+mpiSize-1)%mpiSize;
+
+                        testtausch.addSendHaloInfo(indices, 1, sendRank);
+                        testtausch.addRecvHaloInfo(indices, 1, recvRank);
+
+                        testtausch.setSendCommunicationStrategy(0, strategies[iSend]);
+                        testtausch.setRecvCommunicationStrategy(0, strategies[iRecv]);
+
+                        if(cache != nullptr && configSendSignature[allt.size()] == "") {
+                            testtausch.setupNodeInformation();
+                            configSendSignature[allt.size()] = testtausch.getHaloSignature(true, 0);
+                            configRecvSignature[allt.size()] = testtausch.getHaloSignature(false, 0);
+                        }
+
+                        if(strategies[iRecv] == Communication::TryDirectCopy) {
+                            sendRank = mpiRank;
+                            recvRank = mpiRank;
+                        }
+
+                        if(strategies[iSend] == Communication::DerivedMpiDatatype || strategies[iSend] == Communication::DerivedMpiDatatypeSingleMessage)
+                            testtausch.setSendHaloBuffer(0, 0, &sendbuf[0]);
+                        if(strategies[iRecv] == Communication::DerivedMpiDatatype || strategies[iRecv] == Communication::DerivedMpiDatatypeSingleMessage)
+                            testtausch.setRecvHaloBuffer(0, 0, &recvbuf[0]);
+
+                        auto t1 = std::chrono::steady_clock::now();
+
+                        for(int iter = 0; iter < 10; ++iter) {
+
+                            if(strategies[iSend] != Communication::DerivedMpiDatatype && strategies[iSend] != Communication::DerivedMpiDatatypeSingleMessage &&
+                               strategies[iSend] != Communication::TryDirectCopy)
+                                testtausch.packSendBuffer(0, 0, &sendbuf[0]);
+
+                            Status sendstatus(MPI_REQUEST_NULL);
+                            Status recvstatus(MPI_REQUEST_NULL);
+
+                            if(strategies[iSend] == Communication::DerivedMpiDatatype)
+                                sendstatus = testtausch.send(0, 0, sendRank, 0);
+                            else
+                                sendstatus = testtausch.send(0, 0, sendRank);
+
+                            if(strategies[iRecv] == Communication::DerivedMpiDatatype)
+                                recvstatus = testtausch.recv(0, 0, recvRank, 0);
+                            else
+                                recvstatus = testtausch.recv(0, 0, recvRank);
+
+                            sendstatus.wait();
+                            recvstatus.wait();
+
+                            if(strategies[iRecv] != Communication::DerivedMpiDatatype && strategies[iRecv] != Communication::DerivedMpiDatatypeSingleMessage &&
+                               strategies[iRecv] != Communication::TryDirectCopy)
+                                testtausch.unpackRecvBuffer(0, 0, &recvbuf[0]);
+
+                        }
+
+                        auto t2 = std::chrono::steady_clock::now();
+
+                        double duration = std::chrono::duration<double, std::milli>(t2-t1).count();
                         allt.push_back(duration);
 
-                        MPI_Barrier(testcomm);
+                        MPI_Barrier(testcomm);
+
+                    }
+
+                }
+
+                std::vector<double> allt_reduced(allt.size());
+                MPI_Reduce(allt.data(), allt_reduced.data(), allt.size(), MPI_DOUBLE, MPI_SUM, 0, testcomm);
+
+                if(mpiRank == 0) {
+
+                    double t_reduced = std::accumulate(allt_reduced.begin(), allt_reduced.end(), 0.0);
+                    t_reduced /= static_cast<double>(mpiSize);
+
+                    for(int config = 0; config < numConfigs; ++config) {
+                        const double t_config = allt_reduced[config]/static_cast<double>(mpiSize*10);
+                        if(configBestTime[config] == -1 || configBestTime[config] > t_config) {
+                            configBestSend[config] = iSend;
+                            configBestRecv[config] = iRecv;
+                            configBestTime[config] = t_config;
+                        }
+                    }
+
+                    if(t_best == -1 || (t_best > t_reduced)) {
+                        bestSend = iSend;
+                        bestRecv = iRecv;
+                        t_best = t_reduced;
+                    }
+
+                    if(printProgress)
+                        std::cout << t_reduced << " ms" << std::endl;
+
+                }
+
+            }
+
+        }
+
+        MPI_Bcast(&bestSend, 1, MPI_INT, 0, testcomm);
+        MPI_Bcast(&bestRecv, 1, MPI_INT, 0, testcomm);
+
+        if(cache != nullptr) {
+
+            MPI_Bcast(configBestSend.data(), numConfigs, MPI_INT, 0, testcomm);
+            MPI_Bcast(configBestRecv.data(), numConfigs, MPI_INT, 0, testcomm);
+            MPI_Bcast(configBestTime.data(), numConfigs, MPI_DOUBLE, 0, testcomm);
+
+            for(int config = 0; config < numConfigs; ++config) {
+                if(configBestTime[config] < 0)
+                    continue;
+                cache->storeCommunicationStrategy(configSendSignature[config], strategies[configBestSend[config]], configBestTime[config]);
+                cache->storeCommunicationStrategy(configRecvSignature[config], strategies[configBestRecv[config]], configBestTime[config]);
+            }
+
+        }
+
+        if(mpiRank == 0 && printProgress) {
+
+            std::cout << std::endl;
+            std::cout << " ** Best strategy combo:" << std::endl << std::endl
+                    << std::setw(24) << " Sending: " << strategyNames[bestSend] << std::endl
+                    << std::setw(24) << " Receiving: " << strategyNames[bestRecv] << std::endl
+                    << " Average time required: " << t_best << " ms" << std::endl << std::endl;
+
+        }
+
+        return {strategies[bestSend], strategies[bestRecv]};
+
+    }
+
+    /**
+     * @brief
+     * Static member function quickly finding the fastest communication strategies.
+     *
+     * Static member function finding the fastest combination of send and recv strategy within a
+     * bounded amount of time. Contrary to testForBestCommunication() only a single problem size is
+     * tested and all trials share one Tausch object (and thus one duplicated communicator) and one
+     * set of buffers. Each combination is exchanged once untimed first (to set up persistent
+     * requests, datatypes and connections), then all combinations are sampled in turns. After a
+     * few samples any combination whose 95% confidence interval (using the quantiles of Student's t
+     * distribution, the number of samples is small) lies entirely above the one of the currently
+     * fastest combination is pruned. Testing stops once a single combination is left, once all confidence intervals are
+     * separated, or once the time budget is used up (which is checked before every message). If the
+     * budget runs out before any combination was timed, Default is returned for both sides.
+     *
+     * @param testcomm
+     * Which communicator to use
+     * @param budget
+     * The maximum time (in ms) to spend on testing.
+     * @param size
+     * The size of the (square) test domain.
+     * @param halowidth
+     * The width of the halo of the test domain.
+     * @param printProgress
+     * Whether to print the results.
+     * @param cache
+     * If set, the fastest combination is stored in the strategy cache of this Tausch object (see
+     * setStrategyCache()), keyed by the signature of the test halo. This has to be set either on all
+     * or on none of the ranks.
+     *
+     * @return
+     * Returns a vector containing the best send and the best receiving
+     * communication strategy.
+     */
+    static std::vector<Communication> testForBestCommunicationFast(MPI_Comm testcomm, double budget = 100, int size = 1000, int halowidth = 1, bool printProgress = false,
+                                                                   Tausch *cache = nullptr) {
+
+        const std::vector<Communication> strategies = {Communication::Default,
+                                                       Communication::TryDirectCopy,
+                                                       Communication::DerivedMpiDatatype,
+                                                       Communication::DerivedMpiDatatypeSingleMessage,
+                                                       Communication::CUDAAwareMPI,
+                                                       Communication::MPIPersistent,
+                                                       Communication::GPUMultiCopy,
+#if MPI_VERSION >= 4
+                                                       Communication::MPIPartitioned
+#endif
+                                                      };
+
+        // the minimum and maximum number of samples per combination
+        const int minSamples = 3;
+        const int maxSamples = 50;
+
+        auto t_start = std::chrono::steady_clock::now();
+
+        int mpiRank, mpiSize;
+        MPI_Comm_rank(testcomm, &mpiRank);
+        MPI_Comm_size(testcomm, &mpiSize);
+
+        Tausch testtausch(testcomm, true);
+        if(cache != nullptr)
+            testtausch.setupNodeInformation();
+
+        const int sendRank = (mpiRank+1)%mpiSize;
+        const int recvRank = (mpiRank+mpiSize-1)%mpiSize;
+
+        std::vector<unsigned char> sendbuf(size*size);
+        std::vector<unsigned char> recvbuf(size*size);
+
+        std::vector<std::array<int,4> > indices;
+        indices.push_back({0, size, halowidth, size});
+        indices.push_back({size*(size-halowidth), size, halowidth, size});
+        indices.push_back({size*halowidth, halowidth, size-2*halowidth, size});
+        indices.push_back({size*halowidth-2*halowidth, halowidth, size-2*halowidth, size});
+
+        // one halo pair per combination, all in the same Tausch object
+        std::vector<std::array<Communication, 2> > combos;
+        for(auto sendStrategy : strategies) {
+            for(auto recvStrategy : strategies) {
+
+                if(!isTestableStrategyCombination(sendStrategy, recvStrategy, mpiSize))
+                    continue;
+
+                const size_t haloId = combos.size();
+                combos.push_back({sendStrategy, recvStrategy});
+
+                testtausch.addSendHaloInfo(indices, 1, sendRank);
+                testtausch.addRecvHaloInfo(indices, 1, recvRank);
+                testtausch.setSendCommunicationStrategy(haloId, sendStrategy);
+                testtausch.setRecvCommunicationStrategy(haloId, recvStrategy);
+                if(sendStrategy == Communication::DerivedMpiDatatype || sendStrategy == Communication::DerivedMpiDatatypeSingleMessage)
+                    testtausch.setSendHaloBuffer(haloId, 0, &sendbuf[0]);
+                if(recvStrategy == Communication::DerivedMpiDatatype || recvStrategy == Communication::DerivedMpiDatatypeSingleMessage)
+                    testtausch.setRecvHaloBuffer(haloId, 0, &recvbuf[0]);
+
+            }
+        }
+
+        std::vector<std::vector<double> > samples(combos.size());
+        std::vector<bool> alive(combos.size(), true);
+        std::vector<bool> warmedUp(combos.size(), false);
+        size_t numAlive = combos.size();
+
+        // two-sided 95% quantiles of Student's t distribution for 1 to 30 degrees of freedom,
+        // beyond that 1.96+2.4/df is within 0.002 of the exact value
+        const std::array<double, 30> tQuantile = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                                                  2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+                                                  2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+
+        auto meanAndHalfWidth = [&](size_t c) {
+            const double n = samples[c].size();
+            const double mean = std::accumulate(samples[c].begin(), samples[c].end(), 0.0)/n;
+            if(n < 2)
+                return std::array<double, 2>{mean, std::numeric_limits<double>::infinity()};
+            double var = 0;
+            for(auto const & t : samples[c])
+                var += (t-mean)*(t-mean);
+            var /= n-1;
+            const size_t df = samples[c].size()-1;
+            const double t = (df <= tQuantile.size() ? tQuantile[df-1] : 1.96+2.4/df);
+            return std::array<double, 2>{mean, t*std::sqrt(var/n)};
+        };
+
+        auto exchange = [&](size_t c) {
+
+            if(combos[c][0] != Communication::DerivedMpiDatatype && combos[c][0] != Communication::DerivedMpiDatatypeSingleMessage &&
+               combos[c][0] != Communication::TryDirectCopy)
+                testtausch.packSendBuffer(c, 0, &sendbuf[0]);
+
+            // only DerivedMpiDatatype sends one message per buffer, anything else sends all buffers at once
+            Status sendstatus = testtausch.send(c, c, sendRank, (combos[c][0] == Communication::DerivedMpiDatatype ? 0 : -1));
+            Status recvstatus = testtausch.recv(c, c, recvRank, (combos[c][1] == Communication::DerivedMpiDatatype ? 0 : -1));
+
+            sendstatus.wait();
+            recvstatus.wait();
+
+            if(combos[c][1] != Communication::DerivedMpiDatatype && combos[c][1] != Communication::DerivedMpiDatatypeSingleMessage &&
+               combos[c][1] != Communication::TryDirectCopy)
+                testtausch.unpackRecvBuffer(c, 0, &recvbuf[0]);
+
+        };
+
+        bool done = false;
+        while(!done) {
+
+            std::vector<double> roundTimes(combos.size(), -1);
+            bool outOfBudget = false;
+
+            for(size_t c = 0; c < combos.size(); ++c) {
+
+                if(!alive[c])
+                    continue;
+
+                // the budget is checked before every message, all ranks need to take the same decision
+                double spent = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now()-t_start).count();
+                MPI_Allreduce(MPI_IN_PLACE, &spent, 1, MPI_DOUBLE, MPI_MAX, testcomm);
+                if(spent >= budget) {
+                    outOfBudget = true;
+                    break;
+                }
+
+                // the first exchange of a combination sets things up and is not timed
+                if(!warmedUp[c]) {
+                    exchange(c);
+                    warmedUp[c] = true;
+                    continue;
+                }
+
+                auto t1 = std::chrono::steady_clock::now();
+                exchange(c);
+                auto t2 = std::chrono::steady_clock::now();
+
+                roundTimes[c] = std::chrono::duration<double, std::milli>(t2-t1).count();
+
+            }
+
+            // all ranks need to take the same decisions
+            MPI_Allreduce(MPI_IN_PLACE, roundTimes.data(), roundTimes.size(), MPI_DOUBLE, MPI_MAX, testcomm);
+
+            for(size_t c = 0; c < combos.size(); ++c)
+                if(alive[c] && roundTimes[c] >= 0)
+                    samples[c].push_back(roundTimes[c]);
+
+            if(outOfBudget)
+                break;
+
+            const int numSamples = samples[std::find(alive.begin(), alive.end(), true)-alive.begin()].size();
+
+            if(numSamples >= minSamples) {
+
+                size_t best = 0;
+                double bestMean = -1;
+                for(size_t c = 0; c < combos.size(); ++c) {
+                    if(alive[c] && (bestMean < 0 || meanAndHalfWidth(c)[0] < bestMean)) {
+                        best = c;
+                        bestMean = meanAndHalfWidth(c)[0];
+                    }
+                }
+
+                // prune anything that is clearly slower than the best combination
+                const auto bestStats = meanAndHalfWidth(best);
+                bool separated = true;
+                for(size_t c = 0; c < combos.size(); ++c) {
+                    if(!alive[c] || c == best)
+                        continue;
+                    const auto stats = meanAndHalfWidth(c);
+                    if(stats[0]-stats[1] > bestStats[0]+bestStats[1]) {
+                        alive[c] = false;
+                        --numAlive;
+                    } else
+                        separated = false;
+                }
+
+                done = (numAlive == 1 || separated || numSamples >= maxSamples);
+
+            }
+
+        }
+
+        // if the budget ran out early, some combinations might not have been sampled at all
+        size_t best = 0;
+        double bestMean = -1;
+        for(size_t c = 0; c < combos.size(); ++c) {
+            if(alive[c] && samples[c].size() > 0 && (bestMean < 0 || meanAndHalfWidth(c)[0] < bestMean)) {
+                best = c;
+                bestMean = meanAndHalfWidth(c)[0];
+            }
+        }
+
+        if(mpiRank == 0 && printProgress)
+            std::cout << " ** Best strategy combo (" << getCommunicationStrategyName(combos[best][0]) << " sending, "
+                      << getCommunicationStrategyName(combos[best][1]) << " receiving): "
+                      << bestMean << " ms after " << samples[best].size() << " samples, "
+                      << numAlive << " of " << combos.size() << " combinations left" << std::endl;
+
+        if(cache != nullptr && bestMean >= 0) {
+            cache->storeCommunicationStrategy(testtausch.getHaloSignature(true, best), combos[best][0], bestMean);
+            cache->storeCommunicationStrategy(testtausch.getHaloSignature(false, best), combos[best][1], bestMean);
+        }
+
+        return {combos[best][0], combos[best][1]};
+
+    }
+
+private:
+
+    // state of adaptive strategy selection of a single halo
+    struct AdaptiveStrategy {
+        std::vector<Communication> candidates;
+        std::vector<double> times;      // moving average per candidate (in ms), -1 if not yet timed
+        size_t current = 0;             // candidate currently in use
+        size_t explore = 0;             // candidate re-timed last
+        int exploreInterval = 50;
+        int counter = 0;
+        Status previous = Status(MPI_REQUEST_NULL);                 // last operation
+        std::shared_ptr<Status::CompletionTiming> timing;           // its timing, not yet accounted for if set
+        int validationRounds = 0;       // > 0 while validating a cached strategy against Default
+        std::string signature;          // signature of the halo in the strategy cache
+        bool enabled = true;            // false once the validation of a cached strategy has finished
+        bool switching = false;         // whether the strategy is being switched by adaptive mode
+    };
+
+    MPI_Comm TAUSCH_COMM;
+
+    std::vector<std::vector<std::vector<std::array<int, 4> > > > sendHaloIndices;
+    std::vector<std::vector<int> > sendHaloIndicesSizePerBuffer;
+    std::vector<int> sendHaloIndicesSizeTotal;
+    std::vector<int> sendHaloNumBuffers;
+    std::vector<int> sendHaloRemoteRank;
+    std::vector<unsigned char*> sendBuffer;
+    std::vector<std::vector<MPI_Request> > sendHaloMpiRequests;
+    std::vector<std::vector<int> > sendHaloMpiSetup;
+    std::vector<Communication> sendHaloCommunicationStrategy;
+    std::map<int, std::map<int, unsigned char*> > sendHaloBuffer;
+    std::map<int, std::vector<MPI_Datatype> > sendHaloDerivedDatatype;
+    std::vector<std::vector<size_t> > sendHaloTypeSizePerBuffer;
+    std::vector<std::vector<std::vector<uint32_t> > > sendHaloElementOffsets;  // per buffer, empty unless fragmented
+    std::vector<char> sendHaloUniformLayout;  // whether all buffers share the same indices and type size
+    std::map<int, AdaptiveStrategy> sendHaloAdaptive;
+    std::map<int, MPI_Datatype> sendHaloCombinedDatatype;
+
+    std::vector<std::vector<std::vector<std::array<int, 4> > > > recvHaloIndices;
+    std::vector<std::vector<int> > recvHaloIndicesSizePerBuffer;
+    std::vector<int> recvHaloIndicesSizeTotal;
+    std::vector<int> recvHaloNumBuffers;
+    std::vector<int> recvHaloRemoteRank;
+    std::vector<unsigned char*> recvBuffer;
+    std::vector<std::vector<MPI_Request> > recvHaloMpiRequests;
+    std::vector<std::vector<int> > recvHaloMpiSetup;
+    std::vector<Communication> recvHaloCommunicationStrategy;
+    std::map<int, std::map<int, unsigned char*> > recvHaloBuffer;
+    std::map<int, std::vector<MPI_Datatype> > recvHaloDerivedDatatype;
+    std::vector<std::vector<size_t> > recvHaloTypeSizePerBuffer;
+    std::vector<std::vector<std::vector<uint32_t> > > recvHaloElementOffsets;  // per buffer, empty unless fragmented
+    std::vector<char> recvHaloUniformLayout;  // whether all buffers share the same indices and type size
+    std::map<int, AdaptiveStrategy> recvHaloAdaptive;
+    std::map<int, MPI_Datatype> recvHaloCombinedDatatype;
+
+    // derived datatypes shared between halos, keyed by region list, with reference count
+    std::map<std::vector<std::array<int, 4> >, std::pair<MPI_Datatype, int> > derivedDatatypeCache;
+
+    // an aggregated message to/from a remote rank with a given tag
+    struct AggregatedMessage {
+        std::vector<unsigned char> buffer;
+        MPI_Request request = MPI_REQUEST_NULL;
+    };
+    std::map<std::pair<int, int>, AggregatedMessage> aggregatedSendMessages;
+    std::map<std::pair<int, int>, AggregatedMessage> aggregatedRecvMessages;
+    std::mutex aggregatedMutex;
+
+    // striping of large halos into chunks sent as independent messages
+    struct Striping {
+        size_t minSize;
+        std::vector<MPI_Request> requests;  // one per chunk
+    };
+    std::map<int, Striping> sendHaloStriping;
+    std::map<int, Striping> recvHaloStriping;
+    std::vector<MPI_Comm> communicatorPool;
+
+    // channels, i.e., messages spread over a pool of communicators separate from the striping one
+    std::vector<MPI_Comm> channelPool;
+    bool useChannels = false;
+    std::map<int, int> sendHaloChannel;
+    std::map<int, int> recvHaloChannel;
+
+    // ring of staging buffers of a send halo, the current one is also stored in sendBuffer
+    struct SendRing {
+        std::vector<unsigned char*> buffers;
+        std::vector<MPI_Request> requests;  // one per buffer
+        std::vector<int> setup;             // whether a persistent request has been set up
+        size_t current = 0;
+    };
+    std::map<int, SendRing> sendHaloRing;
+
+    // network emulation, the arrival times in flight are kept alive in sent/received
+    struct NetworkEmulation {
+        bool enabled = false;
+        double latency = 0;
+        double bandwidth = 0;
+        int ranksPerNode = 1;
+        double contention = 0;
+        int64_t linkFreeAt = 0;
+        MPI_Comm comm = MPI_COMM_NULL;
+        std::vector<std::shared_ptr<Status::EmulatedCompletion> > sent;
+        std::vector<std::shared_ptr<Status::EmulatedCompletion> > received;
+        std::mutex mutex;
+    };
+    NetworkEmulation networkEmulation;
+
+    // custom transport used instead of MPI and the outstanding receives through it
+    std::shared_ptr<Transport> transport;
+    std::map<int, Status> recvHaloTransportStatus;
+    std::mutex transportMutex;
+
+#ifdef TAUSCH_UCX
+    // UCX transport, the worker addresses of all ranks are exchanged in setupUcx()
+    ucp_context_h ucxContext = nullptr;
+    ucp_worker_h ucxWorker = nullptr;
+    std::vector<std::vector<char> > ucxAddresses;
+    std::vector<ucp_ep_h> ucxEndpoints;
+    std::mutex ucxMutex;    // guards the lazy creation of endpoints
+    // registered staging buffer and outstanding request of a halo using UCX
+    struct UcxHalo {
+        unsigned char *buffer = nullptr;
+        ucp_mem_h memh = nullptr;
+        void *request = nullptr;
+    };
+    std::map<int, UcxHalo> sendHaloUcx;
+    std::map<int, UcxHalo> recvHaloUcx;
+#endif
+
+    // auto-rearming of a persistent recv halo after unpacking
+    struct RecvRearm {
+        bool enabled = false;
+        bool armed = false;         // whether the receive has been restarted but not yet consumed by recv()
+        std::vector<char> unpacked; // per buffer, whether it has been unpacked since the last restart
+    };
+    std::map<int, RecvRearm> recvHaloRearm;
+
+    // state of a halo using MPI partitioned communication
+    struct Partitioned {
+        int numPartitions;
+        size_t partitionSize;
+        std::vector<size_t> packed; // per buffer, how many bytes have been packed for the current message
+        std::vector<char> ready;    // per partition, whether it has been marked ready
+        bool started = false;       // whether the current message has been started (send only)
+    };
+    std::map<int, Partitioned> sendHaloPartitioned;
+    std::map<int, Partitioned> recvHaloPartitioned;
+    std::mutex partitionedMutex;
+
+    // this is used for exchanges on same mpi rank
+    std::map<int, int> msgtagToHaloId;
+    std::mutex msgtagToHaloIdMutex;
+
+    // NUMA node the non-blocking pack/unpack threads of a halo are pinned to
+    std::map<int, int> sendHaloThreadNumaNode;
+    std::map<int, int> recvHaloThreadNumaNode;
+
+    // halo sizes above which packing uses non-temporal stores and unpacking prefetches rows
+    size_t nonTemporalPackThreshold = defaultNonTemporalPackThreshold();
+    size_t unpackPrefetchThreshold = 1<<18;
+    size_t prefetchDistance = 4;
+
+    // packing/unpacking of multiple buffers is done concurrently above this total halo size
+    size_t multiFieldParallelThreshold = 1<<21;
+    int multiFieldMaxThreads = 0;
+
+    // whether the same Tausch object is used from multiple threads
+    bool threadSafe = false;
+
+    // node-local communicator and the node id of every rank of TAUSCH_COMM (set up on demand)
+    MPI_Comm TAUSCH_NODE_COMM = MPI_COMM_NULL;
+    std::vector<int> rankToNode;
+
+    // cached strategies, key is the halo signature, value is the strategy and the time it took
+    bool strategyCacheLoaded = false;
+    bool strategyCacheStale = false;
+    double strategyCacheTolerance = 2.0;
+    int strategyCacheValidationRounds = 5;
+    std::mutex strategyCacheMutex;
+    std::string strategyCacheFilename;
+    std::map<std::string, std::pair<int, double> > strategyCache;
+
+    // calibrated cost model, times in ms and bandwidths in bytes/ms
+    bool costModelCalibrated = false;
+    double costAlpha = 0;
+    double costAlphaPersistent = 0;
+    double costBeta = 1;
+    double costPackBandwidth = 1;
+    double costPackRow = 0;
+    double costDerivedBandwidth = 1;
+    double costDerivedRow = 0;
+
+    std::vector<int> recvBufferHaloIdDeleted;
+    std::vector<int> sendBufferHaloIdDeleted;
+
+    OutOfSync handleOutOfSync;
+    std::vector<Status> packFutures;
+    std::vector<Status> unpackFutures;
+
+#ifdef TAUSCH_CUDA
+    std::vector<unsigned char*> cudaSendBuffer;
+    std::vector<unsigned char*> cudaRecvBuffer;
+#endif
+
+#ifdef TAUSCH_OPENCL
+
+    cl::Device ocl_device;
+    cl::Context ocl_context;
+    cl::CommandQueue ocl_queue;
+
+#endif
+
+    /***********************************************************************/
+    /*                      CACHE OF BEST STRATEGIES                       */
+    /***********************************************************************/
+
+    /**
+     * @brief
+     * Compute the signature of a halo used as key in the strategy cache.
+     *
+     * The signature combines the message size (rounded to the next power of two), the number of
+     * regions, whether the remote rank is on the same node, the size of the data type of each
+     * buffer, and the version of the MPI library.
+     *
+     * @param isSend
+     * Whether the signature of a send halo (true) or of a recv halo (false) is requested.
+     * @param haloId
+     * The halo id returned by the addSendHaloInfo()/addRecvHaloInfo() member function.
+     *
+     * @return
+     * The signature as string.
+     */
+    inline std::string getHaloSignature(const bool isSend, const size_t haloId) {
+
+        const auto &indices = (isSend ? sendHaloIndices[haloId] : recvHaloIndices[haloId]);
+        const auto &elementOffsets = (isSend ? sendHaloElementOffsets[haloId] : recvHaloElementOffsets[haloId]);
+        const size_t totalSize = (isSend ? sendHaloIndicesSizeTotal[haloId] : recvHaloIndicesSizeTotal[haloId]);
+        const int remoteRank = (isSend ? sendHaloRemoteRank[haloId] : recvHaloRemoteRank[haloId]);
+        const auto &typeSizes = (isSend ? sendHaloTypeSizePerBuffer[haloId] : recvHaloTypeSizePerBuffer[haloId]);
+
+        size_t sizeBucket = 1;
+        while(sizeBucket < totalSize)
+            sizeBucket *= 2;
+
+        // fragmented buffers are packed element by element and count one region per element
+        size_t numRegions = 0;
+        for(size_t iBuf = 0; iBuf < indices.size(); ++iBuf)
+            numRegions += (elementOffsets[iBuf].size() > 0 ? elementOffsets[iBuf].size() : indices[iBuf].size());
+
+        // without a communicator (e.g., with a ThreadTransport) the location is not known
+        std::string location = "unknown";
+        if(TAUSCH_COMM != MPI_COMM_NULL && remoteRank >= 0 && remoteRank < static_cast<int>(rankToNode.size())) {
+            int myRank;
+            MPI_Comm_rank(TAUSCH_COMM, &myRank);
+            location = (rankToNode[remoteRank] == rankToNode[myRank] ? "onnode" : "offnode");
+        }
+
+        char version[MPI_MAX_LIBRARY_VERSION_STRING];
+        int versionLength;
+        MPI_Get_library_version(version, &versionLength);
+        std::string mpiVersion(version, versionLength);
+        mpiVersion = mpiVersion.substr(0, mpiVersion.find_first_of("\r\n,"));
+        std::replace(mpiVersion.begin(), mpiVersion.end(), ' ', '_');
+
+        std::stringstream sig;
+        sig << (isSend ? "send" : "recv") << ":" << sizeBucket << ":" << numRegions << ":" << location << ":";
+        for(size_t i = 0; i < typeSizes.size(); ++i)
+            sig << (i>0 ? "," : "") << typeSizes[i];
+        sig << ":" << mpiVersion;
+
+        return sig.str();
+
+    }
+
+    /**
+     * @brief
+     * Set the strategy of a halo to the one stored in the cache.
+     *
+     * Set the strategy of a halo to the one stored in the cache, if one is found and it can be used
+     * on this side only, i.e., it is one of the strategies allowed by setSendAdaptiveStrategy() (a
+     * stored TryDirectCopy is dropped). Unless disabled, the validation of the cached strategy is
+     * started (see setStrategyCache()).
+     *
+     * @param isSend
+     * Whether this is a send halo (true) or a recv halo (false).
+     * @param haloId
+     * The halo id returned by the addSendHaloInfo()/addRecvHaloInfo() member function.
+     */
+    inline void applyCachedCommunicationStrategy(const bool isSend, const size_t haloId) {
+
+        auto it = strategyCache.find(getHaloSignature(isSend, haloId));
+        if(it == strategyCache.end())
+            return;
+
+        // the cache is looked up for each side on its own, the remote side might not find the same
+        // entry, thus only strategies that work against Default on the other side are applied
+        // TryDirectCopy needs both halos to agree and is dropped, the message is then sent as usual
+        Communication strategy = static_cast<Communication>(it->second.first);
+        if((strategy&Communication::TryDirectCopy) == Communication::TryDirectCopy) {
+            strategy = static_cast<Communication>(strategy & ~Communication::TryDirectCopy);
+            if(strategy == 0)
+                strategy = Communication::Default;
+        }
+        if(!isAdaptiveCandidate(strategy))
+            return;
+
+        if(isSend)
+            setSendCommunicationStrategy(haloId, strategy);
+        else
+            setRecvCommunicationStrategy(haloId, strategy);
+
+        if(strategyCacheValidationRounds == 0 || strategy == Communication::Default)
+            return;
+
+        setAdaptiveStrategy(isSend, haloId, {strategy, Communication::Default}, 1);
+        AdaptiveStrategy &adaptive = (isSend ? sendHaloAdaptive[haloId] : recvHaloAdaptive[haloId]);
+        adaptive.validationRounds = strategyCacheValidationRounds;
+        adaptive.signature = it->first;
+
+    }
+
+    /**
+     * @brief
+     * Conclude the validation of a cached strategy.
+     *
+     * Keeps the faster of the cached strategy and Default, stores it in the cache, and marks the cache
+     * as stale if the cached strategy lost or got slower than allowed by the tolerance.
+     *
+     * @param isSend
+     * Whether this is a send halo (true) or a recv halo (false).
+     * @param haloId
+     * The halo id returned by the addSendHaloInfo()/addRecvHaloInfo() member function.
+     */
+    inline void finishStrategyValidation(const bool isSend, const size_t haloId) {
+
+        // the entry is only disabled, other threads might be looking up the adaptive state of other halos
+        AdaptiveStrategy &adaptive = (isSend ? sendHaloAdaptive[haloId] : recvHaloAdaptive[haloId]);
+        adaptive.enabled = false;
+
+        // candidate 0 is the cached strategy, candidate 1 is Default
+        const size_t best = (adaptive.times[0] <= adaptive.times[1] ? 0 : 1);
+
+        std::unique_lock<std::mutex> lock(strategyCacheMutex, std::defer_lock);
+        if(threadSafe)
+            lock.lock();
+
+        auto it = strategyCache.find(adaptive.signature);
+        if(best != 0 || (it != strategyCache.end() && adaptive.times[0] > strategyCacheTolerance*it->second.second))
+            strategyCacheStale = true;
+
+        strategyCache[adaptive.signature] = {static_cast<int>(adaptive.candidates[best]), adaptive.times[best]};
+
+        if(threadSafe)
+            lock.unlock();
+
+        if(adaptive.current != best)
+            switchCommunicationStrategy(isSend, haloId, adaptive.candidates[best]);
+
+    }
+
+    /**
+     * @brief
+     * Store a measured strategy for a given halo signature in the cache.
+     *
+     * @param signature
+     * The signature as returned by getHaloSignature().
+     * @param strategy
+     * The strategy that was measured.
+     * @param t
+     * The time it took (in ms).
+     */
+    inline void storeCommunicationStrategy(const std::string &signature, Communication strategy, double t) {
+
+        std::unique_lock<std::mutex> lock(strategyCacheMutex, std::defer_lock);
+        if(threadSafe)
+            lock.lock();
+
+        auto it = strategyCache.find(signature);
+
+        if(it == strategyCache.end() || it->second.second > t) {
+            strategyCache[signature] = {strategy, t};
+        } else if(it->second.first == strategy) {
+            if(t > strategyCacheTolerance*it->second.second)
+                strategyCacheStale = true;
+            it->second.second = t;
+        }
+
+    }
+
+    /**
+     * @brief
+     * Record for each rank which node it lives on.
+     *
+     * The node is identified by the rank (in the communicator passed to the constructor) of its
+     * leader, the rank 0 of the node communicator. This is a collective call.
+     */
+    inline void setupNodeMapping() {
+
+        int myRank, mpiSize;
+        MPI_Comm_rank(TAUSCH_COMM, &myRank);
+        MPI_Comm_size(TAUSCH_COMM, &mpiSize);
+
+        int nodeLeader = myRank;
+        MPI_Bcast(&nodeLeader, 1, MPI_INT, 0, TAUSCH_NODE_COMM);
+
+        rankToNode.resize(mpiSize);
+        MPI_Allgather(&nodeLeader, 1, MPI_INT, rankToNode.data(), 1, MPI_INT, TAUSCH_COMM);
+
+    }
+
+    /***********************************************************************/
+    /*                    ADAPTIVE STRATEGY SELECTION                      */
+    /***********************************************************************/
+
+    /**
+     * @brief
+     * Switch to a new strategy at a safe point.
+     *
+     * Waits for all outstanding messages of this halo (see waitForHaloMessages()), releases
+     * persistent requests, and then sets the new strategy.
+     *
+     * @param isSend
+     * Whether this is a send halo (true) or a recv halo (false).
+     * @param haloId
+     * The halo id returned by the addSendHaloInfo()/addRecvHaloInfo() member function.
+     * @param strategy
+     * The new strategy.
+     */
+    inline void switchCommunicationStrategy(const bool isSend, const size_t haloId, Communication strategy) {
+
+        waitForHaloMessages(isSend, haloId);
+        releasePersistentRequests(isSend, haloId);
+
+        auto &adaptiveMap = (isSend ? sendHaloAdaptive : recvHaloAdaptive);
+        auto adaptive = adaptiveMap.find(haloId);
+        if(adaptive != adaptiveMap.end())
+            adaptive->second.switching = true;
+
+        if(isSend)
+            setSendCommunicationStrategy(haloId, strategy);
+        else
+            setRecvCommunicationStrategy(haloId, strategy);
+
+        if(adaptive != adaptiveMap.end())
+            adaptive->second.switching = false;
+
+    }
+
+    /**
+     * @brief
+     * Enable adaptive strategy selection for a halo.
+     *
+     * See setSendAdaptiveStrategy() and setRecvAdaptiveStrategy().
+     *
+     * @param isSend
+     * Whether this is a send halo (true) or a recv halo (false).
+     * @param haloId
+     * The halo id returned by the addSendHaloInfo()/addRecvHaloInfo() member function.
+     * @param candidates
+     * The strategies to choose from.
+     * @param exploreInterval
+     * Every how many operations one of the currently not preferred strategies is re-timed.
+     */
+    inline void setAdaptiveStrategy(const bool isSend, const size_t haloId, std::vector<Communication> candidates, int exploreInterval) {
+
+        AdaptiveStrategy adaptive;
+        for(auto const & strategy : candidates) {
+            if(!isAdaptiveCandidate(strategy)) {
+                std::cout << "Tausch::setAdaptiveStrategy(): Strategy " << strategy << " cannot be selected adaptively, ignoring it..." << std::endl;
+                continue;
+            }
+            if(std::find(adaptive.candidates.begin(), adaptive.candidates.end(), strategy) != adaptive.candidates.end())
+                continue;
+            adaptive.candidates.push_back(strategy);
+            adaptive.times.push_back(-1);
+        }
+
+        if(adaptive.candidates.size() == 0)
+            return;
+
+        adaptive.exploreInterval = std::max(1, exploreInterval);
+
+        if(isSend)
+            sendHaloAdaptive[haloId] = adaptive;
+        else
+            recvHaloAdaptive[haloId] = adaptive;
+
+        switchCommunicationStrategy(isSend, haloId, adaptive.candidates[0]);
+
+    }
+
+    /**
+     * @brief
+     * Check whether a strategy can be switched to and from on one side only.
+     *
+     * See setSendAdaptiveStrategy() for which strategies are allowed.
+     *
+     * @param strategy
+     * The strategy to check.
+     *
+     * @return
+     * True if the strategy can be selected adaptively.
+     */
+    inline bool isAdaptiveCandidate(Communication strategy) {
+
+        if((strategy&Communication::DerivedMpiDatatype) == Communication::DerivedMpiDatatype ||
+           (strategy&Communication::DerivedMpiDatatypeSingleMessage) == Communication::DerivedMpiDatatypeSingleMessage ||
+           (strategy&Communication::MPIPartitioned) == Communication::MPIPartitioned ||
+           (strategy&Communication::UCX) == Communication::UCX ||
+           (strategy&Communication::TryDirectCopy) == Communication::TryDirectCopy)
+            return false;
+
+#ifndef TAUSCH_CUDA
+        if((strategy&Communication::CUDAAwareMPI) == Communication::CUDAAwareMPI)
+            return false;
+#endif
+#if !defined(TAUSCH_CUDA) && !defined(TAUSCH_HIP) && !defined(TAUSCH_OPENCL)
+        if((strategy&Communication::GPUMultiCopy) == Communication::GPUMultiCopy)
+            return false;
+#endif
+
+        return true;
+
+    }
+
+    /**
+     * @brief
+     * Record the timing of the previous operation and choose the strategy for the next one.
+     *
+     * This is called at the beginning of each send/recv of a halo in adaptive mode. It waits for the
+     * previous operation of the halo to complete (unless its completion was observed already), updates
+     * the moving average of the strategy used with the time from posting the previous operation until
+     * its completion, and switches strategy if another one is to be used next.
+     *
+     * @param isSend
+     * Whether this is a send halo (true) or a recv halo (false).
+     * @param haloId
+     * The halo id returned by the addSendHaloInfo()/addRecvHaloInfo() member function.
+     */
+    inline void adaptCommunicationStrategy(const bool isSend, const size_t haloId) {
+
+        AdaptiveStrategy &adaptive = (isSend ? sendHaloAdaptive[haloId] : recvHaloAdaptive[haloId]);
+
+        if(adaptive.timing != nullptr) {
+
+            adaptive.previous.wait();
+
+            const double sample = adaptive.timing->elapsed;
+            double &avg = adaptive.times[adaptive.current];
+            avg = (avg < 0 ? sample : 0.75*avg + 0.25*sample);
+
+            adaptive.timing.reset();
+            adaptive.previous = Status(MPI_REQUEST_NULL);
+
+        }
+
+        ++adaptive.counter;
+
+        // a cached strategy is validated by using it and Default in turns
+        if(adaptive.validationRounds > 0) {
+            if(adaptive.counter > adaptive.validationRounds*static_cast<int>(adaptive.candidates.size())) {
+                finishStrategyValidation(isSend, haloId);
+                return;
+            }
+            const size_t next = (adaptive.counter-1)%adaptive.candidates.size();
+            if(next != adaptive.current) {
+                adaptive.current = next;
+                switchCommunicationStrategy(isSend, haloId, adaptive.candidates[next]);
+            }
+            return;
+        }
+
+        size_t next = std::find(adaptive.times.begin(), adaptive.times.end(), -1.0) - adaptive.times.begin();
+
+        if(next == adaptive.times.size()) {
+
+            const size_t best = std::min_element(adaptive.times.begin(), adaptive.times.end()) - adaptive.times.begin();
+            next = best;
+
+            // every now and then we re-time one of the other candidates, and we let the cache know about the winner
+            if(adaptive.candidates.size() > 1 && adaptive.counter%adaptive.exploreInterval == 0) {
+                if(strategyCacheLoaded) {
+                    if(adaptive.signature == "")
+                        adaptive.signature = getHaloSignature(isSend, haloId);
+                    storeCommunicationStrategy(adaptive.signature, adaptive.candidates[best], adaptive.times[best]);
+                }
+                adaptive.explore = (adaptive.explore+1)%adaptive.candidates.size();
+                if(adaptive.explore == best)
+                    adaptive.explore = (adaptive.explore+1)%adaptive.candidates.size();
+                next = adaptive.explore;
+            }
+
+        }
+
+        if(next != adaptive.current) {
+            adaptive.current = next;
+            switchCommunicationStrategy(isSend, haloId, adaptive.candidates[next]);
+        }
+
+    }
+
+    /**
+     * @brief
+     * Check whether a halo is in adaptive mode.
+     *
+     * @param isSend
+     * Whether this is a send halo (true) or a recv halo (false).
+     * @param haloId
+     * The halo id returned by the addSendHaloInfo()/addRecvHaloInfo() member function.
+     *
+     * @return
+     * True if the strategy of the halo is picked adaptively (or a cached strategy is being validated).
+     */
+    inline bool isAdaptive(const bool isSend, const size_t haloId) {
+        auto &adaptiveMap = (isSend ? sendHaloAdaptive : recvHaloAdaptive);
+        auto it = adaptiveMap.find(haloId);
+        return (it != adaptiveMap.end() && it->second.enabled);
+    }
+
+    /**
+     * @brief
+     * Waits for and frees the persistent requests of a halo.
+     *
+     * They are set up again on the next send/recv.
+     *
+     * @param isSend
+     * Whether this is a send halo (true) or a recv halo (false).
+     * @param haloId
+     * The halo id returned by the addSendHaloInfo()/addRecvHaloInfo() member function.
+     */
+    inline void releasePersistentRequests(const bool isSend, const size_t haloId) {
+
+        if(!isSend)
+            cancelRearmed(haloId);
+
+        auto &requests = (isSend ? sendHaloMpiRequests[haloId] : recvHaloMpiRequests[haloId]);
+        auto &setup = (isSend ? sendHaloMpiSetup[haloId] : recvHaloMpiSetup[haloId]);
+
+        for(size_t iBuf = 0; iBuf < requests.size(); ++iBuf) {
+            if(setup[iBuf]) {
+                MPI_Wait(&requests[iBuf], MPI_STATUS_IGNORE);
+                MPI_Request_free(&requests[iBuf]);
+                requests[iBuf] = MPI_REQUEST_NULL;
+                setup[iBuf] = false;
+            }
+        }
+
+        auto ring = sendHaloRing.find(haloId);
+        if(isSend && ring != sendHaloRing.end()) {
+            for(size_t slot = 0; slot < ring->second.requests.size(); ++slot) {
+                MPI_Wait(&ring->second.requests[slot], MPI_STATUS_IGNORE);
+                if(ring->second.setup[slot]) {
+                    MPI_Request_free(&ring->second.requests[slot]);
+                    ring->second.requests[slot] = MPI_REQUEST_NULL;
+                    ring->second.setup[slot] = false;
+                }
+            }
+        }
+
+    }
+
+    /**
+     * @brief
+     * Waits for all messages of a halo still in flight.
+     *
+     * This covers the requests of the halo (persistent or not), the chunks of a striped halo, all
+     * buffers of a ring of send buffers, a UCX message and a receive posted through a custom transport. An
+     * auto-rearmed receive is cancelled, it is posted again by the next recv(). Sends through a custom
+     * transport are not tracked by Tausch, the caller has to have waited for them.
+     *
+     * @param isSend
+     * Whether this is a send halo (true) or a recv halo (false).
+     * @param haloId
+     * The halo id returned by the addSendHaloInfo()/addRecvHaloInfo() member function.
+     */
+    inline void waitForHaloMessages(const bool isSend, const size_t haloId) {
+
+        if(!isSend)
+            cancelRearmed(haloId);
+
+        // all requests are null without MPI (e.g., with a ThreadTransport), MPI must not be called then
+        auto waitAll = [](std::vector<MPI_Request> &requests) {
+            for(auto &req : requests) {
+                if(req != MPI_REQUEST_NULL) {
+                    MPI_Waitall(requests.size(), requests.data(), MPI_STATUSES_IGNORE);
+                    return;
+                }
+            }
+        };
+
+        waitAll(isSend ? sendHaloMpiRequests[haloId] : recvHaloMpiRequests[haloId]);
+
+        auto &striping = (isSend ? sendHaloStriping : recvHaloStriping);
+        auto stripes = striping.find(haloId);
+        if(stripes != striping.end())
+            waitAll(stripes->second.requests);
+
+        auto ring = sendHaloRing.find(haloId);
+        if(isSend && ring != sendHaloRing.end())
+            waitAll(ring->second.requests);
+
+#ifdef TAUSCH_UCX
+        auto &ucx = (isSend ? sendHaloUcx : recvHaloUcx);
+        auto ucxHalo = ucx.find(haloId);
+        if(ucxHalo != ucx.end() && ucxHalo->second.request != nullptr)
+            Status(ucxWorker, &ucxHalo->second.request).wait();
+#endif
+
+        if(!isSend && transport != nullptr) {
+            std::vector<Status> transported;
+            std::unique_lock<std::mutex> lock(transportMutex, std::defer_lock);
+            if(threadSafe)
+                lock.lock();
+            auto outstanding = recvHaloTransportStatus.find(haloId);
+            if(outstanding != recvHaloTransportStatus.end()) {
+                transported.push_back(outstanding->second);
+                recvHaloTransportStatus.erase(outstanding);
+            }
+            if(threadSafe)
+                lock.unlock();
+            for(auto &status : transported)
+                transport->wait(status);
+        }
+
+    }
+
+    /***********************************************************************/
+    /*                             COST MODEL                              */
+    /***********************************************************************/
+
+    /**
+     * @brief
+     * Predict the time spent on packing or unpacking a halo.
+     *
+     * @param isSend
+     * Whether this is a send halo (true) or a recv halo (false).
+     * @param haloId
+     * The halo id returned by the addSendHaloInfo()/addRecvHaloInfo() member function.
+     * @param strategy
+     * The strategy to predict the time for. With DerivedMpiDatatype and DerivedMpiDatatypeSingleMessage
+     * the packing is done by MPI.
+     *
+     * @return
+     * The predicted time in ms, or -1 if the cost model has not been calibrated.
+     */
+    inline double predictPackTime(const bool isSend, const size_t haloId, Communication strategy) {
+
+        if(!costModelCalibrated)
+            return -1;
+
+        const auto &indices = (isSend ? sendHaloIndices[haloId] : recvHaloIndices[haloId]);
+        const auto &elementOffsets = (isSend ? sendHaloElementOffsets[haloId] : recvHaloElementOffsets[haloId]);
+        const double bytes = (isSend ? sendHaloIndicesSizeTotal[haloId] : recvHaloIndicesSizeTotal[haloId]);
+
+        // fragmented buffers are packed element by element, every element counts as a row
+        double rows = 0;
+        for(size_t iBuf = 0; iBuf < indices.size(); ++iBuf) {
+            rows += elementOffsets[iBuf].size();
+            for(auto const & region : indices[iBuf])
+                rows += region[2];
+        }
+
+        if((strategy&Communication::DerivedMpiDatatype) == Communication::DerivedMpiDatatype ||
+           (strategy&Communication::DerivedMpiDatatypeSingleMessage) == Communication::DerivedMpiDatatypeSingleMessage)
+            return rows*costDerivedRow + bytes/costDerivedBandwidth;
+
+        return rows*costPackRow + bytes/costPackBandwidth;
+
+    }
+
+    /**
+     * @brief
+     * Predict the time a halo spends on the wire.
+     *
+     * @param isSend
+     * Whether this is a send halo (true) or a recv halo (false).
+     * @param haloId
+     * The halo id returned by the addSendHaloInfo()/addRecvHaloInfo() member function.
+     * @param strategy
+     * The strategy to predict the time for.
+     *
+     * @return
+     * The predicted time in ms, or -1 if the cost model has not been calibrated.
+     */
+    inline double predictWireTime(const bool isSend, const size_t haloId, Communication strategy) {
+
+        if(!costModelCalibrated)
+            return -1;
+
+        const double bytes = (isSend ? sendHaloIndicesSizeTotal[haloId] : recvHaloIndicesSizeTotal[haloId]);
+        if(bytes == 0)
+            return 0;
+
+        const double alpha = ((strategy&Communication::MPIPersistent) == Communication::MPIPersistent ? costAlphaPersistent : costAlpha);
+
+        // derived datatypes are sent as one message per buffer, unless they are combined into a single message
+        double numMessages = 1;
+        if((strategy&Communication::DerivedMpiDatatype) == Communication::DerivedMpiDatatype)
+            numMessages = (isSend ? sendHaloNumBuffers[haloId] : recvHaloNumBuffers[haloId]);
+
+        return numMessages*alpha + bytes/costBeta;
+
+    }
+
+    /**
+     * @brief
+     * Choose a strategy for a halo based on the cost model.
+     *
+     * @param isSend
+     * Whether this is a send halo (true) or a recv halo (false).
+     * @param haloId
+     * The halo id returned by the addSendHaloInfo()/addRecvHaloInfo() member function.
+     *
+     * @return
+     * The predicted fastest strategy (Default if the cost model has not been calibrated).
+     */
+    inline Communication chooseCommunicationStrategy(const bool isSend, const size_t haloId) {
+
+        if(!costModelCalibrated)
+            return Communication::Default;
+
+        Communication best = Communication::Default;
+        double t_best = -1;
+
+        for(Communication strategy : {Communication::Default, Communication::MPIPersistent,
+                                      Communication::DerivedMpiDatatype, Communication::DerivedMpiDatatypeSingleMessage}) {
+            const double t = predictPackTime(isSend, haloId, strategy) + predictWireTime(isSend, haloId, strategy);
+            if(t_best < 0 || t < t_best) {
+                t_best = t;
+                best = strategy;
+            }
+        }
+
+        return best;
+
+    }
+
+    /***********************************************************************/
+    /*                            NUMA PLACEMENT                           */
+    /***********************************************************************/
+
+    /**
+     * @brief
+     * Places the staging buffer of a halo on a NUMA node.
+     *
+     * The staging buffers are not initialised when a halo is added, thus their pages are placed
+     * by whichever thread touches them first. This re-allocates the staging buffer of a halo (all
+     * buffers of a ring of send buffers, see setSendBufferRing()) and touches it from a thread pinned to
+     * the given node, e.g., the node of the data being packed (see getNumaNodeOfAddress()) or the
+     * node close to the network card. Optionally the threads doing the non-blocking
+     * packing/unpacking of this halo are pinned to the same node.
+     *
+     * This function blocks until the old staging buffer is no longer in use: a non-blocking
+     * packing/unpacking of this halo is completed and all its messages still in flight (including
+     * striped chunks, a ring of send buffers and a receive through a custom transport) are waited
+     * for, an auto-rearmed receive is cancelled. Thus, for a recv halo the matching message has to be
+     * sent before, otherwise this deadlocks. A send through a custom transport is not tracked, it has
+     * to have been waited for before. Any persistent requests of this halo are released and set up
+     * again on the next send/recv, a UCX registration is moved to the new buffer. The content of the
+     * staging buffer is copied over, so data received but not yet unpacked (or packed but not yet
+     * sent) is kept. Waiting on a Status returned by an earlier send()/recv() of this halo is still
+     * valid afterwards.
+     *
+     * @param isSend
+     * Whether this is a send halo (true) or a recv halo (false).
+     * @param haloId
+     * The halo id returned by the addSendHaloInfo()/addRecvHaloInfo() member function.
+     * @param node
+     * The NUMA node.
+     * @param pinThreads
+     * Whether to pin the threads doing non-blocking packing/unpacking to the node.
+     */
+    inline void setHaloNumaNode(const bool isSend, const size_t haloId, const int node, const bool pinThreads = true) {
+
+        auto &threadNode = (isSend ? sendHaloThreadNumaNode : recvHaloThreadNumaNode);
+        if(pinThreads)
+            threadNode[haloId] = node;
+        else
+            threadNode.erase(haloId);
+
+        // with derived datatypes there is no staging buffer
+        const Communication strategy = (isSend ? sendHaloCommunicationStrategy[haloId] : recvHaloCommunicationStrategy[haloId]);
+        if((strategy&Communication::DerivedMpiDatatype) == Communication::DerivedMpiDatatype ||
+           (strategy&Communication::DerivedMpiDatatypeSingleMessage) == Communication::DerivedMpiDatatypeSingleMessage)
+            return;
+
+        // nothing may still be reading from or writing into the old staging buffer
+        (isSend ? packFutures[haloId] : unpackFutures[haloId]).wait();
+        waitForHaloMessages(isSend, haloId);
+        releasePersistentRequests(isSend, haloId);
+
+        auto &staging = (isSend ? sendBuffer[haloId] : recvBuffer[haloId]);
+        auto ring = sendHaloRing.find(haloId);
+        const bool hasRing = (isSend && ring != sendHaloRing.end());
+
+        // with a ring of send buffers all buffers of the ring are moved
+        std::vector<unsigned char*> old;
+        if(hasRing)
+            old = ring->second.buffers;
+        else
+            old.push_back(staging);
+
+        // the content is kept, e.g., data packed but not yet sent or received but not yet unpacked
+        const size_t size = (isSend ? sendHaloIndicesSizeTotal[haloId] : recvHaloIndicesSizeTotal[haloId]);
+        std::vector<unsigned char*> bufs(old.size());
+        for(auto &buf : bufs)
+            buf = new unsigned char[size];
+        std::thread([=]() {
+            pinThreadToNumaNode(node);
+            for(size_t i = 0; i < bufs.size(); ++i)
+                std::memcpy(bufs[i], old[i], size);
+        }).join();
+
+        if(hasRing) {
+            ring->second.buffers = bufs;
+            staging = bufs[ring->second.current];
+        } else
+            staging = bufs[0];
+
+#ifdef TAUSCH_UCX
+        // moves the registration to the new staging buffer
+        if((isSend ? sendHaloUcx : recvHaloUcx).count(haloId) > 0)
+            registerUcxBuffer(isSend, haloId);
+#endif
+
+        for(auto buf : old)
+            delete[] buf;
+
+    }
+
+    /**
+     * @brief
+     * Pins the calling worker thread as requested by setHaloNumaNode().
+     *
+     * @param isSend
+     * Whether this is a send halo (true) or a recv halo (false).
+     * @param haloId
+     * The halo id returned by the addSendHaloInfo()/addRecvHaloInfo() member function.
+     */
+    inline void pinWorkerThread(const bool isSend, const size_t haloId) {
+        const int node = getThreadNumaNode(isSend, haloId);
+        if(node >= 0)
+            pinThreadToNumaNode(node);
+    }
+
+    /**
+     * @brief
+     * Returns the NUMA node worker threads of a halo are pinned to, -1 if none.
+     */
+    inline int getThreadNumaNode(const bool isSend, const size_t haloId) {
+        const auto &threadNode = (isSend ? sendHaloThreadNumaNode : recvHaloThreadNumaNode);
+        auto it = threadNode.find(haloId);
+        return (it == threadNode.end() ? -1 : it->second);
+    }
+
+    /***********************************************************************/
+    /*                         PACK MULTIPLE BUFFERS                       */
+    /***********************************************************************/
+
+    /**
+     * @brief
+     * Packs the buffers with ids [first, last) of a send halo.
+     *
+     * Used internally by packSendBuffers().
+     */
+    inline void packSendBufferFields(const size_t haloId, const std::vector<const unsigned char*> &bufs, const size_t first, const size_t last) {
+
+        if(!sendHaloUniformLayout[haloId]) {
+            for(size_t bufferId = first; bufferId < last; ++bufferId)
+                packSendBuffer(haloId, bufferId, bufs[bufferId]);
+            return;
+        }
+
+        const size_t fieldSize = sendHaloIndicesSizePerBuffer[haloId][0];
+        unsigned char *dst = &sendBuffer[haloId][first*fieldSize];
+        const unsigned char * const *srcs = &bufs[first];
+        const size_t numFields = last-first;
+
+        const auto &elementOffsets = sendHaloElementOffsets[haloId][0];
+
+        if(elementOffsets.size() > 0) {
+
+            gatherElementsMultiField(dst, fieldSize, srcs, numFields, elementOffsets.data(), elementOffsets.size(), sendHaloTypeSizePerBuffer[haloId][0]);
+
+        } else {
+
+            size_t mpiSendBufferIndex = 0;
+            const bool streaming = (size_t(sendHaloIndicesSizeTotal[haloId]) >= nonTemporalPackThreshold);
+
+            for(auto const & region : haloRegions(true, haloId, 0)) {
+
+                const size_t &region_start = region[0];
+                const size_t &region_howmanycols = region[1];
+                const size_t &region_howmanyrows = region[2];
+                const size_t &region_stridecol = region[3];
+
+                for(size_t rows = 0; rows < region_howmanyrows; ++rows) {
+
+                    for(size_t f = 0; f < numFields; ++f)
+                        copyRow(&dst[f*fieldSize + mpiSendBufferIndex], &srcs[f][region_start + rows*region_stridecol], region_howmanycols, streaming);
+                    mpiSendBufferIndex += region_howmanycols;
+
+                }
+
+            }
+
+            if(streaming)
+                streamFence();
+
+        }
+
+        if((sendHaloCommunicationStrategy[haloId]&Communication::MPIPartitioned) == Communication::MPIPartitioned)
+            for(size_t bufferId = first; bufferId < last; ++bufferId)
+                markPartitionPacked(haloId, bufferId, sendHaloIndicesSizePerBuffer[haloId][bufferId]);
+
+    }
+
+    /***********************************************************************/
+    /*                       HIERARCHICAL EXCHANGE                         */
+    /***********************************************************************/
+
+    /**
+     * @brief
+     * Serializes the halos handled by exchangeHierarchical().
+     *
+     * The layout is: number of outgoing triples, number of incoming triples, the triples (source
+     * rank, destination rank, size in bytes), and the data of the outgoing halos.
+     */
+    static inline std::vector<unsigned char> serializeHierarchicalItems(const std::vector<uint64_t> &outMeta, const std::vector<uint64_t> &inMeta, const std::vector<unsigned char> &data) {
+
+        std::vector<uint64_t> header = {outMeta.size()/3, inMeta.size()/3};
+        header.insert(header.end(), outMeta.begin(), outMeta.end());
+        header.insert(header.end(), inMeta.begin(), inMeta.end());
+
+        std::vector<unsigned char> blob(header.size()*sizeof(uint64_t) + data.size());
+        std::memcpy(blob.data(), header.data(), header.size()*sizeof(uint64_t));
+        if(data.size() > 0)
+            std::memcpy(&blob[header.size()*sizeof(uint64_t)], data.data(), data.size());
+
+        return blob;
+
+    }
+
+    /**
+     * @brief
+     * Deserializes the halos handled by exchangeHierarchical(), see serializeHierarchicalItems().
+     */
+    static inline void deserializeHierarchicalItems(const unsigned char *blob, std::vector<uint64_t> &outMeta, std::vector<uint64_t> &inMeta, std::vector<unsigned char> &data) {
+
+        uint64_t counts[2];
+        std::memcpy(counts, blob, 2*sizeof(uint64_t));
+
+        outMeta.resize(3*counts[0]);
+        inMeta.resize(3*counts[1]);
+        size_t offset = 2*sizeof(uint64_t);
+        if(counts[0] > 0)
+            std::memcpy(outMeta.data(), &blob[offset], outMeta.size()*sizeof(uint64_t));
+        offset += outMeta.size()*sizeof(uint64_t);
+        if(counts[1] > 0)
+            std::memcpy(inMeta.data(), &blob[offset], inMeta.size()*sizeof(uint64_t));
+        offset += inMeta.size()*sizeof(uint64_t);
+
+        size_t dataSize = 0;
+        for(size_t j = 0; j < outMeta.size(); j += 3)
+            dataSize += outMeta[j+2];
+        data.assign(&blob[offset], &blob[offset+dataSize]);
+
+    }
+
+    /**
+     * @brief
+     * Gathers a blob of every rank of the node on the node leader.
+     *
+     * Used internally by exchangeHierarchical().
+     */
+    inline void gatherOnNodeLeader(const std::vector<unsigned char> &blob, std::vector<unsigned char> &all, std::vector<int> &sizes, std::vector<int> &displs) {
+
+        int nodeRank, nodeSize;
+        MPI_Comm_rank(TAUSCH_NODE_COMM, &nodeRank);
+        MPI_Comm_size(TAUSCH_NODE_COMM, &nodeSize);
+
+        const int size = blob.size();
+        sizes.assign(nodeSize, 0);
+        displs.assign(nodeSize, 0);
+        MPI_Gather(&size, 1, MPI_INT, sizes.data(), 1, MPI_INT, 0, TAUSCH_NODE_COMM);
+
+        if(nodeRank == 0) {
+            for(int i = 1; i < nodeSize; ++i)
+                displs[i] = displs[i-1] + sizes[i-1];
+            all.resize(displs.back() + sizes.back());
+        }
+
+        MPI_Gatherv(blob.data(), size, MPI_CHAR, all.data(), sizes.data(), displs.data(), MPI_CHAR, 0, TAUSCH_NODE_COMM);
+
+    }
+
+    /**
+     * @brief
+     * Scatters a blob to every rank of the node from the node leader.
+     *
+     * Used internally by exchangeHierarchical().
+     */
+    inline void scatterFromNodeLeader(const std::vector<unsigned char> &all, const std::vector<int> &sizes, const std::vector<int> &displs, std::vector<unsigned char> &blob) {
+
+        int size;
+        MPI_Scatter(sizes.data(), 1, MPI_INT, &size, 1, MPI_INT, 0, TAUSCH_NODE_COMM);
+
+        blob.resize(size);
+        MPI_Scatterv(all.data(), sizes.data(), displs.data(), MPI_CHAR, blob.data(), size, MPI_CHAR, 0, TAUSCH_NODE_COMM);
+
+    }
+
+    /***********************************************************************/
+    /*                              CHANNELS                               */
+    /***********************************************************************/
+
+    /**
+     * @brief
+     * Assign a halo to a specific channel.
+     *
+     * By default the channel of a message is chosen by hashing the sending rank, the receiving
+     * rank, and the message tag, which gives the same channel on both sides. This allows to
+     * balance the load across channels by hand instead, the sending and the receiving halo need to
+     * be assigned the same channel.
+     *
+     * @param isSend
+     * Whether this is a send halo (true) or a recv halo (false).
+     * @param haloId
+     * The halo id returned by the addSendHaloInfo()/addRecvHaloInfo() member function.
+     * @param channel
+     * The channel, -1 to go back to hashing.
+     */
+    inline void setHaloChannel(const bool isSend, const size_t haloId, const int channel) {
+
+        auto &channels = (isSend ? sendHaloChannel : recvHaloChannel);
+        if(channel < 0)
+            channels.erase(haloId);
+        else
+            channels[haloId] = channel;
+
+    }
+
+    /**
+     * @brief
+     * Returns the channel a message of a halo is sent/received on.
+     *
+     * @param isSend
+     * Whether this is a send halo (true) or a recv halo (false).
+     * @param haloId
+     * The halo id returned by the addSendHaloInfo()/addRecvHaloInfo() member function.
+     * @param msgtag
+     * The message tag.
+     * @param remoteMpiRank
+     * The remote rank.
+     *
+     * @return
+     * The channel, an index into the pool of channel communicators.
+     */
+    inline int getChannel(const bool isSend, const size_t haloId, const int msgtag, const int remoteMpiRank) {
+
+        const int numChannels = channelPool.size();
+
+        const auto &channels = (isSend ? sendHaloChannel : recvHaloChannel);
+        auto it = channels.find(haloId);
+        if(it != channels.end())
+            return it->second%numChannels;
+
+        int myRank;
+        MPI_Comm_rank(TAUSCH_COMM, &myRank);
+        const uint64_t sender = (isSend ? myRank : remoteMpiRank);
+        const uint64_t receiver = (isSend ? remoteMpiRank : myRank);
+
+        const uint64_t hash = (sender*73856093u) ^ (receiver*19349663u) ^ (static_cast<uint64_t>(msgtag)*83492791u);
+
+        return hash%numChannels;
+
+    }
+
+    /***********************************************************************/
+    /*                             PREWARMING                              */
+    /***********************************************************************/
+
+    /**
+     * @brief
+     * Set up the resources of a single halo before the first exchange.
+     *
+     * Used internally by prewarm().
+     *
+     * @param isSend
+     * Whether this is a send halo (true) or a recv halo (false).
+     * @param haloId
+     * The halo id returned by the addSendHaloInfo()/addRecvHaloInfo() member function.
+     * @param msgtags
+     * The message tags to be used per halo id.
+     */
+    inline void prewarmHalo(const bool isSend, const size_t haloId, const std::map<size_t, int> &msgtags) {
+
+        const Communication strategy = (isSend ? sendHaloCommunicationStrategy[haloId] : recvHaloCommunicationStrategy[haloId]);
+        const size_t size = (isSend ? sendHaloIndicesSizeTotal[haloId] : recvHaloIndicesSizeTotal[haloId]);
+        const int numBuffers = (isSend ? sendHaloNumBuffers[haloId] : recvHaloNumBuffers[haloId]);
+        const auto &haloBuffers = (isSend ? sendHaloBuffer : recvHaloBuffer);
+        const bool haveBuffers = (haloBuffers.find(haloId) != haloBuffers.end() && static_cast<int>(haloBuffers.at(haloId).size()) == numBuffers);
+
+        if(size == 0)
+            return;
+
+        // the staging buffer is only used (and allocated) without derived datatypes
+        const bool derived = ((strategy&Communication::DerivedMpiDatatype) == Communication::DerivedMpiDatatype ||
+                              (strategy&Communication::DerivedMpiDatatypeSingleMessage) == Communication::DerivedMpiDatatypeSingleMessage);
+
+        if((strategy&Communication::DerivedMpiDatatypeSingleMessage) == Communication::DerivedMpiDatatypeSingleMessage && haveBuffers)
+            getCombinedDatatype(isSend, haloId);
+
+        // buffers placed on a NUMA node have been touched from there already
+        const auto &numaNodes = (isSend ? sendHaloThreadNumaNode : recvHaloThreadNumaNode);
+        if(!derived && numaNodes.find(haloId) == numaNodes.end()) {
+            std::memset((isSend ? sendBuffer[haloId] : recvBuffer[haloId]), 0, size);
+            auto ring = sendHaloRing.find(haloId);
+            if(isSend && ring != sendHaloRing.end())
+                for(auto buf : ring->second.buffers)
+                    std::memset(buf, 0, size);
+        }
+
+        // persistent requests are only used when sending/receiving the halo as a whole
+        auto msgtag = msgtags.find(haloId);
+        if(msgtag == msgtags.end() ||
+           (strategy&Communication::MPIPersistent) != Communication::MPIPersistent ||
+           (strategy&Communication::MPIPartitioned) == Communication::MPIPartitioned ||
+           (strategy&Communication::UCX) == Communication::UCX ||
+           usesTransport(isSend, haloId, MPI_COMM_NULL) ||
+           isStriped(isSend, haloId) ||
+           (isSend && isRingBuffered(haloId)))
+            return;
+
+        if((strategy&Communication::DerivedMpiDatatypeSingleMessage) == Communication::DerivedMpiDatatypeSingleMessage && !haveBuffers)
+            return;
+
+        // the remote rank might only be known once the halo is sent/received
+        const int remoteRank = (isSend ? sendHaloRemoteRank[haloId] : recvHaloRemoteRank[haloId]);
+        if(remoteRank < 0)
+            return;
+
+        MPI_Comm communicator = (useChannels ? channelPool[getChannel(isSend, haloId, msgtag->second, remoteRank)] : TAUSCH_COMM);
+
+        auto &setup = (isSend ? sendHaloMpiSetup[haloId] : recvHaloMpiSetup[haloId]);
+        const int numRequests = ((strategy&Communication::DerivedMpiDatatype) == Communication::DerivedMpiDatatype ? numBuffers : 1);
+        for(int bufferId = 0; bufferId < numRequests; ++bufferId) {
+            if(setup[bufferId])
+                continue;
+            if((strategy&Communication::DerivedMpiDatatype) == Communication::DerivedMpiDatatype &&
+               (haloBuffers.find(haloId) == haloBuffers.end() || haloBuffers.at(haloId).find(bufferId) == haloBuffers.at(haloId).end()))
+                continue;
+            initPersistentRequest(isSend, haloId, bufferId, msgtag->second, remoteRank, communicator);
+        }
+
+    }
+
+    /**
+     * @brief
+     * Initialize the persistent request of a halo.
+     *
+     * Used internally by send()/recv() the first time a halo using MPIPersistent is sent/received,
+     * and by prewarm(). The request is not started.
+     *
+     * @param isSend
+     * Whether this is a send halo (true) or a recv halo (false).
+     * @param haloId
+     * The halo id returned by the addSendHaloInfo()/addRecvHaloInfo() member function.
+     * @param bufferId
+     * The buffer id (only relevant for DerivedMpiDatatype, 0 otherwise).
+     * @param msgtag
+     * The message tag to be used.
+     * @param remoteRank
+     * The rank to send to/receive from.
+     * @param communicator
+     * The communicator to be used.
+     */
+    inline void initPersistentRequest(const bool isSend, const size_t haloId, const int bufferId, const int msgtag, const int remoteRank, MPI_Comm communicator) {
+
+        if(isSend) {
+
+            sendHaloMpiSetup[haloId][bufferId] = true;
+
+#ifdef TAUSCH_CUDA
+            if((sendHaloCommunicationStrategy[haloId]&Communication::CUDAAwareMPI) == Communication::CUDAAwareMPI) {
+
+                MPI_Send_init(cudaSendBuffer[haloId], sendHaloIndicesSizeTotal[haloId], MPI_CHAR,
+                              remoteRank, msgtag, communicator,
+                              &sendHaloMpiRequests[haloId][0]);
+
+            } else
+#endif
+            if((sendHaloCommunicationStrategy[haloId]&Communication::DerivedMpiDatatypeSingleMessage) == Communication::DerivedMpiDatatypeSingleMessage)
+                MPI_Send_init(MPI_BOTTOM, 1, getCombinedDatatype(true, haloId),
+                              remoteRank, msgtag, communicator,
+                              &sendHaloMpiRequests[haloId][0]);
+            else if((sendHaloCommunicationStrategy[haloId]&Communication::DerivedMpiDatatype) == Communication::DerivedMpiDatatype)
+                MPI_Send_init(sendHaloBuffer.at(haloId).at(bufferId), 1, sendHaloDerivedDatatype.at(haloId)[bufferId],
+                              remoteRank, msgtag, communicator,
+                              &sendHaloMpiRequests[haloId][bufferId]);
+            else
+                MPI_Send_init(sendBuffer[haloId], sendHaloIndicesSizeTotal[haloId], MPI_CHAR,
+                              remoteRank, msgtag, communicator,
+                              &sendHaloMpiRequests[haloId][0]);
+
+        } else {
+
+            recvHaloMpiSetup[haloId][bufferId] = true;
+
+#ifdef TAUSCH_CUDA
+            if((recvHaloCommunicationStrategy[haloId]&Communication::CUDAAwareMPI) == Communication::CUDAAwareMPI) {
+
+                MPI_Recv_init(cudaRecvBuffer[haloId], recvHaloIndicesSizeTotal[haloId], MPI_CHAR,
+                              remoteRank, msgtag, communicator,
+                              &recvHaloMpiRequests[haloId][0]);
+
+            } else
+#endif
+            if((recvHaloCommunicationStrategy[haloId]&Communication::DerivedMpiDatatypeSingleMessage) == Communication::DerivedMpiDatatypeSingleMessage)
+                MPI_Recv_init(MPI_BOTTOM, 1, getCombinedDatatype(false, haloId),
+                              remoteRank, msgtag, communicator,
+                              &recvHaloMpiRequests[haloId][0]);
+            else if((recvHaloCommunicationStrategy[haloId]&Communication::DerivedMpiDatatype) == Communication::DerivedMpiDatatype)
+                MPI_Recv_init(recvHaloBuffer.at(haloId).at(bufferId), 1, recvHaloDerivedDatatype.at(haloId)[bufferId],
+                              remoteRank, msgtag, communicator,
+                              &recvHaloMpiRequests[haloId][bufferId]);
+            else
+                MPI_Recv_init(recvBuffer[haloId], recvHaloIndicesSizeTotal[haloId], MPI_CHAR,
+                              remoteRank, msgtag, communicator,
+                              &recvHaloMpiRequests[haloId][0]);
+
+        }
+
+    }
+
+    /***********************************************************************/
+    /*                          NETWORK EMULATION                          */
+    /***********************************************************************/
+
+    /**
+     * @brief
+     * Compute the modeled completion of a message and attach it to its Status.
+     *
+     * Used internally by send()/recv(). The sender sends the modeled arrival time as a separate
+     * message with the same tag on a duplicate of the communicator, the receiver only learns it
+     * once that message has arrived. MPI keeps messages with the same source and tag in order, so
+     * the k-th arrival time belongs to the k-th message.
+     *
+     * @param isSend
+     * Whether this is a send halo (true) or a recv halo (false).
+     * @param haloId
+     * The halo id returned by the addSendHaloInfo()/addRecvHaloInfo() member function.
+     * @param msgtag
+     * The message tag used.
+     * @param remoteMpiRank
+     * The remote rank passed to send()/recv().
+     * @param bufferId
+     * The buffer id passed to send()/recv().
+     * @param status
+     * The Status of the message.
+     */
+    inline void emulateNetwork(const bool isSend, const size_t haloId, const int msgtag, const int remoteMpiRank, const int bufferId, Status &status) {
+
+        if(usesTransport(isSend, haloId, MPI_COMM_NULL))
+            return;
+
+        // same decisions as in sendMessage()/recvMessage(), messages are sent only if these are fulfilled
+        size_t size = (isSend ? sendHaloIndicesSizeTotal[haloId] : recvHaloIndicesSizeTotal[haloId]);
+        if(size == 0)
+            return;
+
+        Communication strategy = (isSend ? sendHaloCommunicationStrategy[haloId] : recvHaloCommunicationStrategy[haloId]);
+        if((strategy&Communication::DerivedMpiDatatype) == Communication::DerivedMpiDatatype && bufferId >= 0)
+            size = (isSend ? sendHaloIndicesSizePerBuffer[haloId][bufferId] : recvHaloIndicesSizePerBuffer[haloId][bufferId]);
+
+        int remoteRank = (remoteMpiRank != -1 ? remoteMpiRank : (isSend ? sendHaloRemoteRank.at(haloId) : recvHaloRemoteRank.at(haloId)));
+
+        int myRank;
+        MPI_Comm_rank(TAUSCH_COMM, &myRank);
+        if(myRank/networkEmulation.ranksPerNode == remoteRank/networkEmulation.ranksPerNode)
+            return;
+
+        // the link and the arrival times in flight are shared by all halos
+        std::unique_lock<std::mutex> lock(networkEmulation.mutex, std::defer_lock);
+        if(threadSafe)
+            lock.lock();
+
+        // drop the arrival times sent/received earlier that are not needed anymore
+        for(auto *pending : {&networkEmulation.sent, &networkEmulation.received}) {
+            for(size_t i = 0; i < pending->size();) {
+                int flag = 1;
+                if((*pending)[i]->request != MPI_REQUEST_NULL)
+                    MPI_Test(&(*pending)[i]->request, &flag, MPI_STATUS_IGNORE);
+                if(flag && (*pending)[i].use_count() == 1) {
+                    (*pending)[i] = pending->back();
+                    pending->pop_back();
+                } else
+                    ++i;
+            }
+        }
+
+        auto emulated = std::make_shared<Status::EmulatedCompletion>();
+
+        if(isSend) {
+
+            const double share = 1.0 + networkEmulation.contention*(networkEmulation.ranksPerNode-1);
+            const int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+            const int64_t start = std::max(now, networkEmulation.linkFreeAt);
+            const int64_t transfer = static_cast<int64_t>(1e9*size*share/networkEmulation.bandwidth);
+
+            // the send buffer can be reused once the message has left, the message arrives a latency later
+            networkEmulation.linkFreeAt = start + transfer;
+            emulated->completion = start + transfer;
+
+            auto arrival = std::make_shared<Status::EmulatedCompletion>();
+            arrival->completion = start + transfer + static_cast<int64_t>(1e9*networkEmulation.latency);
+            MPI_Isend(&arrival->completion, 1, MPI_INT64_T, remoteRank, msgtag, networkEmulation.comm, &arrival->request);
+            networkEmulation.sent.push_back(arrival);
+
+        } else {
+
+            MPI_Irecv(&emulated->completion, 1, MPI_INT64_T, remoteRank, msgtag, networkEmulation.comm, &emulated->request);
+            networkEmulation.received.push_back(emulated);
+
+        }
+
+        status.setEmulatedCompletion(emulated);
+
+    }
+
+    /***********************************************************************/
+    /*                              TRANSPORT                              */
+    /***********************************************************************/
+
+    /**
+     * @brief
+     * Check whether a message of a halo goes through the custom transport.
+     *
+     * This is checked before TryDirectCopy, striping, and the ring of send buffers, which are all
+     * bypassed by the transport (see setTransport()).
+     *
+     * @param isSend
+     * Whether this is a send halo (true) or a recv halo (false).
+     * @param haloId
+     * The halo id returned by the addSendHaloInfo()/addRecvHaloInfo() member function.
+     * @param communicator
+     * The communicator passed to send()/recv().
+     *
+     * @return
+     * Whether the transport is used.
+     */
+    inline bool usesTransport(const bool isSend, const size_t haloId, MPI_Comm communicator) {
+
+        if(transport == nullptr || communicator != MPI_COMM_NULL)
+            return false;
+
+        Communication strategy = (isSend ? sendHaloCommunicationStrategy[haloId] : recvHaloCommunicationStrategy[haloId]);
+        return (isAggregatable(strategy) && (strategy&Communication::UCX) != Communication::UCX);
+
+    }
+
+    /**
+     * @brief
+     * Post the message of a halo using the custom transport.
+     *
+     * Used internally by send()/recv().
+     *
+     * @param isSend
+     * Whether this is a send halo (true) or a recv halo (false).
+     * @param haloId
+     * The halo id returned by the addSendHaloInfo()/addRecvHaloInfo() member function.
+     * @param msgtag
+     * The message tag to be used.
+     * @param remoteRank
+     * The rank of the transport to send to/receive from.
+     * @param blocking
+     * Whether to wait for the message to complete.
+     *
+     * @return
+     * Status object returned by the transport.
+     */
+    inline Status postTransportMessage(const bool isSend, const size_t haloId, const int msgtag, const int remoteRank, const bool blocking) {
+
+        if(isSend) {
+            Status status = transport->postSend(sendBuffer[haloId], sendHaloIndicesSizeTotal[haloId], remoteRank, msgtag);
+            if(blocking)
+                transport->wait(status);
+            return status;
+        }
+
+        // the map of outstanding receives is shared by all halos, the waiting is done without holding the lock
+        std::unique_lock<std::mutex> lock(transportMutex, std::defer_lock);
+        if(threadSafe)
+            lock.lock();
+        std::vector<Status> previous;
+        auto outstanding = recvHaloTransportStatus.find(haloId);
+        if(outstanding != recvHaloTransportStatus.end()) {
+            previous.push_back(outstanding->second);
+            recvHaloTransportStatus.erase(outstanding);
+        }
+        if(threadSafe)
+            lock.unlock();
+
+        for(auto &prev : previous)
+            transport->wait(prev);
+
+        Status status = transport->postRecv(recvBuffer[haloId], recvHaloIndicesSizeTotal[haloId], remoteRank, msgtag);
+        if(blocking)
+            transport->wait(status);
+
+        if(threadSafe)
+            lock.lock();
+        recvHaloTransportStatus.insert(std::make_pair(int(haloId), status));
+        return status;
+
+    }
+
+    /***********************************************************************/
+    /*                                 UCX                                 */
+    /***********************************************************************/
+
+    /**
+     * @brief
+     * Check whether a halo can use the UCX strategy.
+     *
+     * Used internally by setSendCommunicationStrategy()/setRecvCommunicationStrategy(). Falls back
+     * to the Default strategy if UCX is not available or has not been set up.
+     *
+     * @param isSend
+     * Whether this is a send halo (true) or a recv halo (false).
+     * @param haloId
+     * The halo id returned by the addSendHaloInfo()/addRecvHaloInfo() member function.
+     */
+    inline void setupUcxHalo(const bool isSend, const size_t haloId) {
+
+#ifdef TAUSCH_UCX
+        if(ucxWorker != nullptr) {
+            // register the staging buffer right away, it is re-registered if it changes later on
+            registerUcxBuffer(isSend, haloId);
+            return;
+        }
+        std::cout << "Tausch::setupUcxHalo(): UCX has not been set up using setupUcx(), falling back to Default..." << std::endl;
+#else
+        std::cout << "Tausch::setupUcxHalo(): UCX requires TAUSCH_UCX, falling back to Default..." << std::endl;
+#endif
+
+        if(isSend)
+            sendHaloCommunicationStrategy[haloId] = Communication::Default;
+        else
+            recvHaloCommunicationStrategy[haloId] = Communication::Default;
+
+    }
+
+#ifdef TAUSCH_UCX
+
+    /**
+     * @brief
+     * Get the UCX endpoint connected to a rank.
+     *
+     * The endpoint is created the first time it is needed.
+     *
+     * @param rank
+     * The rank in the communicator passed to the constructor.
+     *
+     * @return
+     * The UCX endpoint.
+     */
+    inline ucp_ep_h getUcxEndpoint(const int rank) {
+
+        std::unique_lock<std::mutex> lock(ucxMutex, std::defer_lock);
+        if(threadSafe)
+            lock.lock();
+
+        if(ucxEndpoints[rank] == nullptr) {
+            ucp_ep_params_t params;
+            params.field_mask = UCP_EP_PARAM_FIELD_REMOTE_ADDRESS;
+            params.address = reinterpret_cast<const ucp_address_t*>(ucxAddresses[rank].data());
+            ucs_status_t status = ucp_ep_create(ucxWorker, &params, &ucxEndpoints[rank]);
+            if(status != UCS_OK) {
+                std::cout << "Tausch::getUcxEndpoint(): Unable to connect to rank " << rank << ": " << ucs_status_string(status) << std::endl;
+                ucxEndpoints[rank] = nullptr;
+            }
+        }
+
+        return ucxEndpoints[rank];
+
+    }
+
+    /**
+     * @brief
+     * Register the staging buffer of a halo with UCX.
+     *
+     * The registered memory handle lets UCX skip the registration cache for every message. The
+     * staging buffer can change (e.g., with a ring of send buffers or after moving it to another
+     * NUMA node), in which case the old registration is released and the new buffer registered.
+     *
+     * @param isSend
+     * Whether this is a send halo (true) or a recv halo (false).
+     * @param haloId
+     * The halo id returned by the addSendHaloInfo()/addRecvHaloInfo() member function.
+     */
+    inline void registerUcxBuffer(const bool isSend, const size_t haloId) {
+
+        UcxHalo &halo = (isSend ? sendHaloUcx : recvHaloUcx)[haloId];
+        unsigned char *buffer = (isSend ? sendBuffer[haloId] : recvBuffer[haloId]);
+
+        if(halo.buffer == buffer && halo.memh != nullptr)
+            return;
+
+        if(halo.request != nullptr)
+            Status(ucxWorker, &halo.request).wait();
+
+        if(halo.memh != nullptr) {
+            ucp_mem_unmap(ucxContext, halo.memh);
+            halo.memh = nullptr;
+        }
+
+        halo.buffer = buffer;
+
+        const size_t size = (isSend ? sendHaloIndicesSizeTotal[haloId] : recvHaloIndicesSizeTotal[haloId]);
+        if(size == 0)
+            return;
+
+        ucp_mem_map_params_t params;
+        params.field_mask = UCP_MEM_MAP_PARAM_FIELD_ADDRESS | UCP_MEM_MAP_PARAM_FIELD_LENGTH;
+        params.address = buffer;
+        params.length = size;
+        if(ucp_mem_map(ucxContext, &params, &halo.memh) != UCS_OK)
+            halo.memh = nullptr;
+
+    }
+
+    /**
+     * @brief
+     * Post a UCX tagged message for a halo.
+     *
+     * Used internally by send()/recv(). The UCX tag combines the sending rank (upper 32 bits) and
+     * the message tag (lower 32 bits), so messages are matched exactly like MPI messages with the
+     * same source and tag. A previous message of the same halo still in flight is completed first.
+     *
+     * @param isSend
+     * Whether this is a send halo (true) or a recv halo (false).
+     * @param haloId
+     * The halo id returned by the addSendHaloInfo()/addRecvHaloInfo() member function.
+     * @param msgtag
+     * The message tag to be used.
+     * @param remoteRank
+     * The rank in the communicator passed to the constructor to send to/receive from.
+     * @param blocking
+     * Whether to wait for the message to complete.
+     *
+     * @return
+     * Status object referring to the UCX request.
+     */
+    inline Status postUcxMessage(const bool isSend, const size_t haloId, const int msgtag, const int remoteRank, const bool blocking) {
+
+        registerUcxBuffer(isSend, haloId);
+
+        UcxHalo &halo = (isSend ? sendHaloUcx : recvHaloUcx)[haloId];
+
+        if(halo.request != nullptr)
+            Status(ucxWorker, &halo.request).wait();
+
+        int myRank;
+        MPI_Comm_rank(TAUSCH_COMM, &myRank);
+
+        const uint64_t sender = static_cast<uint32_t>(isSend ? myRank : remoteRank);
+        const ucp_tag_t tag = (sender << 32) | static_cast<uint32_t>(msgtag);
+
+        ucp_request_param_t param;
+        param.op_attr_mask = UCP_OP_ATTR_FIELD_DATATYPE;
+        param.datatype = ucp_dt_make_contig(1);
+#if UCP_API_VERSION >= UCP_VERSION(1, 14)
+        if(halo.memh != nullptr) {
+            param.op_attr_mask |= UCP_OP_ATTR_FIELD_MEMH;
+            param.memh = halo.memh;
+        }
+#endif
+
+        ucs_status_ptr_t request;
+        if(isSend)
+            request = ucp_tag_send_nbx(getUcxEndpoint(remoteRank), sendBuffer[haloId], sendHaloIndicesSizeTotal[haloId], tag, &param);
+        else
+            request = ucp_tag_recv_nbx(ucxWorker, recvBuffer[haloId], recvHaloIndicesSizeTotal[haloId], tag, ~ucp_tag_t(0), &param);
+
+        if(UCS_PTR_IS_ERR(request)) {
+            std::cout << "Tausch::postUcxMessage(): Error posting message of halo " << haloId << ": " << ucs_status_string(UCS_PTR_STATUS(request)) << std::endl;
+            request = nullptr;
+        }
+
+        halo.request = request;
+
+        Status status(ucxWorker, &halo.request);
+        if(blocking)
+            status.wait();
+
+        return status;
+
+    }
+
+    /**
+     * @brief
+     * Release all UCX resources.
+     *
+     * Outstanding sends are completed and outstanding receives are cancelled. Used internally by
+     * setupUcx() and the destructor.
+     */
+    inline void releaseUcx() {
+
+        if(ucxWorker != nullptr) {
+
+            for(auto &halo : recvHaloUcx)
+                if(halo.second.request != nullptr)
+                    ucp_request_cancel(ucxWorker, halo.second.request);
+
+            for(auto *halos : {&sendHaloUcx, &recvHaloUcx}) {
+                for(auto &halo : *halos) {
+                    if(halo.second.request != nullptr)
+                        Status(ucxWorker, &halo.second.request).wait();
+                    if(halo.second.memh != nullptr)
+                        ucp_mem_unmap(ucxContext, halo.second.memh);
+                }
+                halos->clear();
+            }
+
+            ucp_request_param_t param;
+            param.op_attr_mask = UCP_OP_ATTR_FIELD_FLAGS;
+            param.flags = UCP_EP_CLOSE_FLAG_FORCE;
+            for(auto &ep : ucxEndpoints) {
+                if(ep == nullptr)
+                    continue;
+                void *request = ucp_ep_close_nbx(ep, &param);
+                if(UCS_PTR_IS_PTR(request))
+                    Status(ucxWorker, &request).wait();
+                ep = nullptr;
+            }
+
+            ucp_worker_destroy(ucxWorker);
+            ucxWorker = nullptr;
+
+        }
+
+        if(ucxContext != nullptr) {
+            ucp_cleanup(ucxContext);
+            ucxContext = nullptr;
+        }
+
+        ucxEndpoints.clear();
+        ucxAddresses.clear();
+
+    }
+
+#endif
+
+    /***********************************************************************/
+    /*                           SEND BUFFER RING                          */
+    /***********************************************************************/
+
+    /**
+     * @brief
+     * Whether a send halo is sent using a ring of staging buffers.
+     *
+     * @param haloId
+     * The halo id returned by the addSendHaloInfo() member function.
+     *
+     * @return
+     * True if a ring has been set up and the current strategy sends from the staging buffer.
+     */
+    inline bool isRingBuffered(const size_t haloId) {
+        return (sendHaloRing.find(haloId) != sendHaloRing.end() &&
+                isAggregatable(sendHaloCommunicationStrategy[haloId]) &&
+                !isStriped(true, haloId));
+    }
+
+    /**
+     * @brief
+     * Posts a message from the current buffer of a ring and moves on to the next one.
+     *
+     * Used internally by send().
+     *
+     * @param haloId
+     * The halo id returned by the addSendHaloInfo() member function.
+     * @param msgtag
+     * The message tag to be used.
+     * @param remoteMpiRank
+     * The receiving MPI rank.
+     * @param blocking
+     * Whether to wait for the message to have been sent.
+     * @param communicator
+     * The communicator to use.
+     *
+     * @return
+     * The Status of the message just posted.
+     */
+    inline Status postRingMessage(const size_t haloId, const int msgtag, const int remoteMpiRank, const bool blocking, MPI_Comm communicator) {
+
+        SendRing &ring = sendHaloRing.at(haloId);
+        const size_t slot = ring.current;
+
+        if((sendHaloCommunicationStrategy[haloId]&Communication::MPIPersistent) == Communication::MPIPersistent) {
+
+            if(!ring.setup[slot]) {
+                MPI_Send_init(ring.buffers[slot], sendHaloIndicesSizeTotal[haloId], MPI_CHAR,
+                              remoteMpiRank, msgtag, communicator,
+                              &ring.requests[slot]);
+                ring.setup[slot] = true;
+            }
+
+            MPI_Start(&ring.requests[slot]);
+
+        } else
+
+            MPI_Isend(ring.buffers[slot], sendHaloIndicesSizeTotal[haloId], MPI_CHAR,
+                      remoteMpiRank, msgtag, communicator,
+                      &ring.requests[slot]);
+
+        if(blocking)
+            MPI_Wait(&ring.requests[slot], MPI_STATUS_IGNORE);
+
+        // the next buffer is packed next, its previous send needs to have completed
+        ring.current = (slot+1)%ring.buffers.size();
+        MPI_Wait(&ring.requests[ring.current], MPI_STATUS_IGNORE);
+        sendBuffer[haloId] = ring.buffers[ring.current];
+
+        return Status(&ring.requests[slot]);
+
+    }
+
+    /***********************************************************************/
+    /*                      AUTO-REARMING RECEIVES                         */
+    /***********************************************************************/
+
+    /**
+     * @brief
+     * Marks a buffer as unpacked and restarts the persistent receive once all are.
+     *
+     * Used internally by unpackRecvBuffer() and unpackRecvBuffers().
+     *
+     * @param haloId
+     * The halo id returned by the addRecvHaloInfo() member function.
+     * @param bufferId
+     * The id of the buffer that has been unpacked.
+     */
+    inline void rearmAfterUnpack(const size_t haloId, const size_t bufferId) {
+
+        auto it = recvHaloRearm.find(haloId);
+        if(it == recvHaloRearm.end() || !it->second.enabled || it->second.armed || !recvHaloMpiSetup[haloId][0])
+            return;
+
+        // in adaptive mode the next recv times the previous message through its request, it must not be restarted before
+        const Communication strategy = recvHaloCommunicationStrategy[haloId];
+        if((strategy&Communication::MPIPersistent) != Communication::MPIPersistent || !isAggregatable(strategy) || isStriped(false, haloId) ||
+           isAdaptive(false, haloId))
+            return;
+
+        RecvRearm &rearm = it->second;
+        rearm.unpacked[bufferId] = true;
+        if(std::find(rearm.unpacked.begin(), rearm.unpacked.end(), false) != rearm.unpacked.end())
+            return;
+
+        std::fill(rearm.unpacked.begin(), rearm.unpacked.end(), false);
+
+        // the previous message needs to have completed before the request can be started again
+        MPI_Wait(&recvHaloMpiRequests[haloId][0], MPI_STATUS_IGNORE);
+        MPI_Start(&recvHaloMpiRequests[haloId][0]);
+        rearm.armed = true;
+
+    }
+
+    /**
+     * @brief
+     * Whether the persistent receive of a halo has been restarted by rearmAfterUnpack().
+     *
+     * Used internally by recv(), the flag is reset.
+     *
+     * @param haloId
+     * The halo id returned by the addRecvHaloInfo() member function.
+     *
+     * @return
+     * Whether the receive has already been started.
+     */
+    inline bool consumeRearmed(const size_t haloId) {
+
+        auto it = recvHaloRearm.find(haloId);
+        if(it == recvHaloRearm.end() || !it->second.armed)
+            return false;
+
+        it->second.armed = false;
+        return true;
+
+    }
+
+    /**
+     * @brief
+     * Cancels a receive restarted by rearmAfterUnpack() that has not been consumed by recv().
+     *
+     * @param haloId
+     * The halo id returned by the addRecvHaloInfo() member function.
+     */
+    inline void cancelRearmed(const size_t haloId) {
+
+        if(!consumeRearmed(haloId))
+            return;
+
+        MPI_Cancel(&recvHaloMpiRequests[haloId][0]);
+        MPI_Wait(&recvHaloMpiRequests[haloId][0], MPI_STATUS_IGNORE);
+
+    }
+
+    /***********************************************************************/
+    /*                        UNPACK MULTIPLE BUFFERS                      */
+    /***********************************************************************/
+
+    /**
+     * @brief
+     * Unpacks the buffers with ids [first, last) of a recv halo.
+     *
+     * Used internally by unpackRecvBuffers(). The caller is responsible for having checked that
+     * the data has arrived.
+     */
+    inline void unpackRecvBufferFields(const size_t haloId, const std::vector<unsigned char*> &bufs, const size_t first, const size_t last) {
+
+        const size_t fieldSize = recvHaloIndicesSizePerBuffer[haloId][0];
+
+        if(!recvHaloUniformLayout[haloId]) {
+            size_t bufferOffset = 0;
+            for(size_t i = 0; i < first; ++i)
+                bufferOffset += recvHaloIndicesSizePerBuffer[haloId][i];
+            for(size_t bufferId = first; bufferId < last; ++bufferId) {
+                const auto &elementOffsets = recvHaloElementOffsets[haloId][bufferId];
+                if(elementOffsets.size() > 0)
+                    scatterElements(bufs[bufferId], &recvBuffer[haloId][bufferOffset], elementOffsets.data(), elementOffsets.size(), recvHaloTypeSizePerBuffer[haloId][bufferId]);
+                else
+                    unpackRecvBufferRange(haloId, bufferId, bufs[bufferId], bufferOffset, bufferOffset+recvHaloIndicesSizePerBuffer[haloId][bufferId]);
+                bufferOffset += recvHaloIndicesSizePerBuffer[haloId][bufferId];
+            }
+            return;
+        }
+
+        const unsigned char *src = &recvBuffer[haloId][first*fieldSize];
+        unsigned char * const *dsts = &bufs[first];
+        const size_t numFields = last-first;
+
+        const auto &elementOffsets = recvHaloElementOffsets[haloId][0];
+
+        if(elementOffsets.size() > 0) {
+
+            scatterElementsMultiField(dsts, numFields, src, fieldSize, elementOffsets.data(), elementOffsets.size(), recvHaloTypeSizePerBuffer[haloId][0]);
+
+        } else {
+
+            size_t mpiRecvBufferIndex = 0;
+            const bool prefetch = (size_t(recvHaloIndicesSizeTotal[haloId]) >= unpackPrefetchThreshold);
+
+            for(auto const & region : haloRegions(false, haloId, 0)) {
+
+                const size_t &region_start = region[0];
+                const size_t &region_howmanycols = region[1];
+                const size_t &region_howmanyrows = region[2];
+                const size_t &region_stridecol = region[3];
+
+                for(size_t rows = 0; rows < region_howmanyrows; ++rows) {
+
+                    if(prefetch && rows+prefetchDistance < region_howmanyrows)
+                        for(size_t f = 0; f < numFields; ++f)
+                            prefetchRow(&dsts[f][region_start + (rows+prefetchDistance)*region_stridecol], region_howmanycols);
+                    for(size_t f = 0; f < numFields; ++f)
+                        std::memcpy(&dsts[f][region_start + rows*region_stridecol], &src[f*fieldSize + mpiRecvBufferIndex], region_howmanycols);
+                    mpiRecvBufferIndex += region_howmanycols;
+
+                }
+
+            }
+
+        }
+
+    }
+
+    /***********************************************************************/
+    /*                        UNPACK BUFFER (HIP)                         */
+    /***********************************************************************/
+
+    /**
+     * @brief
+     * Builds the flat list of element offsets of a fragmented halo buffer.
+     *
+     * Halo buffers whose contiguous runs are on average no longer than two elements (e.g.,
+     * unstructured halos) are packed and unpacked element by element using a flat list of 32-bit
+     * element offsets rather than one memcpy per region row. This requires all regions to be
+     * aligned to the element size.
+     *
+     * @param regions
+     * The regions of a single buffer (in bytes).
+     * @param typeSize
+     * The size of the underlying data type in bytes.
+     *
+     * @return
+     * The element offsets in packing order, or an empty list if the buffer is better handled region
+     * by region.
+     */
+    static inline std::vector<uint32_t> buildElementOffsets(const std::vector<std::array<int, 4> > &regions, const size_t typeSize) {
+
+        size_t numElements = 0;
+        size_t numRows = 0;
+        for(auto const & region : regions) {
+            if(region[0]%typeSize != 0 || region[1]%typeSize != 0 || region[3]%typeSize != 0)
+                return std::vector<uint32_t>();
+            numElements += region[1]/typeSize*region[2];
+            numRows += region[2];
+        }
+
+        if(numElements < 16 || 2*numRows < numElements)
+            return std::vector<uint32_t>();
+
+        std::vector<uint32_t> offsets;
+        offsets.reserve(numElements);
+
+        for(auto const & region : regions) {
+            for(int rows = 0; rows < region[2]; ++rows) {
+                const size_t rowStart = (static_cast<size_t>(region[0]) + rows*static_cast<size_t>(region[3]))/typeSize;
+                for(size_t col = 0; col < region[1]/typeSize; ++col) {
+                    // the AVX2 gather uses signed 32-bit indices
+                    if(rowStart+col > 0x7fffffff)
+                        return std::vector<uint32_t>();
+                    offsets.push_back(rowStart+col);
+                }
+            }
+        }
+
+        return offsets;
+
+    }
+
+    /**
+     * @brief
+     * Rebuilds the regions of a fragmented halo buffer from its element offsets.
+     *
+     * Consecutive elements are combined into a row, rows of equal length and constant stride into
+     * a region. The regions describe the same elements in the same packing order as the offsets.
+     *
+     * @param offsets
+     * The element offsets returned by buildElementOffsets().
+     * @param typeSize
+     * The size of the underlying data type in bytes.
+     *
+     * @return
+     * The regions (in bytes).
+     */
+    static inline std::vector<std::array<int, 4> > buildRegions(const std::vector<uint32_t> &offsets, const size_t typeSize) {
+
+        std::vector<std::array<int, 4> > regions;
+
+        size_t i = 0;
+        while(i < offsets.size()) {
+
+            size_t len = 1;
+            while(i+len < offsets.size() && offsets[i+len] == offsets[i]+len)
+                ++len;
+
+            const int start = offsets[i]*typeSize;
+            const int cols = len*typeSize;
+
+            // append the row to the previous region if it continues its stride
+            if(regions.size() > 0 && regions.back()[1] == cols) {
+                auto &prev = regions.back();
+                const int stride = start - (prev[0] + (prev[2]-1)*prev[3]);
+                if(stride > 0 && (prev[2] == 1 || stride == prev[3])) {
+                    prev[3] = stride;
+                    ++prev[2];
+                    i += len;
+                    continue;
+                }
+            }
+
+            regions.push_back({start, cols, 1, cols});
+            i += len;
+
+        }
+
+        return regions;
+
+    }
+
+    /**
+     * @brief
+     * Returns the regions of a halo buffer.
+     *
+     * Fragmented buffers that are packed through element offsets do not keep their regions, they
+     * are rebuilt from the offsets the first time they are needed (e.g., for derived MPI datatypes
+     * or GPU buffers).
+     *
+     * @param isSend
+     * Whether this is a send halo (true) or a recv halo (false).
+     * @param haloId
+     * The halo id returned by the addSendHaloInfo()/addRecvHaloInfo() member function.
+     * @param bufferId
+     * The id of the buffer.
+     *
+     * @return
+     * The regions (in bytes).
+     */
+    inline const std::vector<std::array<int, 4> > &haloRegions(const bool isSend, const size_t haloId, const size_t bufferId) {
+
+        auto &regions = (isSend ? sendHaloIndices[haloId][bufferId] : recvHaloIndices[haloId][bufferId]);
+        const auto &offsets = (isSend ? sendHaloElementOffsets[haloId][bufferId] : recvHaloElementOffsets[haloId][bufferId]);
+
+        if(regions.size() == 0 && offsets.size() > 0)
+            regions = buildRegions(offsets, (isSend ? sendHaloTypeSizePerBuffer[haloId][bufferId] : recvHaloTypeSizePerBuffer[haloId][bufferId]));
+
+        return regions;
+
+    }
+
+    /**
+     * @brief
+     * Gathers elements at the given offsets into a contiguous buffer.
+     *
+     * Uses a four-way unrolled scalar loop. AVX2 gather instructions for 4 and 8 byte elements can
+     * be used instead by defining TAUSCH_AVX2_GATHER (and compiling with AVX2 enabled), whether they
+     * are faster depends on the CPU.
+     *
+     * @param dst
+     * The contiguous destination buffer.
+     * @param src
+     * The data buffer.
+     * @param offsets
+     * The element offsets.
+     * @param count
+     * The number of elements.
+     * @param typeSize
+     * The size of the elements in bytes.
+     */
+    static inline void gatherElements(unsigned char *dst, const unsigned char *src, const uint32_t *offsets, const size_t count, const size_t typeSize) {
+
+        size_t i = 0;
+
+        if(typeSize == 8) {
+#if defined(TAUSCH_AVX2_GATHER) && defined(__AVX2__)
+            for(; i+4 <= count; i += 4) {
+                const __m128i idx = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&offsets[i]));
+                const __m256i val = _mm256_i32gather_epi64(reinterpret_cast<const long long*>(src), idx, 8);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(&dst[i*8]), val);
+            }
+#endif
+            for(; i+4 <= count; i += 4) {
+                std::memcpy(&dst[i*8], &src[offsets[i]*size_t(8)], 8);
+                std::memcpy(&dst[(i+1)*8], &src[offsets[i+1]*size_t(8)], 8);
+                std::memcpy(&dst[(i+2)*8], &src[offsets[i+2]*size_t(8)], 8);
+                std::memcpy(&dst[(i+3)*8], &src[offsets[i+3]*size_t(8)], 8);
+            }
+            for(; i < count; ++i)
+                std::memcpy(&dst[i*8], &src[offsets[i]*size_t(8)], 8);
+        } else if(typeSize == 4) {
+#if defined(TAUSCH_AVX2_GATHER) && defined(__AVX2__)
+            for(; i+8 <= count; i += 8) {
+                const __m256i idx = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&offsets[i]));
+                const __m256i val = _mm256_i32gather_epi32(reinterpret_cast<const int*>(src), idx, 4);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(&dst[i*4]), val);
+            }
+#endif
+            for(; i+4 <= count; i += 4) {
+                std::memcpy(&dst[i*4], &src[offsets[i]*size_t(4)], 4);
+                std::memcpy(&dst[(i+1)*4], &src[offsets[i+1]*size_t(4)], 4);
+                std::memcpy(&dst[(i+2)*4], &src[offsets[i+2]*size_t(4)], 4);
+                std::memcpy(&dst[(i+3)*4], &src[offsets[i+3]*size_t(4)], 4);
+            }
+            for(; i < count; ++i)
+                std::memcpy(&dst[i*4], &src[offsets[i]*size_t(4)], 4);
+        } else {
+            for(; i < count; ++i)
+                std::memcpy(&dst[i*typeSize], &src[offsets[i]*typeSize], typeSize);
+        }
+
+    }
+
+    /**
+     * @brief
+     * Scatters elements from a contiguous buffer to the given offsets.
+     *
+     * There is no AVX2 scatter instruction, thus this uses a four-way unrolled scalar loop.
+     *
+     * @param dst
+     * The data buffer.
+     * @param src
+     * The contiguous source buffer.
+     * @param offsets
+     * The element offsets.
+     * @param count
+     * The number of elements.
+     * @param typeSize
+     * The size of the elements in bytes.
+     */
+    static inline void scatterElements(unsigned char *dst, const unsigned char *src, const uint32_t *offsets, const size_t count, const size_t typeSize) {
+
+        size_t i = 0;
+
+        if(typeSize == 8) {
+            for(; i+4 <= count; i += 4) {
+                std::memcpy(&dst[offsets[i]*size_t(8)], &src[i*8], 8);
+                std::memcpy(&dst[offsets[i+1]*size_t(8)], &src[(i+1)*8], 8);
+                std::memcpy(&dst[offsets[i+2]*size_t(8)], &src[(i+2)*8], 8);
+                std::memcpy(&dst[offsets[i+3]*size_t(8)], &src[(i+3)*8], 8);
+            }
+            for(; i < count; ++i)
+                std::memcpy(&dst[offsets[i]*size_t(8)], &src[i*8], 8);
+        } else if(typeSize == 4) {
+            for(; i+4 <= count; i += 4) {
+                std::memcpy(&dst[offsets[i]*size_t(4)], &src[i*4], 4);
+                std::memcpy(&dst[offsets[i+1]*size_t(4)], &src[(i+1)*4], 4);
+                std::memcpy(&dst[offsets[i+2]*size_t(4)], &src[(i+2)*4], 4);
+                std::memcpy(&dst[offsets[i+3]*size_t(4)], &src[(i+3)*4], 4);
+            }
+            for(; i < count; ++i)
+                std::memcpy(&dst[offsets[i]*size_t(4)], &src[i*4], 4);
+        } else {
+            for(; i < count; ++i)
+                std::memcpy(&dst[offsets[i]*typeSize], &src[i*typeSize], typeSize);
+        }
+
+    }
+
+    /**
+     * @brief
+     * Gathers elements of several data buffers sharing the same offsets.
+     *
+     * The elements of field f are stored contiguously starting at dst + f*fieldStride, i.e., the
+     * result is the same as calling gatherElements() once per field but the offsets are only read
+     * once.
+     *
+     * @param dst
+     * The contiguous destination buffer.
+     * @param fieldStride
+     * The distance in bytes between the data of two fields in dst.
+     * @param srcs
+     * The data buffers, one per field.
+     * @param numFields
+     * The number of fields.
+     * @param offsets
+     * The element offsets.
+     * @param count
+     * The number of elements.
+     * @param typeSize
+     * The size of the elements in bytes.
+     */
+    static inline void gatherElementsMultiField(unsigned char *dst, const size_t fieldStride, const unsigned char * const *srcs, const size_t numFields,
+                                                const uint32_t *offsets, const size_t count, const size_t typeSize) {
+
+        if(typeSize == 8) {
+            for(size_t i = 0; i < count; ++i) {
+                const size_t off = offsets[i]*size_t(8);
+                for(size_t f = 0; f < numFields; ++f)
+                    std::memcpy(&dst[f*fieldStride + i*8], &srcs[f][off], 8);
+            }
+        } else if(typeSize == 4) {
+            for(size_t i = 0; i < count; ++i) {
+                const size_t off = offsets[i]*size_t(4);
+                for(size_t f = 0; f < numFields; ++f)
+                    std::memcpy(&dst[f*fieldStride + i*4], &srcs[f][off], 4);
+            }
+        } else {
+            for(size_t i = 0; i < count; ++i) {
+                const size_t off = offsets[i]*typeSize;
+                for(size_t f = 0; f < numFields; ++f)
+                    std::memcpy(&dst[f*fieldStride + i*typeSize], &srcs[f][off], typeSize);
+            }
+        }
+
+    }
+
+    /**
+     * @brief
+     * Scatters elements to several data buffers sharing the same offsets.
+     *
+     * The counterpart to gatherElementsMultiField().
+     *
+     * @param dsts
+     * The data buffers, one per field.
+     * @param numFields
+     * The number of fields.
+     * @param src
+     * The contiguous source buffer.
+     * @param fieldStride
+     * The distance in bytes between the data of two fields in src.
+     * @param offsets
+     * The element offsets.
+     * @param count
+     * The number of elements.
+     * @param typeSize
+     * The size of the elements in bytes.
+     */
+    static inline void scatterElementsMultiField(unsigned char * const *dsts, const size_t numFields, const unsigned char *src, const size_t fieldStride,
+                                                 const uint32_t *offsets, const size_t count, const size_t typeSize) {
+
+        if(typeSize == 8) {
+            for(size_t i = 0; i < count; ++i) {
+                const size_t off = offsets[i]*size_t(8);
+                for(size_t f = 0; f < numFields; ++f)
+                    std::memcpy(&dsts[f][off], &src[f*fieldStride + i*8], 8);
+            }
+        } else if(typeSize == 4) {
+            for(size_t i = 0; i < count; ++i) {
+                const size_t off = offsets[i]*size_t(4);
+                for(size_t f = 0; f < numFields; ++f)
+                    std::memcpy(&dsts[f][off], &src[f*fieldStride + i*4], 4);
+            }
+        } else {
+            for(size_t i = 0; i < count; ++i) {
+                const size_t off = offsets[i]*typeSize;
+                for(size_t f = 0; f < numFields; ++f)
+                    std::memcpy(&dsts[f][off], &src[f*fieldStride + i*typeSize], typeSize);
+            }
+        }
+
+    }
+
+    /**
+     * @brief
+     * Checks whether all buffers of a halo use the same indices and type size.
+     *
+     * @param indices
+     * The halo indices (in bytes) per buffer.
+     * @param typeSizePerBuffer
+     * The type size per buffer.
+     *
+     * @return
+     * Whether the buffers share the same layout.
+     */
+    static inline bool hasUniformLayout(const std::vector<std::vector<std::array<int, 4> > > &indices, const std::vector<size_t> &typeSizePerBuffer) {
+
+        for(size_t bufferId = 1; bufferId < indices.size(); ++bufferId)
+            if(indices[bufferId] != indices[0] || typeSizePerBuffer[bufferId] != typeSizePerBuffer[0])
+                return false;
+
+        return true;
+
+    }
+
+    /**
+     * @brief
+     * Calls a function for groups of fields, concurrently for large halos.
+     *
+     * Used internally by packSendBuffers() and unpackRecvBuffers(). The first group is handled by
+     * the calling thread.
+     *
+     * @param numFields
+     * The number of fields.
+     * @param totalSize
+     * The total size of the halo in bytes.
+     * @param pinNode
+     * The NUMA node the spawned threads are pinned to, -1 for no pinning.
+     * @param func
+     * The function called with the range [first, last) of field ids of a group.
+     */
+    inline void forEachFieldGroup(const size_t numFields, const size_t totalSize, const int pinNode, const std::function<void(size_t, size_t)> &func) {
+
+        size_t numGroups = 1;
+        if(numFields > 1 && totalSize >= multiFieldParallelThreshold) {
+            const size_t maxThreads = (multiFieldMaxThreads > 0 ? multiFieldMaxThreads : std::max(1u, std::thread::hardware_concurrency()));
+            numGroups = std::min(numFields, maxThreads);
+        }
+
+        if(numGroups == 1) {
+            func(0, numFields);
+            return;
+        }
+
+        std::vector<std::future<void> > groups;
+        for(size_t g = 1; g < numGroups; ++g)
+            groups.push_back(std::async(std::launch::async, [=, &func]() {
+                if(pinNode >= 0)
+                    pinThreadToNumaNode(pinNode);
+                func((g*numFields)/numGroups, ((g+1)*numFields)/numGroups);
+            }));
+        func(0, numFields/numGroups);
+        for(auto &g : groups)
+            g.get();
+
+    }
+
+    /**
+     * @brief
+     * Copies a row into a staging buffer, optionally using non-temporal stores.
+     *
+     * Non-temporal (streaming) stores bypass the cache, the staging buffer is only read by the
+     * network afterwards and would otherwise evict the working set of the caller. They are only
+     * available with SSE2 and only used for rows of at least one cache line, a streamFence() is
+     * needed once all rows have been copied.
+     *
+     * @param dst
+     * The destination in the staging buffer.
+     * @param src
+     * The source.
+     * @param n
+     * The number of bytes.
+     * @param streaming
+     * Whether to use non-temporal stores.
+     */
+    static inline void copyRow(unsigned char *dst, const unsigned char *src, const size_t n, const bool streaming) {
+
+#ifdef __SSE2__
+        if(streaming && n >= 64) {
+
+            // streaming stores need 16 byte aligned destinations
+            size_t head = (16 - reinterpret_cast<uintptr_t>(dst)%16)%16;
+            std::memcpy(dst, src, head);
+
+            size_t i = head;
+            for(; i+64 <= n; i += 64) {
+                const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&src[i]));
+                const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&src[i+16]));
+                const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&src[i+32]));
+                const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&src[i+48]));
+                _mm_stream_si128(reinterpret_cast<__m128i*>(&dst[i]), a);
+                _mm_stream_si128(reinterpret_cast<__m128i*>(&dst[i+16]), b);
+                _mm_stream_si128(reinterpret_cast<__m128i*>(&dst[i+32]), c);
+                _mm_stream_si128(reinterpret_cast<__m128i*>(&dst[i+48]), d);
+            }
+            std::memcpy(&dst[i], &src[i], n-i);
+
+            return;
+
+        }
+#else
+        (void)streaming;
+#endif
+
+        std::memcpy(dst, src, n);
+
+    }
+
+    /**
+     * @brief
+     * Returns the default halo size above which packing uses non-temporal stores.
+     *
+     * This is twice the size of the last-level cache as reported by the system, or 64 MiB if it
+     * cannot be determined.
+     */
+    static inline size_t defaultNonTemporalPackThreshold() {
+#if defined(__linux__) && defined(_SC_LEVEL3_CACHE_SIZE)
+        long cacheSize = sysconf(_SC_LEVEL3_CACHE_SIZE);
+        if(cacheSize <= 0)
+            cacheSize = sysconf(_SC_LEVEL2_CACHE_SIZE);
+        if(cacheSize > 0)
+            return 2*static_cast<size_t>(cacheSize);
+#endif
+        return size_t(64)<<20;
+    }
+
+    /**
+     * @brief
+     * Orders preceding non-temporal stores done by copyRow() before any later stores.
+     */
+    static inline void streamFence() {
+#ifdef __SSE2__
+        _mm_sfence();
+#endif
+    }
+
+    /**
+     * @brief
+     * Issues software prefetches for a row about to be written.
+     *
+     * At most the first eight cache lines of the row are prefetched.
+     *
+     * @param ptr
+     * The beginning of the row.
+     * @param n
+     * The number of bytes in the row.
+     */
+    static inline void prefetchRow(const unsigned char *ptr, const size_t n) {
+#if defined(__GNUC__) || defined(__clang__)
+        for(size_t i = 0; i < n && i < 512; i += 64)
+            __builtin_prefetch(&ptr[i], 1);
+#else
+        (void)ptr;
+        (void)n;
+#endif
+    }
+
+    /***********************************************************************/
+    /*                       DERIVED DATATYPE CACHE                        */
+    /***********************************************************************/
+
+    /**
+     * @brief
+     * Get a committed derived datatype describing the given halo regions.
+     *
+     * The datatype is built from MPI_CHAR, the type used for the packed staging buffers, thus a halo
+     * sent with a derived datatype matches a receive of the packed buffer and vice versa. Datatypes
+     * are cached by their region list and are shared between all halos with an identical layout,
+     * every call has to be matched by a call to releaseDerivedDatatype().
+     *
+     * Fragmented halos consisting only of single-row regions (e.g., random access halos with one
+     * region per element) are described by a single MPI_Type_create_hindexed_block (or
+     * MPI_Type_create_hindexed if the block lengths differ) after merging adjacent blocks, instead
+     * of a struct of one vector per region.
+     *
+     * @param regions
+     * The regions of a single buffer (in bytes).
+     *
+     * @return
+     * The committed datatype.
+     */
+    inline MPI_Datatype getDerivedDatatype(const std::vector<std::array<int, 4> > &regions) {
+
+        auto it = derivedDatatypeCache.find(regions);
+        if(it != derivedDatatypeCache.end()) {
+            ++it->second.second;
+            return it->second.first;
+        }
+
+        MPI_Datatype newtype;
+
+        // fragmented halos: one block per region
+        bool fragmented = (regions.size() > 1);
+        for(auto const & item : regions)
+            if(item[2] > 1)
+                fragmented = false;
+
+        if(fragmented) {
+
+            std::vector<MPI_Aint> displacement;
+            std::vector<int> blocklength;
+
+            for(auto const & item : regions) {
+                if(item[1] == 0 || item[2] == 0)
+                    continue;
+                // merge with the previous block if adjacent
+                if(displacement.size() > 0 && displacement.back() + blocklength.back() == item[0])
+                    blocklength.back() += item[1];
+                else {
+                    displacement.push_back(item[0]);
+                    blocklength.push_back(item[1]);
+                }
+            }
+
+            bool sameLength = true;
+            for(auto const & len : blocklength)
+                if(len != blocklength[0])
+                    sameLength = false;
+
+            if(sameLength && blocklength.size() > 0)
+                MPI_Type_create_hindexed_block(displacement.size(), blocklength[0], displacement.data(), MPI_CHAR, &newtype);
+            else
+                MPI_Type_create_hindexed(displacement.size(), blocklength.data(), displacement.data(), MPI_CHAR, &newtype);
+            MPI_Type_commit(&newtype);
+
+            derivedDatatypeCache[regions] = std::make_pair(newtype, 1);
+
+            return newtype;
+
+        }
+
+        std::vector<MPI_Datatype> vectorDataTypes;
+        std::vector<MPI_Aint> displacement;
+        std::vector<int> blocklength;
+
+        vectorDataTypes.reserve(regions.size());
+        displacement.reserve(regions.size());
+        blocklength.reserve(regions.size());
+
+        for(auto const & item : regions) {
+
+            MPI_Datatype vec;
+            MPI_Type_create_hvector(item[2], item[1], item[3], MPI_CHAR, &vec);
+
+            vectorDataTypes.push_back(vec);
+            displacement.push_back(item[0]);
+            blocklength.push_back(1);
+
+        }
+
+        MPI_Type_create_struct(regions.size(), blocklength.data(), displacement.data(), vectorDataTypes.data(), &newtype);
+        MPI_Type_commit(&newtype);
+
+        // the struct holds on to its building blocks
+        for(auto &vec : vectorDataTypes)
+            MPI_Type_free(&vec);
+
+        derivedDatatypeCache[regions] = std::make_pair(newtype, 1);
+
+        return newtype;
+
+    }
+
+    /**
+     * @brief
+     * Release a derived datatype obtained from getDerivedDatatype().
+     *
+     * The datatype is freed once it is not used by any halo anymore.
+     *
+     * @param type
+     * The datatype to release.
+     */
+    inline void releaseDerivedDatatype(MPI_Datatype type) {
+
+        for(auto it = derivedDatatypeCache.begin(); it != derivedDatatypeCache.end(); ++it) {
+            if(it->second.first == type) {
+                if(--it->second.second == 0) {
+                    MPI_Type_free(&it->second.first);
+                    derivedDatatypeCache.erase(it);
+                }
+                return;
+            }
+        }
+
+    }
+
+    /***********************************************************************/
+    /*                             PACK BUFFER                             */
+    /***********************************************************************/
+
+    /**
+     * @brief
+     * Packs a data buffer into the staging buffer of a send halo.
+     *
+     * Used internally by packSendBuffer(). With MPIPartitioned every partition is marked as packed
+     * as soon as it has been filled, i.e., partitions can be sent off while the rest of the buffer
+     * is still being packed.
+     *
+     * @param haloId
+     * The halo id returned by the addSendHaloInfo() member function.
+     * @param bufferId
+     * The id of the current buffer (numbered starting at 0).
+     * @param buf
+     * Pointer to the data buffer.
+     */
+    inline void packBuffer(const size_t haloId, const size_t bufferId, const unsigned char *buf) {
+
+        size_t bufferOffset = 0;
+        for(size_t i = 0; i < bufferId; ++i)
+            bufferOffset += sendHaloIndicesSizePerBuffer[haloId][i];
+
+        const bool partitioned = ((sendHaloCommunicationStrategy[haloId]&Communication::MPIPartitioned) == Communication::MPIPartitioned);
+
+        // the number of bytes of this buffer that complete the next partition
+        size_t partitionSize = 0;
+        size_t nextBoundary = 0;
+        if(partitioned) {
+            std::lock_guard<std::mutex> lock(partitionedMutex);
+            partitionSize = sendHaloPartitioned.at(haloId).partitionSize;
+            nextBoundary = (bufferOffset/partitionSize + 1)*partitionSize - bufferOffset;
+        }
+
+        const auto &elementOffsets = sendHaloElementOffsets[haloId][bufferId];
+
+        size_t mpiSendBufferIndex = 0;
+        if(elementOffsets.size() > 0) {
+
+            const size_t typeSize = sendHaloTypeSizePerBuffer[haloId][bufferId];
+
+            // gather the elements in chunks ending at partition boundaries
+            size_t done = 0;
+            while(done < elementOffsets.size()) {
+
+                size_t count = elementOffsets.size()-done;
+                if(partitioned)
+                    count = std::min(count, (nextBoundary - done*typeSize + typeSize-1)/typeSize);
+
+                gatherElements(&sendBuffer[haloId][bufferOffset + done*typeSize], buf, &elementOffsets[done], count, typeSize);
+                done += count;
+
+                if(partitioned && done*typeSize >= nextBoundary && done < elementOffsets.size()) {
+                    markPartitionPacked(haloId, bufferId, done*typeSize);
+                    while(nextBoundary <= done*typeSize)
+                        nextBoundary += partitionSize;
+                }
+
+            }
+
+        } else {
+
+            const bool streaming = (size_t(sendHaloIndicesSizeTotal[haloId]) >= nonTemporalPackThreshold);
+
+            for(auto const & region : haloRegions(true, haloId, bufferId)) {
+
+                const size_t &region_start = region[0];
+                const size_t &region_howmanycols = region[1];
+                const size_t &region_howmanyrows = region[2];
+                const size_t &region_stridecol = region[3];
+
+                for(size_t rows = 0; rows < region_howmanyrows; ++rows) {
+
+                    copyRow(&sendBuffer[haloId][bufferOffset + mpiSendBufferIndex], &buf[region_start + rows*region_stridecol], region_howmanycols, streaming);
+                    mpiSendBufferIndex += region_howmanycols;
+
+                    if(partitioned && mpiSendBufferIndex >= nextBoundary && mpiSendBufferIndex < size_t(sendHaloIndicesSizePerBuffer[haloId][bufferId])) {
+                        if(streaming)
+                            streamFence();
+                        markPartitionPacked(haloId, bufferId, mpiSendBufferIndex);
+                        while(nextBoundary <= mpiSendBufferIndex)
+                            nextBoundary += partitionSize;
+                    }
+
+                }
+
+            }
+
+            if(streaming)
+                streamFence();
+
+        }
+
+        if(partitioned)
+            markPartitionPacked(haloId, bufferId, sendHaloIndicesSizePerBuffer[haloId][bufferId]);
+
+    }
+
+    /***********************************************************************/
+    /*                         AGGREGATED MESSAGES                         */
+    /***********************************************************************/
+
+    /**
+     * @brief
+     * Whether a halo with the given strategy can be part of an aggregated message.
+     *
+     * @param strategy
+     * The communication strategy of the halo.
+     *
+     * @return
+     * True if the halo uses a packed buffer in host memory.
+     */
+    inline bool isAggregatable(Communication strategy) {
+        return ((strategy&Communication::DerivedMpiDatatype) != Communication::DerivedMpiDatatype &&
+                (strategy&Communication::DerivedMpiDatatypeSingleMessage) != Communication::DerivedMpiDatatypeSingleMessage &&
+                (strategy&Communication::CUDAAwareMPI) != Communication::CUDAAwareMPI &&
+                (strategy&Communication::MPIPartitioned) != Communication::MPIPartitioned);
+    }
+
+    /***********************************************************************/
+    /*                              STRIPING                               */
+    /***********************************************************************/
+
+    /**
+     * @brief
+     * Enable striping of a halo.
+     *
+     * See setSendStriping() and setRecvStriping().
+     *
+     * @param isSend
+     * Whether this is a send halo (true) or a recv halo (false).
+     * @param haloId
+     * The halo id returned by the addSendHaloInfo()/addRecvHaloInfo() member function.
+     * @param numChunks
+     * The number of chunks, a value of 1 or less disables striping.
+     * @param minSize
+     * Only halos of at least this size (in bytes) are striped.
+     */
+    inline void setStriping(const bool isSend, const size_t haloId, const int numChunks, const size_t minSize) {
+
+        auto &stripingPerHalo = (isSend ? sendHaloStriping : recvHaloStriping);
+
+        auto it = stripingPerHalo.find(haloId);
+        if(it != stripingPerHalo.end()) {
+            MPI_Waitall(it->second.requests.size(), it->second.requests.data(), MPI_STATUSES_IGNORE);
+            stripingPerHalo.erase(it);
+        }
+
+        if(numChunks <= 1)
+            return;
+
+        Striping striping;
+        striping.minSize = minSize;
+        striping.requests.resize(numChunks, MPI_REQUEST_NULL);
+        stripingPerHalo[haloId] = striping;
+
+    }
+
+    /**
+     * @brief
+     * Post the chunks of a striped halo.
+     *
+     * Used internally by send() and recv().
+     *
+     * @param isSend
+     * Whether this is a send halo (true) or a recv halo (false).
+     * @param haloId
+     * The halo id returned by the addSendHaloInfo()/addRecvHaloInfo() member function.
+     * @param msgtag
+     * The message tag to be used by this communication.
+     * @param remoteMpiRank
+     * The remote MPI rank.
+     * @param blocking
+     * Whether to wait for all chunks to complete.
+     * @param communicator
+     * The communicator to use, the communicator pool is only used in place of the global communicator.
+     *
+     * @return
+     * Returns the Status object connected to all chunks.
+     */
+    inline Status postStripedMessage(const bool isSend, const size_t haloId, const int msgtag, const int remoteMpiRank, const bool blocking, MPI_Comm communicator) {
+
+        Striping &striping = (isSend ? sendHaloStriping : recvHaloStriping).at(haloId);
+        const int numChunks = striping.requests.size();
+
+        // the previous message needs to be done before the buffer is reused
+        MPI_Waitall(numChunks, striping.requests.data(), MPI_STATUSES_IGNORE);
+
+        const size_t size = (isSend ? sendHaloIndicesSizeTotal[haloId] : recvHaloIndicesSizeTotal[haloId]);
+        unsigned char *buf = (isSend ? sendBuffer[haloId] : recvBuffer[haloId]);
+
+        for(int c = 0; c < numChunks; ++c) {
+
+            const size_t chunkBegin = size*c/numChunks;
+            const size_t chunkEnd = size*(c+1)/numChunks;
+
+            MPI_Comm comm = communicator;
+            if(communicator == TAUSCH_COMM && communicatorPool.size() > 0)
+                comm = communicatorPool[c%communicatorPool.size()];
+
+            if(isSend)
+                MPI_Isend(&buf[chunkBegin], chunkEnd-chunkBegin, MPI_CHAR, remoteMpiRank, msgtag, comm, &striping.requests[c]);
+            else
+                MPI_Irecv(&buf[chunkBegin], chunkEnd-chunkBegin, MPI_CHAR, remoteMpiRank, msgtag, comm, &striping.requests[c]);
+
+        }
+
+        if(blocking)
+            MPI_Waitall(numChunks, striping.requests.data(), MPI_STATUSES_IGNORE);
+
+        return Status(striping.requests.data(), numChunks);
+
+    }
+
+    /***********************************************************************/
+    /*                      PARTITIONED COMMUNICATION                      */
+    /***********************************************************************/
+
+    /**
+     * @brief
+     * Set up the partitions of a halo using MPIPartitioned.
+     *
+     * See setSendPartitions() and setRecvPartitions(). Without MPI 4 the halo falls back to the
+     * Default strategy.
+     *
+     * @param isSend
+     * Whether this is a send halo (true) or a recv halo (false).
+     * @param haloId
+     * The halo id returned by the addSendHaloInfo()/addRecvHaloInfo() member function.
+     * @param numPartitions
+     * The requested number of partitions, 0 chooses the default based on the size of the halo.
+     */
+    inline void setupPartitions(const bool isSend, const size_t haloId, int numPartitions) {
+
+#if MPI_VERSION >= 4
+
+        auto &requests = (isSend ? sendHaloMpiRequests[haloId] : recvHaloMpiRequests[haloId]);
+        auto &setup = (isSend ? sendHaloMpiSetup[haloId] : recvHaloMpiSetup[haloId]);
+        if(setup[0]) {
+            MPI_Wait(&requests[0], MPI_STATUS_IGNORE);
+            MPI_Request_free(&requests[0]);
+            requests[0] = MPI_REQUEST_NULL;
+            setup[0] = false;
+        }
+
+        const size_t size = (isSend ? sendHaloIndicesSizeTotal[haloId] : recvHaloIndicesSizeTotal[haloId]);
+        const int numBuffers = (isSend ? sendHaloNumBuffers[haloId] : recvHaloNumBuffers[haloId]);
+        if(numPartitions <= 0)
+            numPartitions = std::max(numBuffers, static_cast<int>(std::min<size_t>(size/(16*1024), 64)));
+        numPartitions = std::max(1, std::min(numPartitions, static_cast<int>(std::max<size_t>(size, 1))));
+        while(size%numPartitions != 0)
+            --numPartitions;
+
+        Partitioned partitioned;
+        partitioned.numPartitions = numPartitions;
+        partitioned.partitionSize = size/numPartitions;
+        partitioned.packed.resize(numBuffers, 0);
+        partitioned.ready.resize(numPartitions, 0);
+
+        std::lock_guard<std::mutex> lock(partitionedMutex);
+        (isSend ? sendHaloPartitioned : recvHaloPartitioned)[haloId] = partitioned;
+
+#else
+
+        (void)numPartitions;
+
+        std::cout << "Tausch::setupPartitions(): MPIPartitioned requires MPI 4, falling back to Default..." << std::endl;
+        if(isSend)
+            sendHaloCommunicationStrategy[haloId] = Communication::Default;
+        else
+            recvHaloCommunicationStrategy[haloId] = Communication::Default;
+
+#endif
+
+    }
+
+    /**
+     * @brief
+     * Mark the beginning of a buffer of a send halo using MPIPartitioned as packed.
+     *
+     * Used internally by packSendBuffer().
+     *
+     * @param haloId
+     * The halo id returned by the addSendHaloInfo() member function.
+     * @param bufferId
+     * The id of the buffer being packed.
+     * @param bytes
+     * The number of bytes at the beginning of the buffer that have been packed.
+     */
+    inline void markPartitionPacked(const size_t haloId, const size_t bufferId, const size_t bytes) {
+
+        std::lock_guard<std::mutex> lock(partitionedMutex);
+
+        Partitioned &partitioned = sendHaloPartitioned.at(haloId);
+        partitioned.packed[bufferId] = bytes;
+        if(partitioned.started)
+            readyPartitions(haloId);
+
+    }
+
+    /**
+     * @brief
+     * Mark all partitions of a send halo whose buffers have been packed as ready.
+     *
+     * Once all partitions are ready the halo is reset for the next message. Used internally, the
+     * caller needs to hold the partitionedMutex.
+     *
+     * @param haloId
+     * The halo id returned by the addSendHaloInfo() member function.
+     */
+    inline void readyPartitions(const size_t haloId) {
+
+#if MPI_VERSION >= 4
+
+        Partitioned &partitioned = sendHaloPartitioned.at(haloId);
+
+        bool allReady = true;
+
+        for(int p = 0; p < partitioned.numPartitions; ++p) {
+
+            if(partitioned.ready[p])
+                continue;
+
+            const size_t partitionBegin = p*partitioned.partitionSize;
+            const size_t partitionEnd = partitionBegin + partitioned.partitionSize;
+
+            // all buffers overlapping the partition need to be packed up to its end
+            bool packed = true;
+            size_t bufferOffset = 0;
+            for(size_t iBuf = 0; iBuf < partitioned.packed.size() && bufferOffset < partitionEnd; ++iBuf) {
+                const size_t bufferEnd = bufferOffset + sendHaloIndicesSizePerBuffer[haloId][iBuf];
+                if(bufferEnd > partitionBegin && partitioned.packed[iBuf] < std::min(partitionEnd, bufferEnd)-bufferOffset)
+                    packed = false;
+                bufferOffset = bufferEnd;
+            }
+
+            if(packed) {
+                MPI_Pready(p, sendHaloMpiRequests[haloId][0]);
+                partitioned.ready[p] = 1;
+            } else
+                allReady = false;
+
+        }
+
+        if(allReady) {
+            partitioned.started = false;
+            std::fill(partitioned.packed.begin(), partitioned.packed.end(), size_t(0));
+            std::fill(partitioned.ready.begin(), partitioned.ready.end(), 0);
+        }
+
+#else
+
+        (void)haloId;
+
+#endif
+
+    }
+
+    /**
+     * @brief
+     * Start a partitioned message.
+     *
+     * Used internally by send() and recv().
+     *
+     * @param isSend
+     * Whether this is a send halo (true) or a recv halo (false).
+     * @param haloId
+     * The halo id returned by the addSendHaloInfo()/addRecvHaloInfo() member function.
+     * @param msgtag
+     * The message tag to be used by this communication.
+     * @param remoteMpiRank
+     * The remote MPI rank.
+     * @param blocking
+     * Whether to wait for the message to complete.
+     * @param communicator
+     * The communicator to use.
+     *
+     * @return
+     * Returns the Status object connected to the partitioned request.
+     */
+    inline Status startPartitionedMessage(const bool isSend, const size_t haloId, const int msgtag, const int remoteMpiRank, const bool blocking, MPI_Comm communicator) {
+
+#if MPI_VERSION >= 4
+
+        Partitioned &partitioned = (isSend ? sendHaloPartitioned : recvHaloPartitioned).at(haloId);
+        MPI_Request &request = (isSend ? sendHaloMpiRequests[haloId][0] : recvHaloMpiRequests[haloId][0]);
+        auto &setup = (isSend ? sendHaloMpiSetup[haloId] : recvHaloMpiSetup[haloId]);
+
+        if(!setup[0]) {
+
+            setup[0] = true;
+
+            if(isSend)
+                MPI_Psend_init(sendBuffer[haloId], partitioned.numPartitions, partitioned.partitionSize, MPI_CHAR,
+                               remoteMpiRank, msgtag, communicator, MPI_INFO_NULL, &request);
+            else
+                MPI_Precv_init(recvBuffer[haloId], partitioned.numPartitions, partitioned.partitionSize, MPI_CHAR,
+                               remoteMpiRank, msgtag, communicator, MPI_INFO_NULL, &request);
+
+        } else
+
+            MPI_Wait(&request, MPI_STATUS_IGNORE);
+
+        MPI_Start(&request);
+
+        if(isSend) {
+            std::lock_guard<std::mutex> lock(partitionedMutex);
+            partitioned.started = true;
+            readyPartitions(haloId);
+        }
+
+        if(blocking)
+            MPI_Wait(&request, MPI_STATUS_IGNORE);
+
+        return Status(&request);
+
+#else
+
+        (void)isSend;
+        (void)haloId;
+        (void)msgtag;
+        (void)remoteMpiRank;
+        (void)blocking;
+        (void)communicator;
+
+        return Status(MPI_REQUEST_NULL);
+
+#endif
+
+    }
+
+    /**
+     * @brief
+     * Wait for the partitions of a recv halo overlapping a buffer to arrive.
+     *
+     * Used internally by unpackRecvBuffer().
+     *
+     * @param haloId
+     * The halo id returned by the addRecvHaloInfo() member function.
+     * @param bufferId
+     * The id of the buffer to be unpacked.
+     */
+    inline void waitForPartitions(const size_t haloId, const size_t bufferId) {
+
+#if MPI_VERSION >= 4
+
+        Partitioned &partitioned = recvHaloPartitioned.at(haloId);
+        if(!recvHaloMpiSetup[haloId][0] || recvHaloIndicesSizePerBuffer[haloId][bufferId] == 0)
+            return;
+
+        // nothing to do if the whole message has arrived already (this includes inactive requests)
+        int complete;
+        MPI_Request_get_status(recvHaloMpiRequests[haloId][0], &complete, MPI_STATUS_IGNORE);
+        if(complete)
+            return;
+
+        size_t bufferOffset = 0;
+        for(size_t i = 0; i < bufferId; ++i)
+            bufferOffset += recvHaloIndicesSizePerBuffer[haloId][i];
+
+        const int firstPartition = bufferOffset/partitioned.partitionSize;
+        const int lastPartition = (bufferOffset + recvHaloIndicesSizePerBuffer[haloId][bufferId] - 1)/partitioned.partitionSize;
+
+        for(int p = firstPartition; p <= lastPartition; ++p) {
+            int flag = 0;
+            while(!flag)
+                MPI_Parrived(recvHaloMpiRequests[haloId][0], p, &flag);
+        }
+
+#else
+
+        (void)haloId;
+        (void)bufferId;
+
+#endif
+
+    }
+
+    /**
+     * @brief
+     * Checks whether the data of a recv halo overlapping a buffer has arrived.
+     *
+     * Depending on how out-of-sync situations are handled (see setOutOfSyncHandling()) this warns
+     * and/or waits if the data has not arrived yet. Used internally by unpackRecvBuffer() and
+     * unpackRecvBuffers().
+     *
+     * @param haloId
+     * The halo id returned by the addRecvHaloInfo() member function.
+     * @param bufferId
+     * The id of the buffer to be unpacked.
+     */
+    inline void checkRecvBufferArrived(const size_t haloId, const size_t bufferId) {
+
+        if((handleOutOfSync&OutOfSync::DontCheck) != OutOfSync::DontCheck && isStriped(false, haloId)) {
+
+            std::vector<MPI_Request> &requests = recvHaloStriping.at(haloId).requests;
+
+            if((handleOutOfSync&OutOfSync::WarnMe) == OutOfSync::WarnMe) {
+                int flag;
+                MPI_Testall(requests.size(), requests.data(), &flag, MPI_STATUSES_IGNORE);
+                if(!flag)
+                    std::cout << "Warning: Halo " << haloId << " has not finished receiving..." << std::endl;
+            }
+
+            if((handleOutOfSync&OutOfSync::Wait) == OutOfSync::Wait)
+                MPI_Waitall(requests.size(), requests.data(), MPI_STATUSES_IGNORE);
+
+        }
+
+        std::vector<Status> transported;
+        if(transport != nullptr) {
+            std::unique_lock<std::mutex> lock(transportMutex, std::defer_lock);
+            if(threadSafe)
+                lock.lock();
+            auto outstanding = recvHaloTransportStatus.find(haloId);
+            if(outstanding != recvHaloTransportStatus.end())
+                transported.push_back(outstanding->second);
+        }
+        if((handleOutOfSync&OutOfSync::DontCheck) != OutOfSync::DontCheck && transported.size() > 0) {
+
+            if((handleOutOfSync&OutOfSync::WarnMe) == OutOfSync::WarnMe && !transport->test(transported[0]))
+                std::cout << "Warning: Halo " << haloId << " has not finished receiving..." << std::endl;
+
+            if((handleOutOfSync&OutOfSync::Wait) == OutOfSync::Wait)
+                transport->wait(transported[0]);
+
+        }
+
+#ifdef TAUSCH_UCX
+        auto ucx = recvHaloUcx.find(haloId);
+        if((handleOutOfSync&OutOfSync::DontCheck) != OutOfSync::DontCheck &&
+           ucx != recvHaloUcx.end() && ucx->second.request != nullptr) {
+
+            Status status(ucxWorker, &ucx->second.request);
+
+            if((handleOutOfSync&OutOfSync::WarnMe) == OutOfSync::WarnMe && status.isRunning())
+                std::cout << "Warning: Halo " << haloId << " has not finished receiving..." << std::endl;
+
+            if((handleOutOfSync&OutOfSync::Wait) == OutOfSync::Wait)
+                status.wait();
+
+        }
+#endif
+
+        // with partitioned communication only the partitions overlapping this buffer need to have arrived
+        if((recvHaloCommunicationStrategy[haloId]&Communication::MPIPartitioned) == Communication::MPIPartitioned)
+            waitForPartitions(haloId, bufferId);
+
+        else if((handleOutOfSync&OutOfSync::DontCheck) != OutOfSync::DontCheck && recvHaloMpiRequests[haloId][0] != MPI_REQUEST_NULL) {
+
+            if((handleOutOfSync&OutOfSync::WarnMe) == OutOfSync::WarnMe) {
+
+                int useBufferId = 0;
+                if((recvHaloCommunicationStrategy[haloId]&Communication::DerivedMpiDatatype) == Communication::DerivedMpiDatatype)
+                    useBufferId = bufferId;
+
+                int flag;
+                MPI_Test(&recvHaloMpiRequests[haloId][useBufferId], &flag, MPI_STATUS_IGNORE);
+                if(!flag)
+                    std::cout << "Warning: Halo " << haloId << " has not finished receiving..." << std::endl;
+
+            }
+
+            if((handleOutOfSync&OutOfSync::Wait) == OutOfSync::Wait) {
+
+                int useBufferId = 0;
+                if((recvHaloCommunicationStrategy[haloId]&Communication::DerivedMpiDatatype) == Communication::DerivedMpiDatatype)
+                    useBufferId = bufferId;
+
+                MPI_Wait(&recvHaloMpiRequests[haloId][useBufferId], MPI_STATUS_IGNORE);
+
+            }
+
+        }
+
+    }
+
+    /***********************************************************************/
+    /*                      COMBINED DERIVED DATATYPE                      */
+    /***********************************************************************/
+
+    /**
+     * @brief
+     * Get the datatype combining all buffers of a halo into a single message.
+     *
+     * Used by the DerivedMpiDatatypeSingleMessage strategy: The per-buffer derived datatypes are
+     * combined into one struct datatype relative to the absolute addresses of the halo buffers
+     * (to be used with MPI_BOTTOM). The wire layout is the same as the one of the packed buffer
+     * used by the Default strategy, i.e., both sides can be combined freely. The datatype is built
+     * the first time it is needed and rebuilt whenever a halo buffer changes.
+     *
+     * @param isSend
+     * Whether this is a send halo (true) or a recv halo (false).
+     * @param haloId
+     * The halo id returned by the addSendHaloInfo()/addRecvHaloInfo() member function.
+     *
+     * @return
+     * The committed combined datatype.
+     */
+    inline MPI_Datatype getCombinedDatatype(const bool isSend, const size_t haloId) {
+
+        auto &combinedPerHalo = (isSend ? sendHaloCombinedDatatype : recvHaloCombinedDatatype);
+        if(combinedPerHalo.find(haloId) == combinedPerHalo.end())
+            combinedPerHalo[haloId] = MPI_DATATYPE_NULL;
+        MPI_Datatype &combined = combinedPerHalo[haloId];
+
+        if(combined == MPI_DATATYPE_NULL) {
+
+            const int numBuffers = (isSend ? sendHaloNumBuffers[haloId] : recvHaloNumBuffers[haloId]);
+            auto &buffers = (isSend ? sendHaloBuffer : recvHaloBuffer)[haloId];
+            auto &types = (isSend ? sendHaloDerivedDatatype : recvHaloDerivedDatatype)[haloId];
+
+            // without all halo buffers there is nothing the datatype could refer to
+            for(int iBuf = 0; iBuf < numBuffers; ++iBuf) {
+                if(buffers.find(iBuf) == buffers.end() || static_cast<int>(types.size()) != numBuffers) {
+                    std::cout << "Tausch::getCombinedDatatype(): Buffer " << iBuf << " of " << (isSend ? "send" : "recv") << " halo " << haloId
+                              << " has not been set using " << (isSend ? "setSendHaloBuffer()" : "setRecvHaloBuffer()")
+                              << " or the halo does not use DerivedMpiDatatypeSingleMessage, aborting..." << std::endl;
+                    MPI_Abort(TAUSCH_COMM, 1);
+                }
+            }
+
+            std::vector<int> blocklengths(numBuffers, 1);
+            std::vector<MPI_Aint> displacements(numBuffers);
+            for(int iBuf = 0; iBuf < numBuffers; ++iBuf)
+                MPI_Get_address(buffers[iBuf], &displacements[iBuf]);
 
-                    }
+            MPI_Type_create_struct(numBuffers, blocklengths.data(), displacements.data(), types.data(), &combined);
+            MPI_Type_commit(&combined);
 
-                }
+        }
 
-                double t = std::accumulate(allt.begin(), allt.end(), 0.0);
+        return combined;
 
-                double t_reduced;
-                MPI_Reduce(&t, &t_reduced, 1, MPI_DOUBLE, MPI_SUM, 0, testcomm);
+    }
 
-                if(mpiRank == 0) {
+    /**
+     * @brief
+     * Release the datatype combining all buffers of a halo.
+     *
+     * Any persistent request set up with the old datatype is released, too. The datatype is
+     * rebuilt the next time it is needed.
+     *
+     * @param isSend
+     * Whether this is a send halo (true) or a recv halo (false).
+     * @param haloId
+     * The halo id returned by the addSendHaloInfo()/addRecvHaloInfo() member function.
+     */
+    inline void freeCombinedDatatype(const bool isSend, const size_t haloId) {
 
-                    t_reduced /= static_cast<double>(mpiSize);
+        auto &combinedPerHalo = (isSend ? sendHaloCombinedDatatype : recvHaloCombinedDatatype);
+        if(combinedPerHalo.find(haloId) == combinedPerHalo.end()) {
+            combinedPerHalo[haloId] = MPI_DATATYPE_NULL;
+            return;
+        }
 
-                    if(t_best == -1 || (t_best > t_reduced)) {
-                        bestSend = iSend;
-                        bestRecv = iRecv;
-                        t_best = t_reduced;
-                    }
+        MPI_Datatype &combined = combinedPerHalo[haloId];
+        if(combined == MPI_DATATYPE_NULL)
+            return;
+
+        auto &requests = (isSend ? sendHaloMpiRequests[haloId] : recvHaloMpiRequests[haloId]);
+        auto &setup = (isSend ? sendHaloMpiSetup[haloId] : recvHaloMpiSetup[haloId]);
+        if(setup[0]) {
+            MPI_Wait(&requests[0], MPI_STATUS_IGNORE);
+            MPI_Request_free(&requests[0]);
+            requests[0] = MPI_REQUEST_NULL;
+            setup[0] = false;
+        }
 
-                    if(printProgress)
-                        std::cout << t_reduced << " ms" << std::endl;
+        MPI_Type_free(&combined);
+        combined = MPI_DATATYPE_NULL;
 
-                }
+    }
+
+    /***********************************************************************/
+    /*                            SEND MESSAGE                             */
+    /***********************************************************************/
 
+    /**
+     * @brief
+     * Post the send of a given halo.
+     *
+     * Used internally by sendMessage(), see send() for the parameters.
+     */
+    inline Status postSendMessage(size_t haloId, const int msgtag, const int remoteMpiRank, const int bufferId, const bool blocking, MPI_Comm communicator) {
+
+        if(sendHaloIndicesSizeTotal[haloId] == 0) {
+            sendHaloMpiRequests[haloId][0] = MPI_REQUEST_NULL;
+            // a transport might not use MPI at all, waiting for MPI_REQUEST_NULL would call into MPI
+            if(usesTransport(true, haloId, communicator))
+                return Status(Transport::completed());
+            return Status(MPI_REQUEST_NULL);
+        }
+
+        if((handleOutOfSync&OutOfSync::DontCheck) != OutOfSync::DontCheck) {
+
+            if((handleOutOfSync&OutOfSync::WarnMe) == OutOfSync::WarnMe) {
+                if(packFutures[haloId].isRunning())
+                    std::cout << "Warning: Halo " << haloId << " has not finished packing..." << std::endl;
+            }
+
+            if((handleOutOfSync&OutOfSync::Wait) == OutOfSync::Wait) {
+                if(packFutures[haloId].isRunning())
+                    packFutures[haloId].wait();
             }
 
         }
 
-        MPI_Bcast(&bestSend, 1, MPI_INT, 0, testcomm);
-        MPI_Bcast(&bestRecv, 1, MPI_INT, 0, testcomm);
+        int useRemoteMpiRank = sendHaloRemoteRank.at(haloId);
+        if(remoteMpiRank != -1)
+            useRemoteMpiRank = remoteMpiRank;
 
-        if(mpiRank == 0 && printProgress) {
+        if(usesTransport(true, haloId, communicator))
+            return postTransportMessage(true, haloId, msgtag, useRemoteMpiRank, blocking);
 
-            std::cout << std::endl;
-            std::cout << " ** Best strategy combo:" << std::endl << std::endl
-                    << std::setw(24) << " Sending: " << strategyNames[bestSend] << std::endl
-                    << std::setw(24) << " Receiving: " << strategyNames[bestRecv] << std::endl
-                    << " Average time required: " << t_best << " ms" << std::endl << std::endl;
+        if(communicator == MPI_COMM_NULL)
+            communicator = (useChannels ? channelPool[getChannel(true, haloId, msgtag, useRemoteMpiRank)] : TAUSCH_COMM);
 
+        // if we stay on the same rank, we don't need to use MPI
+        int myRank;
+        MPI_Comm_rank(communicator, &myRank);
+        if(useRemoteMpiRank == myRank && (sendHaloCommunicationStrategy[haloId]&Communication::TryDirectCopy) == Communication::TryDirectCopy) {
+            std::unique_lock<std::mutex> lock(msgtagToHaloIdMutex, std::defer_lock);
+            if(threadSafe)
+                lock.lock();
+            msgtagToHaloId[myRank*1000000 + msgtag] = haloId;
+            return Status(MPI_REQUEST_NULL);
         }
 
-        return {strategies[bestSend], strategies[bestRecv]};
+#ifdef TAUSCH_UCX
+        // UCX tagged messages bypass MPI entirely
+        if((sendHaloCommunicationStrategy[haloId]&Communication::UCX) == Communication::UCX)
+            return postUcxMessage(true, haloId, msgtag, useRemoteMpiRank, blocking);
+#endif
 
-    }
+        // MPI-4 partitioned communication, partitions are marked ready as they are packed
+        if((sendHaloCommunicationStrategy[haloId]&Communication::MPIPartitioned) == Communication::MPIPartitioned)
+            return startPartitionedMessage(true, haloId, msgtag, useRemoteMpiRank, blocking, communicator);
 
-private:
+        // Large halos can be split into chunks sent as independent messages
+        if(isStriped(true, haloId))
+            return postStripedMessage(true, haloId, msgtag, useRemoteMpiRank, blocking, communicator);
 
-    MPI_Comm TAUSCH_COMM;
+        // With a ring of staging buffers the next packing goes into another buffer
+        if(isRingBuffered(haloId))
+            return postRingMessage(haloId, msgtag, useRemoteMpiRank, blocking, communicator);
 
-    std::vector<std::vector<std::vector<std::array<int, 4> > > > sendHaloIndices;
-    std::vector<std::vector<int> > sendHaloIndicesSizePerBuffer;
-    std::vector<int> sendHaloIndicesSizeTotal;
-    std::vector<int> sendHaloNumBuffers;
-    std::vector<int> sendHaloRemoteRank;
-    std::vector<unsigned char*> sendBuffer;
-    std::vector<std::vector<MPI_Request> > sendHaloMpiRequests;
-    std::vector<std::vector<bool> > sendHaloMpiSetup;
-    std::vector<Communication> sendHaloCommunicationStrategy;
-    std::map<int, std::map<int, unsigned char*> > sendHaloBuffer;
-    std::map<int, std::vector<MPI_Datatype> > sendHaloDerivedDatatype;
+        int useBufferId = 0;
+        if((sendHaloCommunicationStrategy[haloId]&Communication::DerivedMpiDatatype) == Communication::DerivedMpiDatatype)
+            useBufferId = bufferId;
 
-    std::vector<std::vector<std::vector<std::array<int, 4> > > > recvHaloIndices;
-    std::vector<std::vector<int> > recvHaloIndicesSizePerBuffer;
-    std::vector<int> recvHaloIndicesSizeTotal;
-    std::vector<int> recvHaloNumBuffers;
-    std::vector<int> recvHaloRemoteRank;
-    std::vector<unsigned char*> recvBuffer;
-    std::vector<std::vector<MPI_Request> > recvHaloMpiRequests;
-    std::vector<std::vector<bool> > recvHaloMpiSetup;
-    std::vector<Communication> recvHaloCommunicationStrategy;
-    std::map<int, std::map<int, unsigned char*> > recvHaloBuffer;
-    std::map<int, std::vector<MPI_Datatype> > recvHaloDerivedDatatype;
+        // Take this path if we are to use MPI persistent communication
+        // Depending on the implementation this can be a good or bad idea.
+        // Using persistent communication could pin the communication protocol to eager (tends to bad performance for larger messages)
+        if((sendHaloCommunicationStrategy[haloId]&Communication::MPIPersistent) == Communication::MPIPersistent) {
 
-    // this is used for exchanges on same mpi rank
-    std::map<int, int> msgtagToHaloId;
+            if(!sendHaloMpiSetup[haloId][useBufferId])
+                initPersistentRequest(true, haloId, useBufferId, msgtag, useRemoteMpiRank, communicator);
+            else
+                MPI_Wait(&sendHaloMpiRequests[haloId][useBufferId], MPI_STATUS_IGNORE);
 
-    std::vector<int> recvBufferHaloIdDeleted;
-    std::vector<int> sendBufferHaloIdDeleted;
+            MPI_Start(&sendHaloMpiRequests[haloId][useBufferId]);
 
-    OutOfSync handleOutOfSync;
-    std::vector<Status> packFutures;
-    std::vector<Status> unpackFutures;
+        // Take this path to use normal Isend/Irecv communication
+        // This is the default.
+        } else {
 
 #ifdef TAUSCH_CUDA
-    std::vector<unsigned char*> cudaSendBuffer;
-    std::vector<unsigned char*> cudaRecvBuffer;
+            if((sendHaloCommunicationStrategy[haloId]&Communication::CUDAAwareMPI) == Communication::CUDAAwareMPI) {
+
+                MPI_Isend(cudaSendBuffer[haloId], sendHaloIndicesSizeTotal[haloId], MPI_CHAR,
+                          useRemoteMpiRank, msgtag, communicator,
+                          &sendHaloMpiRequests[haloId][0]);
+
+            } else
 #endif
 
-#ifdef TAUSCH_OPENCL
+                if((sendHaloCommunicationStrategy[haloId]&Communication::DerivedMpiDatatypeSingleMessage) == Communication::DerivedMpiDatatypeSingleMessage)
+                    MPI_Isend(MPI_BOTTOM, 1, getCombinedDatatype(true, haloId),
+                              useRemoteMpiRank, msgtag, communicator,
+                              &sendHaloMpiRequests[haloId][0]);
+                else if((sendHaloCommunicationStrategy[haloId]&Communication::DerivedMpiDatatype) == Communication::DerivedMpiDatatype)
+                    MPI_Isend(sendHaloBuffer.at(haloId).at(useBufferId), 1, sendHaloDerivedDatatype.at(haloId)[useBufferId],
+                              useRemoteMpiRank, msgtag, communicator,
+                              &sendHaloMpiRequests[haloId][useBufferId]);
+                else
+                    MPI_Isend(sendBuffer[haloId], sendHaloIndicesSizeTotal[haloId], MPI_CHAR,
+                              useRemoteMpiRank, msgtag, communicator,
+                              &sendHaloMpiRequests[haloId][0]);
 
-    cl::Device ocl_device;
-    cl::Context ocl_context;
-    cl::CommandQueue ocl_queue;
+        }
+
+        if(blocking)
+            MPI_Wait(&sendHaloMpiRequests[haloId][useBufferId], MPI_STATUS_IGNORE);
+
+        // waiting on the Status updates the stored request, which Tausch checks again later on (e.g.,
+        // when unpacking or before switching strategy in adaptive mode)
+        return Status(&sendHaloMpiRequests[haloId][useBufferId]);
+
+    }
+
+    /**
+     * @brief
+     * Send a given halo without network emulation.
+     *
+     * Used internally by send(), see there for the parameters. In adaptive mode this picks the
+     * strategy and times the send.
+     */
+    inline Status sendMessage(size_t haloId, const int msgtag, const int remoteMpiRank, const int bufferId, const bool blocking, MPI_Comm communicator) {
+
+        if(!isAdaptive(true, haloId))
+            return postSendMessage(haloId, msgtag, remoteMpiRank, bufferId, blocking, communicator);
+
+        adaptCommunicationStrategy(true, haloId);
+
+        auto timing = std::make_shared<Status::CompletionTiming>();
+        Status status = postSendMessage(haloId, msgtag, remoteMpiRank, bufferId, blocking, communicator);
+        status.setCompletionTiming(timing);
+        if(blocking)
+            status.wait();
+
+        // the validation of a cached strategy might have ended adaptive mode
+        if(isAdaptive(true, haloId)) {
+            sendHaloAdaptive[haloId].previous = status;
+            sendHaloAdaptive[haloId].timing = timing;
+        }
+
+        return status;
+
+    }
+
+    /***********************************************************************/
+    /*                         RECEIVE MESSAGE                             */
+    /***********************************************************************/
+
+    /**
+     * @brief
+     * Post the receive of a given halo.
+     *
+     * Used internally by recvMessage(), see recv() for the parameters.
+     */
+    inline Status postRecvMessage(size_t haloId, const int msgtag, const int remoteMpiRank, const int bufferId, const bool blocking, MPI_Comm communicator) {
+
+        if(recvHaloIndicesSizeTotal[haloId] == 0) {
+            recvHaloMpiRequests[haloId][0] = MPI_REQUEST_NULL;
+            if(usesTransport(false, haloId, communicator))
+                return Status(Transport::completed());
+            return Status(MPI_REQUEST_NULL);
+        }
+
+        int useRemoteMpiRank = recvHaloRemoteRank.at(haloId);
+        if(remoteMpiRank != -1)
+            useRemoteMpiRank = remoteMpiRank;
+
+        if(usesTransport(false, haloId, communicator)) {
+            recvHaloMpiRequests[haloId][0] = MPI_REQUEST_NULL;
+            return postTransportMessage(false, haloId, msgtag, useRemoteMpiRank, blocking);
+        }
+
+        if(communicator == MPI_COMM_NULL)
+            communicator = (useChannels ? channelPool[getChannel(false, haloId, msgtag, useRemoteMpiRank)] : TAUSCH_COMM);
+
+        // if we stay on the same rank, we don't need to use MPI
+        int myRank;
+        MPI_Comm_rank(communicator, &myRank);
+        if(useRemoteMpiRank == myRank && (recvHaloCommunicationStrategy[haloId]&Communication::TryDirectCopy) == Communication::TryDirectCopy) {
+            std::unique_lock<std::mutex> lock(msgtagToHaloIdMutex, std::defer_lock);
+            if(threadSafe)
+                lock.lock();
+            const int remoteHaloId = msgtagToHaloId[myRank*1000000 + msgtag];
+            if(threadSafe)
+                lock.unlock();
+            std::memcpy(recvBuffer[haloId], sendBuffer[remoteHaloId], recvHaloIndicesSizeTotal[haloId]);
+            return Status(MPI_REQUEST_NULL);
+        }
+
+#ifdef TAUSCH_UCX
+        // UCX tagged messages bypass MPI entirely
+        if((recvHaloCommunicationStrategy[haloId]&Communication::UCX) == Communication::UCX) {
+            recvHaloMpiRequests[haloId][0] = MPI_REQUEST_NULL;
+            return postUcxMessage(false, haloId, msgtag, useRemoteMpiRank, blocking);
+        }
+#endif
+
+        // MPI-4 partitioned communication, partitions can be unpacked as they arrive
+        if((recvHaloCommunicationStrategy[haloId]&Communication::MPIPartitioned) == Communication::MPIPartitioned)
+            return startPartitionedMessage(false, haloId, msgtag, useRemoteMpiRank, blocking, communicator);
+
+        // Large halos can be received in chunks sent as independent messages
+        if(isStriped(false, haloId)) {
+            if(!recvHaloMpiSetup[haloId][0])
+                recvHaloMpiRequests[haloId][0] = MPI_REQUEST_NULL;
+            return postStripedMessage(false, haloId, msgtag, useRemoteMpiRank, blocking, communicator);
+        }
+
+        int useBufferId = 0;
+        if((recvHaloCommunicationStrategy[haloId]&Communication::DerivedMpiDatatype) == Communication::DerivedMpiDatatype)
+            useBufferId = bufferId;
+
+        // Take this path if we are to use MPI persistent communication
+        // Depending on the implementation this can be a good or bad idea.
+        // Using persistent communication could pin the communication protocol to eager (tends to bad performance for larger messages)
+        if((recvHaloCommunicationStrategy[haloId]&Communication::MPIPersistent) == Communication::MPIPersistent) {
+
+            if(!recvHaloMpiSetup[haloId][useBufferId]) {
+
+                initPersistentRequest(false, haloId, useBufferId, msgtag, useRemoteMpiRank, communicator);
+
+                MPI_Start(&recvHaloMpiRequests[haloId][useBufferId]);
+
+            // the receive might have been restarted already right after unpacking
+            } else if(!consumeRearmed(haloId)) {
+
+                MPI_Wait(&recvHaloMpiRequests[haloId][useBufferId], MPI_STATUS_IGNORE);
+                MPI_Start(&recvHaloMpiRequests[haloId][useBufferId]);
+
+            }
+
+        // Take this path to use normal Isend/Irecv communication
+        // This is the default.
+        } else {
+
+#ifdef TAUSCH_CUDA
+            if((recvHaloCommunicationStrategy[haloId]&Communication::CUDAAwareMPI) == Communication::CUDAAwareMPI) {
+
+                MPI_Irecv(cudaRecvBuffer[haloId], recvHaloIndicesSizeTotal[haloId], MPI_CHAR,
+                          useRemoteMpiRank, msgtag, communicator,
+                          &recvHaloMpiRequests[haloId][0]);
 
+            } else
 #endif
+            if((recvHaloCommunicationStrategy[haloId]&Communication::DerivedMpiDatatypeSingleMessage) == Communication::DerivedMpiDatatypeSingleMessage)
+                MPI_Irecv(MPI_BOTTOM, 1, getCombinedDatatype(false, haloId),
+                          useRemoteMpiRank, msgtag, communicator,
+                          &recvHaloMpiRequests[haloId][0]);
+            else if((recvHaloCommunicationStrategy[haloId]&Communication::DerivedMpiDatatype) == Communication::DerivedMpiDatatype)
+                MPI_Irecv(recvHaloBuffer.at(haloId).at(useBufferId), 1, recvHaloDerivedDatatype.at(haloId)[useBufferId],
+                          useRemoteMpiRank, msgtag, communicator,
+                          &recvHaloMpiRequests[haloId][useBufferId]);
+            else
+                MPI_Irecv(recvBuffer[haloId], recvHaloIndicesSizeTotal[haloId], MPI_CHAR,
+                          useRemoteMpiRank, msgtag, communicator,
+                          &recvHaloMpiRequests[haloId][0]);
+
+        }
+
+        if(blocking)
+            MPI_Wait(&recvHaloMpiRequests[haloId][useBufferId], MPI_STATUS_IGNORE);
+
+        // waiting on the Status updates the stored request, which Tausch checks again later on (e.g.,
+        // when unpacking or before switching strategy in adaptive mode)
+        return Status(&recvHaloMpiRequests[haloId][useBufferId]);
+
+    }
+
+    /**
+     * @brief
+     * Receive a given halo without network emulation.
+     *
+     * Used internally by recv(), see there for the parameters.
+     */
+    inline Status recvMessage(size_t haloId, const int msgtag, const int remoteMpiRank, const int bufferId, const bool blocking, MPI_Comm communicator) {
+
+        if(!isAdaptive(false, haloId))
+            return postRecvMessage(haloId, msgtag, remoteMpiRank, bufferId, blocking, communicator);
+
+        adaptCommunicationStrategy(false, haloId);
+
+        auto timing = std::make_shared<Status::CompletionTiming>();
+        Status status = postRecvMessage(haloId, msgtag, remoteMpiRank, bufferId, blocking, communicator);
+        status.setCompletionTiming(timing);
+        if(blocking)
+            status.wait();
+
+        // the validation of a cached strategy might have ended adaptive mode
+        if(isAdaptive(false, haloId)) {
+            recvHaloAdaptive[haloId].previous = status;
+            recvHaloAdaptive[haloId].timing = timing;
+        }
+
+        return status;
+
+    }
 
 };
 
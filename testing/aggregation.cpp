@@ -0,0 +1,244 @@
+#include <catch2/catch.hpp>
+#include "../tausch.h"
+
+// the tests in here combine several halos into one message or look at how they map to nodes, and use the CPU code path only
+#if defined(TEST_SEND_TAUSCH_CPU) && defined(TEST_RECV_TAUSCH_CPU)
+
+TEST_CASE("3 halos, aggregated messages, multiple MPI ranks") {
+
+    std::cout << " * Test: " << "3 halos, aggregated messages, multiple MPI ranks" << std::endl;
+
+    int mpiRank, mpiSize;
+    MPI_Comm_rank(MPI_COMM_WORLD, &mpiRank);
+    MPI_Comm_size(MPI_COMM_WORLD, &mpiSize);
+
+    const int right = (mpiRank+1)%mpiSize;
+    const int left = (mpiRank+mpiSize-1)%mpiSize;
+
+    Tausch tausch(MPI_COMM_WORLD, false);
+
+    // halos 0 and 1 go to the right, halo 2 goes to the left
+    const std::vector<int> sizes = {7, 1, 20};
+    const std::vector<int> sendTo = {right, right, left};
+    const std::vector<int> recvFrom = {left, left, right};
+
+    std::vector<std::vector<int> > in(3), out(3);
+    for(int h = 0; h < 3; ++h) {
+        std::vector<int> indices(sizes[h]);
+        for(int i = 0; i < sizes[h]; ++i)
+            indices[i] = i;
+        tausch.addSendHaloInfo(indices, sizeof(int), sendTo[h]);
+        tausch.addRecvHaloInfo(indices, sizeof(int), recvFrom[h]);
+        in[h].resize(sizes[h]);
+        out[h].resize(sizes[h]);
+    }
+
+    // the aggregation buffers are reused for every iteration
+    for(int iter = 0; iter < 3; ++iter) {
+
+        for(int h = 0; h < 3; ++h) {
+            for(int i = 0; i < sizes[h]; ++i)
+                in[h][i] = iter*100000 + mpiRank*1000 + h*100 + i;
+            tausch.packSendBuffer(h, 0, in[h].data());
+        }
+
+        std::vector<Status> status = tausch.sendAggregated({0, 1, 2}, 5);
+        tausch.recvAggregated({0, 1, 2}, 5);
+
+        for(auto &s : status)
+            s.wait();
+
+        for(int h = 0; h < 3; ++h) {
+            tausch.unpackRecvBuffer(h, 0, out[h].data());
+            for(int i = 0; i < sizes[h]; ++i)
+                REQUIRE(out[h][i] == iter*100000 + recvFrom[h]*1000 + h*100 + i);
+        }
+
+        MPI_Barrier(MPI_COMM_WORLD);
+
+    }
+
+}
+
+TEST_CASE("4 halos, hierarchical exchange through fake nodes, multiple MPI ranks") {
+
+    std::cout << " * Test: " << "4 halos, hierarchical exchange through fake nodes, multiple MPI ranks" << std::endl;
+
+    int mpiRank, mpiSize;
+    MPI_Comm_rank(MPI_COMM_WORLD, &mpiRank);
+    MPI_Comm_size(MPI_COMM_WORLD, &mpiSize);
+
+    const int right = (mpiRank+1)%mpiSize;
+    const int left = (mpiRank+mpiSize-1)%mpiSize;
+
+    // every fake node consists of ranksPerNode consecutive ranks, i.e., neighbours are on- and off-node
+    for(int ranksPerNode : {1, 2}) {
+
+        Tausch tausch(MPI_COMM_WORLD, false);
+
+        MPI_Comm nodeComm;
+        MPI_Comm_split(MPI_COMM_WORLD, mpiRank/ranksPerNode, mpiRank, &nodeComm);
+        tausch.setNodeCommunicator(nodeComm);
+        MPI_Comm_free(&nodeComm);
+
+        // halos 0 and 1 go to the right, halos 2 and 3 go to the left
+        const std::vector<int> sizes = {5, 1, 17, 3};
+        const std::vector<int> sendTo = {right, right, left, left};
+        const std::vector<int> recvFrom = {left, left, right, right};
+
+        std::vector<size_t> haloIds;
+        std::vector<std::vector<int> > in(4), out(4);
+        for(int h = 0; h < 4; ++h) {
+            std::vector<int> indices(sizes[h]);
+            for(int i = 0; i < sizes[h]; ++i)
+                indices[i] = i;
+            haloIds.push_back(tausch.addSendHaloInfo(indices, sizeof(int), sendTo[h]));
+            tausch.addRecvHaloInfo(indices, sizeof(int), recvFrom[h]);
+            in[h].resize(sizes[h]);
+            out[h].resize(sizes[h]);
+        }
+
+        for(int iter = 0; iter < 2; ++iter) {
+
+            for(int h = 0; h < 4; ++h) {
+                for(int i = 0; i < sizes[h]; ++i)
+                    in[h][i] = iter*100000 + mpiRank*1000 + h*100 + i;
+                tausch.packSendBuffer(h, 0, in[h].data());
+            }
+
+            tausch.exchangeHierarchical(haloIds, haloIds, 9);
+
+            for(int h = 0; h < 4; ++h) {
+                tausch.unpackRecvBuffer(h, 0, out[h].data());
+                for(int i = 0; i < sizes[h]; ++i)
+                    REQUIRE(out[h][i] == iter*100000 + recvFrom[h]*1000 + h*100 + i);
+            }
+
+            MPI_Barrier(MPI_COMM_WORLD);
+
+        }
+
+    }
+
+}
+
+TEST_CASE("1 halo per rank, rank reordering permutation and traffic report, multiple MPI ranks") {
+
+    std::cout << " * Test: " << "1 halo per rank, rank reordering permutation and traffic report, multiple MPI ranks" << std::endl;
+
+    int mpiRank, mpiSize;
+    MPI_Comm_rank(MPI_COMM_WORLD, &mpiRank);
+    MPI_Comm_size(MPI_COMM_WORLD, &mpiSize);
+
+    const int ranksPerNode = 2;
+    const int size = 10;
+
+    Tausch tausch(MPI_COMM_WORLD, false);
+
+    MPI_Comm nodeComm;
+    MPI_Comm_split(MPI_COMM_WORLD, mpiRank/ranksPerNode, mpiRank, &nodeComm);
+    tausch.setNodeCommunicator(nodeComm);
+    MPI_Comm_free(&nodeComm);
+
+    std::vector<int> indices(size);
+    for(int i = 0; i < size; ++i)
+        indices[i] = i;
+    tausch.addSendHaloInfo(indices, sizeof(double), (mpiRank+1)%mpiSize);
+    tausch.addRecvHaloInfo(indices, sizeof(double), (mpiRank+mpiSize-1)%mpiSize);
+
+    // the traffic of every rank to its right neighbour with the subdomain of rank s handled by the
+    // process that was rank inverse[s]
+    auto expectedTraffic = [&](const std::vector<int> &permutation) {
+        std::vector<int> inverse(mpiSize);
+        for(int i = 0; i < mpiSize; ++i)
+            inverse[permutation[i]] = i;
+        std::array<unsigned long long, 4> traffic = {0, 0, 0, 0};
+        for(int r = 0; r < mpiSize; ++r) {
+            const int right = (r+1)%mpiSize;
+            traffic[(r/ranksPerNode == right/ranksPerNode ? 0 : 1)] += size*sizeof(double);
+            traffic[(inverse[r]/ranksPerNode == inverse[right]/ranksPerNode ? 2 : 3)] += size*sizeof(double);
+        }
+        return traffic;
+    };
+
+    // a permutation that is not its own inverse
+    std::vector<int> permutation(mpiSize);
+    std::iota(permutation.begin(), permutation.end(), 0);
+    if(mpiSize >= 4) {
+        permutation[1] = 2;
+        permutation[2] = 3;
+        permutation[3] = 1;
+    }
+
+    const std::array<unsigned long long, 4> traffic = tausch.estimateNodeTraffic(permutation);
+
+    // whether the MPI library moves any ranks is up to it, the permutation needs to be consistent though
+    MPI_Comm reorderedComm;
+    std::stringstream report;
+    std::vector<int> reordered = tausch.reorderRanksByCommunication(&reorderedComm, &report);
+
+    int reorderedRank;
+    MPI_Comm_rank(reorderedComm, &reorderedRank);
+    MPI_Comm_free(&reorderedComm);
+
+    // all collective calls are done, a failing check does not leave the other ranks hanging
+    if(mpiRank == 0)
+        REQUIRE(traffic == expectedTraffic(permutation));
+
+    REQUIRE(reordered.size() == size_t(mpiSize));
+    REQUIRE(reordered[mpiRank] == reorderedRank);
+    std::vector<int> sorted = reordered;
+    std::sort(sorted.begin(), sorted.end());
+    for(int i = 0; i < mpiSize; ++i)
+        REQUIRE(sorted[i] == i);
+
+    if(mpiRank == 0) {
+
+        const std::array<unsigned long long, 4> reorderedTraffic = expectedTraffic(reordered);
+        const std::string text = report.str();
+
+        std::stringstream before, after;
+        before << "before reordering: " << reorderedTraffic[0] << " bytes intra-node";
+        after << "after reordering:  " << reorderedTraffic[2] << " bytes intra-node";
+        REQUIRE(text.find(before.str()) != std::string::npos);
+        REQUIRE(text.find(after.str()) != std::string::npos);
+
+    }
+
+}
+
+// Hidden test, it is expected to abort and is run separately by ctest, see CMakeLists.txt.
+TEST_CASE("2 halos, aggregated messages with mismatched sizes", "[.aggregatedmismatch]") {
+
+    std::cout << " * Test: " << "2 halos, aggregated messages with mismatched sizes" << std::endl;
+
+    int mpiRank, mpiSize;
+    MPI_Comm_rank(MPI_COMM_WORLD, &mpiRank);
+    MPI_Comm_size(MPI_COMM_WORLD, &mpiSize);
+
+    Tausch tausch(MPI_COMM_WORLD, false);
+
+    // the same total size, but split up differently on both sides
+    std::vector<int> in(12, mpiRank), out(12);
+    std::vector<int> eight = {0, 1, 2, 3, 4, 5, 6, 7};
+    std::vector<int> four = {0, 1, 2, 3};
+    tausch.addSendHaloInfo(eight, sizeof(int), (mpiRank+1)%mpiSize);
+    tausch.addSendHaloInfo(four, sizeof(int), (mpiRank+1)%mpiSize);
+    tausch.addRecvHaloInfo(four, sizeof(int), (mpiRank+mpiSize-1)%mpiSize);
+    tausch.addRecvHaloInfo(eight, sizeof(int), (mpiRank+mpiSize-1)%mpiSize);
+
+    tausch.packSendBuffer(0, 0, in.data());
+    tausch.packSendBuffer(1, 0, in.data());
+
+    std::vector<Status> status = tausch.sendAggregated({0, 1}, 6);
+    tausch.recvAggregated({0, 1}, 6);
+
+    for(auto &s : status)
+        s.wait();
+
+    // never reached
+    REQUIRE(false);
+
+}
+
+#endif
@@ -5,7 +5,8 @@
 int main(int argc, char** argv) {
 
     int provided;
-    MPI_Init_thread(&argc, &argv, MPI_THREAD_SERIALIZED, &provided);
+    // the thread safety tests need MPI_THREAD_MULTIPLE, they check what is provided
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &provided);
 
     int mpiRank, mpiSize;
     MPI_Comm_rank(MPI_COMM_WORLD, &mpiRank);
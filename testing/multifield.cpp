@@ -0,0 +1,155 @@
+#include <catch2/catch.hpp>
+#include "../tausch.h"
+
+// the tests in here pack and unpack all buffers of a halo at once and use the CPU code path only
+#if defined(TEST_SEND_TAUSCH_CPU) && defined(TEST_RECV_TAUSCH_CPU)
+
+TEST_CASE("3 buffers, packSendBuffers/unpackRecvBuffers, multiple MPI ranks") {
+
+    std::cout << " * Test: " << "3 buffers, packSendBuffers/unpackRecvBuffers, multiple MPI ranks" << std::endl;
+
+    const int size = 30;
+
+    int mpiRank, mpiSize;
+    MPI_Comm_rank(MPI_COMM_WORLD, &mpiRank);
+    MPI_Comm_size(MPI_COMM_WORLD, &mpiSize);
+
+    const int sendRank = (mpiRank+1)%mpiSize;
+    const int recvRank = (mpiRank+mpiSize-1)%mpiSize;
+
+    // two rows (copied row by row), every third element (packed through element offsets)
+    std::vector<int> rows, fragmented;
+    for(int i = 0; i < 2*size; ++i)
+        rows.push_back(size + i);
+    for(int i = 0; i < size*size; i += 3)
+        fragmented.push_back(i);
+
+    for(auto layout : {rows, fragmented}) {
+
+        // all buffers share the same indices, or the last buffer has its own
+        for(bool uniform : {true, false}) {
+
+            // the buffers are handled by the calling thread, or split up between two threads
+            for(bool parallel : {false, true}) {
+
+                Tausch tausch(MPI_COMM_WORLD, false);
+                if(parallel)
+                    tausch.setMultiFieldParallelThreshold(0, 2);
+
+                std::vector<std::vector<int> > indices = {layout, layout, (uniform ? layout : rows)};
+
+                tausch.addSendHaloInfos(indices, {sizeof(double), sizeof(double), sizeof(double)}, sendRank);
+                tausch.addRecvHaloInfos(indices, {sizeof(double), sizeof(double), sizeof(double)}, recvRank);
+
+                std::vector<std::vector<double> > in(3, std::vector<double>(size*size)), out(3, std::vector<double>(size*size, 0));
+                for(int b = 0; b < 3; ++b)
+                    for(int i = 0; i < size*size; ++i)
+                        in[b][i] = mpiRank*100000 + b*10000 + i;
+
+                tausch.packSendBuffers(0, std::vector<const double*>{in[0].data(), in[1].data(), in[2].data()});
+
+                Status status = tausch.send(0, 0);
+                tausch.recv(0, 0);
+
+                status.wait();
+
+                tausch.unpackRecvBuffers(0, std::vector<double*>{out[0].data(), out[1].data(), out[2].data()});
+
+                for(int b = 0; b < 3; ++b) {
+                    for(int i = 0; i < size*size; ++i) {
+                        if(std::find(indices[b].begin(), indices[b].end(), i) != indices[b].end())
+                            REQUIRE(out[b][i] == recvRank*100000 + b*10000 + i);
+                        else
+                            REQUIRE(out[b][i] == 0);
+                    }
+                }
+
+                MPI_Barrier(MPI_COMM_WORLD);
+
+            }
+
+        }
+
+    }
+
+}
+
+TEST_CASE("2 buffers, cache-aware packing and unpacking forced on, multiple MPI ranks") {
+
+    std::cout << " * Test: " << "2 buffers, cache-aware packing and unpacking forced on, multiple MPI ranks" << std::endl;
+
+    const int size = 40;
+
+    int mpiRank, mpiSize;
+    MPI_Comm_rank(MPI_COMM_WORLD, &mpiRank);
+    MPI_Comm_size(MPI_COMM_WORLD, &mpiSize);
+
+    const int sendRank = (mpiRank+1)%mpiSize;
+    const int recvRank = (mpiRank+mpiSize-1)%mpiSize;
+
+    // rows of odd lengths at odd offsets, i.e., unaligned heads and tails of the non-temporal stores
+    std::vector<std::array<int, 4> > regions = {{3, 13, 20, size}, {805, 1, 7, size}, {1201, 37, 2, size}};
+
+    std::vector<std::vector<double> > inDouble(2, std::vector<double>(size*size));
+    std::vector<std::vector<unsigned char> > inChar(2, std::vector<unsigned char>(size*size));
+    for(int b = 0; b < 2; ++b) {
+        for(int i = 0; i < size*size; ++i) {
+            inDouble[b][i] = mpiRank*100000 + b*10000 + i;
+            inChar[b][i] = (mpiRank*31 + b*7 + i)%251;
+        }
+    }
+
+    // halo 0 (doubles) is packed buffer by buffer, halo 1 (bytes) all buffers at once
+    auto exchange = [&](const bool forced, std::vector<std::vector<double> > &outDouble, std::vector<std::vector<unsigned char> > &outChar) {
+
+        Tausch tausch(MPI_COMM_WORLD, false);
+        if(forced)
+            tausch.setCacheAwareThresholds(0, 0, 1);
+
+        tausch.addSendHaloInfos(regions, sizeof(double), 2, sendRank);
+        tausch.addRecvHaloInfos(regions, sizeof(double), 2, recvRank);
+        tausch.addSendHaloInfos(regions, 1, 2, sendRank);
+        tausch.addRecvHaloInfos(regions, 1, 2, recvRank);
+
+        for(int b = 0; b < 2; ++b)
+            tausch.packSendBuffer(0, b, inDouble[b].data());
+        tausch.packSendBuffers(1, std::vector<const unsigned char*>{inChar[0].data(), inChar[1].data()});
+
+        std::vector<Status> status;
+        status.push_back(tausch.send(0, 0));
+        status.push_back(tausch.send(1, 1));
+        tausch.recv(0, 0);
+        tausch.recv(1, 1);
+        for(auto &s : status)
+            s.wait();
+
+        for(int b = 0; b < 2; ++b)
+            tausch.unpackRecvBuffer(0, b, outDouble[b].data());
+        tausch.unpackRecvBuffers(1, std::vector<unsigned char*>{outChar[0].data(), outChar[1].data()});
+
+    };
+
+    std::vector<std::vector<double> > defaultDouble(2, std::vector<double>(size*size, 0)), forcedDouble(2, std::vector<double>(size*size, 0));
+    std::vector<std::vector<unsigned char> > defaultChar(2, std::vector<unsigned char>(size*size, 0)), forcedChar(2, std::vector<unsigned char>(size*size, 0));
+
+    exchange(false, defaultDouble, defaultChar);
+    exchange(true, forcedDouble, forcedChar);
+
+    std::vector<bool> inHalo(size*size, false);
+    for(auto const & region : regions)
+        for(int row = 0; row < region[2]; ++row)
+            for(int col = 0; col < region[1]; ++col)
+                inHalo[region[0] + row*region[3] + col] = true;
+
+    for(int b = 0; b < 2; ++b) {
+        for(int i = 0; i < size*size; ++i) {
+            REQUIRE(forcedDouble[b][i] == defaultDouble[b][i]);
+            REQUIRE(forcedChar[b][i] == defaultChar[b][i]);
+            REQUIRE(forcedDouble[b][i] == (inHalo[i] ? recvRank*100000 + b*10000 + i : 0));
+            REQUIRE(static_cast<int>(forcedChar[b][i]) == (inHalo[i] ? (recvRank*31 + b*7 + i)%251 : 0));
+        }
+    }
+
+}
+
+#endif
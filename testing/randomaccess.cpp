@@ -329,3 +329,56 @@ TEST_CASE("1 buffer, random indices, with pack/unpack, multiple MPI ranks") {
     }
 
 }
+
+TEST_CASE("2 neighbours, locality renumbering of scattered halos") {
+
+    std::cout << " * Test: " << "2 neighbours, locality renumbering of scattered halos" << std::endl;
+
+    const int numLocal = 20;
+
+    // entry 7 is sent to both neighbours, the ghost entries are scattered as well
+    std::vector<std::vector<int> > sendIndices = {{3, 7, 12}, {7, 15, 2}};
+    std::vector<std::vector<int> > recvIndices = {{18, 5}, {10, 19, 0}};
+
+    std::vector<int> permutation = Tausch::computeLocalityRenumbering(numLocal, sendIndices, recvIndices);
+
+    // every new index is used exactly once
+    REQUIRE(permutation.size() == numLocal);
+    std::vector<int> seen(numLocal, 0);
+    for(auto ind : permutation) {
+        REQUIRE(ind >= 0);
+        REQUIRE(ind < numLocal);
+        ++seen[ind];
+    }
+    for(auto count : seen)
+        REQUIRE(count == 1);
+
+    // data moved to the new numbering is found through the renumbered index lists
+    std::vector<double> data(numLocal), renumbered(numLocal);
+    for(int i = 0; i < numLocal; ++i) {
+        data[i] = 100 + i;
+        renumbered[permutation[i]] = data[i];
+    }
+    for(auto const & lists : {sendIndices, recvIndices}) {
+        for(auto const & indices : lists) {
+            std::vector<int> newIndices = Tausch::applyRenumbering(permutation, indices);
+            REQUIRE(newIndices.size() == indices.size());
+            for(size_t i = 0; i < indices.size(); ++i)
+                REQUIRE(renumbered[newIndices[i]] == data[indices[i]]);
+        }
+    }
+
+    // the ghost entries of each neighbour are contiguous, so are the owned ones of the first neighbour
+    for(auto const & indices : {sendIndices[0], recvIndices[0], recvIndices[1]}) {
+        std::vector<int> newIndices = Tausch::applyRenumbering(permutation, indices);
+        for(size_t i = 1; i < newIndices.size(); ++i)
+            REQUIRE(newIndices[i] == newIndices[i-1]+1);
+    }
+
+    // invalid input is rejected
+    REQUIRE(Tausch::computeLocalityRenumbering(-1, sendIndices, recvIndices).size() == 0);
+    REQUIRE(Tausch::computeLocalityRenumbering(numLocal, {{3, numLocal}}, recvIndices).size() == 0);
+    REQUIRE(Tausch::computeLocalityRenumbering(numLocal, sendIndices, {{-1}}).size() == 0);
+    REQUIRE(Tausch::applyRenumbering(permutation, {numLocal}).size() == 0);
+
+}
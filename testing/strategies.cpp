@@ -0,0 +1,991 @@
+#include <catch2/catch.hpp>
+#include "../tausch.h"
+
+// the tests in here exercise communication strategies of the CPU code path only
+#if defined(TEST_SEND_TAUSCH_CPU) && defined(TEST_RECV_TAUSCH_CPU)
+
+TEST_CASE("2 buffers, DerivedMpiDatatypeSingleMessage, multiple MPI ranks") {
+
+    std::cout << " * Test: " << "2 buffers, DerivedMpiDatatypeSingleMessage, multiple MPI ranks" << std::endl;
+
+    const int size = 10;
+
+    int mpiRank, mpiSize;
+    MPI_Comm_rank(MPI_COMM_WORLD, &mpiRank);
+    MPI_Comm_size(MPI_COMM_WORLD, &mpiSize);
+
+    const int sendRank = (mpiRank+1)%mpiSize;
+    const int recvRank = (mpiRank+mpiSize-1)%mpiSize;
+
+    // the combined datatype has the same wire layout as the packed buffer
+    for(auto recvStrategy : {Tausch::Communication::DerivedMpiDatatypeSingleMessage, Tausch::Communication::Default}) {
+
+        Tausch tausch(MPI_COMM_WORLD, false);
+
+        std::vector<double> in1(size*size), in2(size*size);
+        std::vector<double> out1(size*size, 0), out2(size*size, 0);
+        for(int i = 0; i < size*size; ++i) {
+            in1[i] = mpiRank*1000 + i;
+            in2[i] = -(mpiRank*1000 + i);
+        }
+
+        // the first row is sent, the last row is received
+        std::vector<std::array<int, 4> > sendIndices = {{0, size, 1, size}};
+        std::vector<std::array<int, 4> > recvIndices = {{size*(size-1), size, 1, size}};
+
+        tausch.addSendHaloInfos(sendIndices, sizeof(double), 2, sendRank);
+        tausch.addRecvHaloInfos(recvIndices, sizeof(double), 2, recvRank);
+
+        tausch.setSendCommunicationStrategy(0, Tausch::Communication::DerivedMpiDatatypeSingleMessage);
+        tausch.setRecvCommunicationStrategy(0, recvStrategy);
+
+        tausch.setSendHaloBuffer(0, 0, in1.data());
+        tausch.setSendHaloBuffer(0, 1, in2.data());
+        if(recvStrategy == Tausch::Communication::DerivedMpiDatatypeSingleMessage) {
+            tausch.setRecvHaloBuffer(0, 0, out1.data());
+            tausch.setRecvHaloBuffer(0, 1, out2.data());
+        }
+
+        Status status = tausch.send(0, 0);
+        tausch.recv(0, 0);
+
+        status.wait();
+
+        if(recvStrategy == Tausch::Communication::Default) {
+            tausch.unpackRecvBuffer(0, 0, out1.data());
+            tausch.unpackRecvBuffer(0, 1, out2.data());
+        }
+
+        for(int i = 0; i < size*size; ++i) {
+            if(i >= size*(size-1)) {
+                REQUIRE(out1[i] == recvRank*1000 + (i-size*(size-1)));
+                REQUIRE(out2[i] == -(recvRank*1000 + (i-size*(size-1))));
+            } else {
+                REQUIRE(out1[i] == 0);
+                REQUIRE(out2[i] == 0);
+            }
+        }
+
+    }
+
+}
+
+TEST_CASE("2 buffers, striped halo, multiple MPI ranks") {
+
+    std::cout << " * Test: " << "2 buffers, striped halo, multiple MPI ranks" << std::endl;
+
+    const int size = 13;
+    const int halowidth = 3;
+
+    int mpiRank, mpiSize;
+    MPI_Comm_rank(MPI_COMM_WORLD, &mpiRank);
+    MPI_Comm_size(MPI_COMM_WORLD, &mpiSize);
+
+    const int sendRank = (mpiRank+1)%mpiSize;
+    const int recvRank = (mpiRank+mpiSize-1)%mpiSize;
+
+    // the chunks are either unpacked as they arrive or all at once after the receive completed
+    for(bool unpackStriped : {true, false}) {
+
+        Tausch tausch(MPI_COMM_WORLD, false);
+        tausch.setupCommunicatorPool(2);
+
+        std::vector<double> in1(size*size), in2(size*size);
+        std::vector<double> out1(size*size, 0), out2(size*size, 0);
+        for(int i = 0; i < size*size; ++i) {
+            in1[i] = mpiRank*1000 + i;
+            in2[i] = -(mpiRank*1000 + i);
+        }
+
+        // the chunk boundaries end up in the middle of rows and of buffers
+        std::vector<std::array<int, 4> > sendIndices = {{1, size-2, halowidth, size}};
+        std::vector<std::array<int, 4> > recvIndices = {{size*(size-halowidth)+1, size-2, halowidth, size}};
+
+        tausch.addSendHaloInfos(sendIndices, sizeof(double), 2, sendRank);
+        tausch.addRecvHaloInfos(recvIndices, sizeof(double), 2, recvRank);
+
+        tausch.setSendStriping(0, 4, 0);
+        tausch.setRecvStriping(0, 4, 0);
+
+        REQUIRE(tausch.isStriped(true, 0));
+        REQUIRE(tausch.isStriped(false, 0));
+
+        tausch.packSendBuffer(0, 0, in1.data());
+        tausch.packSendBuffer(0, 1, in2.data());
+
+        Status status = tausch.send(0, 0);
+        tausch.recv(0, 0, -1, -1, !unpackStriped);
+
+        if(unpackStriped)
+            tausch.unpackRecvBufferStriped(0, {reinterpret_cast<unsigned char*>(out1.data()), reinterpret_cast<unsigned char*>(out2.data())});
+        else {
+            tausch.unpackRecvBuffer(0, 0, out1.data());
+            tausch.unpackRecvBuffer(0, 1, out2.data());
+        }
+
+        status.wait();
+
+        for(int i = 0; i < size*size; ++i) {
+            const int row = i/size;
+            const int col = i%size;
+            if(row >= size-halowidth && col >= 1 && col < size-1) {
+                const int sent = (row-(size-halowidth))*size + col;
+                REQUIRE(out1[i] == recvRank*1000 + sent);
+                REQUIRE(out2[i] == -(recvRank*1000 + sent));
+            } else {
+                REQUIRE(out1[i] == 0);
+                REQUIRE(out2[i] == 0);
+            }
+        }
+
+    }
+
+}
+
+TEST_CASE("2 buffers, fragmented halo packed through element offsets, multiple MPI ranks") {
+
+    std::cout << " * Test: " << "2 buffers, fragmented halo packed through element offsets, multiple MPI ranks" << std::endl;
+
+    const int size = 200;
+
+    int mpiRank, mpiSize;
+    MPI_Comm_rank(MPI_COMM_WORLD, &mpiRank);
+    MPI_Comm_size(MPI_COMM_WORLD, &mpiSize);
+
+    const int sendRank = (mpiRank+1)%mpiSize;
+    const int recvRank = (mpiRank+mpiSize-1)%mpiSize;
+
+    // single elements and pairs at irregular distances, i.e., too fragmented to be packed row by row
+    std::vector<int> indices;
+    for(int i = 0; i < size; i += 3 + i%4) {
+        indices.push_back(i);
+        if(i%5 == 0 && i+1 < size)
+            indices.push_back(i+1);
+    }
+
+    // the default strategy packs through the element offsets, the derived datatypes are built from the regions rebuilt from them
+    for(auto strategy : {Tausch::Communication::Default, Tausch::Communication::DerivedMpiDatatype}) {
+
+        Tausch tausch(MPI_COMM_WORLD, false);
+
+        std::vector<double> in1(size), in2(size);
+        std::vector<double> out1(size, 0), out2(size, 0);
+        for(int i = 0; i < size; ++i) {
+            in1[i] = mpiRank*1000 + i;
+            in2[i] = -(mpiRank*1000 + i);
+        }
+
+        tausch.addSendHaloInfos(indices, sizeof(double), 2, sendRank);
+        tausch.addRecvHaloInfos(indices, sizeof(double), 2, recvRank);
+
+        tausch.setSendCommunicationStrategy(0, strategy);
+        tausch.setRecvCommunicationStrategy(0, strategy);
+
+        if(strategy == Tausch::Communication::DerivedMpiDatatype) {
+            tausch.setSendHaloBuffer(0, 0, in1.data());
+            tausch.setSendHaloBuffer(0, 1, in2.data());
+            tausch.setRecvHaloBuffer(0, 0, out1.data());
+            tausch.setRecvHaloBuffer(0, 1, out2.data());
+        } else {
+            tausch.packSendBuffer(0, 0, in1.data());
+            tausch.packSendBuffer(0, 1, in2.data());
+        }
+
+        std::vector<Status> status;
+        for(int bufferId = 0; bufferId < 2; ++bufferId)
+            status.push_back(tausch.send(0, bufferId, -1, bufferId));
+        for(int bufferId = 0; bufferId < 2; ++bufferId)
+            tausch.recv(0, bufferId, -1, bufferId);
+
+        for(auto &s : status)
+            s.wait();
+
+        if(strategy == Tausch::Communication::Default) {
+            tausch.unpackRecvBuffer(0, 0, out1.data());
+            tausch.unpackRecvBuffer(0, 1, out2.data());
+        }
+
+        for(int i = 0; i < size; ++i) {
+            if(std::find(indices.begin(), indices.end(), i) != indices.end()) {
+                REQUIRE(out1[i] == recvRank*1000 + i);
+                REQUIRE(out2[i] == -(recvRank*1000 + i));
+            } else {
+                REQUIRE(out1[i] == 0);
+                REQUIRE(out2[i] == 0);
+            }
+        }
+
+        MPI_Barrier(MPI_COMM_WORLD);
+
+    }
+
+}
+
+TEST_CASE("1 buffer, ring of send buffers, multiple MPI ranks") {
+
+    std::cout << " * Test: " << "1 buffer, ring of send buffers, multiple MPI ranks" << std::endl;
+
+    // large enough to not be sent eagerly, i.e., the staging buffer stays in use until received
+    const int size = 20000;
+    const int depth = 3;
+
+    int mpiRank, mpiSize;
+    MPI_Comm_rank(MPI_COMM_WORLD, &mpiRank);
+    MPI_Comm_size(MPI_COMM_WORLD, &mpiSize);
+
+    const int sendRank = (mpiRank+1)%mpiSize;
+    const int recvRank = (mpiRank+mpiSize-1)%mpiSize;
+
+    for(auto strategy : {Tausch::Communication::Default, Tausch::Communication::MPIPersistent}) {
+
+        Tausch tausch(MPI_COMM_WORLD, false);
+
+        std::vector<int> indices(size);
+        for(int i = 0; i < size; ++i)
+            indices[i] = i;
+
+        tausch.addSendHaloInfo(indices, sizeof(double), sendRank);
+        tausch.addRecvHaloInfo(indices, sizeof(double), recvRank);
+
+        tausch.setSendCommunicationStrategy(0, strategy);
+        tausch.setRecvCommunicationStrategy(0, strategy);
+        tausch.setSendBufferRing(0, depth);
+
+        std::vector<double> in(size), out(size);
+
+        // every round packs and sends depth-1 steps (moving on to the next buffer waits for the send
+        // posted depth-1 sends earlier) before any of them is received, later rounds reuse the buffers
+        for(int round = 0; round < depth; ++round) {
+
+            std::vector<Status> status;
+            for(int step = 0; step < depth-1; ++step) {
+                for(int i = 0; i < size; ++i)
+                    in[i] = (round*depth + step)*1000000 + mpiRank*100000 + i;
+                tausch.packSendBuffer(0, 0, in.data());
+                status.push_back(tausch.send(0, 0));
+            }
+
+            for(int step = 0; step < depth-1; ++step) {
+                tausch.recv(0, 0);
+                tausch.unpackRecvBuffer(0, 0, out.data());
+                for(int i = 0; i < size; ++i)
+                    REQUIRE(out[i] == (round*depth + step)*1000000 + recvRank*100000 + i);
+            }
+
+            for(auto &s : status)
+                s.wait();
+
+            MPI_Barrier(MPI_COMM_WORLD);
+
+        }
+
+    }
+
+}
+
+TEST_CASE("2 buffers, auto-rearmed persistent receives, multiple MPI ranks") {
+
+    std::cout << " * Test: " << "2 buffers, auto-rearmed persistent receives, multiple MPI ranks" << std::endl;
+
+    const int size = 50;
+
+    int mpiRank, mpiSize;
+    MPI_Comm_rank(MPI_COMM_WORLD, &mpiRank);
+    MPI_Comm_size(MPI_COMM_WORLD, &mpiSize);
+
+    const int sendRank = (mpiRank+1)%mpiSize;
+    const int recvRank = (mpiRank+mpiSize-1)%mpiSize;
+
+    // the buffers are unpacked one by one or all at once, both rearm the receive after the last one
+    for(bool unpackAll : {false, true}) {
+
+        // the receive left armed at the end is only cancelled once this instance is destroyed, i.e.,
+        // it might match the first message of the next instance if both used the same tag
+        const int msgtag = (unpackAll ? 8 : 7);
+
+        Tausch tausch(MPI_COMM_WORLD, false);
+
+        std::vector<int> indices(size);
+        for(int i = 0; i < size; ++i)
+            indices[i] = i;
+
+        tausch.addSendHaloInfos(indices, sizeof(double), 2, sendRank);
+        tausch.addRecvHaloInfos(indices, sizeof(double), 2, recvRank);
+
+        tausch.setSendCommunicationStrategy(0, Tausch::Communication::MPIPersistent);
+        tausch.setRecvCommunicationStrategy(0, Tausch::Communication::MPIPersistent);
+        tausch.setRecvAutoRearm(0);
+
+        std::vector<double> in1(size), in2(size), out1(size), out2(size);
+
+        for(int iter = 0; iter < 4; ++iter) {
+
+            for(int i = 0; i < size; ++i) {
+                in1[i] = iter*10000 + mpiRank*1000 + i;
+                in2[i] = -(iter*10000 + mpiRank*1000 + i);
+            }
+            tausch.packSendBuffer(0, 0, in1.data());
+            tausch.packSendBuffer(0, 1, in2.data());
+
+            Status status = tausch.send(0, msgtag);
+            status.wait();
+            MPI_Barrier(MPI_COMM_WORLD);
+
+            // from the second iteration on the receive has been restarted by the previous unpacking
+            // and has matched the message, it is thus not visible to a probe
+            if(iter > 0) {
+                int flag;
+                MPI_Iprobe(recvRank, msgtag, MPI_COMM_WORLD, &flag, MPI_STATUS_IGNORE);
+                REQUIRE(flag == 0);
+            }
+
+            tausch.recv(0, msgtag);
+
+            if(unpackAll)
+                tausch.unpackRecvBuffers(0, std::vector<double*>{out1.data(), out2.data()});
+            else {
+                tausch.unpackRecvBuffer(0, 0, out1.data());
+                tausch.unpackRecvBuffer(0, 1, out2.data());
+            }
+
+            for(int i = 0; i < size; ++i) {
+                REQUIRE(out1[i] == iter*10000 + recvRank*1000 + i);
+                REQUIRE(out2[i] == -(iter*10000 + recvRank*1000 + i));
+            }
+
+            MPI_Barrier(MPI_COMM_WORLD);
+
+        }
+
+    }
+
+}
+
+TEST_CASE("2 halos, channels combined with a striped halo, multiple MPI ranks") {
+
+    std::cout << " * Test: " << "2 halos, channels combined with a striped halo, multiple MPI ranks" << std::endl;
+
+    const int size = 1000;
+
+    int mpiRank, mpiSize;
+    MPI_Comm_rank(MPI_COMM_WORLD, &mpiRank);
+    MPI_Comm_size(MPI_COMM_WORLD, &mpiSize);
+
+    const int sendRank = (mpiRank+1)%mpiSize;
+    const int recvRank = (mpiRank+mpiSize-1)%mpiSize;
+
+    Tausch tausch(MPI_COMM_WORLD, false);
+
+    // the channels use their own communicators, setting them up does not affect the striping pool
+    tausch.setupCommunicatorPool(2);
+    tausch.setupChannels(3);
+
+    std::vector<int> indices(size);
+    for(int i = 0; i < size; ++i)
+        indices[i] = i;
+
+    // halo 0 is striped, halo 1 is not
+    for(int h = 0; h < 2; ++h) {
+        tausch.addSendHaloInfo(indices, sizeof(double), sendRank);
+        tausch.addRecvHaloInfo(indices, sizeof(double), recvRank);
+    }
+    tausch.setSendStriping(0, 4, 0);
+    tausch.setRecvStriping(0, 4, 0);
+
+    std::vector<std::vector<double> > in(2, std::vector<double>(size)), out(2, std::vector<double>(size));
+
+    for(int iter = 0; iter < 3; ++iter) {
+
+        // setting up the channels again in between must not break the striped halo
+        if(iter == 1)
+            tausch.setupChannels(2);
+
+        std::vector<Status> status;
+        for(int h = 0; h < 2; ++h) {
+            for(int i = 0; i < size; ++i)
+                in[h][i] = iter*100000 + mpiRank*1000 + h*100 + i;
+            tausch.packSendBuffer(h, 0, in[h].data());
+            status.push_back(tausch.send(h, h));
+        }
+        for(int h = 0; h < 2; ++h)
+            tausch.recv(h, h);
+
+        for(auto &s : status)
+            s.wait();
+
+        for(int h = 0; h < 2; ++h) {
+            tausch.unpackRecvBuffer(h, 0, out[h].data());
+            for(int i = 0; i < size; ++i)
+                REQUIRE(out[h][i] == iter*100000 + recvRank*1000 + h*100 + i);
+        }
+
+        MPI_Barrier(MPI_COMM_WORLD);
+
+    }
+
+}
+
+TEST_CASE("1 buffer, network emulation delaying completion, multiple MPI ranks") {
+
+    std::cout << " * Test: " << "1 buffer, network emulation delaying completion, multiple MPI ranks" << std::endl;
+
+    const int size = 100;
+    const double latency = 0.5;
+
+    int mpiRank, mpiSize;
+    MPI_Comm_rank(MPI_COMM_WORLD, &mpiRank);
+    MPI_Comm_size(MPI_COMM_WORLD, &mpiSize);
+
+    const int sendRank = (mpiRank+1)%mpiSize;
+    const int recvRank = (mpiRank+mpiSize-1)%mpiSize;
+
+    Tausch tausch(MPI_COMM_WORLD, false);
+
+    std::vector<int> indices(size);
+    for(int i = 0; i < size; ++i)
+        indices[i] = i;
+    tausch.addSendHaloInfo(indices, sizeof(double), sendRank);
+    tausch.addRecvHaloInfo(indices, sizeof(double), recvRank);
+
+    // every rank is a node of its own, only the message to itself (with a single rank) is not delayed
+    tausch.setNetworkEmulation(latency, 1e12, 1);
+
+    std::vector<double> in(size), out(size);
+    for(int i = 0; i < size; ++i)
+        in[i] = mpiRank*1000 + i;
+
+    tausch.packSendBuffer(0, 0, in.data());
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    const auto start = std::chrono::steady_clock::now();
+
+    Status sendStatus = tausch.send(0, 0);
+    Status recvStatus = tausch.recv(0, 0, -1, -1, false);
+
+    // the message itself has arrived long before the modeled latency is over
+    const bool completedEarly = recvStatus.isCompleted();
+
+    recvStatus.wait();
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+    sendStatus.wait();
+
+    tausch.unpackRecvBuffer(0, 0, out.data());
+
+    // without emulation the next message is not held back anymore
+    tausch.disableNetworkEmulation();
+    MPI_Barrier(MPI_COMM_WORLD);
+    tausch.packSendBuffer(0, 0, in.data());
+    Status status = tausch.send(0, 1);
+    tausch.recv(0, 1);
+    status.wait();
+
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    for(int i = 0; i < size; ++i)
+        REQUIRE(out[i] == recvRank*1000 + i);
+
+    if(mpiSize > 1) {
+        REQUIRE_FALSE(completedEarly);
+        // the ranks leave the barrier at slightly different times
+        REQUIRE(elapsed >= 0.8*latency);
+    }
+
+}
+
+TEST_CASE("2 halos, prewarm before the first exchange, multiple MPI ranks") {
+
+    std::cout << " * Test: " << "2 halos, prewarm before the first exchange, multiple MPI ranks" << std::endl;
+
+    const int size = 10;
+
+    int mpiRank, mpiSize;
+    MPI_Comm_rank(MPI_COMM_WORLD, &mpiRank);
+    MPI_Comm_size(MPI_COMM_WORLD, &mpiSize);
+
+    const int sendRank = (mpiRank+1)%mpiSize;
+    const int recvRank = (mpiRank+mpiSize-1)%mpiSize;
+
+    // halo 0 is packed into the staging buffer, halo 1 is sent straight from its buffers
+    for(auto strategy : {Tausch::Communication::Default, Tausch::Communication::MPIPersistent}) {
+
+        Tausch tausch(MPI_COMM_WORLD, false);
+
+        std::vector<int> indices(size);
+        for(int i = 0; i < size; ++i)
+            indices[i] = i;
+        std::vector<std::array<int, 4> > rows = {{0, size, 1, size}};
+
+        tausch.addSendHaloInfo(indices, sizeof(double), sendRank);
+        tausch.addRecvHaloInfo(indices, sizeof(double), recvRank);
+        tausch.addSendHaloInfos(rows, sizeof(double), 2, sendRank);
+        tausch.addRecvHaloInfos(rows, sizeof(double), 2, recvRank);
+
+        tausch.setSendCommunicationStrategy(0, strategy);
+        tausch.setRecvCommunicationStrategy(0, strategy);
+        tausch.setSendCommunicationStrategy(1, Tausch::Communication::DerivedMpiDatatypeSingleMessage);
+        tausch.setRecvCommunicationStrategy(1, Tausch::Communication::DerivedMpiDatatypeSingleMessage);
+
+        std::vector<double> in(size), out(size);
+        std::vector<std::vector<double> > in1(2, std::vector<double>(size)), out1(2, std::vector<double>(size));
+        for(int b = 0; b < 2; ++b) {
+            tausch.setSendHaloBuffer(1, b, in1[b].data());
+            tausch.setRecvHaloBuffer(1, b, out1[b].data());
+        }
+
+        // sets up the persistent requests of halo 0 and the combined datatypes of halo 1
+        tausch.prewarm({{0, 3}, {1, 4}}, {{0, 3}, {1, 4}});
+
+        // the first exchange right after prewarming uses the resources set up by it
+        for(int iter = 0; iter < 3; ++iter) {
+
+            for(int i = 0; i < size; ++i) {
+                in[i] = iter*10000 + mpiRank*100 + i;
+                for(int b = 0; b < 2; ++b)
+                    in1[b][i] = -(iter*10000 + mpiRank*100 + b*size + i);
+            }
+
+            tausch.packSendBuffer(0, 0, in.data());
+
+            std::vector<Status> status;
+            status.push_back(tausch.send(0, 3));
+            status.push_back(tausch.send(1, 4));
+            tausch.recv(0, 3);
+            tausch.recv(1, 4);
+
+            for(auto &s : status)
+                s.wait();
+
+            tausch.unpackRecvBuffer(0, 0, out.data());
+
+            MPI_Barrier(MPI_COMM_WORLD);
+
+            for(int i = 0; i < size; ++i) {
+                REQUIRE(out[i] == iter*10000 + recvRank*100 + i);
+                for(int b = 0; b < 2; ++b)
+                    REQUIRE(out1[b][i] == -(iter*10000 + recvRank*100 + b*size + i));
+            }
+
+        }
+
+    }
+
+}
+
+TEST_CASE("1 buffer, staging buffers moved while messages are in flight, multiple MPI ranks") {
+
+    std::cout << " * Test: " << "1 buffer, staging buffers moved while messages are in flight, multiple MPI ranks" << std::endl;
+
+    // large enough to not be sent eagerly, i.e., the staging buffer stays in use until received
+    const int size = 20000;
+
+    int mpiRank, mpiSize;
+    MPI_Comm_rank(MPI_COMM_WORLD, &mpiRank);
+    MPI_Comm_size(MPI_COMM_WORLD, &mpiSize);
+
+    const int sendRank = (mpiRank+1)%mpiSize;
+    const int recvRank = (mpiRank+mpiSize-1)%mpiSize;
+
+    for(auto strategy : {Tausch::Communication::Default, Tausch::Communication::MPIPersistent}) {
+
+        Tausch tausch(MPI_COMM_WORLD, false);
+
+        std::vector<int> indices(size);
+        for(int i = 0; i < size; ++i)
+            indices[i] = i;
+
+        tausch.addSendHaloInfo(indices, sizeof(double), sendRank);
+        tausch.addRecvHaloInfo(indices, sizeof(double), recvRank);
+
+        tausch.setSendCommunicationStrategy(0, strategy);
+        tausch.setRecvCommunicationStrategy(0, strategy);
+
+        // nothing has been sent or received yet
+        tausch.setSendHaloNumaNode(0, 0, false);
+        tausch.setRecvHaloNumaNode(0, 0, false);
+
+        std::vector<double> in(size), out(size);
+
+        for(int iter = 0; iter < 3; ++iter) {
+
+            for(int i = 0; i < size; ++i)
+                in[i] = iter*1000000 + mpiRank*100000 + i;
+
+            tausch.packSendBuffer(0, 0, in.data());
+            Status sendStatus = tausch.send(0, 0);
+            Status recvStatus = tausch.recv(0, 0, -1, -1, false);
+
+            // both staging buffers are still in use by MPI, node 0 exists on every system
+            tausch.setSendHaloNumaNode(0, 0, false);
+            tausch.setRecvHaloNumaNode(0, 0, false);
+
+            sendStatus.wait();
+            recvStatus.wait();
+
+            tausch.unpackRecvBuffer(0, 0, out.data());
+
+            MPI_Barrier(MPI_COMM_WORLD);
+
+            for(int i = 0; i < size; ++i)
+                REQUIRE(out[i] == iter*1000000 + recvRank*100000 + i);
+
+        }
+
+    }
+
+}
+
+TEST_CASE("1 buffer, strategies applied from the strategy cache, multiple MPI ranks") {
+
+    std::cout << " * Test: " << "1 buffer, strategies applied from the strategy cache, multiple MPI ranks" << std::endl;
+
+    const int size = 10;
+    const std::string filename = "tausch_strategies_test.cache";
+
+    int mpiRank, mpiSize;
+    MPI_Comm_rank(MPI_COMM_WORLD, &mpiRank);
+    MPI_Comm_size(MPI_COMM_WORLD, &mpiSize);
+
+    const int sendRank = (mpiRank+1)%mpiSize;
+    const int recvRank = (mpiRank+mpiSize-1)%mpiSize;
+
+    // halos of three sizes in different power-of-two buckets, i.e., three different signatures
+    std::vector<std::vector<int> > indices(3);
+    for(int h = 0; h < 3; ++h)
+        for(int i = 0; i < (1<<(2*h))*size; ++i)
+            indices[h].push_back(i);
+
+    if(mpiRank == 0)
+        std::remove(filename.c_str());
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    // fill the cache and write it to file
+    {
+        Tausch tausch(MPI_COMM_WORLD, false);
+        tausch.setStrategyCache(filename, 2.0, 0);
+        for(int h = 0; h < 3; ++h) {
+            tausch.addSendHaloInfo(indices[h], sizeof(double), sendRank);
+            tausch.addRecvHaloInfo(indices[h], sizeof(double), recvRank);
+        }
+        tausch.storeSendCommunicationStrategy(0, Tausch::Communication::MPIPersistent, 1.0);
+        tausch.storeRecvCommunicationStrategy(0, Tausch::Communication::MPIPersistent, 1.0);
+        tausch.storeSendCommunicationStrategy(1, static_cast<Tausch::Communication>(Tausch::Communication::MPIPersistent|Tausch::Communication::TryDirectCopy), 1.0);
+        tausch.storeRecvCommunicationStrategy(1, static_cast<Tausch::Communication>(Tausch::Communication::MPIPersistent|Tausch::Communication::TryDirectCopy), 1.0);
+        tausch.storeSendCommunicationStrategy(2, Tausch::Communication::DerivedMpiDatatype, 1.0);
+        tausch.storeRecvCommunicationStrategy(2, Tausch::Communication::DerivedMpiDatatype, 1.0);
+        tausch.saveStrategyCache();
+    }
+
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    Tausch tausch(MPI_COMM_WORLD, false);
+    tausch.setStrategyCache(filename, 2.0, 0);
+    for(int h = 0; h < 3; ++h) {
+        tausch.addSendHaloInfo(indices[h], sizeof(double), sendRank);
+        tausch.addRecvHaloInfo(indices[h], sizeof(double), recvRank);
+    }
+
+    std::vector<std::vector<double> > in(3), out(3);
+    for(int h = 0; h < 3; ++h) {
+        in[h].resize(indices[h].size());
+        out[h].resize(indices[h].size());
+        for(size_t i = 0; i < indices[h].size(); ++i)
+            in[h][i] = h*1000 + mpiRank*100 + i;
+    }
+
+    for(int iter = 0; iter < 2; ++iter) {
+        for(int h = 0; h < 3; ++h) {
+            tausch.packSendBuffer(h, 0, in[h].data());
+            tausch.send(h, h);
+        }
+        for(int h = 0; h < 3; ++h) {
+            tausch.recv(h, h);
+            tausch.unpackRecvBuffer(h, 0, out[h].data());
+        }
+    }
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    if(mpiRank == 0)
+        std::remove(filename.c_str());
+
+    // the stored strategy is applied, TryDirectCopy is dropped, a strategy needing setup is not applied
+    REQUIRE(tausch.getCachedSendCommunicationStrategy(0) == Tausch::Communication::MPIPersistent);
+    REQUIRE(tausch.getSendCommunicationStrategy(0) == Tausch::Communication::MPIPersistent);
+    REQUIRE(tausch.getRecvCommunicationStrategy(0) == Tausch::Communication::MPIPersistent);
+    REQUIRE(tausch.getSendCommunicationStrategy(1) == Tausch::Communication::MPIPersistent);
+    REQUIRE(tausch.getRecvCommunicationStrategy(1) == Tausch::Communication::MPIPersistent);
+    REQUIRE(tausch.getSendCommunicationStrategy(2) == Tausch::Communication::Default);
+    REQUIRE(tausch.getRecvCommunicationStrategy(2) == Tausch::Communication::Default);
+
+    for(int h = 0; h < 3; ++h)
+        for(size_t i = 0; i < indices[h].size(); ++i)
+            REQUIRE(out[h][i] == h*1000 + recvRank*100 + i);
+
+}
+
+TEST_CASE("1 buffer, derived datatypes shared between halos, multiple MPI ranks") {
+
+    std::cout << " * Test: " << "1 buffer, derived datatypes shared between halos, multiple MPI ranks" << std::endl;
+
+    const int size = 10;
+
+    int mpiRank, mpiSize;
+    MPI_Comm_rank(MPI_COMM_WORLD, &mpiRank);
+    MPI_Comm_size(MPI_COMM_WORLD, &mpiSize);
+
+    const int sendRank = (mpiRank+1)%mpiSize;
+    const int recvRank = (mpiRank+mpiSize-1)%mpiSize;
+
+    Tausch tausch(MPI_COMM_WORLD, false);
+
+    // halos 0 and 1 have the same layout (the first row), halo 2 sends the last row
+    std::vector<std::array<int, 4> > firstRow = {{0, size, 1, size}};
+    std::vector<std::array<int, 4> > lastRow = {{size*(size-1), size, 1, size}};
+
+    tausch.addSendHaloInfos(firstRow, sizeof(double), 1, sendRank);
+    tausch.addSendHaloInfos(firstRow, sizeof(double), 1, sendRank);
+    tausch.addSendHaloInfos(lastRow, sizeof(double), 1, sendRank);
+    tausch.addRecvHaloInfos(firstRow, sizeof(double), 1, recvRank);
+    tausch.addRecvHaloInfos(firstRow, sizeof(double), 1, recvRank);
+
+    for(int h = 0; h < 3; ++h)
+        tausch.setSendCommunicationStrategy(h, Tausch::Communication::DerivedMpiDatatype);
+    tausch.setRecvCommunicationStrategy(1, Tausch::Communication::DerivedMpiDatatype);
+
+    const MPI_Datatype shared = tausch.getSendHaloDerivedDatatype(0, 0);
+    const bool sameLayoutShared = (tausch.getSendHaloDerivedDatatype(1, 0) == shared && tausch.getRecvHaloDerivedDatatype(1, 0) == shared);
+    const bool otherLayoutDistinct = (tausch.getSendHaloDerivedDatatype(2, 0) != shared);
+
+    // releasing the datatype of halo 0 must not free it while halo 1 still uses it
+    tausch.setSendCommunicationStrategy(0, Tausch::Communication::Default);
+    const bool released = (tausch.getSendHaloDerivedDatatype(0, 0) == MPI_DATATYPE_NULL);
+    int typeSize = 0;
+    MPI_Type_size(tausch.getSendHaloDerivedDatatype(1, 0), &typeSize);
+
+    std::vector<double> in(size*size), out0(size*size, 0), out1(size*size, 0);
+    for(int i = 0; i < size*size; ++i)
+        in[i] = mpiRank*1000 + i;
+
+    tausch.setSendHaloBuffer(1, 0, in.data());
+    tausch.setRecvHaloBuffer(1, 0, out1.data());
+
+    // a derived datatype on one side matches the packed staging buffer on the other side
+    tausch.packSendBuffer(0, 0, in.data());
+    std::vector<Status> status;
+    status.push_back(tausch.send(0, 0));
+    status.push_back(tausch.send(1, 1, -1, 0));
+    tausch.recv(0, 1);
+    tausch.recv(1, 0, -1, 0);
+    for(auto &s : status)
+        s.wait();
+    tausch.unpackRecvBuffer(0, 0, out0.data());
+
+    REQUIRE(shared != MPI_DATATYPE_NULL);
+    REQUIRE(sameLayoutShared);
+    REQUIRE(otherLayoutDistinct);
+    REQUIRE(released);
+    REQUIRE(typeSize == size*static_cast<int>(sizeof(double)));
+
+    for(int i = 0; i < size*size; ++i) {
+        REQUIRE(out0[i] == (i < size ? recvRank*1000 + i : 0));
+        REQUIRE(out1[i] == (i < size ? recvRank*1000 + i : 0));
+    }
+
+}
+
+TEST_CASE("1 buffer, adaptive strategy selection switching strategies, multiple MPI ranks") {
+
+    std::cout << " * Test: " << "1 buffer, adaptive strategy selection switching strategies, multiple MPI ranks" << std::endl;
+
+    const int size = 100;
+    const int numIter = 20;
+
+    int mpiRank, mpiSize;
+    MPI_Comm_rank(MPI_COMM_WORLD, &mpiRank);
+    MPI_Comm_size(MPI_COMM_WORLD, &mpiSize);
+
+    const int sendRank = (mpiRank+1)%mpiSize;
+    const int recvRank = (mpiRank+mpiSize-1)%mpiSize;
+
+    Tausch tausch(MPI_COMM_WORLD, false);
+
+    std::vector<int> indices(size);
+    for(int i = 0; i < size; ++i)
+        indices[i] = i;
+
+    tausch.addSendHaloInfo(indices, sizeof(double), sendRank);
+    tausch.addRecvHaloInfo(indices, sizeof(double), recvRank);
+
+    // every candidate is timed once first, and one of them is re-timed every other message
+    tausch.setSendAdaptiveStrategy(0, {Tausch::Communication::Default, Tausch::Communication::MPIPersistent}, 2);
+    tausch.setRecvAdaptiveStrategy(0, {Tausch::Communication::Default, Tausch::Communication::MPIPersistent}, 2);
+
+    std::vector<double> in(size);
+    std::vector<std::vector<double> > received(numIter, std::vector<double>(size));
+    int sendPersistent = 0, recvPersistent = 0;
+
+    for(int iter = 0; iter < numIter; ++iter) {
+
+        for(int i = 0; i < size; ++i)
+            in[i] = iter*10000 + mpiRank*1000 + i;
+
+        tausch.packSendBuffer(0, 0, in.data());
+        Status status = tausch.send(0, 0);
+        tausch.recv(0, 0);
+        sendPersistent += (tausch.getSendCommunicationStrategy(0) == Tausch::Communication::MPIPersistent);
+        recvPersistent += (tausch.getRecvCommunicationStrategy(0) == Tausch::Communication::MPIPersistent);
+
+        // every other iteration the send is left for the next send (i.e., the switch) to wait for
+        if(iter%2 == 0)
+            status.wait();
+
+        tausch.unpackRecvBuffer(0, 0, received[iter].data());
+
+    }
+
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    // both strategies have been used on both sides
+    REQUIRE(sendPersistent > 0);
+    REQUIRE(sendPersistent < numIter);
+    REQUIRE(recvPersistent > 0);
+    REQUIRE(recvPersistent < numIter);
+
+    for(int iter = 0; iter < numIter; ++iter)
+        for(int i = 0; i < size; ++i)
+            REQUIRE(received[iter][i] == iter*10000 + recvRank*1000 + i);
+
+}
+
+TEST_CASE("4 regions, strategies found by testForBestCommunicationFast, multiple MPI ranks") {
+
+    std::cout << " * Test: " << "4 regions, strategies found by testForBestCommunicationFast, multiple MPI ranks" << std::endl;
+
+    const int size = 64;
+    const int halowidth = 1;
+
+    int mpiRank, mpiSize;
+    MPI_Comm_rank(MPI_COMM_WORLD, &mpiRank);
+    MPI_Comm_size(MPI_COMM_WORLD, &mpiSize);
+
+    const int sendRank = (mpiRank+1)%mpiSize;
+    const int recvRank = (mpiRank+mpiSize-1)%mpiSize;
+
+    std::vector<Tausch::Communication> best = Tausch::testForBestCommunicationFast(MPI_COMM_WORLD, 200, size, halowidth);
+
+    // all ranks have to agree on the result
+    int mine[2] = {best[0], best[1]};
+    int lowest[2], highest[2];
+    MPI_Allreduce(mine, lowest, 2, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+    MPI_Allreduce(mine, highest, 2, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+
+    const bool testable = Tausch::isTestableStrategyCombination(best[0], best[1], mpiSize);
+
+    // exchange the same halo as during testing using the combination found
+    std::vector<std::array<int, 4> > indices = {{0, size, halowidth, size},
+                                                {size*(size-halowidth), size, halowidth, size},
+                                                {size*halowidth, halowidth, size-2*halowidth, size},
+                                                {size*halowidth-2*halowidth, halowidth, size-2*halowidth, size}};
+
+    std::vector<unsigned char> in(size*size), out(size*size, 0);
+    for(int i = 0; i < size*size; ++i)
+        in[i] = (mpiRank*7 + i)%251;
+
+    const bool derivedSend = (best[0] == Tausch::Communication::DerivedMpiDatatype || best[0] == Tausch::Communication::DerivedMpiDatatypeSingleMessage);
+    const bool derivedRecv = (best[1] == Tausch::Communication::DerivedMpiDatatype || best[1] == Tausch::Communication::DerivedMpiDatatypeSingleMessage);
+
+    if(testable) {
+
+        Tausch tausch(MPI_COMM_WORLD, true);
+        tausch.addSendHaloInfo(indices, 1, sendRank);
+        tausch.addRecvHaloInfo(indices, 1, recvRank);
+        tausch.setSendCommunicationStrategy(0, best[0]);
+        tausch.setRecvCommunicationStrategy(0, best[1]);
+        if(derivedSend)
+            tausch.setSendHaloBuffer(0, 0, in.data());
+        if(derivedRecv)
+            tausch.setRecvHaloBuffer(0, 0, out.data());
+
+        // TryDirectCopy copies the packed staging buffer
+        if(!derivedSend)
+            tausch.packSendBuffer(0, 0, in.data());
+        Status status = tausch.send(0, 0, sendRank, (best[0] == Tausch::Communication::DerivedMpiDatatype ? 0 : -1));
+        tausch.recv(0, 0, recvRank, (best[1] == Tausch::Communication::DerivedMpiDatatype ? 0 : -1));
+        status.wait();
+        if(!derivedRecv)
+            tausch.unpackRecvBuffer(0, 0, out.data());
+
+    }
+
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    REQUIRE(best.size() == 2);
+    REQUIRE(lowest[0] == highest[0]);
+    REQUIRE(lowest[1] == highest[1]);
+    REQUIRE(testable);
+
+    for(auto const & region : indices)
+        for(int row = 0; row < region[2]; ++row)
+            for(int col = 0; col < region[1]; ++col) {
+                const int i = region[0] + row*region[3] + col;
+                REQUIRE(static_cast<int>(out[i]) == (recvRank*7 + i)%251);
+            }
+
+}
+
+TEST_CASE("3 halo sizes, calibrated cost model, multiple MPI ranks") {
+
+    std::cout << " * Test: " << "3 halo sizes, calibrated cost model, multiple MPI ranks" << std::endl;
+
+    int mpiRank, mpiSize;
+    MPI_Comm_rank(MPI_COMM_WORLD, &mpiRank);
+    MPI_Comm_size(MPI_COMM_WORLD, &mpiSize);
+
+    const int sendRank = (mpiRank+1)%mpiSize;
+    const int recvRank = (mpiRank+mpiSize-1)%mpiSize;
+
+    Tausch tausch(MPI_COMM_WORLD, false);
+
+    const std::vector<int> sizes = {10, 10000, 1000000};
+    for(auto size : sizes) {
+        std::vector<int> indices(size);
+        for(int i = 0; i < size; ++i)
+            indices[i] = i;
+        tausch.addSendHaloInfo(indices, sizeof(double), sendRank);
+        tausch.addRecvHaloInfo(indices, sizeof(double), recvRank);
+    }
+
+    const double uncalibrated = tausch.predictSendTime(0);
+
+    tausch.calibrateCostModel(5);
+
+    std::vector<double> sendTimes, recvTimes;
+    for(size_t haloId = 0; haloId < sizes.size(); ++haloId) {
+        sendTimes.push_back(tausch.predictSendTime(haloId));
+        recvTimes.push_back(tausch.predictRecvTime(haloId));
+    }
+
+    std::stringstream report;
+    tausch.printCostModelReport(report);
+
+    REQUIRE(uncalibrated == -1);
+
+    for(size_t haloId = 0; haloId < sizes.size(); ++haloId) {
+        REQUIRE(std::isfinite(sendTimes[haloId]));
+        REQUIRE(std::isfinite(recvTimes[haloId]));
+        REQUIRE(sendTimes[haloId] >= 0);
+        REQUIRE(recvTimes[haloId] >= 0);
+        if(haloId > 0) {
+            REQUIRE(sendTimes[haloId] > sendTimes[haloId-1]);
+            REQUIRE(recvTimes[haloId] > recvTimes[haloId-1]);
+        }
+    }
+
+    // strategies are reported by name
+    REQUIRE(report.str().find("suggested strategy ") != std::string::npos);
+    REQUIRE(report.str().find("suggested strategy 1") == std::string::npos);
+    REQUIRE(Tausch::getCommunicationStrategyName(Tausch::Communication::DerivedMpiDatatypeSingleMessage) == "DerivedMpiDatatypeSingleMessage");
+    REQUIRE(Tausch::getCommunicationStrategyName(static_cast<Tausch::Communication>(Tausch::Communication::MPIPersistent|Tausch::Communication::TryDirectCopy)) == "TryDirectCopy|MPIPersistent");
+
+}
+
+#endif
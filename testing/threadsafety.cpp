@@ -0,0 +1,82 @@
+#include <catch2/catch.hpp>
+#include "../tausch.h"
+
+// the tests in here use Tausch concurrently from several threads of each MPI rank
+#if defined(TEST_SEND_TAUSCH_CPU) && defined(TEST_RECV_TAUSCH_CPU)
+
+TEST_CASE("2 threads, concurrent exchange of separate halos, multiple MPI ranks") {
+
+    std::cout << " * Test: " << "2 threads, concurrent exchange of separate halos, multiple MPI ranks" << std::endl;
+
+    int provided;
+    MPI_Query_thread(&provided);
+    if(provided != MPI_THREAD_MULTIPLE) {
+        WARN("MPI does not provide MPI_THREAD_MULTIPLE, skipping test");
+        return;
+    }
+
+    const int size = 1000;
+    const int numThreads = 2;
+    const int numIter = 50;
+
+    int mpiRank, mpiSize;
+    MPI_Comm_rank(MPI_COMM_WORLD, &mpiRank);
+    MPI_Comm_size(MPI_COMM_WORLD, &mpiSize);
+
+    const int sendRank = (mpiRank+1)%mpiSize;
+    const int recvRank = (mpiRank+mpiSize-1)%mpiSize;
+
+    Tausch tausch(MPI_COMM_WORLD, false);
+    tausch.setThreadSafety(true);
+
+    std::vector<int> indices(size);
+    for(int i = 0; i < size; ++i)
+        indices[i] = i;
+
+    // each thread has its own halo pair, one of them using persistent requests
+    for(int t = 0; t < numThreads; ++t) {
+        tausch.addSendHaloInfo(indices, sizeof(double), sendRank);
+        tausch.addRecvHaloInfo(indices, sizeof(double), recvRank);
+    }
+    tausch.setSendCommunicationStrategy(1, Tausch::Communication::MPIPersistent);
+    tausch.setRecvCommunicationStrategy(1, Tausch::Communication::MPIPersistent);
+
+    std::vector<int> errors(numThreads, 0);
+
+    auto run = [&](const int t) {
+
+        std::vector<double> in(size), out(size);
+
+        for(int iter = 0; iter < numIter; ++iter) {
+
+            for(int i = 0; i < size; ++i)
+                in[i] = t*1000000 + iter*10000 + mpiRank*1000 + i;
+
+            tausch.packSendBuffer(t, 0, in.data());
+            Status status = tausch.send(t, t);
+            tausch.recv(t, t);
+            status.wait();
+            tausch.unpackRecvBuffer(t, 0, out.data());
+
+            for(int i = 0; i < size; ++i)
+                if(out[i] != t*1000000 + iter*10000 + recvRank*1000 + i)
+                    ++errors[t];
+
+        }
+
+    };
+
+    std::vector<std::thread> threads;
+    for(int t = 0; t < numThreads; ++t)
+        threads.push_back(std::thread(run, t));
+    for(auto &thread : threads)
+        thread.join();
+
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    for(int t = 0; t < numThreads; ++t)
+        REQUIRE(errors[t] == 0);
+
+}
+
+#endif
@@ -0,0 +1,129 @@
+#include <catch2/catch.hpp>
+#include "../tausch.h"
+
+// the tests in here connect several Tausch objects living in the same process and do not use MPI,
+// except for the checks of the MpiTransport
+#if defined(TEST_SEND_TAUSCH_CPU) && defined(TEST_RECV_TAUSCH_CPU)
+
+TEST_CASE("4 threads, 2 halos each, ThreadTransport without MPI") {
+
+    std::cout << " * Test: " << "4 threads, 2 halos each, ThreadTransport without MPI" << std::endl;
+
+    const int numThreads = 4;
+    const int size = 500;
+
+    std::vector<std::shared_ptr<Transport> > endpoints = ThreadTransport::create(numThreads);
+
+    // every thread counts the wrong values it receives, checked once all threads are done
+    std::vector<int> wrong(numThreads, 0);
+
+    auto run = [&](const int rank) {
+
+        const int right = (rank+1)%numThreads;
+        const int left = (rank+numThreads-1)%numThreads;
+
+        Tausch tausch(endpoints[rank]);
+
+        // halo 0 goes to the right, halo 1 goes to the left, halo 2 is empty
+        std::vector<int> indices(size);
+        for(int i = 0; i < size; ++i)
+            indices[i] = i;
+        tausch.addSendHaloInfo(indices, sizeof(double), right);
+        tausch.addRecvHaloInfo(indices, sizeof(double), left);
+        tausch.addSendHaloInfo(std::vector<int>(indices.begin(), indices.begin()+size/2), sizeof(double), left);
+        tausch.addRecvHaloInfo(std::vector<int>(indices.begin(), indices.begin()+size/2), sizeof(double), right);
+        tausch.addSendHaloInfo(std::vector<int>(), sizeof(double), right);
+        tausch.addRecvHaloInfo(std::vector<int>(), sizeof(double), left);
+
+        std::vector<double> in(size), outLeft(size), outRight(size);
+
+        for(int iter = 0; iter < 10; ++iter) {
+
+            for(int i = 0; i < size; ++i)
+                in[i] = iter*100000 + rank*1000 + i;
+
+            tausch.packSendBuffer(0, 0, in.data());
+            tausch.packSendBuffer(1, 0, in.data());
+
+            // the receives are posted in the opposite order of the sends on some threads
+            std::vector<Status> status;
+            if(rank%2 == 0) {
+                status.push_back(tausch.send(0, 1));
+                status.push_back(tausch.send(1, 2));
+                status.push_back(tausch.send(2, 3));
+                tausch.recv(2, 3);
+                tausch.recv(1, 2);
+                tausch.recv(0, 1);
+            } else {
+                status.push_back(tausch.recv(0, 1, -1, -1, false));
+                status.push_back(tausch.recv(1, 2, -1, -1, false));
+                tausch.recv(2, 3);
+                status.push_back(tausch.send(0, 1));
+                status.push_back(tausch.send(1, 2));
+                status.push_back(tausch.send(2, 3));
+            }
+
+            for(auto &s : status)
+                s.wait();
+
+            tausch.unpackRecvBuffer(0, 0, outLeft.data());
+            tausch.unpackRecvBuffer(1, 0, outRight.data());
+
+            for(int i = 0; i < size; ++i)
+                if(outLeft[i] != iter*100000 + left*1000 + i)
+                    ++wrong[rank];
+            for(int i = 0; i < size/2; ++i)
+                if(outRight[i] != iter*100000 + right*1000 + i)
+                    ++wrong[rank];
+
+        }
+
+    };
+
+    std::vector<std::thread> threads;
+    for(int rank = 0; rank < numThreads; ++rank)
+        threads.push_back(std::thread(run, rank));
+    for(auto &t : threads)
+        t.join();
+
+    for(int rank = 0; rank < numThreads; ++rank)
+        REQUIRE(wrong[rank] == 0);
+
+}
+
+// Hidden test, it is expected to abort and is run separately by ctest, see CMakeLists.txt.
+TEST_CASE("2 endpoints, ThreadTransport message longer than the receive buffer", "[.threadtransporttruncate]") {
+
+    std::cout << " * Test: " << "2 endpoints, ThreadTransport message longer than the receive buffer" << std::endl;
+
+    std::vector<std::shared_ptr<Transport> > endpoints = ThreadTransport::create(2);
+
+    std::vector<double> in(10, 1), out(5);
+
+    // the send completes right away, the message waits in the mailbox
+    Status status = endpoints[0]->postSend(reinterpret_cast<unsigned char*>(in.data()), in.size()*sizeof(double), 1, 4);
+    status.wait();
+    endpoints[1]->postRecv(reinterpret_cast<unsigned char*>(out.data()), out.size()*sizeof(double), 0, 4);
+
+    // never reached
+    REQUIRE(false);
+
+}
+
+// Hidden test, it is expected to abort and is run separately by ctest, see CMakeLists.txt.
+TEST_CASE("1 rank, MpiTransport message larger than an MPI count", "[.mpitransportcount]") {
+
+    std::cout << " * Test: " << "1 rank, MpiTransport message larger than an MPI count" << std::endl;
+
+    MpiTransport transport(MPI_COMM_WORLD);
+
+    // the size is rejected before the buffer is touched
+    unsigned char buf[1];
+    transport.postSend(buf, static_cast<size_t>(std::numeric_limits<int>::max())+1, 0, 5);
+
+    // never reached
+    REQUIRE(false);
+
+}
+
+#endif
@@ -0,0 +1,62 @@
+#include <catch2/catch.hpp>
+#include "../tausch.h"
+
+// the tests in here exchange halos through UCX and are only built with TEST_UCX (which defines TAUSCH_UCX)
+#if defined(TAUSCH_UCX) && defined(TEST_SEND_TAUSCH_CPU) && defined(TEST_RECV_TAUSCH_CPU)
+
+TEST_CASE("1 buffer, UCX strategy, multiple MPI ranks") {
+
+    std::cout << " * Test: " << "1 buffer, UCX strategy, multiple MPI ranks" << std::endl;
+
+    const int size = 1000;
+
+    int mpiRank, mpiSize;
+    MPI_Comm_rank(MPI_COMM_WORLD, &mpiRank);
+    MPI_Comm_size(MPI_COMM_WORLD, &mpiSize);
+
+    const int sendRank = (mpiRank+1)%mpiSize;
+    const int recvRank = (mpiRank+mpiSize-1)%mpiSize;
+
+    Tausch tausch(MPI_COMM_WORLD, false);
+
+    // collective, every rank has to be able to set up UCX
+    const bool ucx = tausch.setupUcx();
+
+    std::vector<int> indices(size);
+    for(int i = 0; i < size; ++i)
+        indices[i] = i;
+    tausch.addSendHaloInfo(indices, sizeof(double), sendRank);
+    tausch.addRecvHaloInfo(indices, sizeof(double), recvRank);
+    tausch.setSendCommunicationStrategy(0, Tausch::Communication::UCX);
+    tausch.setRecvCommunicationStrategy(0, Tausch::Communication::UCX);
+
+    std::vector<double> in(size), out(size);
+
+    // the staging buffers stay registered with UCX across iterations
+    for(int iter = 0; iter < 3; ++iter) {
+
+        for(int i = 0; i < size; ++i) {
+            in[i] = iter*1000000 + mpiRank*10000 + i;
+            out[i] = 0;
+        }
+
+        tausch.packSendBuffer(0, 0, in.data());
+
+        Status status = tausch.send(0, 3);
+        tausch.recv(0, 3);
+
+        status.wait();
+
+        tausch.unpackRecvBuffer(0, 0, out.data());
+
+        MPI_Barrier(MPI_COMM_WORLD);
+
+        REQUIRE(ucx);
+        for(int i = 0; i < size; ++i)
+            REQUIRE(out[i] == iter*1000000 + recvRank*10000 + i);
+
+    }
+
+}
+
+#endif